@@ -0,0 +1,285 @@
+#include "benchsupport.h"
+
+#include "configmanager.h"
+#include "connectguard.h"
+#include "metricsregistry.h"
+
+#include <QApplication>
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr int kPollMs = 10;
+// 请求头上限，超过后直接断开
+constexpr int kMaxRequestBytes = 16 * 1024;
+
+// %1 为 JSON 字符串字面量形式的前缀
+const char kEchoScript[] = R"JS(
+(function() {
+  var prefix = %1;
+  window.__benchEcho = window.__benchEcho || {};
+  if (!window.qtBridgeReady || window.__benchEcho[prefix]) return;
+  window.__benchEcho[prefix] = true;
+  window.qtBridgeReady.then(function(bridge) {
+    bridge.messageFromCpp.connect(function(payload) {
+      if (payload.indexOf(prefix) === 0) bridge.sendToCpp(payload);
+    });
+    bridge.messageBatchFromCpp.connect(function(payloads) {
+      payloads.forEach(function(payload) {
+        if (payload.indexOf(prefix) === 0) bridge.sendToCpp(payload);
+      });
+    });
+    if (location.protocol !== 'qrc:') bridge.notifyPageReady();
+  });
+})();
+)JS";
+} // namespace
+
+QStringList BenchSupport::arguments(int argc, char *argv[])
+{
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+    return arguments;
+}
+
+void BenchSupport::prepareEnvironment(bool offscreen)
+{
+    qputenv("QTWEBENGINE_DISABLE_SANDBOX", "1");
+    if (offscreen) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+        QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+        if (!flags.contains("--disable-gpu")) {
+            flags.append(flags.isEmpty() ? "--disable-gpu" : " --disable-gpu");
+            qputenv("QTWEBENGINE_CHROMIUM_FLAGS", flags);
+        }
+        QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    }
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+}
+
+void BenchSupport::initializeApplication(const QString &name)
+{
+    QApplication::setApplicationName(name);
+    QApplication::setOrganizationName(QStringLiteral("DemoOrg"));
+    ConfigManager::instance().initialize(QCoreApplication::applicationDirPath());
+}
+
+bool BenchSupport::parse(QCommandLineParser &parser, const QStringList &arguments, QString *error)
+{
+    if (!parser.parse(arguments)) {
+        *error = parser.errorText();
+        return false;
+    }
+    if (parser.isSet(QStringLiteral("help"))) {
+        *error = parser.helpText();
+        return false;
+    }
+    return true;
+}
+
+int BenchSupport::reportOptionError(const QStringList &arguments, const QString &error)
+{
+    QTextStream(stderr) << error << "\n";
+    return arguments.contains(QStringLiteral("--help")) || arguments.contains(QStringLiteral("-h")) ? 0 : 2;
+}
+
+QCommandLineOption BenchSupport::intOption(const char *name, const char *description, const char *valueName, int value)
+{
+    return QCommandLineOption(QString::fromLatin1(name), QString::fromLatin1(description), QString::fromLatin1(valueName),
+                              QString::number(value));
+}
+
+bool BenchSupport::readInt(const QCommandLineParser &parser, const QCommandLineOption &option, int min, int *out,
+                           QString *error)
+{
+    bool ok = false;
+    const int value = parser.value(option).toInt(&ok);
+    if (!ok || value < min) {
+        *error = QStringLiteral("--%1 must be an integer >= %2").arg(option.names().constFirst()).arg(min);
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+QCommandLineOption BenchSupport::outputOption()
+{
+    return QCommandLineOption(QStringLiteral("output"), QStringLiteral("text or json."), QStringLiteral("format"),
+                              QStringLiteral("text"));
+}
+
+bool BenchSupport::readOutput(const QCommandLineParser &parser, const QCommandLineOption &option, bool *json,
+                              QString *error)
+{
+    const QString output = parser.value(option).toLower();
+    if (output != QLatin1String("text") && output != QLatin1String("json")) {
+        *error = QStringLiteral("--output must be text or json");
+        return false;
+    }
+    *json = output == QLatin1String("json");
+    return true;
+}
+
+bool BenchSupport::waitUntil(const std::function<bool()> &done, int timeoutMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+    while (!done()) {
+        if (clock.elapsed() > timeoutMs) {
+            return false;
+        }
+        QEventLoop loop;
+        QTimer::singleShot(kPollMs, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return true;
+}
+
+double BenchSupport::percentile(QVector<double> values, double p)
+{
+    values.erase(std::remove_if(values.begin(), values.end(), [](double value) { return value < 0.0; }), values.end());
+    return values.isEmpty() ? -1.0 : MetricsRegistry::percentile(values, p);
+}
+
+QString BenchSupport::echoScript(const QString &prefix)
+{
+    const QByteArray literal = QJsonDocument(QJsonArray {prefix}).toJson(QJsonDocument::Compact);
+    return QString::fromLatin1(kEchoScript).arg(QString::fromUtf8(literal.mid(1, literal.size() - 2)));
+}
+
+const QByteArray CorpusSchemeHandler::kScheme = QByteArrayLiteral("bench");
+
+void CorpusSchemeHandler::registerScheme()
+{
+    QWebEngineUrlScheme scheme(kScheme);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+QUrl CorpusSchemeHandler::url(const QString &page)
+{
+    QUrl url;
+    url.setScheme(QString::fromLatin1(kScheme));
+    url.setHost(QStringLiteral("corpus"));
+    url.setPath(QLatin1Char('/') + page);
+    return url;
+}
+
+void CorpusSchemeHandler::install(QWebEngineProfile *profile)
+{
+    // 多个 pane 可能共用同一个 profile，重复安装会被 WebEngine 拒绝并告警
+    if (profile->urlSchemeHandler(kScheme) != this) {
+        profile->installUrlSchemeHandler(kScheme, this);
+    }
+}
+
+void CorpusSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    QFile file(QStringLiteral(":/bench/corpus") + job->requestUrl().path());
+    if (!file.open(QIODevice::ReadOnly)) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    auto *buffer = new QBuffer(job);
+    buffer->setData(file.readAll());
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(mimeTypeFor(job->requestUrl().path()), buffer);
+}
+
+QByteArray CorpusSchemeHandler::mimeTypeFor(const QString &path)
+{
+    if (path.endsWith(QLatin1String(".js"))) {
+        return "application/javascript";
+    }
+    if (path.endsWith(QLatin1String(".css"))) {
+        return "text/css";
+    }
+    return "text/html";
+}
+
+CorpusHttpServer::CorpusHttpServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    ENSURE_QT_CONNECT(m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+            ENSURE_QT_CONNECT(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            // 每个连接只处理一个请求，响应后关闭；请求体（GET 没有）不读取
+            auto request = std::make_shared<QByteArray>();
+            auto served = std::make_shared<bool>(false);
+            ENSURE_QT_CONNECT(socket, &QTcpSocket::readyRead, socket, [this, socket, request, served]() {
+                if (*served) {
+                    socket->readAll();
+                    return;
+                }
+                request->append(socket->readAll());
+                if (request->contains("\r\n\r\n")) {
+                    *served = true;
+                    serve(socket, *request);
+                } else if (request->size() > kMaxRequestBytes) {
+                    socket->abort();
+                }
+            });
+        }
+    });
+}
+
+bool CorpusHttpServer::listen()
+{
+    if (!m_server->listen(QHostAddress::LocalHost)) {
+        qWarning() << "CorpusHttpServer: cannot listen" << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+QUrl CorpusHttpServer::url(const QString &page) const
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("http"));
+    url.setHost(QStringLiteral("127.0.0.1"));
+    url.setPort(m_server->serverPort());
+    url.setPath(QStringLiteral("/corpus/") + page);
+    return url;
+}
+
+void CorpusHttpServer::serve(QTcpSocket *socket, const QByteArray &request)
+{
+    // 请求行：GET /corpus/<页面>[?查询] HTTP/1.1
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    const QString target = requestLine.size() == 3 ? QUrl(QString::fromLatin1(requestLine.at(1))).path() : QString();
+    const QString path = QDir::cleanPath(target);
+    QFile file(QStringLiteral(":/bench") + path);
+    QByteArray response;
+    if (requestLine.value(0) != "GET" || !path.startsWith(QLatin1String("/corpus/")) || !file.open(QIODevice::ReadOnly)) {
+        response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    } else {
+        const QByteArray body = file.readAll();
+        response = "HTTP/1.1 200 OK\r\nContent-Type: " + CorpusSchemeHandler::mimeTypeFor(path)
+                   + "\r\nContent-Length: " + QByteArray::number(body.size())
+                   + "\r\nCache-Control: max-age=3600\r\nConnection: close\r\n\r\n" + body;
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QCommandLineOption>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include <QWebEngineUrlSchemeHandler>
+
+#include <functional>
+
+class QCommandLineParser;
+class QTcpServer;
+class QTcpSocket;
+class QWebEngineProfile;
+class QWebEngineUrlRequestJob;
+
+// BenchSupport 汇集 bench/ 下各程序共用的启动、命令行解析、事件循环等待与统计辅助函数
+class BenchSupport final
+{
+public:
+    BenchSupport() = delete;
+
+    // 在创建 QApplication 之前把 argv 转成参数列表
+    static QStringList arguments(int argc, char *argv[]);
+    // 关闭沙箱；offscreen 为 true 时改用 offscreen 平台与软件渲染，不依赖显示器与 GPU。
+    // 必须在创建 QApplication 之前调用
+    static void prepareEnvironment(bool offscreen);
+    // 创建 QApplication 之后调用：设置应用名与组织名，并从可执行文件所在目录加载配置
+    static void initializeApplication(const QString &name);
+
+    // 解析参数并处理 --help；返回 false 时 error 为错误或帮助文本
+    static bool parse(QCommandLineParser &parser, const QStringList &arguments, QString *error);
+    // 打印 parse 失败时的文本，返回进程退出码：--help 为 0，其余为 2
+    static int reportOptionError(const QStringList &arguments, const QString &error);
+    static QCommandLineOption intOption(const char *name, const char *description, const char *valueName, int value);
+    static bool readInt(const QCommandLineParser &parser, const QCommandLineOption &option, int min, int *out,
+                        QString *error);
+    // --output text|json
+    static QCommandLineOption outputOption();
+    static bool readOutput(const QCommandLineParser &parser, const QCommandLineOption &option, bool *json,
+                           QString *error);
+
+    // 运行事件循环直到 done() 成立或超时，返回 done() 是否成立
+    static bool waitUntil(const std::function<bool()> &done, int timeoutMs);
+    // 负值视为缺失样本并忽略；没有样本时返回 -1
+    static double percentile(QVector<double> values, double p);
+
+    // 在通道引导脚本之后注入的用户脚本：收到以 prefix 开头的消息立即原样回传，用于测量 C++ -> JS -> C++ 往返；
+    // 非 qrc: 页面上引导脚本不会自动就绪，挂好监听后由该脚本调用 notifyPageReady()
+    static QString echoScript(const QString &prefix);
+};
+
+// CorpusSchemeHandler 把 bench://corpus/<page> 映射到 :/bench/corpus/<page>，避免网络与磁盘抖动影响测量
+class CorpusSchemeHandler final : public QWebEngineUrlSchemeHandler
+{
+public:
+    static const QByteArray kScheme;
+
+    // 必须在创建 QApplication 之前调用
+    static void registerScheme();
+    static QUrl url(const QString &page);
+    static QByteArray mimeTypeFor(const QString &path);
+
+    using QWebEngineUrlSchemeHandler::QWebEngineUrlSchemeHandler;
+
+    void install(QWebEngineProfile *profile);
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+};
+
+// CorpusHttpServer 在 127.0.0.1 的随机端口上以 HTTP 提供同一份语料。自定义 scheme 的响应不进入 HTTP 缓存，
+// 这里的响应带 Cache-Control，冷 / 热加载与 --http-cache 的差异才能体现出来
+class CorpusHttpServer final : public QObject
+{
+public:
+    explicit CorpusHttpServer(QObject *parent = nullptr);
+
+    bool listen();
+    QUrl url(const QString &page) const;
+
+private:
+    void serve(QTcpSocket *socket, const QByteArray &request);
+
+    QTcpServer *m_server {nullptr};
+};
@@ -0,0 +1,265 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "webbridge.h"
+#include "webenginepane.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QUrl>
+#include <QVector>
+#include <QWebEnginePage>
+#include <QWebEngineView>
+
+#include <memory>
+#include <utility>
+
+namespace {
+constexpr int kLoadTimeoutMs = 30000;
+
+struct BenchOptions
+{
+    QStringList transports {QStringLiteral("page"), QStringLiteral("websocket")};
+    QVector<int> sizes {64, 4096, 65536, 1048576};
+    int rounds {200};
+    int burst {1000};
+    int timeoutMs {180000};
+    bool json {false};
+};
+
+struct SizeResult
+{
+    int size {0};
+    int rounds {0};
+    double latencyP50Ms {-1.0};
+    double latencyP95Ms {-1.0};
+    int burst {0};
+    double messagesPerSec {0.0};
+    double mibPerSec {0.0};
+};
+
+struct TransportResult
+{
+    QString transport;
+    QVector<SizeResult> sizes;
+    QString error;
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Echoes bridge messages between a page and C++ over each QWebChannel "
+                                                    "transport and compares round-trip latency and throughput."));
+    parser.addHelpOption();
+    const QCommandLineOption transportsOption(QStringLiteral("transports"), QStringLiteral("Comma separated: page, websocket."),
+                                              QStringLiteral("list"), options->transports.join(QLatin1Char(',')));
+    const QCommandLineOption sizesOption(QStringLiteral("sizes"), QStringLiteral("Comma separated payload sizes in bytes."),
+                                         QStringLiteral("list"), QStringLiteral("64,4096,65536,1048576"));
+    const QCommandLineOption roundsOption(QStringLiteral("rounds"), QStringLiteral("Sequential round trips per size."),
+                                          QStringLiteral("n"), QString::number(options->rounds));
+    const QCommandLineOption burstOption(QStringLiteral("burst"),
+                                         QStringLiteral("Messages sent back to back per size (capped at 64 MiB per burst)."),
+                                         QStringLiteral("n"), QString::number(options->burst));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout-ms"), QStringLiteral("Time limit per transport."),
+                                           QStringLiteral("ms"), QString::number(options->timeoutMs));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({transportsOption, sizesOption, roundsOption, burstOption, timeoutOption, outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    options->transports = parser.value(transportsOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &transport : std::as_const(options->transports)) {
+        if (transport != QLatin1String("page") && transport != QLatin1String("websocket")) {
+            *error = QStringLiteral("unknown transport: %1").arg(transport);
+            return false;
+        }
+    }
+    options->sizes.clear();
+    const QStringList sizes = parser.value(sizesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &size : sizes) {
+        const int bytes = size.toInt();
+        if (bytes <= 0) {
+            *error = QStringLiteral("invalid size: %1").arg(size);
+            return false;
+        }
+        options->sizes.append(bytes);
+    }
+    options->rounds = qMax(1, parser.value(roundsOption).toInt());
+    options->burst = qMax(1, parser.value(burstOption).toInt());
+    options->timeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+class ChannelTransportBench final
+{
+public:
+    explicit ChannelTransportBench(const BenchOptions &options)
+        : m_options(options)
+    {
+    }
+
+    int run()
+    {
+        QVector<TransportResult> results;
+        int failures = 0;
+        for (const QString &transport : std::as_const(m_options.transports)) {
+            QTextStream(stderr) << "channeltransport_bench: " << transport << "\n";
+            results.append(runTransport(transport));
+            failures += results.constLast().error.isEmpty() ? 0 : 1;
+        }
+        print(results);
+        return failures == 0 ? 0 : 1;
+    }
+
+private:
+    TransportResult runTransport(const QString &transport)
+    {
+        TransportResult result;
+        result.transport = transport;
+
+        auto pane = std::make_unique<WebEnginePane>();
+        pane->setChannelTransport(transport == QLatin1String("websocket") ? WebEnginePane::ChannelTransport::WebSocket
+                                                                          : WebEnginePane::ChannelTransport::Page);
+        if (transport == QLatin1String("websocket") && pane->channelTransport() != WebEnginePane::ChannelTransport::WebSocket) {
+            result.error = QStringLiteral("websocket transport unavailable");
+            return result;
+        }
+        pane->resize(800, 600);
+        pane->show();
+
+        WebBridge *bridge = pane->bridge();
+        // 回发时绕过 pane 的排队与冻结逻辑，只测传输本身
+        ENSURE_QT_CONNECT(bridge, &WebBridge::messageFromJs, pane.get(), [bridge](const QString &payload) {
+            if (payload.startsWith(QLatin1String("echo:"))) {
+                bridge->dispatchToWeb(payload);
+            }
+        });
+        bool ready = false;
+        ENSURE_QT_CONNECT(bridge, &WebBridge::pageReady, pane.get(), [&ready]() {
+            ready = true;
+        });
+        QJsonDocument report;
+        ENSURE_QT_CONNECT(bridge, &WebBridge::telemetryReported, pane.get(),
+                          [&report](const QString &channel, const QString &payload) {
+                              if (channel == QLatin1String("channelbench")) {
+                                  report = QJsonDocument::fromJson(payload.toUtf8());
+                              }
+                          });
+
+        pane->load(QUrl(QStringLiteral("qrc:/bench/channeltransport.html")));
+        if (!BenchSupport::waitUntil([&ready]() { return ready; }, kLoadTimeoutMs)) {
+            result.error = QStringLiteral("bridge did not become ready");
+            return result;
+        }
+
+        QJsonArray sizes;
+        for (const int size : std::as_const(m_options.sizes)) {
+            sizes.append(size);
+        }
+        const QJsonObject config {{QStringLiteral("sizes"), sizes},
+                                  {QStringLiteral("rounds"), m_options.rounds},
+                                  {QStringLiteral("burst"), m_options.burst}};
+        pane->view()->page()->runJavaScript(
+            QStringLiteral("window.runChannelBench(%1);")
+                .arg(QString::fromUtf8(QJsonDocument(config).toJson(QJsonDocument::Compact))));
+        if (!BenchSupport::waitUntil([&report]() { return !report.isNull(); }, m_options.timeoutMs)) {
+            result.error = QStringLiteral("timed out");
+            return result;
+        }
+        if (!report.isArray()) {
+            result.error = report.object().value(QStringLiteral("error")).toString(QStringLiteral("invalid report"));
+            return result;
+        }
+
+        const QJsonArray entries = report.array();
+        for (const QJsonValue &value : entries) {
+            const QJsonObject entry = value.toObject();
+            SizeResult size;
+            size.size = entry.value(QStringLiteral("size")).toInt();
+            size.rounds = entry.value(QStringLiteral("rounds")).toInt();
+            size.latencyP50Ms = entry.value(QStringLiteral("latencyP50Ms")).toDouble();
+            size.latencyP95Ms = entry.value(QStringLiteral("latencyP95Ms")).toDouble();
+            size.burst = entry.value(QStringLiteral("burst")).toInt();
+            size.messagesPerSec = entry.value(QStringLiteral("messagesPerSec")).toDouble();
+            size.mibPerSec = entry.value(QStringLiteral("mibPerSec")).toDouble();
+            result.sizes.append(size);
+        }
+        return result;
+    }
+
+    void print(const QVector<TransportResult> &results) const
+    {
+        QTextStream out(stdout);
+        if (m_options.json) {
+            QJsonArray transports;
+            for (const TransportResult &result : results) {
+                QJsonArray sizes;
+                for (const SizeResult &size : result.sizes) {
+                    sizes.append(QJsonObject {{QStringLiteral("size"), size.size},
+                                              {QStringLiteral("rounds"), size.rounds},
+                                              {QStringLiteral("latencyP50Ms"), size.latencyP50Ms},
+                                              {QStringLiteral("latencyP95Ms"), size.latencyP95Ms},
+                                              {QStringLiteral("burst"), size.burst},
+                                              {QStringLiteral("messagesPerSec"), size.messagesPerSec},
+                                              {QStringLiteral("mibPerSec"), size.mibPerSec}});
+                }
+                transports.append(QJsonObject {{QStringLiteral("transport"), result.transport},
+                                               {QStringLiteral("sizes"), sizes},
+                                               {QStringLiteral("error"), result.error}});
+            }
+            out << QJsonDocument(QJsonObject {{QStringLiteral("rounds"), m_options.rounds},
+                                              {QStringLiteral("burst"), m_options.burst},
+                                              {QStringLiteral("transports"), transports}})
+                       .toJson(QJsonDocument::Indented);
+            return;
+        }
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6\n")
+                   .arg(QStringLiteral("transport"), -10)
+                   .arg(QStringLiteral("bytes"), 9)
+                   .arg(QStringLiteral("p50 ms"), 8)
+                   .arg(QStringLiteral("p95 ms"), 8)
+                   .arg(QStringLiteral("msg/s"), 10)
+                   .arg(QStringLiteral("MiB/s"), 8);
+        for (const TransportResult &result : results) {
+            if (!result.error.isEmpty()) {
+                out << QStringLiteral("%1 %2\n").arg(result.transport, -10).arg(result.error);
+                continue;
+            }
+            for (const SizeResult &size : result.sizes) {
+                out << QStringLiteral("%1 %2 %3 %4 %5 %6\n")
+                           .arg(result.transport, -10)
+                           .arg(size.size, 9)
+                           .arg(size.latencyP50Ms, 8, 'f', 3)
+                           .arg(size.latencyP95Ms, 8, 'f', 3)
+                           .arg(size.messagesPerSec, 10, 'f', 0)
+                           .arg(size.mibPerSec, 8, 'f', 1);
+            }
+        }
+    }
+
+    BenchOptions m_options;
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    // 与 soak_test 相同，固定使用 offscreen 平台与软件渲染
+    BenchSupport::prepareEnvironment(true);
+
+    QApplication app(argc, argv);
+    BenchSupport::initializeApplication(QStringLiteral("channeltransport_bench"));
+
+    return ChannelTransportBench(options).run();
+}
@@ -0,0 +1,335 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "framestream.h"
+#include "webenginepane.h"
+
+#include <QApplication>
+#include <QBuffer>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QColor>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QVector>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace {
+constexpr int kLoadTimeoutMs = 30000;
+constexpr int kFirstFrameTimeoutMs = 10000;
+constexpr int kDrainMs = 1000;
+
+struct BenchOptions
+{
+    QStringList modes {QStringLiteral("rgba"), QStringLiteral("jpeg"), QStringLiteral("base64")};
+    QSize size {1280, 720};
+    int fps {60};
+    int durationMs {5000};
+    QString source {QStringLiteral("rgba")};
+    int jpegQuality {80};
+    bool json {false};
+};
+
+struct ModeResult
+{
+    QString mode;
+    quint64 pushed {0};
+    quint64 delivered {0};
+    quint64 dropped {0};
+    double deliveredFps {0.0};
+    double latencyP50Ms {-1.0};
+    double latencyP95Ms {-1.0};
+    QString error;
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Pushes synthetic frames into a page canvas through the framestream "
+                                                    "scheme and through base64 bridge messages, and compares delivery."));
+    parser.addHelpOption();
+    const QCommandLineOption modesOption(QStringLiteral("modes"), QStringLiteral("Comma separated: rgba, jpeg, png, base64."),
+                                         QStringLiteral("list"), options->modes.join(QLatin1Char(',')));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Frame size, e.g. 1280x720."),
+                                        QStringLiteral("WxH"), QStringLiteral("1280x720"));
+    const QCommandLineOption fpsOption(QStringLiteral("fps"), QStringLiteral("Frames pushed per second."),
+                                       QStringLiteral("n"), QString::number(options->fps));
+    const QCommandLineOption durationOption(QStringLiteral("duration-ms"), QStringLiteral("Measurement time per mode."),
+                                            QStringLiteral("ms"), QString::number(options->durationMs));
+    const QCommandLineOption sourceOption(QStringLiteral("source"), QStringLiteral("Pixel format pushed by C++: rgba or i420."),
+                                          QStringLiteral("format"), options->source);
+    const QCommandLineOption qualityOption(QStringLiteral("jpeg-quality"), QStringLiteral("JPEG quality for jpeg and base64."),
+                                           QStringLiteral("q"), QString::number(options->jpegQuality));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({modesOption, sizeOption, fpsOption, durationOption, sourceOption, qualityOption, outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    const QStringList known {QStringLiteral("rgba"), QStringLiteral("jpeg"), QStringLiteral("png"), QStringLiteral("base64")};
+    options->modes = parser.value(modesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &mode : std::as_const(options->modes)) {
+        if (!known.contains(mode)) {
+            *error = QStringLiteral("unknown mode: %1").arg(mode);
+            return false;
+        }
+    }
+    const QStringList size = parser.value(sizeOption).toLower().split(QLatin1Char('x'));
+    options->size = QSize(size.value(0).toInt(), size.value(1).toInt());
+    if (options->size.isEmpty()) {
+        *error = QStringLiteral("invalid --size");
+        return false;
+    }
+    options->fps = qBound(1, parser.value(fpsOption).toInt(), 240);
+    options->durationMs = qMax(500, parser.value(durationOption).toInt());
+    options->source = parser.value(sourceOption).toLower();
+    if (options->source != QLatin1String("rgba") && options->source != QLatin1String("i420")) {
+        *error = QStringLiteral("--source must be rgba or i420");
+        return false;
+    }
+    options->jpegQuality = qBound(1, parser.value(qualityOption).toInt(), 100);
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+class FrameStreamBench final
+{
+public:
+    explicit FrameStreamBench(const BenchOptions &options)
+        : m_options(options)
+        , m_image(options.size, QImage::Format_RGBA8888)
+    {
+        const int width = options.size.width();
+        const int height = options.size.height();
+        m_i420.resize(width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2));
+    }
+
+    int run()
+    {
+        QVector<ModeResult> results;
+        int failures = 0;
+        for (const QString &mode : std::as_const(m_options.modes)) {
+            QTextStream(stderr) << "framestream_bench: " << mode << "\n";
+            results.append(runMode(mode));
+            failures += results.constLast().error.isEmpty() ? 0 : 1;
+        }
+        print(results);
+        return failures == 0 ? 0 : 1;
+    }
+
+private:
+    // 合成帧：背景色随序号变化，再画一个移动的方块，避免编码器命中完全相同的画面
+    void paintFrame(quint64 seq)
+    {
+        m_image.fill(QColor::fromHsv(static_cast<int>(seq % 360), 160, 200));
+        QPainter painter(&m_image);
+        const int side = m_image.height() / 4;
+        const int x = static_cast<int>((seq * 8) % static_cast<quint64>(qMax(1, m_image.width() - side)));
+        painter.fillRect(x, m_image.height() / 2 - side / 2, side, side, Qt::white);
+    }
+
+    void fillI420(quint64 seq)
+    {
+        const int width = m_options.size.width();
+        const int height = m_options.size.height();
+        uchar *y = reinterpret_cast<uchar *>(m_i420.data());
+        for (int row = 0; row < height; ++row) {
+            std::fill_n(y + row * width, width, static_cast<uchar>(16 + (row + seq) % 220));
+        }
+        std::fill(y + width * height, y + m_i420.size(), static_cast<uchar>(128));
+    }
+
+    quint64 pushFrame(FrameStream *stream, quint64 seq)
+    {
+        if (m_options.source == QLatin1String("i420")) {
+            fillI420(seq);
+            return stream->push(reinterpret_cast<const uchar *>(m_i420.constData()), m_options.size, FrameStream::PixelFormat::I420);
+        }
+        paintFrame(seq);
+        return stream->push(m_image);
+    }
+
+    ModeResult runMode(const QString &mode)
+    {
+        ModeResult result;
+        result.mode = mode;
+        const bool bridgeMode = mode == QLatin1String("base64");
+
+        auto pane = std::make_unique<WebEnginePane>();
+        pane->resize(m_options.size);
+        pane->show();
+        FrameStream::Options streamOptions;
+        streamOptions.jpegQuality = m_options.jpegQuality;
+        FrameStream *stream = FrameStreamHandler::forProfile(pane->profile())->createStream(QStringLiteral("bench"), streamOptions);
+
+        // base64 基线：C++ 记录每帧的发送时刻，页面绘制后回传 drawn:<seq>
+        QHash<quint64, qint64> sentAtNs;
+        QVector<double> bridgeLatencyMs;
+        ENSURE_QT_CONNECT(pane.get(), &WebEnginePane::messageFromJs, pane.get(), [&sentAtNs, &bridgeLatencyMs](const QString &payload) {
+            if (!payload.startsWith(QLatin1String("drawn:"))) {
+                return;
+            }
+            const auto it = sentAtNs.find(payload.mid(6).toULongLong());
+            if (it != sentAtNs.end()) {
+                bridgeLatencyMs.append((QDeadlineTimer::current().deadlineNSecs() - it.value()) / 1e6);
+                sentAtNs.erase(it);
+            }
+        });
+
+        bool loaded = false;
+        ENSURE_QT_CONNECT(pane.get(), &WebEnginePane::loadFinished, pane.get(), [&loaded](bool ok) {
+            loaded = loaded || ok;
+        });
+        QUrl url(QStringLiteral("qrc:/bench/framestream.html"));
+        url.setQuery(QUrlQuery {{QStringLiteral("mode"), mode}});
+        pane->load(url);
+        if (!BenchSupport::waitUntil([&loaded]() { return loaded; }, kLoadTimeoutMs)) {
+            result.error = QStringLiteral("page did not load");
+            return result;
+        }
+
+        quint64 seq = 0;
+        const auto pushOne = [&]() {
+            ++seq;
+            if (!bridgeMode) {
+                pushFrame(stream, seq);
+                return;
+            }
+            paintFrame(seq);
+            QByteArray jpeg;
+            QBuffer buffer(&jpeg);
+            buffer.open(QIODevice::WriteOnly);
+            m_image.convertToFormat(QImage::Format_RGB888).save(&buffer, "JPEG", m_options.jpegQuality);
+            sentAtNs.insert(seq, QDeadlineTimer::current().deadlineNSecs());
+            pane->broadcastToPage(QStringLiteral("frame:%1:%2").arg(seq).arg(QString::fromLatin1(jpeg.toBase64())));
+        };
+
+        // 预热：直到页面画出第一帧
+        QTimer producer;
+        producer.setTimerType(Qt::PreciseTimer);
+        producer.setInterval(1000 / m_options.fps);
+        ENSURE_QT_CONNECT(&producer, &QTimer::timeout, &producer, pushOne);
+        producer.start();
+        const bool firstFrame = BenchSupport::waitUntil(
+            [&]() {
+                return bridgeMode ? !bridgeLatencyMs.isEmpty() : stream->stats().delivered > 0;
+            },
+            kFirstFrameTimeoutMs);
+        if (!firstFrame) {
+            result.error = QStringLiteral("no frame reached the page");
+            return result;
+        }
+
+        const FrameStream::Stats before = stream->stats();
+        const quint64 seqBefore = seq;
+        const int bridgeBefore = bridgeLatencyMs.size();
+        QElapsedTimer clock;
+        clock.start();
+        BenchSupport::waitUntil([&clock, this]() { return clock.elapsed() >= m_options.durationMs; },
+                                m_options.durationMs + 1000);
+        producer.stop();
+        const double seconds = clock.elapsed() / 1000.0;
+        // 停止推送后等待在途的帧到达，再统计
+        BenchSupport::waitUntil([]() { return false; }, kDrainMs);
+
+        result.pushed = seq - seqBefore;
+        if (bridgeMode) {
+            result.delivered = static_cast<quint64>(bridgeLatencyMs.size() - bridgeBefore);
+            result.dropped = result.pushed > result.delivered ? result.pushed - result.delivered : 0;
+            const QVector<double> measured = bridgeLatencyMs.mid(bridgeBefore);
+            result.latencyP50Ms = BenchSupport::percentile(measured, 0.50);
+            result.latencyP95Ms = BenchSupport::percentile(measured, 0.95);
+        } else {
+            const FrameStream::Stats after = stream->stats();
+            result.delivered = after.delivered - before.delivered;
+            result.dropped = after.dropped - before.dropped;
+            result.latencyP50Ms = after.latencyP50Ms;
+            result.latencyP95Ms = after.latencyP95Ms;
+        }
+        result.deliveredFps = result.delivered / seconds;
+        return result;
+    }
+
+    void print(const QVector<ModeResult> &results) const
+    {
+        QTextStream out(stdout);
+        if (m_options.json) {
+            QJsonArray modes;
+            for (const ModeResult &result : results) {
+                modes.append(QJsonObject {{QStringLiteral("mode"), result.mode},
+                                          {QStringLiteral("pushed"), static_cast<qint64>(result.pushed)},
+                                          {QStringLiteral("delivered"), static_cast<qint64>(result.delivered)},
+                                          {QStringLiteral("dropped"), static_cast<qint64>(result.dropped)},
+                                          {QStringLiteral("deliveredFps"), result.deliveredFps},
+                                          {QStringLiteral("latencyP50Ms"), result.latencyP50Ms},
+                                          {QStringLiteral("latencyP95Ms"), result.latencyP95Ms},
+                                          {QStringLiteral("error"), result.error}});
+            }
+            out << QJsonDocument(QJsonObject {{QStringLiteral("width"), m_options.size.width()},
+                                              {QStringLiteral("height"), m_options.size.height()},
+                                              {QStringLiteral("fps"), m_options.fps},
+                                              {QStringLiteral("source"), m_options.source},
+                                              {QStringLiteral("modes"), modes}})
+                       .toJson(QJsonDocument::Indented);
+            return;
+        }
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(QStringLiteral("mode"), -8)
+                   .arg(QStringLiteral("pushed"), 8)
+                   .arg(QStringLiteral("drawn"), 8)
+                   .arg(QStringLiteral("dropped"), 8)
+                   .arg(QStringLiteral("fps"), 7)
+                   .arg(QStringLiteral("p50 ms"), 8)
+                   .arg(QStringLiteral("p95 ms"), 8);
+        for (const ModeResult &result : results) {
+            out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7")
+                       .arg(result.mode, -8)
+                       .arg(result.pushed, 8)
+                       .arg(result.delivered, 8)
+                       .arg(result.dropped, 8)
+                       .arg(result.deliveredFps, 7, 'f', 1)
+                       .arg(result.latencyP50Ms, 8, 'f', 2)
+                       .arg(result.latencyP95Ms, 8, 'f', 2);
+            if (!result.error.isEmpty()) {
+                out << "  " << result.error;
+            }
+            out << "\n";
+        }
+    }
+
+    BenchOptions m_options;
+    QImage m_image;
+    QByteArray m_i420;
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    FrameStreamHandler::registerScheme();
+
+    // 与 soak_test 相同，固定使用 offscreen 平台与软件渲染
+    BenchSupport::prepareEnvironment(true);
+
+    QApplication app(argc, argv);
+    BenchSupport::initializeApplication(QStringLiteral("framestream_bench"));
+
+    return FrameStreamBench(options).run();
+}
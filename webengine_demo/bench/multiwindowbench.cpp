@@ -0,0 +1,324 @@
+#include "appcontroller.h"
+#include "benchsupport.h"
+#include "bridgerouter.h"
+#include "connectguard.h"
+#include "processstats.h"
+#include "profileregistry.h"
+#include "webenginepane.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QSet>
+#include <QTextStream>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineView>
+
+namespace {
+const QString kResultPrefix = QStringLiteral("MULTIWINDOW_RESULT ");
+constexpr int kLoadTimeoutMs = 60000;
+constexpr int kChildStartupBudgetMs = 90000;
+
+struct BenchOptions
+{
+    int windows {4};
+    int settleMs {3000};
+    int durationMs {10000};
+    int messagesPerSecond {200};
+    int rendererProcessLimit {2};
+    QString probeMode;
+    bool json {false};
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Opens N BrowserWindows once with a shared profile and renderer "
+                                                    "pool and once with independent profiles, broadcasts bridge "
+                                                    "messages through BridgeRouter and compares memory and CPU."));
+    parser.addHelpOption();
+    const QCommandLineOption windowsOption =
+        BenchSupport::intOption("windows", "Windows opened per mode.", "n", options->windows);
+    const QCommandLineOption settleOption = BenchSupport::intOption(
+        "settle-ms", "Idle time after all windows loaded, before measuring.", "ms", options->settleMs);
+    const QCommandLineOption durationOption =
+        BenchSupport::intOption("duration-ms", "Measurement window while broadcasting.", "ms", options->durationMs);
+    const QCommandLineOption rateOption = BenchSupport::intOption(
+        "messages-per-sec", "Router broadcasts per second during measurement.", "n", options->messagesPerSecond);
+    const QCommandLineOption limitOption = BenchSupport::intOption(
+        "renderer-process-limit", "Renderer process limit in shared mode (0 = Chromium default).", "n",
+        options->rendererProcessLimit);
+    const QCommandLineOption probeOption(QStringLiteral("probe"), QStringLiteral("Internal: measure one mode."),
+                                         QStringLiteral("shared|independent"));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({windowsOption, settleOption, durationOption, rateOption, limitOption, probeOption, outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    const auto readInt = [&parser, error](const QCommandLineOption &option, int min, int *out) {
+        return BenchSupport::readInt(parser, option, min, out, error);
+    };
+    if (!readInt(windowsOption, 1, &options->windows) || !readInt(settleOption, 0, &options->settleMs)
+        || !readInt(durationOption, 100, &options->durationMs) || !readInt(rateOption, 0, &options->messagesPerSecond)
+        || !readInt(limitOption, 0, &options->rendererProcessLimit)) {
+        return false;
+    }
+    options->probeMode = parser.value(probeOption);
+    if (!options->probeMode.isEmpty() && options->probeMode != QLatin1String("shared")
+        && options->probeMode != QLatin1String("independent")) {
+        *error = QStringLiteral("--probe must be shared or independent");
+        return false;
+    }
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+double toMiB(qint64 bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+// 浏览器进程与全部 WebEngine 子进程的 RSS / CPU 合计；共享页在各进程 RSS 中会重复计入，结果偏保守
+struct ProcessTreeSample
+{
+    qint64 browserRssBytes {0};
+    qint64 childRssBytes {0};
+    qint64 cpuTimeMs {0};
+    int children {0};
+};
+
+ProcessTreeSample sampleProcessTree()
+{
+    ProcessTreeSample result;
+    const ProcessStats::Sample self = ProcessStats::sampleSelf();
+    result.browserRssBytes = qMax<qint64>(0, self.rssBytes);
+    result.cpuTimeMs = qMax<qint64>(0, self.cpuTimeMs);
+    for (const qint64 pid : ProcessStats::descendantPids(ProcessStats::currentPid())) {
+        const ProcessStats::Sample child = ProcessStats::sample(pid);
+        result.childRssBytes += qMax<qint64>(0, child.rssBytes);
+        result.cpuTimeMs += qMax<qint64>(0, child.cpuTimeMs);
+        ++result.children;
+    }
+    return result;
+}
+
+void waitFor(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// 在当前进程中按一种模式打开窗口并测量，结果以带前缀的 JSON 行写到 stdout
+int runProbe(const BenchOptions &options)
+{
+    const bool shared = options.probeMode == QLatin1String("shared");
+    AppController::Options controllerOptions;
+    controllerOptions.windows = options.windows;
+    controllerOptions.sharedProfile = shared;
+    AppController controller(controllerOptions);
+
+    int loaded = 0;
+    int failedLoads = 0;
+    QEventLoop loadLoop;
+    ENSURE_QT_CONNECT(&controller, &AppController::windowLoaded, &loadLoop, [&](int, bool ok) {
+        ++loaded;
+        failedLoads += ok ? 0 : 1;
+        if (loaded == options.windows) {
+            loadLoop.quit();
+        }
+    });
+    QElapsedTimer loadClock;
+    loadClock.start();
+    controller.start();
+    for (const int windowId : controller.windowIds()) {
+        controller.window(windowId)->show();
+    }
+    QTimer::singleShot(kLoadTimeoutMs, &loadLoop, &QEventLoop::quit);
+    loadLoop.exec();
+    const qint64 loadMs = loadClock.elapsed();
+    if (loaded < options.windows) {
+        QTextStream(stderr) << "multiwindow_bench: only " << loaded << " of " << options.windows << " windows loaded\n";
+        return 1;
+    }
+
+    waitFor(options.settleMs);
+    const ProcessTreeSample idle = sampleProcessTree();
+
+    // 测量期间经 BridgeRouter 广播，观察共享与独立两种模式下消息分发的 CPU 开销
+    QElapsedTimer busyClock;
+    busyClock.start();
+    int sequence = 0;
+    QTimer broadcaster;
+    if (options.messagesPerSecond > 0) {
+        broadcaster.setInterval(qMax(1, 1000 / options.messagesPerSecond));
+        ENSURE_QT_CONNECT(&broadcaster, &QTimer::timeout, &controller, [&controller, &sequence]() {
+            controller.router()->broadcast(QJsonObject {{QStringLiteral("type"), QStringLiteral("bench")},
+                                                        {QStringLiteral("seq"), ++sequence}});
+        });
+        broadcaster.start();
+    }
+    waitFor(options.durationMs);
+    broadcaster.stop();
+    const qint64 busyMs = busyClock.elapsed();
+    const ProcessTreeSample busy = sampleProcessTree();
+
+    QSet<qint64> renderers;
+    for (const int windowId : controller.windowIds()) {
+        WebEnginePane *pane = controller.window(windowId)->engine();
+        if (pane && pane->view()->page()) {
+            renderers.insert(pane->view()->page()->renderProcessPid());
+        }
+    }
+    renderers.remove(0);
+
+    const BridgeRouter::Stats routerStats = controller.router()->stats();
+    const QJsonObject result {
+        {QStringLiteral("mode"), options.probeMode},
+        {QStringLiteral("windows"), options.windows},
+        {QStringLiteral("profiles"), controller.profiles()->profileCount()},
+        {QStringLiteral("rendererProcesses"), renderers.size()},
+        {QStringLiteral("childProcesses"), busy.children},
+        {QStringLiteral("loadMs"), loadMs},
+        {QStringLiteral("failedLoads"), failedLoads},
+        {QStringLiteral("browserRssMiB"), toMiB(idle.browserRssBytes)},
+        {QStringLiteral("childRssMiB"), toMiB(idle.childRssBytes)},
+        {QStringLiteral("totalRssMiB"), toMiB(idle.browserRssBytes + idle.childRssBytes)},
+        {QStringLiteral("cpuPercent"), busyMs > 0 ? 100.0 * (busy.cpuTimeMs - idle.cpuTimeMs) / busyMs : 0.0},
+        {QStringLiteral("broadcasts"), routerStats.broadcasts},
+        {QStringLiteral("serializations"), routerStats.serializations},
+        {QStringLiteral("deliveries"), routerStats.deliveries},
+    };
+    QTextStream(stdout) << kResultPrefix << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+    return 0;
+}
+
+QJsonObject runMode(const BenchOptions &options, const QString &mode, QString *error)
+{
+    QProcess child;
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    QString flags = environment.value(QStringLiteral("QTWEBENGINE_CHROMIUM_FLAGS"));
+    if (mode == QLatin1String("shared") && options.rendererProcessLimit > 0) {
+        flags += QStringLiteral(" --renderer-process-limit=%1").arg(options.rendererProcessLimit);
+    }
+    environment.insert(QStringLiteral("QTWEBENGINE_CHROMIUM_FLAGS"), flags.trimmed());
+    child.setProcessEnvironment(environment);
+    child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    child.start(QCoreApplication::applicationFilePath(),
+                {QStringLiteral("--probe"), mode,
+                 QStringLiteral("--windows"), QString::number(options.windows),
+                 QStringLiteral("--settle-ms"), QString::number(options.settleMs),
+                 QStringLiteral("--duration-ms"), QString::number(options.durationMs),
+                 QStringLiteral("--messages-per-sec"), QString::number(options.messagesPerSecond)});
+
+    if (!child.waitForFinished(options.settleMs + options.durationMs + kChildStartupBudgetMs)) {
+        child.kill();
+        child.waitForFinished();
+        *error = QStringLiteral("child process timed out");
+        return {};
+    }
+    // 子进程可能混有 Chromium 日志，只取带前缀的结果行
+    const QStringList lines = QString::fromLocal8Bit(child.readAllStandardOutput()).split(QLatin1Char('\n'));
+    for (auto it = lines.crbegin(); it != lines.crend(); ++it) {
+        const QString line = it->trimmed();
+        if (!line.startsWith(kResultPrefix)) {
+            continue;
+        }
+        const QJsonDocument document = QJsonDocument::fromJson(line.mid(kResultPrefix.size()).toUtf8());
+        if (document.isObject()) {
+            return document.object();
+        }
+    }
+    *error = QStringLiteral("no result (exit code %1)").arg(child.exitCode());
+    return {};
+}
+
+int runComparison(const BenchOptions &options)
+{
+    QJsonObject results;
+    for (const QString &mode : {QStringLiteral("independent"), QStringLiteral("shared")}) {
+        QTextStream(stderr) << "multiwindow_bench: measuring " << mode << " with " << options.windows << " windows\n";
+        QString error;
+        const QJsonObject result = runMode(options, mode, &error);
+        if (!error.isEmpty()) {
+            QTextStream(stderr) << "multiwindow_bench: " << mode << " failed: " << error << "\n";
+            return 1;
+        }
+        results.insert(mode, result);
+    }
+
+    const QJsonObject independent = results.value(QStringLiteral("independent")).toObject();
+    const QJsonObject shared = results.value(QStringLiteral("shared")).toObject();
+    const auto ratio = [&](const char *key) {
+        const double base = independent.value(QLatin1String(key)).toDouble();
+        return base > 0.0 ? shared.value(QLatin1String(key)).toDouble() / base : 0.0;
+    };
+    results.insert(QStringLiteral("sharedToIndependent"),
+                   QJsonObject {{QStringLiteral("totalRss"), ratio("totalRssMiB")},
+                                {QStringLiteral("cpu"), ratio("cpuPercent")},
+                                {QStringLiteral("rendererProcesses"), ratio("rendererProcesses")}});
+
+    QTextStream out(stdout);
+    if (options.json) {
+        out << QJsonDocument(results).toJson(QJsonDocument::Indented);
+        return 0;
+    }
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg(QStringLiteral("mode"), -12)
+               .arg(QStringLiteral("profiles"), 9)
+               .arg(QStringLiteral("renderers"), 10)
+               .arg(QStringLiteral("children"), 9)
+               .arg(QStringLiteral("browser MiB"), 12)
+               .arg(QStringLiteral("child MiB"), 10)
+               .arg(QStringLiteral("total MiB"), 10)
+               .arg(QStringLiteral("cpu %"), 7);
+    for (const QJsonObject &result : {independent, shared}) {
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                   .arg(result.value(QStringLiteral("mode")).toString(), -12)
+                   .arg(result.value(QStringLiteral("profiles")).toInt(), 9)
+                   .arg(result.value(QStringLiteral("rendererProcesses")).toInt(), 10)
+                   .arg(result.value(QStringLiteral("childProcesses")).toInt(), 9)
+                   .arg(result.value(QStringLiteral("browserRssMiB")).toDouble(), 12, 'f', 1)
+                   .arg(result.value(QStringLiteral("childRssMiB")).toDouble(), 10, 'f', 1)
+                   .arg(result.value(QStringLiteral("totalRssMiB")).toDouble(), 10, 'f', 1)
+                   .arg(result.value(QStringLiteral("cpuPercent")).toDouble(), 7, 'f', 1);
+    }
+    out << QStringLiteral("shared / independent: total RSS x%1, CPU x%2, router serializations %3 for %4 deliveries\n")
+               .arg(ratio("totalRssMiB"), 0, 'f', 2)
+               .arg(ratio("cpuPercent"), 0, 'f', 2)
+               .arg(shared.value(QStringLiteral("serializations")).toInt())
+               .arg(shared.value(QStringLiteral("deliveries")).toInt());
+    return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    if (options.probeMode.isEmpty()) {
+        // 调度进程本身不创建网页，两种模式分别在子进程中测量，互不影响 Chromium 参数与进程池
+        QCoreApplication controller(argc, argv);
+        return runComparison(options);
+    }
+
+    // 与浸泡测试相同，固定在 offscreen 平台上以软件渲染运行
+    BenchSupport::prepareEnvironment(true);
+
+    QApplication app(argc, argv);
+    BenchSupport::initializeApplication(QStringLiteral("multiwindow_bench"));
+
+    return runProbe(options);
+}
@@ -0,0 +1,449 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "jankmonitor.h"
+#include "pagetimingcollector.h"
+#include "processstats.h"
+#include "profileregistry.h"
+#include "webenginepane.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
+#include <QWebEngineProfile>
+#include <QWebEngineSettings>
+#include <QWebEngineView>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace {
+constexpr int kLoadTimeoutMs = 30000;
+constexpr int kPaintSettleMs = 200;
+
+const QStringList kDefaultPages {
+    QStringLiteral("article.html"),
+    QStringLiteral("table.html"),
+    QStringLiteral("canvas.html"),
+    QStringLiteral("cards.html"),
+    QStringLiteral("spa.html"),
+};
+
+// 读取页面 paint 条目与导航耗时，first-paint 在部分页面上可能缺失
+const char kPaintQuery[] = R"JS(
+(function() {
+  var out = { firstPaintMs: -1, firstContentfulPaintMs: -1, loadEventMs: -1 };
+  try {
+    performance.getEntriesByType('paint').forEach(function(entry) {
+      if (entry.name === 'first-paint') out.firstPaintMs = entry.startTime;
+      if (entry.name === 'first-contentful-paint') out.firstContentfulPaintMs = entry.startTime;
+    });
+    var nav = performance.getEntriesByType('navigation')[0];
+    if (nav && nav.loadEventEnd > 0) out.loadEventMs = nav.loadEventEnd;
+  } catch (e) {}
+  return out;
+})()
+)JS";
+
+struct AttributeName
+{
+    const char *name;
+    QWebEngineSettings::WebAttribute attribute;
+};
+
+const AttributeName kAttributes[] = {
+    {"AutoLoadImages", QWebEngineSettings::AutoLoadImages},
+    {"JavascriptEnabled", QWebEngineSettings::JavascriptEnabled},
+    {"LocalStorageEnabled", QWebEngineSettings::LocalStorageEnabled},
+    {"Accelerated2dCanvasEnabled", QWebEngineSettings::Accelerated2dCanvasEnabled},
+    {"WebGLEnabled", QWebEngineSettings::WebGLEnabled},
+    {"ScrollAnimatorEnabled", QWebEngineSettings::ScrollAnimatorEnabled},
+    {"PluginsEnabled", QWebEngineSettings::PluginsEnabled},
+    {"DnsPrefetchEnabled", QWebEngineSettings::DnsPrefetchEnabled},
+    {"SpatialNavigationEnabled", QWebEngineSettings::SpatialNavigationEnabled},
+    {"ShowScrollBars", QWebEngineSettings::ShowScrollBars},
+    {"PdfViewerEnabled", QWebEngineSettings::PdfViewerEnabled},
+};
+
+struct BenchOptions
+{
+    QStringList pages;
+    int iterations {5};
+    bool cold {true};
+    bool warm {true};
+    bool json {false};
+    // true 时经本机 HTTP 服务加载，false 时经 bench:// scheme（不经过 HTTP 缓存）
+    bool http {true};
+    bool hasCacheType {false};
+    QWebEngineProfile::HttpCacheType cacheType {QWebEngineProfile::DiskHttpCache};
+    QVector<QPair<QWebEngineSettings::WebAttribute, bool>> attributes;
+    QStringList attributeLabels;
+};
+
+struct LoadSample
+{
+    double loadMs {0.0};
+    double firstPaintMs {-1.0};
+    double firstContentfulPaintMs {-1.0};
+    qint64 rendererRssBytes {-1};
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Loads the bundled corpus through WebEnginePane and reports "
+                                                    "load / first-paint percentiles and renderer memory."));
+    parser.addHelpOption();
+    const QCommandLineOption iterationsOption =
+        BenchSupport::intOption("iterations", "Loads per page and mode.", "n", options->iterations);
+    const QCommandLineOption pagesOption(QStringLiteral("pages"),
+                                         QStringLiteral("Comma separated corpus pages."),
+                                         QStringLiteral("list"),
+                                         kDefaultPages.join(QLatin1Char(',')));
+    const QCommandLineOption modeOption(QStringLiteral("mode"),
+                                        QStringLiteral("cold, warm or both."),
+                                        QStringLiteral("mode"),
+                                        QStringLiteral("both"));
+    const QCommandLineOption setOption(QStringLiteral("set"),
+                                       QStringLiteral("WebEngine attribute override, e.g. WebGLEnabled=off. Repeatable."),
+                                       QStringLiteral("attr=on|off"));
+    const QCommandLineOption sourceOption(QStringLiteral("source"),
+                                          QStringLiteral("http (loopback server, cacheable) or scheme (bench://, never cached)."),
+                                          QStringLiteral("source"),
+                                          QStringLiteral("http"));
+    const QCommandLineOption cacheOption(QStringLiteral("http-cache"),
+                                         QStringLiteral("none, memory or disk."),
+                                         QStringLiteral("type"));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    const QCommandLineOption offscreenOption(QStringLiteral("offscreen"),
+                                             QStringLiteral("Use the offscreen platform with software rendering."));
+    parser.addOptions(
+        {iterationsOption, pagesOption, modeOption, sourceOption, setOption, cacheOption, outputOption, offscreenOption});
+    if (!BenchSupport::parse(parser, arguments, error)
+        || !BenchSupport::readInt(parser, iterationsOption, 1, &options->iterations, error)) {
+        return false;
+    }
+    options->pages = parser.value(pagesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    if (options->pages.isEmpty()) {
+        *error = QStringLiteral("--pages is empty");
+        return false;
+    }
+
+    const QString mode = parser.value(modeOption).toLower();
+    if (mode != QLatin1String("cold") && mode != QLatin1String("warm") && mode != QLatin1String("both")) {
+        *error = QStringLiteral("--mode must be cold, warm or both");
+        return false;
+    }
+    options->cold = mode != QLatin1String("warm");
+    options->warm = mode != QLatin1String("cold");
+
+    const QString source = parser.value(sourceOption).toLower();
+    if (source != QLatin1String("http") && source != QLatin1String("scheme")) {
+        *error = QStringLiteral("--source must be http or scheme");
+        return false;
+    }
+    options->http = source == QLatin1String("http");
+
+    for (const QString &assignment : parser.values(setOption)) {
+        const QString name = assignment.section(QLatin1Char('='), 0, 0);
+        const QString value = assignment.section(QLatin1Char('='), 1).toLower();
+        const auto found = std::find_if(std::begin(kAttributes), std::end(kAttributes), [&name](const AttributeName &entry) {
+            return name == QLatin1String(entry.name);
+        });
+        if (found == std::end(kAttributes) || (value != QLatin1String("on") && value != QLatin1String("off"))) {
+            *error = QStringLiteral("Unknown --set value: %1").arg(assignment);
+            return false;
+        }
+        options->attributes.append({found->attribute, value == QLatin1String("on")});
+        options->attributeLabels << assignment;
+    }
+
+    if (parser.isSet(cacheOption)) {
+        const QString cache = parser.value(cacheOption).toLower();
+        options->hasCacheType = true;
+        if (cache == QLatin1String("none")) {
+            options->cacheType = QWebEngineProfile::NoCache;
+        } else if (cache == QLatin1String("memory")) {
+            options->cacheType = QWebEngineProfile::MemoryHttpCache;
+        } else if (cache == QLatin1String("disk")) {
+            options->cacheType = QWebEngineProfile::DiskHttpCache;
+        } else {
+            *error = QStringLiteral("--http-cache must be none, memory or disk");
+            return false;
+        }
+    }
+
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+class PageLoadBench final
+{
+public:
+    explicit PageLoadBench(const BenchOptions &options)
+        : m_options(options)
+    {
+    }
+
+    int run()
+    {
+        if (m_options.http && !m_http.listen()) {
+            return 2;
+        }
+        QJsonArray results;
+        for (const QString &page : std::as_const(m_options.pages)) {
+            if (m_options.cold) {
+                results.append(summarize(page, QStringLiteral("cold"), runCold(page)));
+            }
+            if (m_options.warm) {
+                results.append(summarize(page, QStringLiteral("warm"), runWarm(page)));
+            }
+        }
+        print(results);
+        return m_failures == 0 ? 0 : 1;
+    }
+
+private:
+    // 每个 pane 使用新的命名 profile，缓存与存储目录放在临时目录中：从空缓存开始，也不触碰用户的 DemoProfile
+    std::unique_ptr<WebEnginePane> createPane()
+    {
+        m_storage = std::make_unique<QTemporaryDir>();
+        SharedProfile *shared = m_profiles.acquire(QStringLiteral("pageload-bench-%1").arg(++m_profileSerial));
+        QWebEngineProfile *profile = shared->profile();
+        profile->setCachePath(m_storage->filePath(QStringLiteral("cache")));
+        profile->setPersistentStoragePath(m_storage->filePath(QStringLiteral("storage")));
+        if (m_options.hasCacheType) {
+            profile->setHttpCacheType(m_options.cacheType);
+        }
+        m_handler.install(profile);
+
+        auto pane = std::make_unique<WebEnginePane>(nullptr, nullptr, shared);
+        // 帧监控的 rAF 循环与计时脚本都不属于被测对象
+        pane->jankMonitor()->setEnabled(false);
+        pane->timingCollector()->setEnabled(false);
+
+        auto *settings = pane->view()->page()->settings();
+        for (const auto &attribute : std::as_const(m_options.attributes)) {
+            settings->setAttribute(attribute.first, attribute.second);
+        }
+        pane->resize(1280, 800);
+        pane->show();
+        return pane;
+    }
+
+    void destroyPane(std::unique_ptr<WebEnginePane> pane)
+    {
+        pane.reset();
+        // ProfileRegistry 在事件循环中回收不再使用的 profile，等它销毁后再删除临时目录
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QCoreApplication::processEvents();
+        m_storage.reset();
+    }
+
+    QUrl pageUrl(const QString &page) const
+    {
+        return m_options.http ? m_http.url(page) : CorpusSchemeHandler::url(page);
+    }
+
+    QVector<LoadSample> runCold(const QString &page)
+    {
+        QVector<LoadSample> samples;
+        for (int i = 0; i < m_options.iterations; ++i) {
+            // 每轮都是全新的 profile：空的 HTTP 缓存与新的渲染进程
+            auto pane = createPane();
+            LoadSample sample;
+            if (measureLoad(pane.get(), page, &sample)) {
+                samples.append(sample);
+            }
+            destroyPane(std::move(pane));
+        }
+        return samples;
+    }
+
+    QVector<LoadSample> runWarm(const QString &page)
+    {
+        QVector<LoadSample> samples;
+        auto pane = createPane();
+        LoadSample primer;
+        if (measureLoad(pane.get(), page, &primer)) {
+            for (int i = 0; i < m_options.iterations; ++i) {
+                LoadSample sample;
+                if (measureLoad(pane.get(), page, &sample)) {
+                    samples.append(sample);
+                }
+            }
+        }
+        destroyPane(std::move(pane));
+        return samples;
+    }
+
+    bool measureLoad(WebEnginePane *pane, const QString &page, LoadSample *sample)
+    {
+        QEventLoop loop;
+        bool ok = false;
+        bool timedOut = false;
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        ENSURE_QT_CONNECT(&timeout, &QTimer::timeout, &loop, [&loop, &timedOut]() {
+            timedOut = true;
+            loop.quit();
+        });
+        const auto connection = QObject::connect(pane, &WebEnginePane::loadFinished, &loop, [&loop, &ok](bool success) {
+            ok = success;
+            loop.quit();
+        });
+        ConnectGuard::verify(connection, "WebEnginePane::loadFinished", __FILE__, __LINE__);
+
+        QElapsedTimer clock;
+        clock.start();
+        timeout.start(kLoadTimeoutMs);
+        pane->load(pageUrl(page));
+        loop.exec();
+        sample->loadMs = clock.nsecsElapsed() / 1e6;
+        QObject::disconnect(connection);
+
+        if (timedOut || !ok) {
+            qWarning().noquote() << "PageLoadBench:" << page << (timedOut ? "timed out" : "failed to load");
+            ++m_failures;
+            return false;
+        }
+
+        // paint 条目在 load 之后才稳定，稍等一帧再读取
+        QTimer::singleShot(kPaintSettleMs, &loop, &QEventLoop::quit);
+        loop.exec();
+
+        // 回调可能晚于超时返回，结果与事件循环都不能按引用捕获
+        auto paint = std::make_shared<QVariantMap>();
+        QPointer<QEventLoop> guard(&loop);
+        pane->view()->page()->runJavaScript(QString::fromLatin1(kPaintQuery), [guard, paint](const QVariant &result) {
+            *paint = result.toMap();
+            if (guard) {
+                guard->quit();
+            }
+        });
+        timeout.start(kLoadTimeoutMs);
+        loop.exec();
+
+        sample->firstPaintMs = paint->value(QStringLiteral("firstPaintMs"), -1.0).toDouble();
+        sample->firstContentfulPaintMs = paint->value(QStringLiteral("firstContentfulPaintMs"), -1.0).toDouble();
+        sample->rendererRssBytes = ProcessStats::sample(pane->view()->page()->renderProcessPid()).rssBytes;
+        return true;
+    }
+
+    QJsonObject summarize(const QString &page, const QString &mode, const QVector<LoadSample> &samples) const
+    {
+        QVector<double> load;
+        QVector<double> firstPaint;
+        QVector<double> firstContentfulPaint;
+        QVector<double> rss;
+        for (const LoadSample &sample : samples) {
+            load << sample.loadMs;
+            firstPaint << sample.firstPaintMs;
+            firstContentfulPaint << sample.firstContentfulPaintMs;
+            rss << (sample.rendererRssBytes >= 0 ? sample.rendererRssBytes / (1024.0 * 1024.0) : -1.0);
+        }
+        const auto distribution = [](const QVector<double> &values) {
+            return QJsonObject {
+                {QStringLiteral("p50"), BenchSupport::percentile(values, 0.50)},
+                {QStringLiteral("p90"), BenchSupport::percentile(values, 0.90)},
+                {QStringLiteral("p95"), BenchSupport::percentile(values, 0.95)},
+            };
+        };
+        return QJsonObject {
+            {QStringLiteral("page"), page},
+            {QStringLiteral("mode"), mode},
+            {QStringLiteral("samples"), samples.size()},
+            {QStringLiteral("loadMs"), distribution(load)},
+            {QStringLiteral("firstPaintMs"), distribution(firstPaint)},
+            {QStringLiteral("firstContentfulPaintMs"), distribution(firstContentfulPaint)},
+            {QStringLiteral("rendererRssMiB"), distribution(rss)},
+        };
+    }
+
+    void print(const QJsonArray &results) const
+    {
+        QTextStream out(stdout);
+        if (m_options.json) {
+            const QJsonObject report {
+                {QStringLiteral("iterations"), m_options.iterations},
+                {QStringLiteral("source"), m_options.http ? QStringLiteral("http") : QStringLiteral("scheme")},
+                {QStringLiteral("settings"), QJsonArray::fromStringList(m_options.attributeLabels)},
+                {QStringLiteral("failures"), m_failures},
+                {QStringLiteral("results"), results},
+            };
+            out << QJsonDocument(report).toJson(QJsonDocument::Indented);
+            return;
+        }
+
+        const auto cell = [](const QJsonObject &distribution, const char *key) {
+            const double value = distribution.value(QLatin1String(key)).toDouble(-1.0);
+            return value < 0.0 ? QStringLiteral("-") : QString::number(value, 'f', 1);
+        };
+        out << "source: " << (m_options.http ? "http" : "scheme") << "\n";
+        out << "settings: " << (m_options.attributeLabels.isEmpty() ? QStringLiteral("default")
+                                                                    : m_options.attributeLabels.join(QLatin1Char(' ')))
+            << "\n";
+        out << QStringLiteral("%1 %2 %3  %4  %5  %6\n")
+                   .arg(QStringLiteral("page"), -14)
+                   .arg(QStringLiteral("mode"), -5)
+                   .arg(QStringLiteral("n"), 3)
+                   .arg(QStringLiteral("load p50/p90/p95 ms"), -24)
+                   .arg(QStringLiteral("fcp p50/p90/p95 ms"), -24)
+                   .arg(QStringLiteral("renderer rss p50/p95 MiB"));
+        for (const QJsonValue &value : results) {
+            const QJsonObject row = value.toObject();
+            const QJsonObject load = row.value(QStringLiteral("loadMs")).toObject();
+            const QJsonObject fcp = row.value(QStringLiteral("firstContentfulPaintMs")).toObject();
+            const QJsonObject rss = row.value(QStringLiteral("rendererRssMiB")).toObject();
+            out << QStringLiteral("%1 %2 %3  %4  %5  %6\n")
+                       .arg(row.value(QStringLiteral("page")).toString(), -14)
+                       .arg(row.value(QStringLiteral("mode")).toString(), -5)
+                       .arg(row.value(QStringLiteral("samples")).toInt(), 3)
+                       .arg(cell(load, "p50") + QLatin1Char('/') + cell(load, "p90") + QLatin1Char('/') + cell(load, "p95"), -24)
+                       .arg(cell(fcp, "p50") + QLatin1Char('/') + cell(fcp, "p90") + QLatin1Char('/') + cell(fcp, "p95"), -24)
+                       .arg(cell(rss, "p50") + QLatin1Char('/') + cell(rss, "p95"));
+        }
+        if (m_failures > 0) {
+            out << "failed loads: " << m_failures << "\n";
+        }
+    }
+
+    BenchOptions m_options;
+    CorpusSchemeHandler m_handler;
+    CorpusHttpServer m_http;
+    ProfileRegistry m_profiles;
+    std::unique_ptr<QTemporaryDir> m_storage;
+    int m_profileSerial {0};
+    int m_failures {0};
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    CorpusSchemeHandler::registerScheme();
+    BenchSupport::prepareEnvironment(arguments.contains(QStringLiteral("--offscreen")));
+
+    QApplication app(argc, argv);
+    BenchSupport::initializeApplication(QStringLiteral("pageload_bench"));
+
+    PageLoadBench bench(options);
+    return bench.run();
+}
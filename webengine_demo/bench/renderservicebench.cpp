@@ -0,0 +1,315 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "shardchannel.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr int kConnectTimeoutMs = 5000;
+
+struct BenchOptions
+{
+    QString socketName;
+    int clients {4};
+    int jobsPerClient {50};
+    // 每个客户端同时在途的任务数
+    int inFlight {4};
+    QString type {QStringLiteral("text")};
+    QString url {QStringLiteral("data:text/html,<h1>render service</h1><p>bench</p>")};
+    QString script {QStringLiteral("document.title")};
+    double highFraction {0.1};
+    int deadlineMs {0};
+    int timeoutMs {300000};
+    bool json {false};
+};
+
+// 每个客户端一条连接，自己编号任务，按 --in-flight 保持流水线
+struct Client
+{
+    int index {0};
+    ShardChannel *channel {nullptr};
+    QHash<QString, qint64> submittedAtNs;
+    int submitted {0};
+    int done {0};
+    int failed {0};
+    qint64 bytes {0};
+    QVector<double> latencyMs;
+    QVector<double> highLatencyMs;
+    QVector<double> waitMs;
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Submits jobs to a running WebEngineDemo --render-service from "
+                                                    "several clients and reports throughput, latency and queue wait."));
+    parser.addHelpOption();
+    const QCommandLineOption socketOption(QStringLiteral("socket"), QStringLiteral("Service socket name or path."),
+                                          QStringLiteral("name"));
+    const QCommandLineOption clientsOption(QStringLiteral("clients"), QStringLiteral("Concurrent client connections."),
+                                           QStringLiteral("n"), QString::number(options->clients));
+    const QCommandLineOption jobsOption(QStringLiteral("jobs"), QStringLiteral("Jobs per client."), QStringLiteral("n"),
+                                        QString::number(options->jobsPerClient));
+    const QCommandLineOption inFlightOption(QStringLiteral("in-flight"), QStringLiteral("Outstanding jobs per client."),
+                                            QStringLiteral("n"), QString::number(options->inFlight));
+    const QCommandLineOption typeOption(QStringLiteral("type"), QStringLiteral("render, eval or text."),
+                                        QStringLiteral("type"), options->type);
+    const QCommandLineOption urlOption(QStringLiteral("url"), QStringLiteral("Page to load for every job."),
+                                       QStringLiteral("url"), options->url);
+    const QCommandLineOption scriptOption(QStringLiteral("script"), QStringLiteral("Script for eval jobs."),
+                                          QStringLiteral("js"), options->script);
+    const QCommandLineOption highOption(QStringLiteral("high-fraction"),
+                                        QStringLiteral("Share of jobs submitted with high priority."),
+                                        QStringLiteral("ratio"), QString::number(options->highFraction));
+    const QCommandLineOption deadlineOption(QStringLiteral("deadline-ms"), QStringLiteral("Per-job deadline, 0 for none."),
+                                            QStringLiteral("ms"), QString::number(options->deadlineMs));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout-ms"), QStringLiteral("Time limit for the whole run."),
+                                           QStringLiteral("ms"), QString::number(options->timeoutMs));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({socketOption, clientsOption, jobsOption, inFlightOption, typeOption, urlOption, scriptOption,
+                       highOption, deadlineOption, timeoutOption, outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    options->socketName = parser.value(socketOption);
+    if (options->socketName.isEmpty()) {
+        *error = QStringLiteral("--socket is required");
+        return false;
+    }
+    options->clients = qMax(1, parser.value(clientsOption).toInt());
+    options->jobsPerClient = qMax(1, parser.value(jobsOption).toInt());
+    options->inFlight = qMax(1, parser.value(inFlightOption).toInt());
+    options->type = parser.value(typeOption);
+    options->url = parser.value(urlOption);
+    options->script = parser.value(scriptOption);
+    options->highFraction = qBound(0.0, parser.value(highOption).toDouble(), 1.0);
+    options->deadlineMs = qMax(0, parser.value(deadlineOption).toInt());
+    options->timeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+class Bench final : public QObject
+{
+public:
+    explicit Bench(const BenchOptions &options)
+        : m_options(options)
+    {
+    }
+
+    bool start(QString *error)
+    {
+        for (int i = 0; i < m_options.clients; ++i) {
+            auto *socket = new QLocalSocket;
+            socket->connectToServer(m_options.socketName);
+            if (!socket->waitForConnected(kConnectTimeoutMs)) {
+                *error = QStringLiteral("cannot connect to %1: %2").arg(m_options.socketName, socket->errorString());
+                delete socket;
+                return false;
+            }
+            auto client = std::make_unique<Client>();
+            client->index = i;
+            client->channel = new ShardChannel(socket, this);
+            Client *raw = client.get();
+            ENSURE_QT_CONNECT(raw->channel, &ShardChannel::received, this, [this, raw](const QJsonObject &event) {
+                handleEvent(raw, event);
+            });
+            ENSURE_QT_CONNECT(raw->channel, &ShardChannel::disconnected, this, [this]() {
+                finish(QStringLiteral("service disconnected"));
+            });
+            m_clients.push_back(std::move(client));
+        }
+        m_clock.start();
+        for (const auto &client : m_clients) {
+            for (int i = 0; i < m_options.inFlight; ++i) {
+                submitNext(client.get());
+            }
+        }
+        QTimer::singleShot(m_options.timeoutMs, this, [this]() {
+            finish(QStringLiteral("timed out"));
+        });
+        return true;
+    }
+
+    int exec()
+    {
+        QCoreApplication::exec();
+        return m_error.isEmpty() ? 0 : 1;
+    }
+
+    void print() const
+    {
+        QVector<double> latency;
+        QVector<double> highLatency;
+        QVector<double> wait;
+        int done = 0;
+        int failed = 0;
+        qint64 bytes = 0;
+        QJsonArray perClient;
+        for (const auto &client : m_clients) {
+            latency += client->latencyMs;
+            highLatency += client->highLatencyMs;
+            wait += client->waitMs;
+            done += client->done;
+            failed += client->failed;
+            bytes += client->bytes;
+            perClient.append(QJsonObject {{QStringLiteral("client"), client->index},
+                                          {QStringLiteral("done"), client->done},
+                                          {QStringLiteral("failed"), client->failed},
+                                          {QStringLiteral("p95Ms"), BenchSupport::percentile(client->latencyMs, 0.95)}});
+        }
+        const double seconds = qMax<qint64>(1, m_elapsedMs) / 1000.0;
+        QJsonObject result {{QStringLiteral("clients"), m_options.clients},
+                            {QStringLiteral("jobs"), done},
+                            {QStringLiteral("failed"), failed},
+                            {QStringLiteral("elapsedMs"), m_elapsedMs},
+                            {QStringLiteral("jobsPerSecond"), (done - failed) / seconds},
+                            {QStringLiteral("resultBytes"), bytes},
+                            {QStringLiteral("latencyP50Ms"), BenchSupport::percentile(latency, 0.50)},
+                            {QStringLiteral("latencyP95Ms"), BenchSupport::percentile(latency, 0.95)},
+                            {QStringLiteral("highPriorityP95Ms"), BenchSupport::percentile(highLatency, 0.95)},
+                            {QStringLiteral("queueWaitP50Ms"), BenchSupport::percentile(wait, 0.50)},
+                            {QStringLiteral("queueWaitP95Ms"), BenchSupport::percentile(wait, 0.95)},
+                            {QStringLiteral("perClient"), perClient},
+                            {QStringLiteral("service"), m_serviceStats},
+                            {QStringLiteral("error"), m_error}};
+
+        QTextStream out(stdout);
+        if (m_options.json) {
+            out << QJsonDocument(result).toJson(QJsonDocument::Indented);
+            return;
+        }
+        out << "Jobs: " << done << " (" << failed << " failed) from " << m_options.clients << " clients in "
+            << QString::number(seconds, 'f', 2) << " s, " << QString::number((done - failed) / seconds, 'f', 1) << " jobs/s\n";
+        out << "Latency p50 / p95: " << QString::number(BenchSupport::percentile(latency, 0.50), 'f', 1) << " / "
+            << QString::number(BenchSupport::percentile(latency, 0.95), 'f', 1) << " ms, high priority p95: "
+            << QString::number(BenchSupport::percentile(highLatency, 0.95), 'f', 1) << " ms\n";
+        out << "Queue wait p50 / p95: " << QString::number(BenchSupport::percentile(wait, 0.50), 'f', 1) << " / "
+            << QString::number(BenchSupport::percentile(wait, 0.95), 'f', 1) << " ms\n";
+        if (!m_serviceStats.isEmpty()) {
+            out << "Pool utilization: " << QString::number(m_serviceStats.value(QStringLiteral("utilization")).toDouble() * 100.0, 'f', 1)
+                << "% of " << m_serviceStats.value(QStringLiteral("poolSize")).toInt() << " panes\n";
+        }
+        if (!m_error.isEmpty()) {
+            out << "ERROR " << m_error << "\n";
+        }
+    }
+
+private:
+    void submitNext(Client *client)
+    {
+        if (client->submitted >= m_options.jobsPerClient) {
+            return;
+        }
+        const int sequence = client->submitted++;
+        // 按比例均匀地插入高优先级任务，观察它们越过普通任务的排队时间
+        const bool high = m_options.highFraction > 0.0
+                          && static_cast<int>((sequence + 1) * m_options.highFraction) > static_cast<int>(sequence * m_options.highFraction);
+        const QString id = QStringLiteral("%1-%2%3").arg(client->index).arg(sequence).arg(high ? QStringLiteral("h") : QString());
+        QJsonObject command {{QStringLiteral("cmd"), QStringLiteral("submit")},
+                             {QStringLiteral("id"), id},
+                             {QStringLiteral("type"), m_options.type},
+                             {QStringLiteral("url"), m_options.url},
+                             {QStringLiteral("priority"), high ? QStringLiteral("high") : QStringLiteral("normal")}};
+        if (m_options.type == QLatin1String("eval")) {
+            command.insert(QStringLiteral("script"), m_options.script);
+        }
+        if (m_options.deadlineMs > 0) {
+            command.insert(QStringLiteral("deadlineMs"), m_options.deadlineMs);
+        }
+        client->submittedAtNs.insert(id, m_clock.nsecsElapsed());
+        client->channel->send(command);
+    }
+
+    void handleEvent(Client *client, const QJsonObject &event)
+    {
+        const QString name = event.value(QStringLiteral("evt")).toString();
+        if (name == QLatin1String("stats")) {
+            m_serviceStats = event;
+            QCoreApplication::quit();
+            return;
+        }
+        const QString id = event.value(QStringLiteral("id")).toString();
+        if (name == QLatin1String("chunk")) {
+            client->bytes += event.value(QStringLiteral("data")).toString().size() * 3 / 4
+                             + event.value(QStringLiteral("text")).toString().size();
+            return;
+        }
+        if (name != QLatin1String("done")) {
+            return;
+        }
+        const qint64 submittedAt = client->submittedAtNs.take(id);
+        ++client->done;
+        if (event.value(QStringLiteral("ok")).toBool()) {
+            const double latency = (m_clock.nsecsElapsed() - submittedAt) / 1e6;
+            client->latencyMs.append(latency);
+            if (id.endsWith(QLatin1Char('h'))) {
+                client->highLatencyMs.append(latency);
+            }
+            client->waitMs.append(event.value(QStringLiteral("waitMs")).toDouble());
+        } else {
+            ++client->failed;
+        }
+        submitNext(client);
+
+        const bool allDone = std::all_of(m_clients.cbegin(), m_clients.cend(), [this](const auto &candidate) {
+            return candidate->done >= m_options.jobsPerClient;
+        });
+        if (allDone) {
+            m_elapsedMs = m_clock.elapsed();
+            m_clients.front()->channel->send(QJsonObject {{QStringLiteral("cmd"), QStringLiteral("stats")}});
+        }
+    }
+
+    void finish(const QString &error)
+    {
+        if (m_error.isEmpty() && m_serviceStats.isEmpty()) {
+            m_error = error;
+            m_elapsedMs = m_clock.elapsed();
+            QCoreApplication::quit();
+        }
+    }
+
+private:
+    BenchOptions m_options;
+    std::vector<std::unique_ptr<Client>> m_clients;
+    QElapsedTimer m_clock;
+    qint64 m_elapsedMs {0};
+    QJsonObject m_serviceStats;
+    QString m_error;
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(QCoreApplication::arguments(), &options, &error)) {
+        return BenchSupport::reportOptionError(QCoreApplication::arguments(), error);
+    }
+
+    Bench bench(options);
+    if (!bench.start(&error)) {
+        QTextStream(stderr) << "renderservice_bench: " << error << "\n";
+        return 1;
+    }
+    const int exitCode = bench.exec();
+    bench.print();
+    return exitCode;
+}
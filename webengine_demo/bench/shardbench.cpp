@@ -0,0 +1,282 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "shardbroker.h"
+#include "shardworker.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr int kReadyTimeoutMs = 90000;
+
+struct BenchOptions
+{
+    QVector<int> shardCounts {1, 2, 4};
+    int panes {8};
+    int messages {2000};
+    int inFlight {16};
+    int timeoutMs {120000};
+    bool json {false};
+};
+
+struct RunResult
+{
+    int shards {0};
+    qint64 delivered {0};
+    qint64 elapsedMs {0};
+    double messagesPerSecond {0.0};
+    double p50Ms {-1.0};
+    double p95Ms {-1.0};
+    int restarts {0};
+    QString error;
+};
+
+bool parseOptions(const QStringList &arguments, BenchOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Spreads panes across K shard worker processes and measures the "
+                                                    "aggregate bridge round-trip throughput for each K."));
+    parser.addHelpOption();
+    const QCommandLineOption shardsOption(QStringLiteral("shards"), QStringLiteral("Comma separated worker counts."),
+                                          QStringLiteral("list"), QStringLiteral("1,2,4"));
+    const QCommandLineOption panesOption =
+        BenchSupport::intOption("panes", "Panes in total, spread across workers.", "n", options->panes);
+    const QCommandLineOption messagesOption =
+        BenchSupport::intOption("messages", "Round trips per pane.", "n", options->messages);
+    const QCommandLineOption inFlightOption =
+        BenchSupport::intOption("in-flight", "Outstanding round trips per pane.", "n", options->inFlight);
+    const QCommandLineOption timeoutOption =
+        BenchSupport::intOption("timeout-ms", "Time limit for one run.", "ms", options->timeoutMs);
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({shardsOption, panesOption, messagesOption, inFlightOption, timeoutOption, outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    const auto readInt = [&parser, error](const QCommandLineOption &option, int min, int *out) {
+        return BenchSupport::readInt(parser, option, min, out, error);
+    };
+    if (!readInt(panesOption, 1, &options->panes) || !readInt(messagesOption, 1, &options->messages)
+        || !readInt(inFlightOption, 1, &options->inFlight) || !readInt(timeoutOption, 1000, &options->timeoutMs)) {
+        return false;
+    }
+    options->shardCounts.clear();
+    for (const QString &value : parser.value(shardsOption).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int shards = value.toInt(&ok);
+        if (!ok || shards < 1) {
+            *error = QStringLiteral("--shards entries must be integers >= 1");
+            return false;
+        }
+        options->shardCounts.append(shards);
+    }
+    if (options->shardCounts.isEmpty()) {
+        *error = QStringLiteral("--shards is empty");
+        return false;
+    }
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+// 每个 pane 保持 --in-flight 个未完成的往返，收到回显后立即补发，直到每个 pane 完成 --messages 次
+RunResult runShards(const BenchOptions &options, int shards)
+{
+    RunResult result;
+    result.shards = shards;
+
+    ShardBroker::Options brokerOptions;
+    brokerOptions.shards = shards;
+    brokerOptions.environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+    ShardBroker broker(brokerOptions);
+    if (!broker.start()) {
+        result.error = QStringLiteral("broker failed to start");
+        return result;
+    }
+
+    int loaded = 0;
+    ENSURE_QT_CONNECT(&broker, &ShardBroker::paneLoaded, &broker, [&loaded](int, bool ok) {
+        loaded += ok ? 1 : 0;
+    });
+    const QJsonObject scripts {{QStringLiteral("shard-echo"), BenchSupport::echoScript(QStringLiteral("shard:"))}};
+    for (int i = 0; i < options.panes; ++i) {
+        broker.openPane(QUrl(QStringLiteral("qrc:/web/index.html")), scripts);
+    }
+
+    QHash<QString, qint64> sentAtNs;
+    QHash<int, int> sent;
+    QHash<int, int> received;
+    QVector<double> latenciesMs;
+    QElapsedTimer clock;
+    clock.start();
+    bool warm = false;
+    const auto sendNext = [&](int paneId) {
+        const int sequence = sent[paneId]++;
+        const QString payload = QStringLiteral("shard:%1:%2").arg(paneId).arg(sequence);
+        sentAtNs.insert(payload, clock.nsecsElapsed());
+        broker.sendToPane(paneId, payload);
+    };
+    ENSURE_QT_CONNECT(&broker, &ShardBroker::paneMessage, &broker, [&](int paneId, const QString &payload) {
+        const auto it = sentAtNs.find(payload);
+        if (it == sentAtNs.end()) {
+            return;
+        }
+        if (warm) {
+            latenciesMs.append((clock.nsecsElapsed() - it.value()) / 1e6);
+        }
+        sentAtNs.erase(it);
+        ++received[paneId];
+        if (warm && sent.value(paneId) < options.messages) {
+            sendNext(paneId);
+        }
+    });
+
+    // 预热：每个 pane 完成一次往返，确保页面、通道与回显脚本都已就绪
+    const QList<int> panes = broker.paneIds();
+    for (const int paneId : panes) {
+        sendNext(paneId);
+    }
+    const bool ready = BenchSupport::waitUntil(
+        [&]() {
+            return std::all_of(panes.cbegin(), panes.cend(), [&received](int paneId) {
+                return received.value(paneId) > 0;
+            });
+        },
+        kReadyTimeoutMs);
+    if (!ready) {
+        result.error = QStringLiteral("panes not ready (%1 of %2 loaded)").arg(loaded).arg(options.panes);
+        return result;
+    }
+
+    sent.clear();
+    received.clear();
+    sentAtNs.clear();
+    warm = true;
+    clock.restart();
+    for (const int paneId : panes) {
+        for (int i = 0; i < qMin(options.inFlight, options.messages); ++i) {
+            sendNext(paneId);
+        }
+    }
+    const qint64 expected = qint64(options.messages) * panes.size();
+    const bool completed = BenchSupport::waitUntil(
+        [&]() {
+            qint64 total = 0;
+            for (const int count : std::as_const(received)) {
+                total += count;
+            }
+            return total >= expected;
+        },
+        options.timeoutMs);
+
+    result.elapsedMs = clock.elapsed();
+    for (const int count : std::as_const(received)) {
+        result.delivered += count;
+    }
+    result.messagesPerSecond = result.elapsedMs > 0 ? result.delivered * 1000.0 / result.elapsedMs : 0.0;
+    result.p50Ms = BenchSupport::percentile(latenciesMs, 0.50);
+    result.p95Ms = BenchSupport::percentile(latenciesMs, 0.95);
+    result.restarts = broker.stats().restarts;
+    if (!completed) {
+        result.error = QStringLiteral("timed out after %1 of %2 round trips").arg(result.delivered).arg(expected);
+    }
+    broker.stop();
+    return result;
+}
+
+void printResults(const BenchOptions &options, const QVector<RunResult> &results)
+{
+    QTextStream out(stdout);
+    const double baseline = results.isEmpty() ? 0.0 : results.constFirst().messagesPerSecond;
+    if (options.json) {
+        QJsonArray runs;
+        for (const RunResult &result : results) {
+            runs.append(QJsonObject {{QStringLiteral("shards"), result.shards},
+                                     {QStringLiteral("delivered"), result.delivered},
+                                     {QStringLiteral("elapsedMs"), result.elapsedMs},
+                                     {QStringLiteral("messagesPerSecond"), result.messagesPerSecond},
+                                     {QStringLiteral("speedup"), baseline > 0.0 ? result.messagesPerSecond / baseline : 0.0},
+                                     {QStringLiteral("p50Ms"), result.p50Ms},
+                                     {QStringLiteral("p95Ms"), result.p95Ms},
+                                     {QStringLiteral("restarts"), result.restarts},
+                                     {QStringLiteral("error"), result.error}});
+        }
+        out << QJsonDocument(QJsonObject {{QStringLiteral("panes"), options.panes},
+                                          {QStringLiteral("messagesPerPane"), options.messages},
+                                          {QStringLiteral("inFlight"), options.inFlight},
+                                          {QStringLiteral("runs"), runs}})
+                   .toJson(QJsonDocument::Indented);
+        return;
+    }
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6\n")
+               .arg(QStringLiteral("shards"), 7)
+               .arg(QStringLiteral("msg/s"), 10)
+               .arg(QStringLiteral("speedup"), 8)
+               .arg(QStringLiteral("p50 ms"), 8)
+               .arg(QStringLiteral("p95 ms"), 8)
+               .arg(QStringLiteral("restarts"), 9);
+    for (const RunResult &result : results) {
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6")
+                   .arg(result.shards, 7)
+                   .arg(result.messagesPerSecond, 10, 'f', 0)
+                   .arg(baseline > 0.0 ? result.messagesPerSecond / baseline : 0.0, 8, 'f', 2)
+                   .arg(result.p50Ms, 8, 'f', 2)
+                   .arg(result.p95Ms, 8, 'f', 2)
+                   .arg(result.restarts, 9);
+        if (!result.error.isEmpty()) {
+            out << "  " << result.error;
+        }
+        out << "\n";
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+
+    QString serverName;
+    int shardIndex = 0;
+    if (ShardWorker::fromArguments(arguments, &serverName, &shardIndex)) {
+        // worker 角色：由 broker 以 offscreen 平台拉起，软件渲染
+        BenchSupport::prepareEnvironment(true);
+        QApplication app(argc, argv);
+        BenchSupport::initializeApplication(QStringLiteral("shard_bench"));
+        QApplication::setQuitOnLastWindowClosed(false);
+        ShardWorker worker(serverName, shardIndex);
+        if (!worker.start()) {
+            return 1;
+        }
+        ENSURE_QT_CONNECT(&worker, &ShardWorker::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        return app.exec();
+    }
+
+    BenchOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    // broker 角色只转发消息，不需要 GUI
+    QCoreApplication app(argc, argv);
+    QVector<RunResult> results;
+    int failures = 0;
+    for (const int shards : std::as_const(options.shardCounts)) {
+        QTextStream(stderr) << "shard_bench: " << shards << " worker(s), " << options.panes << " panes\n";
+        results.append(runShards(options, shards));
+        failures += results.constLast().error.isEmpty() ? 0 : 1;
+    }
+    printResults(options, results);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+#include "connectguard.h"
+#include "processstats.h"
+#include "webenginesignals.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QWebEngineView>
+
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr int kDefaultViews = 100;
+constexpr int kDefaultRounds = 2000;
+
+enum class Wiring
+{
+    // 旧方式：hub 转发全部上游信号，处理函数再连到 hub 信号上（两跳）
+    Eager,
+    // 新方式：hub 不转发任何信号，处理函数在 attachView/attachPage 中直连上游（一跳）
+    Lazy,
+};
+
+// 模拟 WebEnginePaneSignalHandler：只关心少数几个信号，其余信号不处理
+class BenchHub final : public WebEngineSignals
+{
+public:
+    explicit BenchHub(Wiring wiring)
+        : m_wiring(wiring)
+    {
+        if (m_wiring == Wiring::Eager) {
+            listen(&WebEngineSignals::viewUrlChanged);
+            listen(&WebEngineSignals::viewTitleChanged);
+            listen(&WebEngineSignals::viewIconChanged);
+            listen(&WebEngineSignals::viewLoadStarted);
+            listen(&WebEngineSignals::viewLoadProgress);
+            listen(&WebEngineSignals::viewLoadFinished);
+            listen(&WebEngineSignals::viewSelectionChanged);
+            listen(&WebEngineSignals::viewRenderProcessTerminated);
+            listen(&WebEngineSignals::pageLinkHovered);
+            listen(&WebEngineSignals::pageFullScreenRequested);
+            listen(&WebEngineSignals::pageFeaturePermissionRequested);
+            listen(&WebEngineSignals::pageFeaturePermissionRequestCanceled);
+            listen(&WebEngineSignals::pageQuotaRequested);
+            listen(&WebEngineSignals::pageSelectClientCertificate);
+            listen(&WebEngineSignals::pageAuthenticationRequired);
+            listen(&WebEngineSignals::pageProxyAuthenticationRequired);
+            listen(&WebEngineSignals::pageRenderProcessTerminated);
+            listen(&WebEngineSignals::pageWindowCloseRequested);
+            listen(&WebEngineSignals::pageRegisterProtocolHandlerRequested);
+            listen(&WebEngineSignals::pageDownloadRequested);
+        }
+    }
+
+    qint64 events() const { return m_events; }
+    int directConnections() const { return m_directConnections; }
+
+protected:
+    void attachView(QWebEngineView *view) override
+    {
+        if (m_wiring != Wiring::Lazy) {
+            return;
+        }
+        const auto count = [this]() { ++m_events; };
+        ENSURE_QT_CONNECT(view, &QWebEngineView::urlChanged, this, count);
+        ENSURE_QT_CONNECT(view, &QWebEngineView::titleChanged, this, count);
+        ENSURE_QT_CONNECT(view, &QWebEngineView::iconChanged, this, count);
+        ENSURE_QT_CONNECT(view, &QWebEngineView::loadStarted, this, count);
+        ENSURE_QT_CONNECT(view, &QWebEngineView::loadProgress, this, count);
+        ENSURE_QT_CONNECT(view, &QWebEngineView::loadFinished, this, count);
+        m_directConnections += 6;
+    }
+
+    void attachPage(QWebEnginePage *page) override
+    {
+        if (m_wiring != Wiring::Lazy) {
+            return;
+        }
+        const auto count = [this]() { ++m_events; };
+        ENSURE_QT_CONNECT(page, &QWebEnginePage::fullScreenRequested, this, count);
+        ENSURE_QT_CONNECT(page, &QWebEnginePage::featurePermissionRequested, this, count);
+        ENSURE_QT_CONNECT(page, &QWebEnginePage::windowCloseRequested, this, count);
+        m_directConnections += 3;
+    }
+
+private:
+    template <typename Signal>
+    void listen(Signal signal)
+    {
+        ENSURE_QT_CONNECT(this, signal, this, [this]() { ++m_events; });
+    }
+
+    Wiring m_wiring;
+    qint64 m_events {0};
+    int m_directConnections {0};
+};
+
+struct Result
+{
+    QString wiring;
+    int views {0};
+    double bindMs {0.0};
+    int upstreamConnections {0};
+    int directConnections {0};
+    qint64 rssDeltaBytes {-1};
+    double handledNsPerEvent {0.0};
+    double unhandledNsPerEvent {0.0};
+};
+
+Result runWiring(Wiring wiring, int viewCount, int rounds)
+{
+    Result result;
+    result.wiring = wiring == Wiring::Eager ? QStringLiteral("eager") : QStringLiteral("lazy");
+    result.views = viewCount;
+
+    std::vector<std::unique_ptr<QWebEngineView>> views;
+    views.reserve(viewCount);
+    for (int i = 0; i < viewCount; ++i) {
+        views.push_back(std::make_unique<QWebEngineView>());
+    }
+
+    const qint64 rssBefore = ProcessStats::sampleSelf().rssBytes;
+    std::vector<std::unique_ptr<BenchHub>> hubs;
+    hubs.reserve(viewCount);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < viewCount; ++i) {
+        hubs.push_back(std::make_unique<BenchHub>(wiring));
+        hubs.back()->bind(views[i].get());
+    }
+    result.bindMs = timer.nsecsElapsed() / 1e6;
+    const qint64 rssAfter = ProcessStats::sampleSelf().rssBytes;
+    if (rssBefore >= 0 && rssAfter >= 0) {
+        result.rssDeltaBytes = rssAfter - rssBefore;
+    }
+
+    for (const auto &hub : hubs) {
+        result.upstreamConnections += hub->upstreamConnectionCount();
+        result.directConnections += hub->directConnections();
+    }
+
+    // 直接发射上游信号，测量一次事件到达处理函数的开销
+    timer.restart();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto &view : views) {
+            emit view->loadProgress(round % 100);
+        }
+    }
+    result.handledNsPerEvent = static_cast<double>(timer.nsecsElapsed()) / (static_cast<qint64>(rounds) * viewCount);
+
+    // 没有处理函数的信号：lazy 模式下没有任何连接，只剩信号发射本身
+    timer.restart();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto &view : views) {
+            emit view->selectionChanged();
+        }
+    }
+    result.unhandledNsPerEvent = static_cast<double>(timer.nsecsElapsed()) / (static_cast<qint64>(rounds) * viewCount);
+
+    qint64 events = 0;
+    for (const auto &hub : hubs) {
+        events += hub->events();
+    }
+    if (events < static_cast<qint64>(rounds) * viewCount) {
+        qWarning() << "signalwiringbench:" << result.wiring << "delivered only" << events << "events";
+    }
+
+    hubs.clear();
+    views.clear();
+    return result;
+}
+
+QJsonObject toJson(const Result &result)
+{
+    return QJsonObject {
+        {QStringLiteral("wiring"), result.wiring},
+        {QStringLiteral("views"), result.views},
+        {QStringLiteral("bindMs"), result.bindMs},
+        {QStringLiteral("upstreamConnections"), result.upstreamConnections},
+        {QStringLiteral("directConnections"), result.directConnections},
+        {QStringLiteral("rssDeltaKiB"), result.rssDeltaBytes >= 0 ? result.rssDeltaBytes / 1024.0 : -1.0},
+        {QStringLiteral("handledNsPerEvent"), result.handledNsPerEvent},
+        {QStringLiteral("unhandledNsPerEvent"), result.unhandledNsPerEvent},
+    };
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    qputenv("QTWEBENGINE_DISABLE_SANDBOX", "1");
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName(QStringLiteral("signalwiring_bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Compares eager two-hop signal forwarding with lazy direct wiring "
+                                                    "across many bound views."));
+    parser.addHelpOption();
+    const QCommandLineOption viewsOption(QStringLiteral("views"),
+                                         QStringLiteral("Number of views."),
+                                         QStringLiteral("n"),
+                                         QString::number(kDefaultViews));
+    const QCommandLineOption roundsOption(QStringLiteral("rounds"),
+                                          QStringLiteral("Signal emissions per view."),
+                                          QStringLiteral("n"),
+                                          QString::number(kDefaultRounds));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+                                          QStringLiteral("text or json."),
+                                          QStringLiteral("format"),
+                                          QStringLiteral("text"));
+    parser.addOptions({viewsOption, roundsOption, outputOption});
+    parser.process(app);
+
+    const int viewCount = qMax(1, parser.value(viewsOption).toInt());
+    const int rounds = qMax(1, parser.value(roundsOption).toInt());
+
+    // 先跑一轮预热，避免首次创建 view 的初始化开销计入第一种模式
+    runWiring(Wiring::Lazy, 1, 1);
+    const QVector<Result> results {
+        runWiring(Wiring::Eager, viewCount, rounds),
+        runWiring(Wiring::Lazy, viewCount, rounds),
+    };
+
+    QTextStream out(stdout);
+    if (parser.value(outputOption) == QLatin1String("json")) {
+        QJsonArray rows;
+        for (const Result &result : results) {
+            rows.append(toJson(result));
+        }
+        out << QJsonDocument(QJsonObject {{QStringLiteral("results"), rows}}).toJson(QJsonDocument::Indented);
+        return 0;
+    }
+
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(QStringLiteral("wiring"), -7)
+               .arg(QStringLiteral("views"), 6)
+               .arg(QStringLiteral("bind ms"), 9)
+               .arg(QStringLiteral("upstream/direct conns"), 22)
+               .arg(QStringLiteral("rss KiB"), 9)
+               .arg(QStringLiteral("handled ns/evt"), 15)
+               .arg(QStringLiteral("unhandled ns/evt"), 17);
+    for (const Result &result : results) {
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(result.wiring, -7)
+                   .arg(result.views, 6)
+                   .arg(result.bindMs, 9, 'f', 2)
+                   .arg(QStringLiteral("%1/%2").arg(result.upstreamConnections).arg(result.directConnections), 22)
+                   .arg(result.rssDeltaBytes >= 0 ? QString::number(result.rssDeltaBytes / 1024) : QStringLiteral("-"), 9)
+                   .arg(result.handledNsPerEvent, 15, 'f', 1)
+                   .arg(result.unhandledNsPerEvent, 17, 'f', 1);
+    }
+    return 0;
+}
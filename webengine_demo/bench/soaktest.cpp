@@ -0,0 +1,608 @@
+#include "benchsupport.h"
+#include "connectguard.h"
+#include "cookiejartransfer.h"
+#include "cookiemirror.h"
+#include "messageconsole.h"
+#include "processstats.h"
+#include "userscriptregistry.h"
+#include "webbridge.h"
+#include "webenginepane.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointF>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <QWebEngineProfile>
+#include <QWebEngineScript>
+#include <QWebEngineView>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// QtCore 为调试工具（GammaRay 等）导出的钩子表，布局见 qhooks_p.h；用来统计存活的 QObject 数量
+extern quintptr Q_CORE_EXPORT qtHookData[];
+
+namespace {
+constexpr int kLoadTimeoutMs = 30000;
+constexpr int kEchoTimeoutMs = 10000;
+// 少于这么多个样本时不判定趋势，避免短时间运行的噪声导致误报
+constexpr int kMinTrendSamples = 6;
+
+const QStringList kDefaultPages {
+    QStringLiteral("article.html"),
+    QStringLiteral("table.html"),
+    QStringLiteral("canvas.html"),
+    QStringLiteral("cards.html"),
+    QStringLiteral("spa.html"),
+};
+
+enum HookIndex
+{
+    kAddQObjectHook = 3,
+    kRemoveQObjectHook = 4,
+};
+
+using QObjectHook = void (*)(QObject *);
+
+std::atomic<qint64> s_liveQObjects {0};
+QObjectHook s_previousAddHook = nullptr;
+QObjectHook s_previousRemoveHook = nullptr;
+
+void countAddedQObject(QObject *object)
+{
+    s_liveQObjects.fetch_add(1, std::memory_order_relaxed);
+    if (s_previousAddHook) {
+        s_previousAddHook(object);
+    }
+}
+
+void countRemovedQObject(QObject *object)
+{
+    s_liveQObjects.fetch_sub(1, std::memory_order_relaxed);
+    if (s_previousRemoveHook) {
+        s_previousRemoveHook(object);
+    }
+}
+
+// 需在创建 QApplication 之前调用，已有的钩子（例如调试器注入的）会被串联
+void installQObjectCounter()
+{
+    s_previousAddHook = reinterpret_cast<QObjectHook>(qtHookData[kAddQObjectHook]);
+    s_previousRemoveHook = reinterpret_cast<QObjectHook>(qtHookData[kRemoveQObjectHook]);
+    qtHookData[kAddQObjectHook] = reinterpret_cast<quintptr>(&countAddedQObject);
+    qtHookData[kRemoveQObjectHook] = reinterpret_cast<quintptr>(&countRemovedQObject);
+}
+
+struct SoakOptions
+{
+    QStringList pages;
+    int durationMinutes {60};
+    int cycles {0};
+    int panes {2};
+    int messages {50};
+    int sampleIntervalSec {30};
+    int warmupMinutes {5};
+    int clearEvery {10};
+    // 各指标允许的增长斜率（每小时）
+    double maxRssMiBPerHour {20.0};
+    double maxRendererRssMiBPerHour {50.0};
+    double maxFdsPerHour {10.0};
+    double maxQObjectsPerHour {200.0};
+    double maxLatencyMsPerHour {5.0};
+    QString csvPath;
+    bool json {false};
+};
+
+struct Sample
+{
+    double hours {0.0};
+    qint64 cycles {0};
+    qint64 rssBytes {-1};
+    qint64 rendererRssBytes {-1};
+    int fds {-1};
+    int threads {-1};
+    qint64 qobjects {0};
+    double latencyP50Ms {-1.0};
+    double latencyP95Ms {-1.0};
+};
+
+struct Trend
+{
+    QString name;
+    QString unit;
+    double limitPerHour {0.0};
+    double slopePerHour {0.0};
+    double first {0.0};
+    double last {0.0};
+    double max {0.0};
+    int samples {0};
+    bool failed {false};
+};
+
+// 最小二乘拟合 y = a + b * x，返回 b
+double leastSquaresSlope(const QVector<QPointF> &points)
+{
+    if (points.size() < 2) {
+        return 0.0;
+    }
+    double sumX = 0.0;
+    double sumY = 0.0;
+    for (const QPointF &point : points) {
+        sumX += point.x();
+        sumY += point.y();
+    }
+    const double meanX = sumX / points.size();
+    const double meanY = sumY / points.size();
+    double covariance = 0.0;
+    double variance = 0.0;
+    for (const QPointF &point : points) {
+        covariance += (point.x() - meanX) * (point.y() - meanY);
+        variance += (point.x() - meanX) * (point.x() - meanX);
+    }
+    return variance > 0.0 ? covariance / variance : 0.0;
+}
+
+int countOpenFds()
+{
+#if defined(Q_OS_LINUX)
+    return QDir(QStringLiteral("/proc/self/fd")).entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot).size();
+#else
+    return -1;
+#endif
+}
+
+int countThreads()
+{
+#if defined(Q_OS_LINUX)
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("Threads:")) {
+            return line.mid(8).trimmed().toInt();
+        }
+    }
+#endif
+    return -1;
+}
+
+bool parseOptions(const QStringList &arguments, SoakOptions *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Creates and destroys WebEnginePanes in a loop under the offscreen "
+                                                    "platform and fails when memory, handles, QObjects or bridge "
+                                                    "latency keep growing."));
+    parser.addHelpOption();
+    const auto slopeOption = [](const char *name, const char *description, double value) {
+        return QCommandLineOption(QString::fromLatin1(name), QString::fromLatin1(description), QStringLiteral("per-hour"),
+                                  QString::number(value));
+    };
+    const QCommandLineOption durationOption =
+        BenchSupport::intOption("duration", "Run time in minutes.", "minutes", options->durationMinutes);
+    const QCommandLineOption cyclesOption =
+        BenchSupport::intOption("cycles", "Stop after this many cycles instead of --duration (0 = use duration).", "n",
+                                options->cycles);
+    const QCommandLineOption panesOption =
+        BenchSupport::intOption("panes", "Panes created per cycle.", "n", options->panes);
+    const QCommandLineOption messagesOption =
+        BenchSupport::intOption("messages", "Bridge round trips per pane per cycle.", "n", options->messages);
+    const QCommandLineOption intervalOption =
+        BenchSupport::intOption("sample-interval", "Seconds between samples.", "seconds", options->sampleIntervalSec);
+    const QCommandLineOption warmupOption =
+        BenchSupport::intOption("warmup", "Minutes excluded from trend fitting.", "minutes", options->warmupMinutes);
+    const QCommandLineOption clearOption = BenchSupport::intOption(
+        "clear-every", "Call clearProfileData every N cycles (0 = never).", "n", options->clearEvery);
+    const QCommandLineOption rssOption = slopeOption("max-rss-slope", "Process RSS growth limit, MiB/h.", options->maxRssMiBPerHour);
+    const QCommandLineOption rendererOption =
+        slopeOption("max-renderer-rss-slope", "Renderer RSS growth limit, MiB/h.", options->maxRendererRssMiBPerHour);
+    const QCommandLineOption fdOption = slopeOption("max-fd-slope", "Open file descriptor growth limit per hour.", options->maxFdsPerHour);
+    const QCommandLineOption qobjectOption =
+        slopeOption("max-qobject-slope", "Live QObject growth limit per hour.", options->maxQObjectsPerHour);
+    const QCommandLineOption latencyOption =
+        slopeOption("max-latency-slope", "Bridge round-trip p95 growth limit, ms/h.", options->maxLatencyMsPerHour);
+    const QCommandLineOption pagesOption(QStringLiteral("pages"), QStringLiteral("Comma separated corpus pages."),
+                                         QStringLiteral("list"), kDefaultPages.join(QLatin1Char(',')));
+    const QCommandLineOption csvOption(QStringLiteral("csv"), QStringLiteral("Append every sample to this CSV file."),
+                                       QStringLiteral("file"));
+    const QCommandLineOption outputOption = BenchSupport::outputOption();
+    parser.addOptions({durationOption, cyclesOption, panesOption, messagesOption, intervalOption, warmupOption, clearOption,
+                       rssOption, rendererOption, fdOption, qobjectOption, latencyOption, pagesOption, csvOption,
+                       outputOption});
+    if (!BenchSupport::parse(parser, arguments, error)) {
+        return false;
+    }
+
+    const auto readInt = [&parser, error](const QCommandLineOption &option, int min, int *out) {
+        return BenchSupport::readInt(parser, option, min, out, error);
+    };
+    const auto readSlope = [&parser, error](const QCommandLineOption &option, double *out) {
+        bool ok = false;
+        const double value = parser.value(option).toDouble(&ok);
+        if (!ok || value < 0.0) {
+            *error = QStringLiteral("--%1 must be a non-negative number").arg(option.names().constFirst());
+            return false;
+        }
+        *out = value;
+        return true;
+    };
+    if (!readInt(durationOption, 1, &options->durationMinutes) || !readInt(cyclesOption, 0, &options->cycles)
+        || !readInt(panesOption, 1, &options->panes) || !readInt(messagesOption, 0, &options->messages)
+        || !readInt(intervalOption, 1, &options->sampleIntervalSec) || !readInt(warmupOption, 0, &options->warmupMinutes)
+        || !readInt(clearOption, 0, &options->clearEvery) || !readSlope(rssOption, &options->maxRssMiBPerHour)
+        || !readSlope(rendererOption, &options->maxRendererRssMiBPerHour) || !readSlope(fdOption, &options->maxFdsPerHour)
+        || !readSlope(qobjectOption, &options->maxQObjectsPerHour)
+        || !readSlope(latencyOption, &options->maxLatencyMsPerHour)) {
+        return false;
+    }
+
+    options->pages = parser.value(pagesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    if (options->pages.isEmpty()) {
+        *error = QStringLiteral("--pages is empty");
+        return false;
+    }
+    options->csvPath = parser.value(csvOption);
+    return BenchSupport::readOutput(parser, outputOption, &options->json, error);
+}
+
+class SoakTest final
+{
+public:
+    explicit SoakTest(const SoakOptions &options)
+        : m_options(options)
+    {
+    }
+
+    int run()
+    {
+        if (!m_options.csvPath.isEmpty()) {
+            m_csv.setFileName(m_options.csvPath);
+            if (!m_csv.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+                qWarning().noquote() << "SoakTest: cannot write" << m_options.csvPath << m_csv.errorString();
+                return 2;
+            }
+            m_csv.write("hours,cycles,rss_mib,renderer_rss_mib,fds,threads,qobjects,latency_p50_ms,latency_p95_ms\n");
+        }
+
+        m_clock.start();
+        const qint64 deadlineMs = qint64(m_options.durationMinutes) * 60 * 1000;
+        qint64 nextSampleMs = 0;
+        while (m_options.cycles > 0 ? m_cycles < m_options.cycles : m_clock.elapsed() < deadlineMs) {
+            runCycle();
+            ++m_cycles;
+            if (m_clock.elapsed() >= nextSampleMs) {
+                recordSample();
+                nextSampleMs = m_clock.elapsed() + qint64(m_options.sampleIntervalSec) * 1000;
+            }
+        }
+        recordSample();
+        return report();
+    }
+
+private:
+    QString pageFor(qint64 index) const
+    {
+        return m_options.pages.at(static_cast<int>(index % m_options.pages.size()));
+    }
+
+    std::unique_ptr<WebEnginePane> createPane()
+    {
+        auto pane = std::make_unique<WebEnginePane>();
+        m_handler.install(pane->profile());
+        pane->userScripts()->install(QStringLiteral("soak-echo"), BenchSupport::echoScript(QStringLiteral("soak:")));
+        pane->resize(1024, 768);
+        pane->show();
+        ENSURE_QT_CONNECT(pane->bridge(), &WebBridge::messageFromJs, pane.get(), [this](const QString &payload) {
+            handleEcho(payload);
+        });
+        m_console.attachBridge(pane->bridge());
+        return pane;
+    }
+
+    // 等待加载完成且 bridge 通知页面就绪
+    bool loadAndWait(WebEnginePane *pane, const QString &page)
+    {
+        bool finished = false;
+        bool ok = false;
+        bool ready = false;
+        const auto loadConnection = QObject::connect(pane, &WebEnginePane::loadFinished, pane, [&finished, &ok](bool success) {
+            finished = true;
+            ok = success;
+        });
+        const auto readyConnection = QObject::connect(pane->bridge(), &WebBridge::pageReady, pane, [&ready]() {
+            ready = true;
+        });
+        ConnectGuard::verify(loadConnection, "WebEnginePane::loadFinished", __FILE__, __LINE__);
+        ConnectGuard::verify(readyConnection, "WebBridge::pageReady", __FILE__, __LINE__);
+
+        pane->load(CorpusSchemeHandler::url(page));
+        const bool done = BenchSupport::waitUntil([&finished, &ready]() { return finished && ready; }, kLoadTimeoutMs);
+        QObject::disconnect(loadConnection);
+        QObject::disconnect(readyConnection);
+        if (!done || !ok) {
+            qWarning().noquote() << "SoakTest:" << page << (finished ? "not ready" : "timed out");
+            ++m_loadFailures;
+            return false;
+        }
+        return true;
+    }
+
+    void exerciseBridge(const std::vector<std::unique_ptr<WebEnginePane>> &panes)
+    {
+        for (int i = 0; i < m_options.messages; ++i) {
+            for (const auto &pane : panes) {
+                const qint64 sequence = ++m_sequence;
+                m_sentAtNs.insert(sequence, m_clock.nsecsElapsed());
+                pane->broadcastToPage(QStringLiteral("soak:%1").arg(sequence));
+            }
+        }
+        if (!BenchSupport::waitUntil([this]() { return m_sentAtNs.isEmpty(); }, kEchoTimeoutMs)) {
+            m_lostMessages += m_sentAtNs.size();
+            m_sentAtNs.clear();
+        }
+    }
+
+    void handleEcho(const QString &payload)
+    {
+        if (!payload.startsWith(QLatin1String("soak:"))) {
+            return;
+        }
+        const auto sentAt = m_sentAtNs.find(payload.mid(5).toLongLong());
+        if (sentAt == m_sentAtNs.end()) {
+            return;
+        }
+        m_windowLatencies.append((m_clock.nsecsElapsed() - sentAt.value()) / 1e6);
+        m_sentAtNs.erase(sentAt);
+    }
+
+    void exerciseCookies(WebEnginePane *pane)
+    {
+        pane->setCookieForCurrentPage(QStringLiteral("soak=%1").arg(m_cycles));
+        pane->cookieMirror()->cookiesForUrl(pane->view()->url());
+
+        bool exported = false;
+        CookieJarTransfer *jar = pane->cookieJar();
+        const auto connection = QObject::connect(jar, &CookieJarTransfer::exportFinished, pane,
+                                                 [&exported](qint64, const QString &) { exported = true; });
+        ConnectGuard::verify(connection, "CookieJarTransfer::exportFinished", __FILE__, __LINE__);
+        if (jar->exportFile(m_tempDir.filePath(QStringLiteral("cookies.jsonl")))) {
+            BenchSupport::waitUntil([&exported]() { return exported; }, kLoadTimeoutMs);
+        }
+        QObject::disconnect(connection);
+    }
+
+    void runCycle()
+    {
+        std::vector<std::unique_ptr<WebEnginePane>> panes;
+        for (int i = 0; i < m_options.panes; ++i) {
+            panes.push_back(createPane());
+        }
+        for (std::size_t i = 0; i < panes.size(); ++i) {
+            loadAndWait(panes[i].get(), pageFor(m_cycles + static_cast<qint64>(i)));
+        }
+        exerciseBridge(panes);
+
+        // 峰值时刻的渲染进程内存，多个 pane 共用同一进程时只计一次
+        QSet<qint64> pids;
+        qint64 rendererRss = 0;
+        for (const auto &pane : panes) {
+            const qint64 pid = pane->view()->page()->renderProcessPid();
+            if (pid > 0 && !pids.contains(pid)) {
+                pids.insert(pid);
+                rendererRss += std::max<qint64>(0, ProcessStats::sample(pid).rssBytes);
+            }
+        }
+        m_lastRendererRss = pids.isEmpty() ? -1 : rendererRss;
+
+        exerciseCookies(panes.front().get());
+        // 同一个 pane 再导航一次，覆盖页面切换路径
+        loadAndWait(panes.front().get(), pageFor(m_cycles + static_cast<qint64>(panes.size())));
+        exerciseBridge(panes);
+        if (m_options.clearEvery > 0 && (m_cycles + 1) % m_options.clearEvery == 0) {
+            panes.front()->clearProfileData();
+        }
+
+        m_console.attachBridge(nullptr);
+        panes.clear();
+        // 让 deleteLater 与渲染进程退出的通知都处理完，再开始下一轮
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QCoreApplication::processEvents();
+    }
+
+    void recordSample()
+    {
+        Sample sample;
+        sample.hours = m_clock.elapsed() / 3600000.0;
+        sample.cycles = m_cycles;
+        sample.rssBytes = ProcessStats::sampleSelf().rssBytes;
+        sample.rendererRssBytes = m_lastRendererRss;
+        sample.fds = countOpenFds();
+        sample.threads = countThreads();
+        sample.qobjects = s_liveQObjects.load(std::memory_order_relaxed);
+        sample.latencyP50Ms = BenchSupport::percentile(m_windowLatencies, 0.50);
+        sample.latencyP95Ms = BenchSupport::percentile(m_windowLatencies, 0.95);
+        m_windowLatencies.clear();
+        m_samples.append(sample);
+
+        const auto mib = [](qint64 bytes) { return bytes >= 0 ? QString::number(bytes / (1024.0 * 1024.0), 'f', 1) : QStringLiteral("-"); };
+        if (m_csv.isOpen()) {
+            m_csv.write(QStringLiteral("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+                            .arg(sample.hours, 0, 'f', 4)
+                            .arg(sample.cycles)
+                            .arg(mib(sample.rssBytes), mib(sample.rendererRssBytes))
+                            .arg(sample.fds)
+                            .arg(sample.threads)
+                            .arg(sample.qobjects)
+                            .arg(sample.latencyP50Ms, 0, 'f', 2)
+                            .arg(sample.latencyP95Ms, 0, 'f', 2)
+                            .toUtf8());
+            m_csv.flush();
+        }
+        if (!m_options.json) {
+            QTextStream(stderr) << QStringLiteral("[%1 min] cycles=%2 rss=%3MiB renderer=%4MiB fds=%5 threads=%6 qobjects=%7 "
+                                                  "latency p50/p95=%8/%9ms\n")
+                                       .arg(sample.hours * 60.0, 0, 'f', 1)
+                                       .arg(sample.cycles)
+                                       .arg(mib(sample.rssBytes), mib(sample.rendererRssBytes))
+                                       .arg(sample.fds)
+                                       .arg(sample.threads)
+                                       .arg(sample.qobjects)
+                                       .arg(sample.latencyP50Ms, 0, 'f', 2)
+                                       .arg(sample.latencyP95Ms, 0, 'f', 2);
+        }
+    }
+
+    Trend fitTrend(const QString &name, const QString &unit, double limit, const std::function<double(const Sample &)> &value) const
+    {
+        Trend trend;
+        trend.name = name;
+        trend.unit = unit;
+        trend.limitPerHour = limit;
+        const double warmupHours = m_options.warmupMinutes / 60.0;
+        QVector<QPointF> points;
+        for (const Sample &sample : m_samples) {
+            const double y = value(sample);
+            if (sample.hours < warmupHours || y < 0.0) {
+                continue;
+            }
+            if (points.isEmpty()) {
+                trend.first = y;
+                trend.max = y;
+            }
+            trend.last = y;
+            trend.max = std::max(trend.max, y);
+            points.append(QPointF(sample.hours, y));
+        }
+        trend.samples = points.size();
+        trend.slopePerHour = leastSquaresSlope(points);
+        trend.failed = trend.samples >= kMinTrendSamples && trend.slopePerHour > limit;
+        return trend;
+    }
+
+    int report() const
+    {
+        const auto mib = [](qint64 bytes) { return bytes >= 0 ? bytes / (1024.0 * 1024.0) : -1.0; };
+        const QVector<Trend> trends {
+            fitTrend(QStringLiteral("process-rss"), QStringLiteral("MiB"), m_options.maxRssMiBPerHour,
+                     [&mib](const Sample &sample) { return mib(sample.rssBytes); }),
+            fitTrend(QStringLiteral("renderer-rss"), QStringLiteral("MiB"), m_options.maxRendererRssMiBPerHour,
+                     [&mib](const Sample &sample) { return mib(sample.rendererRssBytes); }),
+            fitTrend(QStringLiteral("open-fds"), QStringLiteral("fds"), m_options.maxFdsPerHour,
+                     [](const Sample &sample) { return double(sample.fds); }),
+            fitTrend(QStringLiteral("qobjects"), QStringLiteral("objects"), m_options.maxQObjectsPerHour,
+                     [](const Sample &sample) { return double(sample.qobjects); }),
+            fitTrend(QStringLiteral("bridge-latency-p95"), QStringLiteral("ms"), m_options.maxLatencyMsPerHour,
+                     [](const Sample &sample) { return sample.latencyP95Ms; }),
+        };
+        const bool failed = std::any_of(trends.cbegin(), trends.cend(), [](const Trend &trend) { return trend.failed; });
+
+        QTextStream out(stdout);
+        if (m_options.json) {
+            QJsonArray trendArray;
+            for (const Trend &trend : trends) {
+                trendArray.append(QJsonObject {
+                    {QStringLiteral("name"), trend.name},
+                    {QStringLiteral("unit"), trend.unit},
+                    {QStringLiteral("samples"), trend.samples},
+                    {QStringLiteral("first"), trend.first},
+                    {QStringLiteral("last"), trend.last},
+                    {QStringLiteral("max"), trend.max},
+                    {QStringLiteral("slopePerHour"), trend.slopePerHour},
+                    {QStringLiteral("limitPerHour"), trend.limitPerHour},
+                    {QStringLiteral("failed"), trend.failed},
+                });
+            }
+            const QJsonObject result {
+                {QStringLiteral("hours"), m_clock.elapsed() / 3600000.0},
+                {QStringLiteral("cycles"), m_cycles},
+                {QStringLiteral("loadFailures"), m_loadFailures},
+                {QStringLiteral("lostMessages"), m_lostMessages},
+                {QStringLiteral("trends"), trendArray},
+                {QStringLiteral("passed"), !failed},
+            };
+            out << QJsonDocument(result).toJson(QJsonDocument::Indented);
+        } else {
+            out << QStringLiteral("ran %1 min, %2 cycles, %3 load failures, %4 lost bridge messages\n")
+                       .arg(m_clock.elapsed() / 60000.0, 0, 'f', 1)
+                       .arg(m_cycles)
+                       .arg(m_loadFailures)
+                       .arg(m_lostMessages);
+            out << QStringLiteral("%1 %2 %3 %4 %5  %6\n")
+                       .arg(QStringLiteral("metric"), -20)
+                       .arg(QStringLiteral("first"), 10)
+                       .arg(QStringLiteral("last"), 10)
+                       .arg(QStringLiteral("slope/h"), 10)
+                       .arg(QStringLiteral("limit/h"), 10)
+                       .arg(QStringLiteral("verdict"));
+            for (const Trend &trend : trends) {
+                const QString verdict = trend.samples < kMinTrendSamples ? QStringLiteral("too few samples")
+                                        : trend.failed                  ? QStringLiteral("FAIL")
+                                                                        : QStringLiteral("ok");
+                out << QStringLiteral("%1 %2 %3 %4 %5  %6\n")
+                           .arg(trend.name + QStringLiteral(" (") + trend.unit + QLatin1Char(')'), -20)
+                           .arg(trend.first, 10, 'f', 1)
+                           .arg(trend.last, 10, 'f', 1)
+                           .arg(trend.slopePerHour, 10, 'f', 2)
+                           .arg(trend.limitPerHour, 10, 'f', 2)
+                           .arg(verdict);
+            }
+            out << (failed ? "FAILED\n" : "PASSED\n");
+        }
+        return failed ? 1 : 0;
+    }
+
+    SoakOptions m_options;
+    CorpusSchemeHandler m_handler;
+    // 消息面板不显示，只挂在每轮的 bridge 上，覆盖其日志追加路径
+    MessageConsole m_console;
+    QTemporaryDir m_tempDir;
+    QFile m_csv;
+    QElapsedTimer m_clock;
+    QHash<qint64, qint64> m_sentAtNs;
+    QVector<double> m_windowLatencies;
+    QVector<Sample> m_samples;
+    qint64 m_sequence {0};
+    qint64 m_cycles {0};
+    qint64 m_lastRendererRss {-1};
+    int m_loadFailures {0};
+    qint64 m_lostMessages {0};
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    installQObjectCounter();
+
+    const QStringList arguments = BenchSupport::arguments(argc, argv);
+    SoakOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error)) {
+        return BenchSupport::reportOptionError(arguments, error);
+    }
+
+    CorpusSchemeHandler::registerScheme();
+    // 浸泡测试总是在 offscreen 平台上以软件渲染运行，不依赖显示器与 GPU
+    BenchSupport::prepareEnvironment(true);
+
+    QApplication app(argc, argv);
+    BenchSupport::initializeApplication(QStringLiteral("soak_test"));
+
+    SoakTest soak(options);
+    return soak.run();
+}
@@ -0,0 +1,168 @@
+#include "appcontroller.h"
+
+#include "bridgerouter.h"
+#include "configmanager.h"
+#include "connectguard.h"
+#include "profileregistry.h"
+
+#include <QDebug>
+#include <QPoint>
+#include <QWebEngineProfile>
+
+#include <algorithm>
+
+namespace {
+constexpr int kMaxWindows = 64;
+constexpr int kCascadeOffset = 32;
+
+int windowsArgument(const QStringList &arguments, int fallback)
+{
+    for (int i = 0; i < arguments.size(); ++i) {
+        QString value;
+        if (arguments.at(i) == QLatin1String("--windows") && i + 1 < arguments.size()) {
+            value = arguments.at(i + 1);
+        } else if (arguments.at(i).startsWith(QLatin1String("--windows="))) {
+            value = arguments.at(i).section(QLatin1Char('='), 1);
+        } else {
+            continue;
+        }
+        bool ok = false;
+        const int windows = value.toInt(&ok);
+        if (!ok || windows < 1) {
+            qWarning().noquote() << "AppController: ignoring invalid --windows value" << value;
+            return fallback;
+        }
+        return windows;
+    }
+    return fallback;
+}
+} // namespace
+
+AppController::Options AppController::Options::fromConfig(const QStringList &arguments)
+{
+    const ConfigManager::MultiWindow config = ConfigManager::instance().multiWindow();
+    Options options;
+    options.windows = std::clamp(windowsArgument(arguments, config.windows), 1, kMaxWindows);
+    options.sharedProfile = config.sharedProfile && !arguments.contains(QStringLiteral("--independent-profiles"));
+    return options;
+}
+
+AppController::AppController(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    m_profiles = new ProfileRegistry(this);
+    m_router = new BridgeRouter(this);
+    ENSURE_QT_CONNECT(m_profiles, &ProfileRegistry::profileReleased, this, [this](const QString &name) {
+        m_cacheClearedAt.remove(name);
+    });
+}
+
+AppController::~AppController()
+{
+    // 窗口（及其页面）必须先于 ProfileRegistry 中的 profile 销毁
+    const auto windows = m_windows;
+    for (const QPointer<BrowserWindow> &window : windows) {
+        delete window.data();
+    }
+}
+
+BrowserWindow *AppController::start()
+{
+    BrowserWindow *first = nullptr;
+    for (int i = 0; i < m_options.windows; ++i) {
+        BrowserWindow *window = openWindow();
+        if (!first) {
+            first = window;
+        }
+    }
+    qInfo() << "AppController: opened" << m_options.windows << "windows," << m_profiles->profileCount()
+            << (m_options.sharedProfile ? "shared profile" : "independent profiles");
+    return first;
+}
+
+BrowserWindow *AppController::openWindow()
+{
+    const int windowId = m_nextWindowId++;
+    // 独立模式下每个窗口使用独立的磁盘目录，便于与共享模式对比资源占用
+    const QString profileName = m_options.sharedProfile
+                                    ? ProfileRegistry::kDefaultProfileName
+                                    : QStringLiteral("%1-%2").arg(ProfileRegistry::kDefaultProfileName).arg(windowId);
+    SharedProfile *profile = m_profiles->acquire(profileName);
+
+    auto *window = new BrowserWindow(m_options.startupMode, nullptr, profile);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    window->setWindowTitle(tr("%1 - 窗口 %2").arg(window->windowTitle()).arg(windowId));
+    m_windows.insert(windowId, window);
+
+    const auto attachEngine = [this, windowId, window]() {
+        m_router->attach(windowId, window->engine());
+    };
+    if (window->engine()) {
+        attachEngine();
+    } else {
+        ENSURE_QT_CONNECT(window, &BrowserWindow::engineReady, this, attachEngine);
+    }
+    ENSURE_QT_CONNECT(window, &BrowserWindow::firstLoadFinished, this, [this, windowId](bool ok) {
+        emit windowLoaded(windowId, ok);
+    });
+    ENSURE_QT_CONNECT(window, &BrowserWindow::httpCacheClearRequested, this, [this, profileName]() {
+        clearSharedHttpCache(profileName);
+    });
+    ENSURE_QT_CONNECT(window, &BrowserWindow::newWindowRequested, this, [this]() {
+        if (BrowserWindow *opened = openWindow()) {
+            opened->show();
+        }
+    });
+    ENSURE_QT_CONNECT(window, &QObject::destroyed, this, [this, windowId]() {
+        m_windows.remove(windowId);
+        m_router->detach(windowId);
+        emit windowClosed(windowId);
+    });
+
+    if (const BrowserWindow *previous = m_windows.value(windowId - 1)) {
+        window->move(previous->pos() + QPoint(kCascadeOffset, kCascadeOffset));
+    }
+    emit windowOpened(windowId);
+    return window;
+}
+
+void AppController::clearSharedHttpCache(const QString &profileName)
+{
+    SharedProfile *shared = m_profiles->find(profileName);
+    if (!shared) {
+        return;
+    }
+    QElapsedTimer &lastClear = m_cacheClearedAt[profileName];
+    if (lastClear.isValid() && !lastClear.hasExpired(ConfigManager::instance().memoryPressure().cooldownMs)) {
+        return;
+    }
+    lastClear.start();
+    shared->profile()->clearHttpCache();
+    qInfo() << "AppController: cleared HTTP cache of shared profile" << profileName << "under memory pressure";
+}
+
+BrowserWindow *AppController::window(int windowId) const
+{
+    return m_windows.value(windowId);
+}
+
+QList<int> AppController::windowIds() const
+{
+    return m_windows.keys();
+}
+
+AppController::Options AppController::options() const
+{
+    return m_options;
+}
+
+ProfileRegistry *AppController::profiles() const
+{
+    return m_profiles;
+}
+
+BridgeRouter *AppController::router() const
+{
+    return m_router;
+}
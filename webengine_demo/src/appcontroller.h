@@ -0,0 +1,61 @@
+#pragma once
+
+#include "browserwindow.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+class BridgeRouter;
+class ProfileRegistry;
+
+// AppController 管理多窗口模式：窗口从 ProfileRegistry 取共用的 profile（Chromium 渲染进程池由
+// rendererProcessLimit 限定），C++ 消息经 BridgeRouter 按窗口 id 投递或广播；sharedProfile 关闭时每个窗口独占一个 profile。
+class AppController final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int windows {1};
+        bool sharedProfile {true};
+        BrowserWindow::StartupMode startupMode {BrowserWindow::StartupMode::Standard};
+
+        // 以 config.json 中的 multiWindow 为默认值，--windows N 与 --independent-profiles 覆盖
+        static Options fromConfig(const QStringList &arguments);
+    };
+
+    explicit AppController(const Options &options, QObject *parent = nullptr);
+    ~AppController() override;
+
+    // 打开 Options::windows 个窗口，返回第一个窗口
+    BrowserWindow *start();
+    BrowserWindow *openWindow();
+    BrowserWindow *window(int windowId) const;
+    QList<int> windowIds() const;
+    Options options() const;
+    ProfileRegistry *profiles() const;
+    BridgeRouter *router() const;
+
+signals:
+    void windowOpened(int windowId);
+    void windowClosed(int windowId);
+    // 每个窗口首次加载完成时各触发一次
+    void windowLoaded(int windowId, bool ok);
+
+private:
+    // 共用 profile 的窗口各自上报内存压力时，每个 profile 在冷却时间内只清空一次缓存
+    void clearSharedHttpCache(const QString &profileName);
+
+    Options m_options;
+    ProfileRegistry *m_profiles {nullptr};
+    BridgeRouter *m_router {nullptr};
+    QMap<int, QPointer<BrowserWindow>> m_windows;
+    int m_nextWindowId {1};
+    QHash<QString, QElapsedTimer> m_cacheClearedAt;
+};
@@ -0,0 +1,379 @@
+#include "batchrenderer.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPixmap>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <QWebEngineView>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr auto kBatchRenderOption = "batch-render";
+
+QSize parseViewport(const QString &text)
+{
+    const QStringList parts = text.toLower().split(QLatin1Char('x'));
+    if (parts.size() != 2) {
+        return {};
+    }
+    bool widthOk = false;
+    bool heightOk = false;
+    const QSize size(parts.at(0).toInt(&widthOk), parts.at(1).toInt(&heightOk));
+    return widthOk && heightOk && size.width() > 0 && size.height() > 0 ? size : QSize();
+}
+} // namespace
+
+bool BatchRenderOptions::fromArguments(const QStringList &arguments, BatchRenderOptions *options, QString *error)
+{
+    const QString flag = QStringLiteral("--") + QLatin1String(kBatchRenderOption);
+    const bool requested = std::any_of(arguments.cbegin(), arguments.cend(), [&flag](const QString &argument) {
+        return argument == flag || argument.startsWith(flag + QLatin1Char('='));
+    });
+    if (!requested) {
+        return false;
+    }
+
+    QCommandLineParser parser;
+    const QCommandLineOption manifestOption(QLatin1String(kBatchRenderOption),
+                                            QStringLiteral("URL manifest, one URL per line."),
+                                            QStringLiteral("manifest"));
+    const QCommandLineOption outputOption(QStringLiteral("output-dir"),
+                                          QStringLiteral("Directory for rendered files."),
+                                          QStringLiteral("dir"),
+                                          QStringLiteral("render-output"));
+    const QCommandLineOption formatOption(QStringLiteral("format"),
+                                          QStringLiteral("pdf or png."),
+                                          QStringLiteral("format"),
+                                          QStringLiteral("pdf"));
+    const QCommandLineOption concurrencyOption(QStringLiteral("concurrency"),
+                                               QStringLiteral("Concurrent pages."),
+                                               QStringLiteral("n"),
+                                               QString::number(options->concurrency));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+                                           QStringLiteral("Per-page timeout in ms."),
+                                           QStringLiteral("ms"),
+                                           QString::number(options->timeoutMs));
+    const QCommandLineOption retriesOption(QStringLiteral("retries"),
+                                           QStringLiteral("Retries per page."),
+                                           QStringLiteral("n"),
+                                           QString::number(options->retries));
+    const QCommandLineOption settleOption(QStringLiteral("settle"),
+                                          QStringLiteral("Delay after load before capture, ms."),
+                                          QStringLiteral("ms"),
+                                          QString::number(options->settleMs));
+    const QCommandLineOption viewportOption(QStringLiteral("viewport"),
+                                            QStringLiteral("Viewport size, e.g. 1280x800."),
+                                            QStringLiteral("WxH"),
+                                            QStringLiteral("1280x800"));
+    parser.addOptions({manifestOption,
+                       outputOption,
+                       formatOption,
+                       concurrencyOption,
+                       timeoutOption,
+                       retriesOption,
+                       settleOption,
+                       viewportOption});
+
+    // main() 传入的是完整 argv，其中还有 Qt 自身（-platform 等）和其他模式的参数，只把本模式选项的错误当作错误
+    if (!parser.parse(arguments) && parser.unknownOptionNames().isEmpty()) {
+        *error = parser.errorText();
+        return true;
+    }
+
+    options->manifestPath = parser.value(manifestOption);
+    options->outputDir = QDir(parser.value(outputOption)).absolutePath();
+
+    const QString format = parser.value(formatOption).toLower();
+    if (format == QLatin1String("pdf")) {
+        options->format = Format::Pdf;
+    } else if (format == QLatin1String("png")) {
+        options->format = Format::Png;
+    } else {
+        *error = QStringLiteral("unsupported format: %1").arg(format);
+        return true;
+    }
+
+    options->concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    options->timeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+    options->retries = qMax(0, parser.value(retriesOption).toInt());
+    options->settleMs = qMax(0, parser.value(settleOption).toInt());
+    options->viewport = parseViewport(parser.value(viewportOption));
+    if (!options->viewport.isValid()) {
+        *error = QStringLiteral("invalid viewport: %1").arg(parser.value(viewportOption));
+    }
+    return true;
+}
+
+BatchRenderer::BatchRenderer(const BatchRenderOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    // 所有并发页面共享一个离线 profile，复用网络缓存与渲染进程
+    m_profile = new QWebEngineProfile(this);
+    m_profile->setHttpCacheType(QWebEngineProfile::MemoryHttpCache);
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    for (const auto &worker : m_workers) {
+        delete worker->view;
+    }
+}
+
+void BatchRenderer::start()
+{
+    QString error;
+    if (!loadManifest(&error)) {
+        qCritical().noquote() << "BatchRenderer:" << error;
+        emit finished(2);
+        return;
+    }
+    if (!QDir().mkpath(m_options.outputDir)) {
+        qCritical().noquote() << "BatchRenderer: cannot create output directory" << m_options.outputDir;
+        emit finished(2);
+        return;
+    }
+
+    m_totalJobs = static_cast<int>(m_queue.size());
+    m_totalClock.start();
+    qInfo().noquote() << QStringLiteral("BatchRenderer: rendering %1 pages with %2 concurrent pages")
+                             .arg(m_totalJobs)
+                             .arg(m_options.concurrency);
+
+    const int workerCount = qMin(m_options.concurrency, m_totalJobs);
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.push_back(std::unique_ptr<Worker>(createWorker()));
+    }
+    for (const auto &worker : m_workers) {
+        dispatchNext(worker.get());
+    }
+    if (m_workers.empty()) {
+        finish();
+    }
+}
+
+bool BatchRenderer::loadManifest(QString *error)
+{
+    QFile file(m_options.manifestPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QStringLiteral("cannot open manifest %1: %2").arg(m_options.manifestPath, file.errorString());
+        return false;
+    }
+
+    // 每行一个 URL，可选第二列作为输出文件名；# 开头为注释
+    QTextStream stream(&file);
+    int index = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        const QStringList columns = line.split(QRegularExpression(QStringLiteral("\\s+")));
+        const QUrl url = QUrl::fromUserInput(columns.at(0));
+        if (!url.isValid()) {
+            qWarning().noquote() << "BatchRenderer: skipping invalid URL" << columns.at(0);
+            continue;
+        }
+        Job job;
+        job.index = ++index;
+        job.url = url;
+        job.outputPath = outputPathFor(job.index, url, columns.value(1));
+        m_queue.push_back(job);
+    }
+    return true;
+}
+
+QString BatchRenderer::outputPathFor(int index, const QUrl &url, const QString &name) const
+{
+    const QString suffix = m_options.format == BatchRenderOptions::Format::Pdf ? QStringLiteral(".pdf")
+                                                                                : QStringLiteral(".png");
+    QString baseName = name;
+    if (baseName.isEmpty()) {
+        QString host = url.host();
+        host.replace(QRegularExpression(QStringLiteral("[^A-Za-z0-9._-]")), QStringLiteral("_"));
+        baseName = QStringLiteral("%1-%2").arg(index, 4, 10, QLatin1Char('0')).arg(host.isEmpty() ? QStringLiteral("page") : host);
+    }
+    return QDir(m_options.outputDir).filePath(baseName + suffix);
+}
+
+BatchRenderer::Worker *BatchRenderer::createWorker()
+{
+    auto *worker = new Worker;
+    worker->view = new QWebEngineView;
+    worker->view->setAttribute(Qt::WA_DontShowOnScreen, true);
+    worker->view->setPage(new QWebEnginePage(m_profile, worker->view));
+    worker->view->resize(m_options.viewport);
+    worker->view->show();
+
+    worker->timeout = new QTimer(worker->view);
+    worker->timeout->setSingleShot(true);
+    worker->timeout->setInterval(m_options.timeoutMs);
+    ENSURE_QT_CONNECT(worker->timeout, &QTimer::timeout, this, [this, worker]() {
+        completeJob(worker, false, QStringLiteral("timeout"));
+        replacePage(worker);
+    });
+
+    connectPage(worker, worker->view->page());
+    return worker;
+}
+
+void BatchRenderer::connectPage(Worker *worker, QWebEnginePage *page)
+{
+    ENSURE_QT_CONNECT(page, &QWebEnginePage::loadStarted, this, [worker]() {
+        worker->startedGeneration = worker->loadGeneration;
+    });
+    ENSURE_QT_CONNECT(page, &QWebEnginePage::loadFinished, this, [this, worker](bool ok) {
+        if (worker->startedGeneration == 0 || worker->startedGeneration != worker->loadGeneration) {
+            return;
+        }
+        handleLoadFinished(worker, worker->startedGeneration, ok);
+    });
+    ENSURE_QT_CONNECT(page, &QWebEnginePage::pdfPrintingFinished, this, [this, worker](const QString &, bool ok) {
+        if (worker->busy && worker->printGeneration == worker->generation) {
+            completeJob(worker, ok, ok ? QString() : QStringLiteral("printToPdf failed"));
+        }
+    });
+}
+
+void BatchRenderer::replacePage(Worker *worker)
+{
+    // loadFinished / pdfPrintingFinished 不带任务标识，被放弃的加载或打印迟到时无法与下一个任务区分；
+    // 换一个新页面，旧页面上的信号随它一起断开
+    QWebEnginePage *stale = worker->view->page();
+    worker->view->setPage(new QWebEnginePage(m_profile, worker->view));
+    connectPage(worker, worker->view->page());
+    if (stale) {
+        stale->disconnect(this);
+        stale->deleteLater();
+    }
+}
+
+void BatchRenderer::dispatchNext(Worker *worker)
+{
+    if (m_queue.empty()) {
+        worker->busy = false;
+        const bool allIdle = std::none_of(m_workers.cbegin(), m_workers.cend(), [](const auto &candidate) {
+            return candidate->busy;
+        });
+        if (allIdle && m_pendingDispatches == 0) {
+            finish();
+        }
+        return;
+    }
+
+    worker->job = m_queue.front();
+    m_queue.pop_front();
+    ++worker->job.attempts;
+    ++worker->generation;
+    worker->busy = true;
+    worker->clock.start();
+    worker->timeout->start();
+    worker->loadGeneration = worker->generation;
+    worker->startedGeneration = 0;
+    worker->view->page()->load(worker->job.url);
+}
+
+void BatchRenderer::handleLoadFinished(Worker *worker, quint64 generation, bool ok)
+{
+    if (!worker->busy || generation != worker->generation) {
+        return;
+    }
+    // 每次 load() 只处理一个 loadFinished，页面自身随后发起的导航不会再触发截图
+    worker->loadGeneration = 0;
+    worker->startedGeneration = 0;
+    if (!ok) {
+        completeJob(worker, false, QStringLiteral("load failed"));
+        return;
+    }
+    QTimer::singleShot(m_options.settleMs, this, [this, worker, generation]() {
+        capture(worker, generation);
+    });
+}
+
+void BatchRenderer::capture(Worker *worker, quint64 generation)
+{
+    if (!worker->busy || generation != worker->generation) {
+        return;
+    }
+
+    if (m_options.format == BatchRenderOptions::Format::Pdf) {
+        const QPageLayout layout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF());
+        worker->printGeneration = generation;
+        worker->view->page()->printToPdf(worker->job.outputPath, layout);
+        return;
+    }
+
+    // 只截取视口，超出 --viewport 的内容不在 PNG 中
+    const QPixmap pixmap = worker->view->grab();
+    const bool saved = !pixmap.isNull() && pixmap.save(worker->job.outputPath, "PNG");
+    completeJob(worker, saved, saved ? QString() : QStringLiteral("grab failed"));
+}
+
+void BatchRenderer::completeJob(Worker *worker, bool success, const QString &reason)
+{
+    if (!worker->busy) {
+        return;
+    }
+    worker->timeout->stop();
+    // 使在途的回调失效，避免超时后迟到的 loadFinished 影响下一个任务
+    ++worker->generation;
+    worker->busy = false;
+
+    const Job job = worker->job;
+    if (success) {
+        m_renderTimesMs.append(worker->clock.elapsed());
+    } else if (job.attempts <= m_options.retries) {
+        qWarning().noquote() << "BatchRenderer: retrying" << job.url.toString() << "after" << reason;
+        m_queue.push_back(job);
+    } else {
+        qWarning().noquote() << "BatchRenderer: giving up on" << job.url.toString() << "-" << reason;
+        m_failures.append(QStringLiteral("%1 (%2)").arg(job.url.toString(), reason));
+    }
+
+    // 延后到下一轮事件循环再派发，避免在 WebEngine 信号回调里直接发起新的加载
+    ++m_pendingDispatches;
+    QTimer::singleShot(0, this, [this, worker]() {
+        --m_pendingDispatches;
+        dispatchNext(worker);
+    });
+}
+
+void BatchRenderer::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    const double seconds = qMax<qint64>(1, m_totalClock.elapsed()) / 1000.0;
+    const int succeeded = m_renderTimesMs.size();
+    QTextStream out(stdout);
+    out << "Rendered " << succeeded << '/' << m_totalJobs << " pages in " << QString::number(seconds, 'f', 2)
+        << " s\n";
+    out << "Throughput: " << QString::number(succeeded / seconds, 'f', 2) << " pages/s\n";
+    out << "Render time p50: " << MetricsRegistry::percentile(m_renderTimesMs, 0.50)
+        << " ms, p95: " << MetricsRegistry::percentile(m_renderTimesMs, 0.95)
+        << " ms, max: " << MetricsRegistry::percentile(m_renderTimesMs, 1.0) << " ms\n";
+    for (const QString &failure : std::as_const(m_failures)) {
+        out << "FAILED " << failure << '\n';
+    }
+    out.flush();
+
+    emit finished(m_failures.isEmpty() ? 0 : 1);
+}
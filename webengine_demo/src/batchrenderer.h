@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QTimer;
+class QWebEnginePage;
+class QWebEngineProfile;
+class QWebEngineView;
+
+// BatchRenderOptions 描述无界面批量渲染模式的命令行参数。
+struct BatchRenderOptions
+{
+    enum class Format
+    {
+        Pdf,
+        Png,
+    };
+
+    QString manifestPath;
+    QString outputDir;
+    Format format {Format::Pdf};
+    int concurrency {4};
+    int timeoutMs {30000};
+    int retries {1};
+    int settleMs {500};
+    QSize viewport {1280, 800};
+
+    // 解析 --batch-render 相关参数；未指定 --batch-render 时返回 false。
+    static bool fromArguments(const QStringList &arguments, BatchRenderOptions *options, QString *error);
+};
+
+// BatchRenderer 读取 URL 清单，使用共享同一个 profile 的多个离屏页面并发渲染为 PDF / PNG，
+// PNG 只截取视口大小（--viewport），不是整页长图；支持超时与重试，结束后输出吞吐量（页/秒）与 p95 渲染耗时并退出事件循环。
+class BatchRenderer final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatchRenderer(const BatchRenderOptions &options, QObject *parent = nullptr);
+    ~BatchRenderer() override;
+
+public slots:
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Job
+    {
+        int index {0};
+        QUrl url;
+        QString outputPath;
+        int attempts {0};
+    };
+
+    struct Worker
+    {
+        QWebEngineView *view {nullptr};
+        QTimer *timeout {nullptr};
+        Job job;
+        quint64 generation {0};
+        // 发起 load() / printToPdf() 时的 generation，对应信号到达时与当前值比较；loadFinished 处理后 loadGeneration 归零
+        quint64 loadGeneration {0};
+        // 收到 loadStarted 时的 loadGeneration：被放弃的上一次导航的 loadFinished 会早于本次 loadStarted 到达
+        quint64 startedGeneration {0};
+        quint64 printGeneration {0};
+        bool busy {false};
+        QElapsedTimer clock;
+    };
+
+    bool loadManifest(QString *error);
+    QString outputPathFor(int index, const QUrl &url, const QString &name) const;
+    Worker *createWorker();
+    void connectPage(Worker *worker, QWebEnginePage *page);
+    void replacePage(Worker *worker);
+    void dispatchNext(Worker *worker);
+    void handleLoadFinished(Worker *worker, quint64 generation, bool ok);
+    void capture(Worker *worker, quint64 generation);
+    void completeJob(Worker *worker, bool success, const QString &reason);
+    void finish();
+
+    BatchRenderOptions m_options;
+    QWebEngineProfile *m_profile {nullptr};
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::deque<Job> m_queue;
+    QVector<double> m_renderTimesMs;
+    QStringList m_failures;
+    QElapsedTimer m_totalClock;
+    int m_totalJobs {0};
+    int m_pendingDispatches {0};
+    bool m_finished {false};
+};
@@ -0,0 +1,151 @@
+#include "bridgerouter.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+#include "tracerecorder.h"
+#include "webenginepane.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QWebEngineView>
+
+namespace {
+MetricsRegistry::Counter &routedCounter(bool broadcast)
+{
+    static const char *const kHelp = "Messages routed between C++ and windows.";
+    static const char *const kName = "webengine_demo_router_messages_total";
+    static MetricsRegistry::Counter &s_unicast =
+        MetricsRegistry::instance().counter(kName, kHelp, {{"mode", QStringLiteral("unicast")}});
+    static MetricsRegistry::Counter &s_broadcast =
+        MetricsRegistry::instance().counter(kName, kHelp, {{"mode", QStringLiteral("broadcast")}});
+    return broadcast ? s_broadcast : s_unicast;
+}
+} // namespace
+
+BridgeRouter::BridgeRouter(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void BridgeRouter::attach(int windowId, WebEnginePane *pane)
+{
+    if (!pane || windowId <= 0) {
+        return;
+    }
+    detach(windowId);
+    m_panes.insert(windowId, pane);
+    ENSURE_QT_CONNECT(pane, &WebEnginePane::messageFromJs, this, [this, windowId](const QString &payload) {
+        emit messageFromWindow(windowId, payload);
+        relay(windowId, payload);
+    });
+    ENSURE_QT_CONNECT(pane, &QObject::destroyed, this, [this, windowId]() {
+        m_panes.remove(windowId);
+    });
+}
+
+void BridgeRouter::detach(int windowId)
+{
+    const QPointer<WebEnginePane> pane = m_panes.take(windowId);
+    if (pane) {
+        disconnect(pane, nullptr, this, nullptr);
+    }
+}
+
+QList<int> BridgeRouter::windowIds() const
+{
+    return m_panes.keys();
+}
+
+BridgeRouter::Stats BridgeRouter::stats() const
+{
+    return m_stats;
+}
+
+bool BridgeRouter::sendTo(int windowId, const QJsonObject &message)
+{
+    if (!m_panes.contains(windowId)) {
+        ++m_stats.unknownTargets;
+        return false;
+    }
+    return sendTo(windowId, serialize(message));
+}
+
+bool BridgeRouter::sendTo(int windowId, const QString &payload)
+{
+    ++m_stats.unicasts;
+    routedCounter(false).increment();
+    if (!deliver(windowId, payload)) {
+        ++m_stats.unknownTargets;
+        qWarning() << "BridgeRouter: no window with id" << windowId;
+        return false;
+    }
+    return true;
+}
+
+int BridgeRouter::broadcast(const QJsonObject &message, int excludeWindowId)
+{
+    return broadcast(serialize(message), excludeWindowId);
+}
+
+int BridgeRouter::broadcast(const QString &payload, int excludeWindowId)
+{
+    TRACE_SCOPE_ARG("bridge", "BridgeRouter::broadcast", "windows", QString::number(m_panes.size()));
+    ++m_stats.broadcasts;
+    routedCounter(true).increment();
+    int delivered = 0;
+    // 先取快照：投递过程中窗口可能关闭
+    const QList<int> ids = m_panes.keys();
+    for (const int id : ids) {
+        if (id != excludeWindowId && deliver(id, payload)) {
+            ++delivered;
+        }
+    }
+    return delivered;
+}
+
+QString BridgeRouter::serialize(const QJsonObject &message)
+{
+    ++m_stats.serializations;
+    return QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+}
+
+bool BridgeRouter::deliver(int windowId, const QString &payload)
+{
+    WebEnginePane *pane = m_panes.value(windowId);
+    if (!pane) {
+        return false;
+    }
+    pane->broadcastToPage(payload);
+    ++m_stats.deliveries;
+    return true;
+}
+
+void BridgeRouter::relay(int fromWindowId, const QString &payload)
+{
+    // 普通文本消息不做解析，只有形如 JSON 对象且带 to 字段的消息才转发
+    if (!payload.startsWith(QLatin1Char('{'))) {
+        return;
+    }
+    QJsonObject message = QJsonDocument::fromJson(payload.toUtf8()).object();
+    const QJsonValue target = message.take(QStringLiteral("to"));
+    const bool toAll = target.toString() == QLatin1String("*");
+    if (!toAll && !target.isDouble()) {
+        return;
+    }
+    // 只有应用自带的 qrc: 页面可以给其他窗口发消息，窗口里打开的网页不行
+    const WebEnginePane *pane = m_panes.value(fromWindowId);
+    const QUrl origin = pane && pane->view() ? pane->view()->url() : QUrl();
+    if (origin.scheme() != QLatin1String("qrc")) {
+        ++m_stats.rejectedRelays;
+        qWarning() << "BridgeRouter: relay from untrusted page rejected" << origin;
+        return;
+    }
+    message.insert(QStringLiteral("from"), fromWindowId);
+    ++m_stats.relayed;
+    if (toAll) {
+        broadcast(message, fromWindowId);
+    } else {
+        sendTo(target.toInt(), message);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class WebEnginePane;
+
+// BridgeRouter 把 C++ 消息按窗口 id 投递或广播给所有窗口：JSON 消息只序列化一次，
+// 各窗口拿到的是同一份隐式共享的字符串；qrc: 页面发来的 {"to": id | "*"} 消息也经这里转发给其他窗口。
+class BridgeRouter final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        qint64 unicasts {0};
+        qint64 broadcasts {0};
+        qint64 relayed {0};
+        qint64 deliveries {0};
+        qint64 serializations {0};
+        qint64 unknownTargets {0};
+        // 来自非 qrc: 页面、被拒绝转发的消息
+        qint64 rejectedRelays {0};
+    };
+
+    explicit BridgeRouter(QObject *parent = nullptr);
+
+    void attach(int windowId, WebEnginePane *pane);
+    void detach(int windowId);
+    QList<int> windowIds() const;
+    Stats stats() const;
+
+    bool sendTo(int windowId, const QJsonObject &message);
+    bool sendTo(int windowId, const QString &payload);
+    // 返回实际投递的窗口数；excludeWindowId 用于转发时跳过发送方
+    int broadcast(const QJsonObject &message, int excludeWindowId = 0);
+    int broadcast(const QString &payload, int excludeWindowId = 0);
+
+signals:
+    void messageFromWindow(int windowId, const QString &payload);
+
+private:
+    QString serialize(const QJsonObject &message);
+    bool deliver(int windowId, const QString &payload);
+    void relay(int fromWindowId, const QString &payload);
+
+    // 按 id 有序，广播顺序稳定
+    QMap<int, QPointer<WebEnginePane>> m_panes;
+    Stats m_stats;
+};
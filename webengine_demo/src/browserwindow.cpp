@@ -1,17 +1,30 @@
 #include "browserwindow.h"
 
+#include "configmanager.h"
+#include "configwatcher.h"
 #include "connectguard.h"
+#include "cookiejartransfer.h"
+#include "downloadmanager.h"
+#include "jankmonitor.h"
+#include "jankoverlay.h"
 #include "messageconsole.h"
+#include "renderermonitor.h"
+#include "startuptrace.h"
+#include "tracerecorder.h"
 #include "webenginepane.h"
 #include "webbridge.h"
 
 #include <QAction>
 #include <QApplication>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QJsonObject>
+#include <QLabel>
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QSlider>
 #include <QStatusBar>
+#include <QTimer>
 #include <QToolBar>
 #include <QUrl>
 #include <QVBoxLayout>
@@ -24,10 +37,14 @@ namespace {
 constexpr int kOpacityMin = 40;
 constexpr int kOpacityMax = 100;
 constexpr int kOpacityDefault = 95;
+// 页面没有上报计时（例如加载失败）时，首次加载完成后最多再等这么久输出启动汇总
+constexpr int kStartupTraceFallbackMs = 10000;
 } // namespace
 
-BrowserWindow::BrowserWindow(QWidget *parent)
+BrowserWindow::BrowserWindow(StartupMode mode, QWidget *parent, SharedProfile *sharedProfile)
     : QMainWindow(parent)
+    , m_startupMode(mode)
+    , m_sharedProfile(sharedProfile)
 {
     setWindowTitle(tr("Qt WebEngine 综合 Demo"));
     resize(1200, 800);
@@ -44,22 +61,42 @@ BrowserWindow::BrowserWindow(QWidget *parent)
         ENSURE_QT_CONNECT(m_console, &MessageConsole::messageFromWeb, this, &BrowserWindow::handleMessageFromPage);
     }
 
-    if (m_engine) {
-        m_engine->load(homeUrl());
-        ENSURE_QT_CONNECT(m_engine, &WebEnginePane::urlChanged, this, [this](const QUrl &url) {
-            if (!url.isEmpty()) {
-                m_addressBar->setText(url.toString());
-            }
-        });
-        ENSURE_QT_CONNECT(m_engine, &WebEnginePane::loadFinished, this, &BrowserWindow::handleLoadFinished);
-    }
-
     m_addressBar->setText(homeUrl().toString());
     applyOpacity(kOpacityDefault);
+
+    if (m_startupMode == StartupMode::Standard) {
+        createEngine();
+    } else {
+        updateStatus(tr("正在初始化网页引擎..."), 0);
+    }
 }
 
 BrowserWindow::~BrowserWindow() = default;
 
+WebEnginePane *BrowserWindow::engine() const
+{
+    return m_engine;
+}
+
+RendererMonitor *BrowserWindow::rendererMonitor() const
+{
+    return m_rendererMonitor;
+}
+
+void BrowserWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    if (m_firstPaintSeen) {
+        return;
+    }
+    m_firstPaintSeen = true;
+    StartupTrace::mark(QStringLiteral("first-window-paint"));
+    if (m_startupMode == StartupMode::FastStart && !m_engine) {
+        // 推迟到本次绘制与 flush 完成之后，保证外壳先上屏
+        QTimer::singleShot(0, this, &BrowserWindow::createEngine);
+    }
+}
+
 void BrowserWindow::buildUi()
 {
     auto *central = new QWidget(this);
@@ -67,18 +104,109 @@ void BrowserWindow::buildUi()
     central->setStyleSheet("#centralWidget { background-color: rgba(255, 255, 255, 255); }");
     setCentralWidget(central);
 
-    auto *layout = new QVBoxLayout(central);
-    layout->setContentsMargins(8, 8, 8, 8);
-    layout->setSpacing(8);
+    m_centralLayout = new QVBoxLayout(central);
+    m_centralLayout->setContentsMargins(8, 8, 8, 8);
+    m_centralLayout->setSpacing(8);
 
-    m_engine = new WebEnginePane(new BasicBridge, this);
-    layout->addWidget(m_engine, 1);
+    m_enginePlaceholder = new QLabel(tr("正在初始化网页引擎..."), central);
+    m_enginePlaceholder->setAlignment(Qt::AlignCenter);
+    m_enginePlaceholder->setStyleSheet("color: rgb(140, 140, 140);");
+    m_centralLayout->addWidget(m_enginePlaceholder, 1);
 
     m_console = new MessageConsole(this);
-    layout->addWidget(m_console);
+    m_centralLayout->addWidget(m_console);
+}
+
+void BrowserWindow::createEngine()
+{
     if (m_engine) {
-        m_console->attachBridge(m_engine->bridge());
+        return;
+    }
+    StartupTrace::mark(QStringLiteral("engine-create-begin"));
+    m_engine = new WebEnginePane(new BasicBridge, this, m_sharedProfile);
+    StartupTrace::mark(QStringLiteral("engine-pane-created"));
+
+    // 先发起导航，其余界面接线在渲染进程启动期间完成
+    m_engine->load(m_pendingUrl.isValid() ? m_pendingUrl : homeUrl());
+    m_pendingUrl.clear();
+    StartupTrace::mark(QStringLiteral("navigation-started"));
+
+    m_centralLayout->replaceWidget(m_enginePlaceholder, m_engine);
+    m_centralLayout->setStretchFactor(m_engine, 1);
+    m_enginePlaceholder->deleteLater();
+    m_enginePlaceholder = nullptr;
+
+    ENSURE_QT_CONNECT(m_engine, &WebEnginePane::urlChanged, this, [this](const QUrl &url) {
+        if (!url.isEmpty()) {
+            m_addressBar->setText(url.toString());
+        }
+    });
+    ENSURE_QT_CONNECT(m_engine, &WebEnginePane::loadFinished, this, &BrowserWindow::handleLoadFinished);
+    ENSURE_QT_CONNECT(m_engine, &WebEnginePane::timingReportReady, this, &BrowserWindow::handleTimingReport);
+
+    // 后台冻结与内存压力动作只用于交互窗口
+    m_engine->enableLifecycle();
+    m_rendererMonitor = new RendererMonitor(m_engine);
+    m_rendererMonitor->setPolicy(ConfigManager::instance().memoryPressure());
+    ENSURE_QT_CONNECT(m_rendererMonitor, &RendererMonitor::sharedCacheClearRequested, this,
+                      &BrowserWindow::httpCacheClearRequested);
+    if (auto *watcher = ConfigWatcher::instance()) {
+        watcher->onChanged(QStringLiteral("memoryPressure"), m_rendererMonitor, [this]() {
+            m_rendererMonitor->setPolicy(ConfigManager::instance().memoryPressure());
+        });
     }
+
+    m_jankOverlay = new JankOverlay(m_engine);
+    m_jankOverlay->setVisible(m_jankAction && m_jankAction->isChecked());
+    if (auto *monitor = m_engine->jankMonitor()) {
+        ENSURE_QT_CONNECT(monitor, &JankMonitor::snapshotUpdated, m_jankOverlay, &JankOverlay::updateSnapshot);
+    }
+
+    if (m_console) {
+        m_console->attachPane(m_engine);
+    }
+    if (auto *cookieJar = m_engine->cookieJar()) {
+        ENSURE_QT_CONNECT(cookieJar, &CookieJarTransfer::progress, this, [this](qint64 processed, qint64 skipped) {
+            updateStatus(tr("Cookie 处理中：%1 条（跳过 %2 条）").arg(processed).arg(skipped), 0);
+        });
+        ENSURE_QT_CONNECT(cookieJar, &CookieJarTransfer::importFinished, this, &BrowserWindow::handleCookieImportFinished);
+        ENSURE_QT_CONNECT(cookieJar, &CookieJarTransfer::exportFinished, this, &BrowserWindow::handleCookieExportFinished);
+    }
+    if (auto *downloads = m_engine->downloads()) {
+        ENSURE_QT_CONNECT(downloads, &DownloadManager::statsUpdated, this, [this](const DownloadManager::Stats &stats) {
+            if (stats.active + stats.queued == 0) {
+                return;
+            }
+            updateStatus(tr("下载中：%1 个进行中，%2 个排队，%3 KiB/s%4")
+                             .arg(stats.active)
+                             .arg(stats.queued)
+                             .arg(stats.bytesPerSecond / 1024)
+                             .arg(stats.throttled ? tr("（限速中）") : QString()),
+                         0);
+        });
+        ENSURE_QT_CONNECT(downloads, &DownloadManager::downloadFinished, this,
+                          [this](const QString &filePath, bool ok, const QString &error) {
+                              updateStatus(ok ? tr("下载完成：%1").arg(filePath)
+                                              : tr("下载失败：%1（%2）").arg(filePath, error));
+                          });
+    }
+    if (m_userAgentInput) {
+        m_userAgentInput->setText(m_engine->currentUserAgent());
+    }
+    if (m_redirectInput) {
+        m_redirectInput->setText(m_engine->redirectTarget().toString());
+    }
+    for (QAction *action : qAsConst(m_engineActions)) {
+        action->setEnabled(true);
+    }
+    if (m_transparentAction && m_transparentAction->isChecked()) {
+        updateWindowTransparency(true);
+    }
+    if (m_startupMode == StartupMode::FastStart) {
+        statusBar()->clearMessage();
+    }
+    StartupTrace::mark(QStringLiteral("engine-ready"));
+    emit engineReady();
 }
 
 void BrowserWindow::buildToolbar()
@@ -87,13 +215,16 @@ void BrowserWindow::buildToolbar()
     toolbar->setMovable(false);
     toolbar->setStyleSheet("background-color:rgb(255,255,255)");
 
-    if (m_engine && m_engine->view()) {
-        toolbar->addAction(tr("后退"), m_engine->view(), &QWebEngineView::back);
-        toolbar->addAction(tr("前进"), m_engine->view(), &QWebEngineView::forward);
-        toolbar->addAction(tr("刷新"), m_engine->view(), &QWebEngineView::reload);
-    }
+    m_engineActions << toolbar->addAction(tr("后退"), this, &BrowserWindow::navigateBack);
+    m_engineActions << toolbar->addAction(tr("前进"), this, &BrowserWindow::navigateForward);
+    m_engineActions << toolbar->addAction(tr("刷新"), this, &BrowserWindow::reloadPage);
     auto *homeAction = toolbar->addAction(tr("主页"));
     ENSURE_QT_CONNECT(homeAction, &QAction::triggered, this, &BrowserWindow::navigateHome);
+    // 只有多窗口控制器管理的窗口才能新开窗口
+    if (m_sharedProfile) {
+        auto *newWindowAction = toolbar->addAction(tr("新窗口"));
+        ENSURE_QT_CONNECT(newWindowAction, &QAction::triggered, this, &BrowserWindow::newWindowRequested);
+    }
 
     m_addressBar = new QLineEdit(this);
     m_addressBar->setPlaceholderText(tr("输入 URL 或按 Enter 加载"));
@@ -101,31 +232,28 @@ void BrowserWindow::buildToolbar()
     ENSURE_QT_CONNECT(m_addressBar, &QLineEdit::returnPressed, this, &BrowserWindow::loadRequestedUrl);
     toolbar->addWidget(m_addressBar);
 
-    if (m_engine && m_engine->profile()) {
-        toolbar->addSeparator();
-        m_userAgentInput = new QLineEdit(this);
-        m_userAgentInput->setPlaceholderText(tr("自定义 UA（留空恢复默认）"));
-        m_userAgentInput->setClearButtonEnabled(true);
-        m_userAgentInput->setText(m_engine->currentUserAgent());
-        ENSURE_QT_CONNECT(m_userAgentInput, &QLineEdit::returnPressed, this, &BrowserWindow::applyCustomUserAgent);
-        ENSURE_QT_CONNECT(m_userAgentInput, &QLineEdit::editingFinished, this, &BrowserWindow::applyCustomUserAgent);
-        toolbar->addWidget(m_userAgentInput);
-    }
+    // UA 与重定向输入框的初始值在 createEngine() 中填充
+    toolbar->addSeparator();
+    m_userAgentInput = new QLineEdit(this);
+    m_userAgentInput->setPlaceholderText(tr("自定义 UA（留空恢复默认）"));
+    m_userAgentInput->setClearButtonEnabled(true);
+    ENSURE_QT_CONNECT(m_userAgentInput, &QLineEdit::returnPressed, this, &BrowserWindow::applyCustomUserAgent);
+    ENSURE_QT_CONNECT(m_userAgentInput, &QLineEdit::editingFinished, this, &BrowserWindow::applyCustomUserAgent);
+    toolbar->addWidget(m_userAgentInput);
 
-    if (m_engine) {
-        toolbar->addSeparator();
-        m_redirectInput = new QLineEdit(this);
-        m_redirectInput->setPlaceholderText(tr("知乎重定向目标（默认 https://baidu.com）"));
-        m_redirectInput->setClearButtonEnabled(true);
-        m_redirectInput->setText(m_engine->redirectTarget().toString());
-        ENSURE_QT_CONNECT(m_redirectInput, &QLineEdit::returnPressed, this, &BrowserWindow::applyRedirectTarget);
-        ENSURE_QT_CONNECT(m_redirectInput, &QLineEdit::editingFinished, this, &BrowserWindow::applyRedirectTarget);
-        toolbar->addWidget(m_redirectInput);
-    }
+    toolbar->addSeparator();
+    m_redirectInput = new QLineEdit(this);
+    m_redirectInput->setPlaceholderText(tr("知乎重定向目标（默认 https://baidu.com）"));
+    m_redirectInput->setClearButtonEnabled(true);
+    ENSURE_QT_CONNECT(m_redirectInput, &QLineEdit::returnPressed, this, &BrowserWindow::applyRedirectTarget);
+    ENSURE_QT_CONNECT(m_redirectInput, &QLineEdit::editingFinished, this, &BrowserWindow::applyRedirectTarget);
+    toolbar->addWidget(m_redirectInput);
 
     toolbar->addSeparator();
     auto *clearAction = toolbar->addAction(tr("清空缓存"));
     ENSURE_QT_CONNECT(clearAction, &QAction::triggered, this, &BrowserWindow::clearProfileData);
+    m_engineActions << toolbar->addAction(tr("导入 Cookie"), this, &BrowserWindow::importCookies);
+    m_engineActions << toolbar->addAction(tr("导出 Cookie"), this, &BrowserWindow::exportCookies);
     auto *sendAction = toolbar->addAction(tr("消息面板"));
     ENSURE_QT_CONNECT(sendAction, &QAction::triggered, this, &BrowserWindow::showMessageConsole);
 
@@ -133,6 +261,22 @@ void BrowserWindow::buildToolbar()
     m_transparentAction->setCheckable(true);
     ENSURE_QT_CONNECT(m_transparentAction, &QAction::toggled, this, &BrowserWindow::handleTransparencyToggle);
 
+    m_jankAction = toolbar->addAction(tr("性能浮层"));
+    m_jankAction->setCheckable(true);
+    ENSURE_QT_CONNECT(m_jankAction, &QAction::toggled, this, &BrowserWindow::handleJankOverlayToggle);
+
+    // 以 --trace 启动时按钮初始为按下状态
+    m_traceAction = toolbar->addAction(tr("追踪"));
+    m_traceAction->setCheckable(true);
+    m_traceAction->setChecked(TraceRecorder::isEnabled());
+    ENSURE_QT_CONNECT(m_traceAction, &QAction::toggled, this, &BrowserWindow::handleTraceToggle);
+
+    if (!m_engine) {
+        for (QAction *action : qAsConst(m_engineActions)) {
+            action->setEnabled(false);
+        }
+    }
+
     auto *sliderAction = new QWidgetAction(this);
     m_opacitySlider = new QSlider(Qt::Horizontal, toolbar);
     m_opacitySlider->setRange(kOpacityMin, kOpacityMax);
@@ -143,6 +287,27 @@ void BrowserWindow::buildToolbar()
     toolbar->addAction(sliderAction);
 }
 
+void BrowserWindow::navigateBack()
+{
+    if (m_engine && m_engine->view()) {
+        m_engine->view()->back();
+    }
+}
+
+void BrowserWindow::navigateForward()
+{
+    if (m_engine && m_engine->view()) {
+        m_engine->view()->forward();
+    }
+}
+
+void BrowserWindow::reloadPage()
+{
+    if (m_engine && m_engine->view()) {
+        m_engine->view()->reload();
+    }
+}
+
 void BrowserWindow::loadRequestedUrl()
 {
     const QString text = m_addressBar->text().trimmed();
@@ -154,6 +319,8 @@ void BrowserWindow::loadRequestedUrl()
     QUrl url = QUrl::fromUserInput(text);
     if (m_engine) {
         m_engine->load(url);
+    } else {
+        m_pendingUrl = url;
     }
     updateStatus(tr("加载 %1").arg(url.toString()));
 }
@@ -162,6 +329,8 @@ void BrowserWindow::navigateHome()
 {
     if (m_engine) {
         m_engine->load(homeUrl());
+    } else {
+        m_pendingUrl.clear();
     }
 }
 
@@ -173,6 +342,54 @@ void BrowserWindow::clearProfileData()
     updateStatus(tr("缓存与 Cookie 清理完成"));
 }
 
+void BrowserWindow::importCookies()
+{
+    auto *cookieJar = m_engine ? m_engine->cookieJar() : nullptr;
+    if (!cookieJar || cookieJar->isBusy()) {
+        return;
+    }
+    const QString path = QFileDialog::getOpenFileName(this,
+                                                      tr("导入 Cookie"),
+                                                      QString(),
+                                                      tr("Cookie 文件 (*.txt *.jsonl *.json);;所有文件 (*)"));
+    if (!path.isEmpty() && cookieJar->importFile(path)) {
+        updateStatus(tr("正在导入 Cookie：%1").arg(path), 0);
+    }
+}
+
+void BrowserWindow::exportCookies()
+{
+    auto *cookieJar = m_engine ? m_engine->cookieJar() : nullptr;
+    if (!cookieJar || cookieJar->isBusy()) {
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this,
+                                                      tr("导出 Cookie"),
+                                                      QStringLiteral("cookies.txt"),
+                                                      tr("Netscape cookies.txt (*.txt);;JSON Lines (*.jsonl)"));
+    if (!path.isEmpty() && cookieJar->exportFile(path)) {
+        updateStatus(tr("正在导出 Cookie：%1").arg(path), 0);
+    }
+}
+
+void BrowserWindow::handleCookieImportFinished(qint64 imported, qint64 skipped, const QString &error)
+{
+    if (!error.isEmpty()) {
+        updateStatus(tr("Cookie 导入中止（已导入 %1 条）：%2").arg(imported).arg(error), 8000);
+        return;
+    }
+    updateStatus(tr("已导入 %1 条 Cookie，跳过 %2 条无效记录").arg(imported).arg(skipped), 8000);
+}
+
+void BrowserWindow::handleCookieExportFinished(qint64 exported, const QString &error)
+{
+    if (!error.isEmpty()) {
+        updateStatus(tr("Cookie 导出失败：%1").arg(error), 8000);
+        return;
+    }
+    updateStatus(tr("已导出 %1 条 Cookie（含 HttpOnly）").arg(exported), 8000);
+}
+
 void BrowserWindow::showMessageConsole()
 {
     if (!m_console) {
@@ -190,6 +407,14 @@ void BrowserWindow::handleMessageFromPage(const QString &payload)
 
 void BrowserWindow::handleLoadFinished(bool ok)
 {
+    if (!m_firstLoadSeen) {
+        m_firstLoadSeen = true;
+        StartupTrace::mark(QStringLiteral("first-load-finished"));
+        emit firstLoadFinished(ok);
+        QTimer::singleShot(kStartupTraceFallbackMs, this, []() {
+            StartupTrace::finish();
+        });
+    }
     if (ok) {
         updateStatus(tr("页面加载完成"));
         if (m_engine) {
@@ -202,6 +427,32 @@ void BrowserWindow::handleLoadFinished(bool ok)
     }
 }
 
+void BrowserWindow::handleTimingReport(const QJsonObject &report)
+{
+    if (!m_firstTimingSeen) {
+        m_firstTimingSeen = true;
+        // FCP 以页面 timeOrigin 为基准，折算到发起导航的时间点上
+        const QJsonValue fcp = report.value(QStringLiteral("firstContentfulPaintMs"));
+        const qint64 navigationNs = StartupTrace::phaseNs(QStringLiteral("navigation-started"));
+        if (fcp.isDouble() && navigationNs >= 0) {
+            StartupTrace::markAt(QStringLiteral("first-contentful-paint"),
+                                 navigationNs + static_cast<qint64>(fcp.toDouble() * 1e6));
+        }
+        StartupTrace::finish();
+    }
+    if (!report.value(QStringLiteral("ok")).toBool()) {
+        return;
+    }
+    const auto formatMs = [](const QJsonValue &value) {
+        return value.isDouble() ? QString::number(qRound(value.toDouble())) : QStringLiteral("-");
+    };
+    updateStatus(tr("TTFB %1 ms，首次内容绘制 %2 ms，load %3 ms")
+                     .arg(formatMs(report.value(QStringLiteral("ttfbMs"))),
+                          formatMs(report.value(QStringLiteral("firstContentfulPaintMs"))),
+                          formatMs(report.value(QStringLiteral("loadMs")))),
+                 8000);
+}
+
 void BrowserWindow::applyOpacity(int sliderValue)
 {
     const auto opacity = static_cast<double>(sliderValue) / 100.0;
@@ -213,6 +464,28 @@ void BrowserWindow::handleTransparencyToggle(bool enabled)
     updateWindowTransparency(enabled);
 }
 
+void BrowserWindow::handleJankOverlayToggle(bool enabled)
+{
+    if (!m_jankOverlay) {
+        return;
+    }
+    m_jankOverlay->setVisible(enabled);
+    if (enabled) {
+        m_jankOverlay->raise();
+    }
+}
+
+void BrowserWindow::handleTraceToggle(bool enabled)
+{
+    if (enabled) {
+        TraceRecorder::start();
+        updateStatus(tr("开始记录追踪事件"));
+        return;
+    }
+    const QString path = TraceRecorder::stop();
+    updateStatus(path.isEmpty() ? tr("追踪文件写入失败") : tr("追踪已保存到 %1，可在 chrome://tracing 中打开").arg(path), 10000);
+}
+
 void BrowserWindow::applyCustomUserAgent()
 {
     if (!m_engine) {
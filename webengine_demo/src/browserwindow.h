@@ -1,33 +1,75 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QJsonObject>
+#include <QList>
 #include <QUrl>
 
 class QLineEdit;
 class QSlider;
 class QAction;
+class QLabel;
+class QVBoxLayout;
+class JankOverlay;
 class WebEnginePane;
 class MessageConsole;
+class RendererMonitor;
+class SharedProfile;
 
 class BrowserWindow final : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit BrowserWindow(QWidget *parent = nullptr);
+    // FastStart 先显示窗口外壳，首帧绘制后再创建 WebEnginePane 并立即发起首次导航
+    enum class StartupMode
+    {
+        Standard,
+        FastStart,
+    };
+
+    // sharedProfile 由多窗口控制器传入，为空时 WebEnginePane 自行创建 profile
+    explicit BrowserWindow(StartupMode mode = StartupMode::Standard, QWidget *parent = nullptr,
+                           SharedProfile *sharedProfile = nullptr);
     ~BrowserWindow() override;
 
+    // FastStart 模式下 engineReady 之前为空
+    WebEnginePane *engine() const;
+    // 窗口为自己的 pane 挂的渲染进程监视器，engineReady 之前为空
+    RendererMonitor *rendererMonitor() const;
+
+signals:
+    void engineReady();
+    void firstLoadFinished(bool ok);
+    void newWindowRequested();
+    // 共用 profile 的内存压力清缓存请求，由 AppController 按 profile 合并执行
+    void httpCacheClearRequested();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
 private slots:
+    void createEngine();
     void loadRequestedUrl();
     void navigateHome();
     void clearProfileData();
+    void importCookies();
+    void exportCookies();
+    void handleCookieImportFinished(qint64 imported, qint64 skipped, const QString &error);
+    void handleCookieExportFinished(qint64 exported, const QString &error);
     void showMessageConsole();
     void handleMessageFromPage(const QString &payload);
     void handleLoadFinished(bool ok);
+    void handleTimingReport(const QJsonObject &report);
     void applyOpacity(int sliderValue);
     void handleTransparencyToggle(bool enabled);
     void applyCustomUserAgent();
     void applyRedirectTarget();
+    void handleJankOverlayToggle(bool enabled);
+    void handleTraceToggle(bool enabled);
+    void navigateBack();
+    void navigateForward();
+    void reloadPage();
 
 private:
     void buildUi();
@@ -36,12 +78,25 @@ private:
     void updateWindowTransparency(bool transparent);
     [[nodiscard]] QUrl homeUrl() const;
 
+    StartupMode m_startupMode {StartupMode::Standard};
+    SharedProfile *m_sharedProfile {nullptr};
+    QVBoxLayout *m_centralLayout {nullptr};
+    QLabel *m_enginePlaceholder {nullptr};
+    QList<QAction *> m_engineActions;
+    QUrl m_pendingUrl;
+    bool m_firstPaintSeen {false};
+    bool m_firstLoadSeen {false};
+    bool m_firstTimingSeen {false};
     WebEnginePane *m_engine {nullptr};
+    RendererMonitor *m_rendererMonitor {nullptr};
     MessageConsole *m_console {nullptr};
     QLineEdit *m_addressBar {nullptr};
     QLineEdit *m_userAgentInput {nullptr};
     QLineEdit *m_redirectInput {nullptr};
     QSlider *m_opacitySlider {nullptr};
     QAction *m_transparentAction {nullptr};
+    QAction *m_jankAction {nullptr};
+    QAction *m_traceAction {nullptr};
+    JankOverlay *m_jankOverlay {nullptr};
 };
 
@@ -2,12 +2,20 @@
 
 #include <QByteArray>
 #include <QCoreApplication>
+#include <QJsonArray>
 #include <QDir>
 #include <QFile>
+#include <QHash>
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 
 namespace {
 QString resolveBaseDir(const QString &preferredDir)
@@ -21,10 +29,161 @@ QString resolveBaseDir(const QString &preferredDir)
     return QDir::currentPath();
 }
 
+constexpr int kDefaultCookieMirrorBudgetKiB = 4096;
+
+const QString kDefaultRenderingProfile = QStringLiteral("default");
+
 bool isValidPort(int port)
 {
     return port > 0 && port <= 65535;
 }
+
+QStringList splitFlags(const QString &flags)
+{
+    return flags.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+}
+
+QString resolvePath(const QString &baseDir, const QString &value)
+{
+    const QString path = value.trimmed();
+    return path.isEmpty() || QDir::isAbsolutePath(path) ? path : QDir(baseDir).filePath(path);
+}
+
+const QStringList kKnownKeys {
+    QStringLiteral("remoteDebugPort"),
+    QStringLiteral("metricsPort"),
+    QStringLiteral("pageFreezeDelayMs"),
+    QStringLiteral("pageTimingExportPath"),
+    QStringLiteral("fastStart"),
+    QStringLiteral("startupSplash"),
+    QStringLiteral("startupTracePath"),
+    QStringLiteral("renderingProfile"),
+    QStringLiteral("chromiumFlags"),
+    QStringLiteral("cookieMirrorBudgetKiB"),
+    QStringLiteral("downloads"),
+    QStringLiteral("memoryPressure"),
+    QStringLiteral("multiWindow"),
+    QStringLiteral("webChannel"),
+};
+
+// 按类型与范围读取单个键：键不存在返回 false；类型或范围不符时记录错误并返回 false，调用方保留默认值
+class SchemaReader
+{
+public:
+    SchemaReader(const QJsonObject &object, QStringList *errors, const QString &prefix = QString())
+        : m_object(object)
+        , m_errors(errors)
+        , m_prefix(prefix)
+    {
+    }
+
+    bool readInt(const QString &key, int min, int max, int *out) const
+    {
+        const QJsonValue value = m_object.value(key);
+        if (value.isUndefined() || value.isNull()) {
+            return false;
+        }
+        const double number = value.toDouble();
+        if (!value.isDouble() || number != std::floor(number)) {
+            return fail(key, QStringLiteral("expected integer"));
+        }
+        if (number < min || number > max) {
+            return fail(key, QStringLiteral("out of range [%1, %2]").arg(min).arg(max));
+        }
+        *out = static_cast<int>(number);
+        return true;
+    }
+
+    bool readBool(const QString &key, bool *out) const
+    {
+        const QJsonValue value = m_object.value(key);
+        if (value.isUndefined() || value.isNull()) {
+            return false;
+        }
+        if (!value.isBool()) {
+            return fail(key, QStringLiteral("expected boolean"));
+        }
+        *out = value.toBool();
+        return true;
+    }
+
+    bool readString(const QString &key, QString *out) const
+    {
+        const QJsonValue value = m_object.value(key);
+        if (value.isUndefined() || value.isNull()) {
+            return false;
+        }
+        if (!value.isString()) {
+            return fail(key, QStringLiteral("expected string"));
+        }
+        *out = value.toString().trimmed();
+        return true;
+    }
+
+private:
+    bool fail(const QString &key, const QString &message) const
+    {
+        m_errors->append(QStringLiteral("%1%2: %3").arg(m_prefix, key, message));
+        return false;
+    }
+
+    const QJsonObject &m_object;
+    QStringList *m_errors;
+    QString m_prefix;
+};
+
+QString switchName(const QString &flag)
+{
+    return flag.section(QLatin1Char('='), 0, 0);
+}
+
+bool isFeatureList(const QString &name)
+{
+    return name == QLatin1String("--enable-features") || name == QLatin1String("--disable-features");
+}
+
+// 同名开关只保留最后出现的一个，保证后来者（config 附加参数、环境变量）能覆盖预设。
+// --enable-features / --disable-features 是逗号分隔的列表，Chromium 只认最后一个，因此合并各处的取值；
+// 同一特性后出现的启用 / 禁用覆盖先出现的相反设置
+QStringList mergeFlags(const QStringList &flags)
+{
+    QStringList merged;
+    QHash<QString, QStringList> features;
+    for (const QString &flag : flags) {
+        const QString name = switchName(flag);
+        if (isFeatureList(name)) {
+            const QString opposite = name == QLatin1String("--enable-features") ? QStringLiteral("--disable-features")
+                                                                                 : QStringLiteral("--enable-features");
+            QStringList &values = features[name];
+            const QStringList added = flag.section(QLatin1Char('='), 1).split(QLatin1Char(','), Qt::SkipEmptyParts);
+            for (const QString &feature : added) {
+                features[opposite].removeAll(feature);
+                values.removeAll(feature);
+                values.append(feature);
+            }
+            if (!merged.contains(name)) {
+                merged.append(name);
+            }
+            continue;
+        }
+        merged.erase(std::remove_if(merged.begin(), merged.end(), [&name](const QString &existing) {
+                         return switchName(existing) == name;
+                     }),
+                     merged.end());
+        merged.append(flag);
+    }
+    for (auto it = merged.begin(); it != merged.end();) {
+        if (!isFeatureList(*it)) {
+            ++it;
+        } else if (features.value(*it).isEmpty()) {
+            it = merged.erase(it);
+        } else {
+            *it += QLatin1Char('=') + features.value(*it).join(QLatin1Char(','));
+            ++it;
+        }
+    }
+    return merged;
+}
 } // namespace
 
 ConfigManager &ConfigManager::instance()
@@ -33,88 +192,488 @@ ConfigManager &ConfigManager::instance()
     return s_instance;
 }
 
+QVector<ConfigManager::RenderingProfile> ConfigManager::renderingProfiles()
+{
+    return {
+        {QStringLiteral("default"),
+         QStringLiteral("ANGLE / OpenGL ES, Chromium defaults"),
+         {},
+         Qt::AA_UseOpenGLES,
+         false},
+        {QStringLiteral("gpu-raster"),
+         QStringLiteral("Desktop OpenGL with GPU rasterization and zero-copy uploads"),
+         {QStringLiteral("--ignore-gpu-blocklist"),
+          QStringLiteral("--enable-gpu-rasterization"),
+          QStringLiteral("--enable-zero-copy")},
+         Qt::AA_UseDesktopOpenGL,
+         true},
+        {QStringLiteral("low-memory"),
+         QStringLiteral("Single renderer process, one raster thread, low-end device heuristics"),
+         {QStringLiteral("--renderer-process-limit=1"),
+          QStringLiteral("--process-per-site"),
+          QStringLiteral("--num-raster-threads=1"),
+          QStringLiteral("--enable-low-end-device-mode"),
+          QStringLiteral("--disable-features=BackForwardCache")},
+         Qt::AA_UseOpenGLES,
+         false},
+        {QStringLiteral("throughput"),
+         QStringLiteral("GPU rasterization with extra raster threads and no background throttling"),
+         {QStringLiteral("--ignore-gpu-blocklist"),
+          QStringLiteral("--enable-gpu-rasterization"),
+          QStringLiteral("--enable-zero-copy"),
+          QStringLiteral("--num-raster-threads=4"),
+          QStringLiteral("--disable-background-timer-throttling"),
+          QStringLiteral("--disable-renderer-backgrounding")},
+         Qt::AA_UseDesktopOpenGL,
+         true},
+        {QStringLiteral("software-only"),
+         QStringLiteral("No GPU process work; software compositing and rasterization"),
+         {QStringLiteral("--disable-gpu"),
+          QStringLiteral("--disable-gpu-compositing")},
+         Qt::AA_UseSoftwareOpenGL,
+         false},
+    };
+}
+
+bool ConfigManager::findRenderingProfile(const QString &name, RenderingProfile *profile)
+{
+    const auto profiles = renderingProfiles();
+    const auto found = std::find_if(profiles.cbegin(), profiles.cend(), [&name](const RenderingProfile &candidate) {
+        return candidate.name.compare(name, Qt::CaseInsensitive) == 0;
+    });
+    if (found == profiles.cend()) {
+        return false;
+    }
+    if (profile) {
+        *profile = *found;
+    }
+    return true;
+}
+
 void ConfigManager::initialize(const QString &baseDir)
 {
+    QMutexLocker locker(&m_writeMutex);
     const QString resolvedDir = resolveBaseDir(baseDir);
-    if (m_initialized && resolvedDir == m_baseDir) {
+    const SnapshotPtr current = snapshot();
+    if (m_initialized.load(std::memory_order_acquire) && resolvedDir == current->baseDir) {
         return;
     }
-    m_baseDir = resolvedDir;
-    loadConfig();
-    m_initialized = true;
+
+    // 启动时宽松处理：出错的键使用默认值，其余照常生效
+    QStringList errors;
+    Snapshot next = parseConfig(resolvedDir, false, &errors);
+    for (const QString &error : std::as_const(errors)) {
+        qWarning().noquote() << "ConfigManager:" << error;
+    }
+    next.version = current->version + 1;
+    publish(std::move(next));
+    m_initialized.store(true, std::memory_order_release);
 }
 
-void ConfigManager::reload()
+ConfigManager::ReloadResult ConfigManager::reload()
 {
     ensureInitialized();
-    loadConfig();
+    QMutexLocker locker(&m_writeMutex);
+    const SnapshotPtr current = snapshot();
+
+    ReloadResult result;
+    result.version = current->version;
+    QStringList errors;
+    // 文件被删除或正被编辑器替换时不能退回默认值
+    Snapshot next = parseConfig(current->baseDir, true, &errors);
+    if (!errors.isEmpty()) {
+        // 热重载时严格处理：编辑到一半的文件不应覆盖正在使用的配置
+        result.error = errors.join(QStringLiteral("; "));
+        qWarning().noquote() << "ConfigManager: reload rejected:" << result.error;
+        return result;
+    }
+
+    result.ok = true;
+    result.changedKeys = diffKeys(*current, next);
+    if (result.changedKeys.isEmpty()) {
+        return result;
+    }
+    next.version = current->version + 1;
+    result.version = next.version;
+    publish(std::move(next));
+    qInfo().noquote() << "ConfigManager: config version" << result.version << "changed:"
+                      << result.changedKeys.join(QStringLiteral(", "));
+    return result;
+}
+
+ConfigManager::SnapshotPtr ConfigManager::snapshot() const
+{
+    return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+}
+
+quint64 ConfigManager::version() const
+{
+    return snapshot()->version;
+}
+
+QStringList ConfigManager::runtimeTunableKeys()
+{
+    return {
+        QStringLiteral("pageFreezeDelayMs"),
+        QStringLiteral("pageTimingExportPath"),
+        QStringLiteral("cookieMirrorBudgetKiB"),
+        QStringLiteral("downloads"),
+        QStringLiteral("memoryPressure"),
+    };
 }
 
 int ConfigManager::remoteDebugPort() const
 {
-    return m_remoteDebugPort;
+    ensureInitialized();
+    return snapshot()->remoteDebugPort;
+}
+
+int ConfigManager::metricsPort() const
+{
+    ensureInitialized();
+    return snapshot()->metricsPort;
+}
+
+int ConfigManager::pageFreezeDelayMs() const
+{
+    ensureInitialized();
+    return snapshot()->pageFreezeDelayMs;
+}
+
+QString ConfigManager::pageTimingExportPath() const
+{
+    ensureInitialized();
+    return snapshot()->pageTimingExportPath;
+}
+
+bool ConfigManager::fastStart() const
+{
+    ensureInitialized();
+    return snapshot()->fastStart;
+}
+
+bool ConfigManager::startupSplash() const
+{
+    ensureInitialized();
+    return snapshot()->startupSplash;
+}
+
+QString ConfigManager::startupTracePath() const
+{
+    ensureInitialized();
+    return snapshot()->startupTracePath;
+}
+
+QString ConfigManager::renderingProfileName() const
+{
+    ensureInitialized();
+    const QString name = snapshot()->renderingProfile;
+    return name.isEmpty() ? kDefaultRenderingProfile : name;
+}
+
+QStringList ConfigManager::extraChromiumFlags() const
+{
+    ensureInitialized();
+    return snapshot()->extraChromiumFlags;
+}
+
+qint64 ConfigManager::cookieMirrorBudgetBytes() const
+{
+    ensureInitialized();
+    return snapshot()->cookieMirrorBudgetBytes;
+}
+
+ConfigManager::DownloadLimits ConfigManager::downloadLimits() const
+{
+    ensureInitialized();
+    return snapshot()->downloadLimits;
+}
+
+ConfigManager::MemoryPressure ConfigManager::memoryPressure() const
+{
+    ensureInitialized();
+    return snapshot()->memoryPressure;
+}
+
+ConfigManager::MultiWindow ConfigManager::multiWindow() const
+{
+    ensureInitialized();
+    return snapshot()->multiWindow;
+}
+
+ConfigManager::WebChannel ConfigManager::webChannel() const
+{
+    ensureInitialized();
+    return snapshot()->webChannel;
 }
 
 QString ConfigManager::configFilePath() const
 {
-    if (m_baseDir.isEmpty()) {
+    const QString baseDir = snapshot()->baseDir;
+    if (baseDir.isEmpty()) {
         return {};
     }
-    return QDir(m_baseDir).filePath(QStringLiteral("config.json"));
+    return QDir(baseDir).filePath(QStringLiteral("config.json"));
 }
 
 void ConfigManager::applyWebEngineRemoteDebugging() const
 {
-    ensureInitialized();
-    if (!isValidPort(m_remoteDebugPort)) {
+    const int port = remoteDebugPort();
+    if (!isValidPort(port)) {
         return;
     }
-    qputenv("QTWEBENGINE_REMOTE_DEBUGGING", QByteArray::number(m_remoteDebugPort));
+    qInfo() << "ConfigManager: enable remote debug port" << port;
+    qputenv("QTWEBENGINE_REMOTE_DEBUGGING", QByteArray::number(port));
+}
+
+bool ConfigManager::applyRenderingProfile(const QString &overrideName) const
+{
+    const QString requested = overrideName.isEmpty() ? renderingProfileName() : overrideName;
+    RenderingProfile profile;
+    bool known = findRenderingProfile(requested, &profile);
+    if (!known) {
+        qWarning() << "ConfigManager: unknown rendering profile" << requested << "- falling back to" << kDefaultRenderingProfile;
+        findRenderingProfile(kDefaultRenderingProfile, &profile);
+    }
+
+    // 环境变量中已有的参数最后合并，便于临时覆盖
+    QStringList flags = profile.chromiumFlags;
+    flags += extraChromiumFlags();
+    // 多窗口共用渲染进程池：超过上限后新页面复用已有的渲染进程
+    const int rendererLimit = multiWindow().rendererProcessLimit;
+    if (rendererLimit > 0) {
+        flags << QStringLiteral("--renderer-process-limit=%1").arg(rendererLimit);
+    }
+    flags += splitFlags(QString::fromLocal8Bit(qgetenv("QTWEBENGINE_CHROMIUM_FLAGS")));
+    flags = mergeFlags(flags);
+    if (!flags.isEmpty()) {
+        qputenv("QTWEBENGINE_CHROMIUM_FLAGS", flags.join(QLatin1Char(' ')).toLocal8Bit());
+    }
+
+    QCoreApplication::setAttribute(profile.openGLAttribute);
+    if (profile.shareOpenGLContexts) {
+        QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    }
+    qInfo().noquote() << "ConfigManager: rendering profile" << profile.name << "flags:" << flags.join(QLatin1Char(' '));
+    return known;
+}
+
+ConfigManager::ConfigManager()
+    : m_snapshot(std::make_shared<const Snapshot>())
+{
 }
 
 void ConfigManager::ensureInitialized() const
 {
-    if (m_initialized) {
+    if (m_initialized.load(std::memory_order_acquire)) {
         return;
     }
     const_cast<ConfigManager *>(this)->initialize(QString());
 }
 
-void ConfigManager::loadConfig()
+void ConfigManager::publish(Snapshot next)
 {
-    m_remoteDebugPort = 0;
+    std::atomic_store_explicit(&m_snapshot, SnapshotPtr(std::make_shared<const Snapshot>(std::move(next))),
+                               std::memory_order_release);
+}
 
-    const QString path = configFilePath();
-    if (path.isEmpty()) {
-        qWarning() << "ConfigManager: config path unresolved";
-        return;
+ConfigManager::Snapshot ConfigManager::parseConfig(const QString &baseDir, bool requireFile, QStringList *errors)
+{
+    Snapshot config;
+    config.baseDir = baseDir;
+    if (baseDir.isEmpty()) {
+        errors->append(QStringLiteral("config path unresolved"));
+        return config;
     }
 
+    const QString path = QDir(baseDir).filePath(QStringLiteral("config.json"));
     QFile file(path);
     if (!file.exists()) {
-        return;
+        if (requireFile) {
+            errors->append(QStringLiteral("%1 not found").arg(path));
+        }
+        return config;
     }
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "ConfigManager: cannot open" << path << file.errorString();
-        return;
+        errors->append(QStringLiteral("cannot open %1: %2").arg(path, file.errorString()));
+        return config;
     }
 
-    const QByteArray data = file.readAll();
-    QJsonParseError error {};
-    const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
-        qWarning() << "ConfigManager: invalid JSON" << path << error.errorString();
-        return;
+    QJsonParseError parseError {};
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        errors->append(QStringLiteral("invalid JSON in %1: %2").arg(path, parseError.errorString()));
+        return config;
     }
 
     const QJsonObject root = doc.object();
-    const int portCandidate = root.value(QStringLiteral("remoteDebugPort")).toInt(0);
-    if (isValidPort(portCandidate)) {
-        m_remoteDebugPort = portCandidate;
-        qInfo() << "ConfigManager: enable remote debug port" << m_remoteDebugPort;
-    } else {
-        m_remoteDebugPort = 0;
+    for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+        if (!kKnownKeys.contains(it.key())) {
+            qWarning().noquote() << "ConfigManager: ignoring unknown key" << it.key();
+        }
     }
-}
 
+    SchemaReader reader(root, errors);
+    reader.readInt(QStringLiteral("remoteDebugPort"), 0, 65535, &config.remoteDebugPort);
+    reader.readInt(QStringLiteral("metricsPort"), 0, 65535, &config.metricsPort);
+    reader.readInt(QStringLiteral("pageFreezeDelayMs"), 0, std::numeric_limits<int>::max(), &config.pageFreezeDelayMs);
+
+    QString timingExport;
+    if (reader.readString(QStringLiteral("pageTimingExportPath"), &timingExport)) {
+        config.pageTimingExportPath = resolvePath(baseDir, timingExport);
+    }
 
+    reader.readBool(QStringLiteral("fastStart"), &config.fastStart);
+    reader.readBool(QStringLiteral("startupSplash"), &config.startupSplash);
+    QString tracePath;
+    if (reader.readString(QStringLiteral("startupTracePath"), &tracePath)) {
+        config.startupTracePath = resolvePath(baseDir, tracePath);
+    }
+
+    if (reader.readString(QStringLiteral("renderingProfile"), &config.renderingProfile)
+        && !config.renderingProfile.isEmpty() && !findRenderingProfile(config.renderingProfile, nullptr)) {
+        errors->append(QStringLiteral("renderingProfile: unknown profile \"%1\"").arg(config.renderingProfile));
+        config.renderingProfile.clear();
+    }
+
+    // chromiumFlags 可以是字符串或字符串数组
+    const QJsonValue extraFlags = root.value(QStringLiteral("chromiumFlags"));
+    if (extraFlags.isString()) {
+        config.extraChromiumFlags = splitFlags(extraFlags.toString());
+    } else if (extraFlags.isArray()) {
+        for (const QJsonValue &flag : extraFlags.toArray()) {
+            if (!flag.isString()) {
+                errors->append(QStringLiteral("chromiumFlags: array entries must be strings"));
+                continue;
+            }
+            config.extraChromiumFlags += splitFlags(flag.toString());
+        }
+    } else if (!extraFlags.isUndefined() && !extraFlags.isNull()) {
+        errors->append(QStringLiteral("chromiumFlags: expected string or array"));
+    }
+
+    int mirrorBudgetKiB = kDefaultCookieMirrorBudgetKiB;
+    if (reader.readInt(QStringLiteral("cookieMirrorBudgetKiB"), 1, std::numeric_limits<int>::max(), &mirrorBudgetKiB)) {
+        config.cookieMirrorBudgetBytes = qint64(mirrorBudgetKiB) * 1024;
+    }
+
+    const QJsonValue downloadsValue = root.value(QStringLiteral("downloads"));
+    if (downloadsValue.isObject()) {
+        SchemaReader downloads(downloadsValue.toObject(), errors, QStringLiteral("downloads."));
+        DownloadLimits &limits = config.downloadLimits;
+        downloads.readInt(QStringLiteral("maxConcurrent"), 1, 64, &limits.maxConcurrent);
+        downloads.readInt(QStringLiteral("maxPerHost"), 1, 64, &limits.maxPerHost);
+        int bandwidthKiBps = 0;
+        if (downloads.readInt(QStringLiteral("bandwidthKiBps"), 0, std::numeric_limits<int>::max(), &bandwidthKiBps)) {
+            limits.bandwidthBytesPerSec = qint64(bandwidthKiBps) * 1024;
+        }
+        int loadingKiBps = 0;
+        if (downloads.readInt(QStringLiteral("loadingBandwidthKiBps"), 0, std::numeric_limits<int>::max(), &loadingKiBps)) {
+            limits.loadingBandwidthBytesPerSec = qint64(loadingKiBps) * 1024;
+        }
+        downloads.readInt(QStringLiteral("maxResumeAttempts"), 0, 100, &limits.maxResumeAttempts);
+    } else if (!downloadsValue.isUndefined() && !downloadsValue.isNull()) {
+        errors->append(QStringLiteral("downloads: expected object"));
+    }
+
+    const QJsonValue pressureValue = root.value(QStringLiteral("memoryPressure"));
+    if (pressureValue.isObject()) {
+        SchemaReader pressure(pressureValue.toObject(), errors, QStringLiteral("memoryPressure."));
+        MemoryPressure &policy = config.memoryPressure;
+        pressure.readInt(QStringLiteral("sampleIntervalMs"), 0, 3600 * 1000, &policy.sampleIntervalMs);
+        pressure.readInt(QStringLiteral("cooldownMs"), 0, std::numeric_limits<int>::max(), &policy.cooldownMs);
+        const auto readMiB = [&pressure](const char *key, qint64 *bytes) {
+            int mib = 0;
+            if (pressure.readInt(QString::fromLatin1(key), 0, 1024 * 1024, &mib)) {
+                *bytes = qint64(mib) * 1024 * 1024;
+            }
+        };
+        readMiB("clearCacheMiB", &policy.clearCacheBytes);
+        readMiB("dropQueuesMiB", &policy.dropQueuesBytes);
+        readMiB("freezeBackgroundMiB", &policy.freezeBackgroundBytes);
+        readMiB("discardBackgroundMiB", &policy.discardBackgroundBytes);
+    } else if (!pressureValue.isUndefined() && !pressureValue.isNull()) {
+        errors->append(QStringLiteral("memoryPressure: expected object"));
+    }
+
+    const QJsonValue multiWindowValue = root.value(QStringLiteral("multiWindow"));
+    if (multiWindowValue.isObject()) {
+        SchemaReader multiWindow(multiWindowValue.toObject(), errors, QStringLiteral("multiWindow."));
+        MultiWindow &windows = config.multiWindow;
+        multiWindow.readInt(QStringLiteral("windows"), 1, 64, &windows.windows);
+        multiWindow.readBool(QStringLiteral("sharedProfile"), &windows.sharedProfile);
+        multiWindow.readInt(QStringLiteral("rendererProcessLimit"), 0, 256, &windows.rendererProcessLimit);
+    } else if (!multiWindowValue.isUndefined() && !multiWindowValue.isNull()) {
+        errors->append(QStringLiteral("multiWindow: expected object"));
+    }
+
+    const QJsonValue webChannelValue = root.value(QStringLiteral("webChannel"));
+    if (webChannelValue.isObject()) {
+        SchemaReader webChannel(webChannelValue.toObject(), errors, QStringLiteral("webChannel."));
+        WebChannel &channel = config.webChannel;
+        QString transport;
+        if (webChannel.readString(QStringLiteral("transport"), &transport)) {
+            transport = transport.toLower();
+            if (transport == QLatin1String("page") || transport == QLatin1String("websocket")) {
+                channel.transport = transport;
+            } else {
+                errors->append(QStringLiteral("webChannel.transport: expected \"page\" or \"websocket\""));
+            }
+        }
+        int maxMessageMiB = 0;
+        if (webChannel.readInt(QStringLiteral("maxMessageMiB"), 1, 1024, &maxMessageMiB)) {
+            channel.maxMessageBytes = qint64(maxMessageMiB) * 1024 * 1024;
+        }
+        int thresholdKiB = 0;
+        if (webChannel.readInt(QStringLiteral("workerThresholdKiB"), 0, 1024 * 1024, &thresholdKiB)) {
+            channel.workerThresholdBytes = thresholdKiB * 1024;
+        }
+    } else if (!webChannelValue.isUndefined() && !webChannelValue.isNull()) {
+        errors->append(QStringLiteral("webChannel: expected object"));
+    }
+    return config;
+}
+
+QStringList ConfigManager::diffKeys(const Snapshot &before, const Snapshot &after)
+{
+    QStringList keys;
+    const auto compare = [&keys](bool changed, const char *key) {
+        if (changed) {
+            keys.append(QString::fromLatin1(key));
+        }
+    };
+    const DownloadLimits &a = before.downloadLimits;
+    const DownloadLimits &b = after.downloadLimits;
+    const MemoryPressure &p = before.memoryPressure;
+    const MemoryPressure &q = after.memoryPressure;
+    const MultiWindow &m = before.multiWindow;
+    const MultiWindow &n = after.multiWindow;
+    const WebChannel &c = before.webChannel;
+    const WebChannel &d = after.webChannel;
+    compare(before.remoteDebugPort != after.remoteDebugPort, "remoteDebugPort");
+    compare(before.metricsPort != after.metricsPort, "metricsPort");
+    compare(before.pageFreezeDelayMs != after.pageFreezeDelayMs, "pageFreezeDelayMs");
+    compare(before.pageTimingExportPath != after.pageTimingExportPath, "pageTimingExportPath");
+    compare(before.fastStart != after.fastStart, "fastStart");
+    compare(before.startupSplash != after.startupSplash, "startupSplash");
+    compare(before.startupTracePath != after.startupTracePath, "startupTracePath");
+    compare(before.renderingProfile != after.renderingProfile, "renderingProfile");
+    compare(before.extraChromiumFlags != after.extraChromiumFlags, "chromiumFlags");
+    compare(before.cookieMirrorBudgetBytes != after.cookieMirrorBudgetBytes, "cookieMirrorBudgetKiB");
+    compare(a.maxConcurrent != b.maxConcurrent || a.maxPerHost != b.maxPerHost
+                || a.bandwidthBytesPerSec != b.bandwidthBytesPerSec
+                || a.loadingBandwidthBytesPerSec != b.loadingBandwidthBytesPerSec
+                || a.maxResumeAttempts != b.maxResumeAttempts,
+            "downloads");
+    compare(p.sampleIntervalMs != q.sampleIntervalMs || p.clearCacheBytes != q.clearCacheBytes
+                || p.dropQueuesBytes != q.dropQueuesBytes || p.freezeBackgroundBytes != q.freezeBackgroundBytes
+                || p.discardBackgroundBytes != q.discardBackgroundBytes || p.cooldownMs != q.cooldownMs,
+            "memoryPressure");
+    compare(m.windows != n.windows || m.sharedProfile != n.sharedProfile
+                || m.rendererProcessLimit != n.rendererProcessLimit,
+            "multiWindow");
+    compare(c.transport != d.transport || c.maxMessageBytes != d.maxMessageBytes
+                || c.workerThresholdBytes != d.workerThresholdBytes,
+            "webChannel");
+    return keys;
+}
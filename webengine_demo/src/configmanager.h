@@ -1,33 +1,146 @@
 #pragma once
 
+#include <QMutex>
 #include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
 
-// 简单的配置单例，负责读取可执行目录下的 config.json，
-// 目前仅暴露 remoteDebugPort 设置以便按需开启远程调试。
+#include <atomic>
+#include <memory>
+
+// 配置单例，读取可执行目录下的 config.json，提供远程调试端口、页面冻结、启动方式与渲染预设等设置。
+// 每次加载生成带版本号的不可变快照并原子替换，任意线程都可无锁读取；配合 ConfigWatcher 支持热重载。
 class ConfigManager final
 {
 public:
+    // 渲染 / 进程模型预设：映射到 QTWEBENGINE_CHROMIUM_FLAGS 与 QApplication 构造前的 OpenGL 属性
+    struct RenderingProfile
+    {
+        QString name;
+        QString description;
+        QStringList chromiumFlags;
+        Qt::ApplicationAttribute openGLAttribute {Qt::AA_UseOpenGLES};
+        bool shareOpenGLContexts {false};
+    };
+
+    // 下载并发与限速；带宽为 0 表示不限速
+    struct DownloadLimits
+    {
+        int maxConcurrent {3};
+        int maxPerHost {2};
+        qint64 bandwidthBytesPerSec {0};
+        // 页面加载期间使用的更低上限，避免下载挤占页面加载
+        qint64 loadingBandwidthBytesPerSec {512 * 1024};
+        int maxResumeAttempts {5};
+    };
+
+    // 渲染进程内存压力策略：阈值按单个渲染进程的 RSS 计算，0 表示不启用对应动作
+    struct MemoryPressure
+    {
+        int sampleIntervalMs {5000};
+        qint64 clearCacheBytes {0};
+        qint64 dropQueuesBytes {0};
+        qint64 freezeBackgroundBytes {0};
+        qint64 discardBackgroundBytes {0};
+        // 同一个 pane 的同一种动作两次触发之间的最短间隔
+        int cooldownMs {30000};
+    };
+
+    // 多窗口模式：窗口共用的 profile 与渲染进程池；渲染进程上限为 0 表示交给 Chromium 决定
+    struct MultiWindow
+    {
+        int windows {1};
+        bool sharedProfile {true};
+        int rendererProcessLimit {0};
+    };
+
+    // QWebChannel 传输："page" 为 QWebEnginePage 内置传输，"websocket" 为本机回环 WebSocket 传输
+    struct WebChannel
+    {
+        QString transport {QStringLiteral("page")};
+        qint64 maxMessageBytes {64 * 1024 * 1024};
+        // WebSocket 传输中估算大小达到该值的消息在线程池中序列化 / 解析
+        int workerThresholdBytes {16 * 1024};
+    };
+
+    // 一次完整解析得到的不可变配置；发布后只读，可在任意线程持有
+    struct Snapshot
+    {
+        quint64 version {0};
+        QString baseDir;
+        int remoteDebugPort {0};
+        int metricsPort {0};
+        int pageFreezeDelayMs {5000};
+        // 为空时不导出加载报告
+        QString pageTimingExportPath;
+        bool fastStart {false};
+        bool startupSplash {false};
+        QString startupTracePath;
+        QString renderingProfile;
+        QStringList extraChromiumFlags;
+        qint64 cookieMirrorBudgetBytes {4096 * 1024};
+        DownloadLimits downloadLimits;
+        MemoryPressure memoryPressure;
+        MultiWindow multiWindow;
+        WebChannel webChannel;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    struct ReloadResult
+    {
+        bool ok {false};
+        quint64 version {0};
+        QStringList changedKeys;
+        QString error;
+    };
+
     static ConfigManager &instance();
+    static QVector<RenderingProfile> renderingProfiles();
+    static bool findRenderingProfile(const QString &name, RenderingProfile *profile);
+    // 修改后无需重启即可生效的配置键
+    static QStringList runtimeTunableKeys();
 
     void initialize(const QString &baseDir);
-    void reload();
+    // 重新读取 config.json；文件缺失或校验失败时保留当前快照
+    ReloadResult reload();
+    // 无锁读取当前快照，任意线程可调用
+    SnapshotPtr snapshot() const;
+    quint64 version() const;
 
     int remoteDebugPort() const;
+    // 本地指标端点端口，0 表示不开启
+    int metricsPort() const;
+    int pageFreezeDelayMs() const;
+    QString pageTimingExportPath() const;
+    bool fastStart() const;
+    bool startupSplash() const;
+    QString startupTracePath() const;
+    QString renderingProfileName() const;
+    QStringList extraChromiumFlags() const;
+    qint64 cookieMirrorBudgetBytes() const;
+    DownloadLimits downloadLimits() const;
+    MemoryPressure memoryPressure() const;
+    MultiWindow multiWindow() const;
+    WebChannel webChannel() const;
     QString configFilePath() const;
 
     void applyWebEngineRemoteDebugging() const;
+    // 必须在 QApplication 构造之前调用；overrideName 非空时优先于 config.json 中的 renderingProfile
+    bool applyRenderingProfile(const QString &overrideName = QString()) const;
 
 private:
-    ConfigManager() = default;
+    ConfigManager();
 
     void ensureInitialized() const;
-    void loadConfig();
+    // 解析失败或校验出错时 errors 非空，out 中出错的键保持默认值；
+    // requireFile 为 false 时缺少 config.json 不算错误，直接返回默认值
+    static Snapshot parseConfig(const QString &baseDir, bool requireFile, QStringList *errors);
+    static QStringList diffKeys(const Snapshot &before, const Snapshot &after);
+    void publish(Snapshot next);
 
-    QString m_baseDir;
-    int m_remoteDebugPort {0};
-    mutable bool m_initialized {false};
+    // 读者通过 std::atomic_load 取得快照，写者（initialize / reload）之间由 m_writeMutex 串行
+    SnapshotPtr m_snapshot;
+    QMutex m_writeMutex;
+    std::atomic<bool> m_initialized {false};
 };
-
-
-
-
@@ -0,0 +1,90 @@
+#include "configwatcher.h"
+
+#include "configmanager.h"
+#include "connectguard.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QPointer>
+#include <QTimer>
+
+namespace {
+// 编辑器保存时常见“写临时文件 + 重命名”的多次事件，合并成一次重载
+constexpr int kDefaultDebounceMs = 300;
+
+QPointer<ConfigWatcher> s_instance;
+} // namespace
+
+ConfigWatcher::ConfigWatcher(QObject *parent)
+    : QObject(parent)
+    , m_filePath(ConfigManager::instance().configFilePath())
+{
+    if (!s_instance) {
+        s_instance = this;
+    }
+
+    m_debounceTimer = new QTimer(this);
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(kDefaultDebounceMs);
+    ENSURE_QT_CONNECT(m_debounceTimer, &QTimer::timeout, this, &ConfigWatcher::reloadNow);
+
+    m_watcher = new QFileSystemWatcher(this);
+    ENSURE_QT_CONNECT(m_watcher, &QFileSystemWatcher::fileChanged, this, &ConfigWatcher::scheduleReload);
+    ENSURE_QT_CONNECT(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ConfigWatcher::scheduleReload);
+    rearm();
+}
+
+ConfigWatcher *ConfigWatcher::instance()
+{
+    return s_instance;
+}
+
+void ConfigWatcher::setDebounceMs(int ms)
+{
+    m_debounceTimer->setInterval(qMax(0, ms));
+}
+
+void ConfigWatcher::reloadNow()
+{
+    rearm();
+    const ConfigManager::ReloadResult result = ConfigManager::instance().reload();
+    if (!result.ok) {
+        emit reloadFailed(result.error);
+        return;
+    }
+    if (result.changedKeys.isEmpty()) {
+        return;
+    }
+
+    const QStringList tunable = ConfigManager::runtimeTunableKeys();
+    for (const QString &key : result.changedKeys) {
+        if (!tunable.contains(key)) {
+            qInfo().noquote() << "ConfigWatcher:" << key << "changed; takes effect after restart";
+        }
+    }
+    emit configReloaded(result.version, result.changedKeys);
+    for (const QString &key : result.changedKeys) {
+        emit keyChanged(key);
+    }
+}
+
+void ConfigWatcher::scheduleReload()
+{
+    m_debounceTimer->start();
+}
+
+void ConfigWatcher::rearm()
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    // 文件被替换后旧的监视会失效，同时监视目录以便文件重新出现时恢复
+    const QString directory = QFileInfo(m_filePath).absolutePath();
+    if (!m_watcher->directories().contains(directory)) {
+        m_watcher->addPath(directory);
+    }
+    if (QFileInfo::exists(m_filePath) && !m_watcher->files().contains(m_filePath)) {
+        m_watcher->addPath(m_filePath);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// ConfigWatcher 监视 config.json 及其所在目录，变更经过防抖后调用 ConfigManager::reload()，
+// 并按配置键发出变更通知；需在 QCoreApplication 创建后于 GUI 线程构造，跨线程的接收者会自动排队投递。
+class ConfigWatcher final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConfigWatcher(QObject *parent = nullptr);
+
+    static ConfigWatcher *instance();
+    void setDebounceMs(int ms);
+
+    // 仅在 key 发生变化时调用 functor；context 销毁后自动断开
+    template <typename Functor>
+    QMetaObject::Connection onChanged(const QString &key, const QObject *context, Functor functor)
+    {
+        return connect(this, &ConfigWatcher::keyChanged, context, [key, functor](const QString &changed) {
+            if (changed == key) {
+                functor();
+            }
+        });
+    }
+
+public slots:
+    void reloadNow();
+
+signals:
+    void configReloaded(quint64 version, const QStringList &changedKeys);
+    void keyChanged(const QString &key);
+    void reloadFailed(const QString &error);
+
+private:
+    void scheduleReload();
+    void rearm();
+
+    QFileSystemWatcher *m_watcher {nullptr};
+    QTimer *m_debounceTimer {nullptr};
+    QString m_filePath;
+};
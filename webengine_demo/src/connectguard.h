@@ -43,7 +43,21 @@ private:
     }
 };
 
+#ifdef WEBENGINE_DEMO_PROFILE_CONNECTIONS
+#include "connectprofiler.h"
+
+// 连接性能分析构建：每个展开点持有一个静态 Site，槽函数经 ConnectProfiler 包装后计时
+#define ENSURE_QT_CONNECT(...)                                                                              \
+    ConnectGuard::verify(ConnectProfiler::connect(                                                          \
+                             []() -> ConnectProfiler::Site & {                                               \
+                                 static ConnectProfiler::Site s_site(__FILE__, __LINE__, #__VA_ARGS__);      \
+                                 return s_site;                                                              \
+                             }(),                                                                            \
+                             __VA_ARGS__),                                                                   \
+                         #__VA_ARGS__, __FILE__, __LINE__)
+#else
 #define ENSURE_QT_CONNECT(...) \
     ConnectGuard::verify(QObject::connect(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+#endif
 
 
@@ -0,0 +1,168 @@
+#include "connectprofiler.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr int kExpressionWidth = 72;
+
+struct Registry
+{
+    QMutex mutex;
+    std::vector<ConnectProfiler::Site *> sites;
+};
+
+Registry &registry()
+{
+    static Registry s_registry;
+    return s_registry;
+}
+
+struct Row
+{
+    const ConnectProfiler::Site *site;
+    qint64 connections;
+    qint64 emissions;
+    qint64 queued;
+    qint64 direct;
+    qint64 totalNs;
+    qint64 selfNs;
+    qint64 maxNs;
+};
+
+double toMs(qint64 ns)
+{
+    return ns / 1e6;
+}
+
+double toUs(qint64 ns)
+{
+    return ns / 1e3;
+}
+} // namespace
+
+ConnectProfiler::Site::Site(const char *file, int line, const char *expression)
+    : file(file)
+    , line(line)
+    , expression(expression)
+{
+    registerSite(this);
+}
+
+QString ConnectProfiler::report(int limit)
+{
+    std::vector<Row> rows;
+    {
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        rows.reserve(reg.sites.size());
+        for (const Site *site : reg.sites) {
+            rows.push_back({site,
+                            site->connections.load(std::memory_order_relaxed),
+                            site->emissions.load(std::memory_order_relaxed),
+                            site->queued.load(std::memory_order_relaxed),
+                            site->direct.load(std::memory_order_relaxed),
+                            site->totalNs.load(std::memory_order_relaxed),
+                            site->selfNs.load(std::memory_order_relaxed),
+                            site->maxNs.load(std::memory_order_relaxed)});
+        }
+    }
+    rows.erase(std::remove_if(rows.begin(), rows.end(), [](const Row &row) { return row.emissions == 0; }), rows.end());
+    std::sort(rows.begin(), rows.end(), [](const Row &left, const Row &right) {
+        return left.selfNs != right.selfNs ? left.selfNs > right.selfNs : left.emissions > right.emissions;
+    });
+
+    qint64 allSelfNs = 0;
+    for (const Row &row : rows) {
+        allSelfNs += row.selfNs;
+    }
+    const int count = limit > 0 ? qMin<int>(limit, static_cast<int>(rows.size())) : static_cast<int>(rows.size());
+
+    QString text;
+    QTextStream out(&text);
+    out << "ConnectProfiler: " << rows.size() << " active call sites, slot self time " << QString::number(toMs(allSelfNs), 'f', 1)
+        << " ms\n";
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(QStringLiteral("#"), 3)
+               .arg(QStringLiteral("self ms"), 10)
+               .arg(QStringLiteral("share"), 6)
+               .arg(QStringLiteral("total ms"), 10)
+               .arg(QStringLiteral("calls"), 9)
+               .arg(QStringLiteral("avg us"), 8)
+               .arg(QStringLiteral("max us"), 9)
+               .arg(QStringLiteral("queued/direct"), 15)
+               .arg(QStringLiteral("conns  site"));
+    for (int i = 0; i < count; ++i) {
+        const Row &row = rows.at(i);
+        QString expression = QString::fromLatin1(row.site->expression).simplified();
+        if (expression.size() > kExpressionWidth) {
+            expression = expression.left(kExpressionWidth - 3) + QStringLiteral("...");
+        }
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9  %10:%11  %12\n")
+                   .arg(i + 1, 3)
+                   .arg(toMs(row.selfNs), 10, 'f', 2)
+                   .arg(allSelfNs > 0 ? QStringLiteral("%1%").arg(100.0 * row.selfNs / allSelfNs, 0, 'f', 1)
+                                      : QStringLiteral("-"),
+                        6)
+                   .arg(toMs(row.totalNs), 10, 'f', 2)
+                   .arg(row.emissions, 9)
+                   .arg(toUs(row.totalNs / row.emissions), 8, 'f', 1)
+                   .arg(toUs(row.maxNs), 9, 'f', 1)
+                   .arg(QStringLiteral("%1/%2").arg(row.queued).arg(row.direct), 15)
+                   .arg(row.connections, 5)
+                   .arg(QFileInfo(QString::fromLocal8Bit(row.site->file)).fileName())
+                   .arg(row.site->line)
+                   .arg(expression);
+    }
+    return text;
+}
+
+void ConnectProfiler::dumpReport(int limit)
+{
+    qInfo().noquote() << report(limit);
+}
+
+void ConnectProfiler::reset()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (Site *site : reg.sites) {
+        site->emissions.store(0, std::memory_order_relaxed);
+        site->queued.store(0, std::memory_order_relaxed);
+        site->direct.store(0, std::memory_order_relaxed);
+        site->totalNs.store(0, std::memory_order_relaxed);
+        site->selfNs.store(0, std::memory_order_relaxed);
+        site->maxNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ConnectProfiler::registerSite(Site *site)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.sites.push_back(site);
+}
+
+void ConnectProfiler::record(Site &site, bool queued, qint64 totalNs, qint64 selfNs)
+{
+    site.emissions.fetch_add(1, std::memory_order_relaxed);
+    (queued ? site.queued : site.direct).fetch_add(1, std::memory_order_relaxed);
+    site.totalNs.fetch_add(totalNs, std::memory_order_relaxed);
+    site.selfNs.fetch_add(selfNs, std::memory_order_relaxed);
+    qint64 max = site.maxNs.load(std::memory_order_relaxed);
+    while (totalNs > max && !site.maxNs.compare_exchange_weak(max, totalNs, std::memory_order_relaxed)) {
+    }
+}
+
+qint64 &ConnectProfiler::childNs()
+{
+    // 当前线程正在执行的槽里，嵌套槽已经花掉的时间，用于从外层槽中扣除得到自身耗时
+    thread_local qint64 t_childNs = 0;
+    return t_childNs;
+}
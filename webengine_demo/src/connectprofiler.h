@@ -0,0 +1,154 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// ConnectProfiler 在 WEBENGINE_DEMO_PROFILE_CONNECTIONS 构建下由 ENSURE_QT_CONNECT 使用：每个调用点登记一个 Site，
+// 槽函数被包装后统计触发次数、耗时（含 / 不含嵌套槽）与 queued / direct 分发次数，report() 按自身耗时排序输出。
+class ConnectProfiler final
+{
+public:
+    struct Site
+    {
+        Site(const char *file, int line, const char *expression);
+
+        const char *file;
+        int line;
+        const char *expression;
+        std::atomic<qint64> connections {0};
+        std::atomic<qint64> emissions {0};
+        std::atomic<qint64> queued {0};
+        std::atomic<qint64> direct {0};
+        std::atomic<qint64> totalNs {0};
+        std::atomic<qint64> selfNs {0};
+        std::atomic<qint64> maxNs {0};
+    };
+
+    ConnectProfiler() = delete;
+
+    // Sender / Context 可以是裸指针或 QPointer，与 QObject::connect 的隐式转换保持一致
+    template <typename Sender, typename Signal, typename Context, typename Slot>
+    static QMetaObject::Connection connect(Site &site,
+                                           Sender sender,
+                                           Signal signal,
+                                           Context context,
+                                           Slot slot,
+                                           Qt::ConnectionType type = Qt::AutoConnection)
+    {
+        using Receiver = std::remove_pointer_t<decltype(&*std::declval<Context &>())>;
+        // 字符串形式的连接保持原样；UniqueConnection 只对成员函数指针生效，包装后会失效，同样不做统计
+        if constexpr (!std::is_member_function_pointer_v<Signal> || !std::is_base_of_v<QObject, Receiver>) {
+            return QObject::connect(sender, signal, context, slot, type);
+        } else {
+            if (type & Qt::UniqueConnection) {
+                return QObject::connect(sender, signal, context, slot, type);
+            }
+            ++site.connections;
+            const QObject *senderObject = &*sender;
+            Receiver *receiver = &*context;
+            return QObject::connect(sender, signal, receiver,
+                                    [&site, senderObject, receiver, slot, type](auto &&...args) mutable {
+                                        const bool queued = isQueued(type, senderObject, receiver);
+                                        invokeMeasured(site, queued, [&]() {
+                                            if constexpr (std::is_member_function_pointer_v<Slot>) {
+                                                invokePrefix(slot, std::make_tuple(receiver), std::forward_as_tuple(args...));
+                                            } else {
+                                                invokePrefix(slot, std::tuple<>(), std::forward_as_tuple(args...));
+                                            }
+                                        });
+                                    },
+                                    type);
+        }
+    }
+
+    template <typename Sender, typename Signal, typename Functor>
+    static QMetaObject::Connection connect(Site &site, Sender sender, Signal signal, Functor functor)
+    {
+        // 没有 context 的 functor 总是在发射线程中直接调用
+        ++site.connections;
+        return QObject::connect(sender, signal, [&site, functor](auto &&...args) mutable {
+            invokeMeasured(site, false, [&]() {
+                invokePrefix(functor, std::tuple<>(), std::forward_as_tuple(args...));
+            });
+        });
+    }
+
+    // 按自身耗时从高到低排列，limit <= 0 时输出全部调用点
+    static QString report(int limit = 20);
+    static void dumpReport(int limit = 20);
+    static void reset();
+
+private:
+    static void registerSite(Site *site);
+    static void record(Site &site, bool queued, qint64 totalNs, qint64 selfNs);
+    static qint64 &childNs();
+
+    static bool isQueued(Qt::ConnectionType type, const QObject *sender, const QObject *context)
+    {
+        const int dispatch = type & ~Qt::UniqueConnection;
+        if (dispatch == Qt::QueuedConnection || dispatch == Qt::BlockingQueuedConnection) {
+            return true;
+        }
+        if (dispatch == Qt::DirectConnection) {
+            return false;
+        }
+        // AutoConnection：按 sender 与接收者所在线程推断，sender 一般在自己的线程中发射信号
+        return sender && context && sender->thread() != context->thread();
+    }
+
+    template <typename Body>
+    static void invokeMeasured(Site &site, bool queued, Body &&body)
+    {
+        qint64 &children = childNs();
+        const qint64 outerChildren = children;
+        children = 0;
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        const qint64 elapsed = timer.nsecsElapsed();
+        record(site, queued, elapsed, elapsed - children);
+        children = outerChildren + elapsed;
+    }
+
+    template <typename Callable, typename Bound, typename Args, typename Sequence>
+    struct PrefixInvocable;
+
+    template <typename Callable, typename... Bound, typename Args, std::size_t... Index>
+    struct PrefixInvocable<Callable, std::tuple<Bound...>, Args, std::index_sequence<Index...>>
+        : std::is_invocable<Callable &, Bound..., std::tuple_element_t<Index, Args>...>
+    {
+    };
+
+    // 与 Qt 一样允许槽函数只接收信号参数的前若干个：从全部参数开始逐个去掉末尾参数，直到可以调用
+    template <typename Callable, typename Bound, typename Args, std::size_t Count = std::tuple_size_v<Args>>
+    static void invokePrefix(Callable &callable, Bound bound, Args args)
+    {
+        if constexpr (PrefixInvocable<Callable, Bound, Args, std::make_index_sequence<Count>>::value) {
+            callWith(callable, bound, args, std::make_index_sequence<Count>());
+        } else {
+            static_assert(Count > 0, "slot is not invocable with the signal arguments");
+            invokePrefix<Callable, Bound, Args, Count - 1>(callable, bound, args);
+        }
+    }
+
+    template <typename Callable, typename Bound, typename Args, std::size_t... Index>
+    static void callWith(Callable &callable, Bound &bound, Args &args, std::index_sequence<Index...>)
+    {
+        std::apply(
+            [&](auto &...leading) {
+                std::invoke(callable, leading..., std::get<Index>(args)...);
+            },
+            bound);
+    }
+};
@@ -0,0 +1,310 @@
+#include "cookiejartransfer.h"
+
+#include "connectguard.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkCookie>
+#include <QTextStream>
+#include <QTimer>
+#include <QtGlobal>
+#include <QUrl>
+#include <QWebEngineCookieStore>
+
+namespace {
+constexpr int kImportBatchLines = 512;
+// loadAllCookies() 没有完成信号：结果在同一个事件里逐个发出 cookieAdded，该事件处理完即已全部送达；
+// 存储为空时不会收到任何信号，超过这个时间仍没有结果就按空导出结束
+constexpr int kEmptyStoreTimeoutMs = 2000;
+const QString kHttpOnlyPrefix = QStringLiteral("#HttpOnly_");
+
+void useUtf8(QTextStream *stream)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    stream->setEncoding(QStringConverter::Utf8);
+#else
+    stream->setCodec("UTF-8");
+#endif
+}
+
+QByteArray cookieKey(const QNetworkCookie &cookie)
+{
+    return cookie.domain().toUtf8() + '\t' + cookie.path().toUtf8() + '\t' + cookie.name();
+}
+
+// 按 cookie 的 domain 构造 setCookie 所需的来源 URL，前导点表示对子域名生效
+QUrl originFor(const QNetworkCookie &cookie)
+{
+    QString host = cookie.domain();
+    if (host.startsWith(QLatin1Char('.'))) {
+        host.remove(0, 1);
+    }
+    QUrl origin;
+    origin.setScheme(cookie.isSecure() ? QStringLiteral("https") : QStringLiteral("http"));
+    origin.setHost(host);
+    origin.setPath(QStringLiteral("/"));
+    return origin;
+}
+
+bool parseNetscapeLine(QString line, QNetworkCookie *cookie)
+{
+    bool httpOnly = false;
+    if (line.startsWith(kHttpOnlyPrefix)) {
+        httpOnly = true;
+        line.remove(0, kHttpOnlyPrefix.size());
+    } else if (line.startsWith(QLatin1Char('#'))) {
+        return false;
+    }
+
+    // domain  includeSubdomains  path  secure  expiry  name  value
+    const QStringList fields = line.split(QLatin1Char('\t'));
+    if (fields.size() < 7 || fields.at(0).isEmpty() || fields.at(5).isEmpty()) {
+        return false;
+    }
+    QString domain = fields.at(0);
+    const bool includeSubdomains = fields.at(1).compare(QStringLiteral("TRUE"), Qt::CaseInsensitive) == 0;
+    if (includeSubdomains && !domain.startsWith(QLatin1Char('.'))) {
+        domain.prepend(QLatin1Char('.'));
+    }
+    cookie->setDomain(domain);
+    cookie->setPath(fields.at(2).isEmpty() ? QStringLiteral("/") : fields.at(2));
+    cookie->setSecure(fields.at(3).compare(QStringLiteral("TRUE"), Qt::CaseInsensitive) == 0);
+    const qint64 expiry = fields.at(4).toLongLong();
+    if (expiry > 0) {
+        cookie->setExpirationDate(QDateTime::fromSecsSinceEpoch(expiry, Qt::UTC));
+    }
+    cookie->setName(fields.at(5).toUtf8());
+    // value 里本身可能含有制表符
+    cookie->setValue(fields.mid(6).join(QLatin1Char('\t')).toUtf8());
+    cookie->setHttpOnly(httpOnly);
+    return true;
+}
+
+bool parseJsonLine(const QString &line, QNetworkCookie *cookie)
+{
+    const QJsonObject object = QJsonDocument::fromJson(line.toUtf8()).object();
+    const QString name = object.value(QStringLiteral("name")).toString();
+    const QString domain = object.value(QStringLiteral("domain")).toString();
+    if (name.isEmpty() || domain.isEmpty()) {
+        return false;
+    }
+    cookie->setName(name.toUtf8());
+    cookie->setValue(object.value(QStringLiteral("value")).toString().toUtf8());
+    cookie->setDomain(domain);
+    cookie->setPath(object.value(QStringLiteral("path")).toString(QStringLiteral("/")));
+    cookie->setSecure(object.value(QStringLiteral("secure")).toBool());
+    cookie->setHttpOnly(object.value(QStringLiteral("httpOnly")).toBool());
+    const qint64 expiry = static_cast<qint64>(object.value(QStringLiteral("expires")).toDouble(0));
+    if (expiry > 0) {
+        cookie->setExpirationDate(QDateTime::fromSecsSinceEpoch(expiry, Qt::UTC));
+    }
+    return true;
+}
+
+QString netscapeLine(const QNetworkCookie &cookie)
+{
+    const QString domain = cookie.domain();
+    const qint64 expiry = cookie.isSessionCookie() ? 0 : cookie.expirationDate().toSecsSinceEpoch();
+    return QStringLiteral("%1%2\t%3\t%4\t%5\t%6\t%7\t%8")
+        .arg(cookie.isHttpOnly() ? kHttpOnlyPrefix : QString(),
+             domain,
+             domain.startsWith(QLatin1Char('.')) ? QStringLiteral("TRUE") : QStringLiteral("FALSE"),
+             cookie.path().isEmpty() ? QStringLiteral("/") : cookie.path(),
+             cookie.isSecure() ? QStringLiteral("TRUE") : QStringLiteral("FALSE"),
+             QString::number(expiry),
+             QString::fromUtf8(cookie.name()),
+             QString::fromUtf8(cookie.value()));
+}
+
+QString jsonLine(const QNetworkCookie &cookie)
+{
+    QJsonObject object {
+        {QStringLiteral("name"), QString::fromUtf8(cookie.name())},
+        {QStringLiteral("value"), QString::fromUtf8(cookie.value())},
+        {QStringLiteral("domain"), cookie.domain()},
+        {QStringLiteral("path"), cookie.path().isEmpty() ? QStringLiteral("/") : cookie.path()},
+    };
+    if (cookie.isSecure()) {
+        object.insert(QStringLiteral("secure"), true);
+    }
+    if (cookie.isHttpOnly()) {
+        object.insert(QStringLiteral("httpOnly"), true);
+    }
+    if (!cookie.isSessionCookie()) {
+        object.insert(QStringLiteral("expires"), static_cast<double>(cookie.expirationDate().toSecsSinceEpoch()));
+    }
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+} // namespace
+
+CookieJarTransfer::CookieJarTransfer(QWebEngineCookieStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+{
+    m_batchTimer = new QTimer(this);
+    m_batchTimer->setInterval(0);
+    ENSURE_QT_CONNECT(m_batchTimer, &QTimer::timeout, this, &CookieJarTransfer::importNextBatch);
+
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setSingleShot(true);
+    ENSURE_QT_CONNECT(m_drainTimer, &QTimer::timeout, this, [this]() {
+        finishExport(QString());
+    });
+}
+
+CookieJarTransfer::~CookieJarTransfer() = default;
+
+bool CookieJarTransfer::isBusy() const
+{
+    return m_operation != Operation::Idle;
+}
+
+CookieJarTransfer::Format CookieJarTransfer::formatForPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == QLatin1String("jsonl") || suffix == QLatin1String("json") ? Format::JsonLines : Format::Netscape;
+}
+
+bool CookieJarTransfer::importFile(const QString &path, Format format)
+{
+    if (isBusy() || !m_store) {
+        return false;
+    }
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        emit importFinished(0, 0, m_file.errorString());
+        return false;
+    }
+    m_format = format == Format::Auto ? formatForPath(path) : format;
+    m_stream = std::make_unique<QTextStream>(&m_file);
+    useUtf8(m_stream.get());
+    m_operation = Operation::Importing;
+    m_processed = 0;
+    m_skipped = 0;
+    m_clock.start();
+    m_batchTimer->start();
+    return true;
+}
+
+bool CookieJarTransfer::exportFile(const QString &path, Format format)
+{
+    if (isBusy() || !m_store) {
+        return false;
+    }
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        emit exportFinished(0, m_file.errorString());
+        return false;
+    }
+    m_format = format == Format::Auto ? formatForPath(path) : format;
+    m_stream = std::make_unique<QTextStream>(&m_file);
+    useUtf8(m_stream.get());
+    if (m_format == Format::Netscape) {
+        *m_stream << "# Netscape HTTP Cookie File\n";
+    }
+    m_operation = Operation::Exporting;
+    m_processed = 0;
+    m_skipped = 0;
+    m_exportedKeys.clear();
+    m_clock.start();
+
+    m_exportConnection = connect(m_store, &QWebEngineCookieStore::cookieAdded, this, &CookieJarTransfer::handleCookieAdded);
+    ConnectGuard::verify(m_exportConnection, "QWebEngineCookieStore::cookieAdded", __FILE__, __LINE__);
+    m_store->loadAllCookies();
+    m_drainTimer->start(kEmptyStoreTimeoutMs);
+    return true;
+}
+
+void CookieJarTransfer::cancel()
+{
+    if (m_operation == Operation::Importing) {
+        finishImport(tr("已取消"));
+    } else if (m_operation == Operation::Exporting) {
+        finishExport(tr("已取消"));
+    }
+}
+
+void CookieJarTransfer::importNextBatch()
+{
+    if (!m_store) {
+        finishImport(tr("Cookie 存储已销毁"));
+        return;
+    }
+    for (int i = 0; i < kImportBatchLines; ++i) {
+        if (m_stream->atEnd()) {
+            finishImport(QString());
+            return;
+        }
+        const QString line = m_stream->readLine().trimmed();
+        if (line.isEmpty() || (line.startsWith(QLatin1Char('#')) && !line.startsWith(kHttpOnlyPrefix))) {
+            continue;
+        }
+        QNetworkCookie cookie;
+        const bool parsed = m_format == Format::JsonLines ? parseJsonLine(line, &cookie) : parseNetscapeLine(line, &cookie);
+        if (!parsed) {
+            ++m_skipped;
+            continue;
+        }
+        m_store->setCookie(cookie, originFor(cookie));
+        ++m_processed;
+    }
+    emit progress(m_processed, m_skipped);
+}
+
+void CookieJarTransfer::handleCookieAdded(const QNetworkCookie &cookie)
+{
+    // 只保留键用于去重，cookie 本身立即写出
+    const QByteArray key = cookieKey(cookie);
+    if (m_exportedKeys.contains(key)) {
+        return;
+    }
+    m_exportedKeys.insert(key);
+    *m_stream << (m_format == Format::JsonLines ? jsonLine(cookie) : netscapeLine(cookie)) << '\n';
+    ++m_processed;
+    // 0 ms 定时器在当前这批 cookieAdded 全部发出之后才触发
+    m_drainTimer->start(0);
+    if (m_processed % kImportBatchLines == 0) {
+        emit progress(m_processed, 0);
+    }
+}
+
+void CookieJarTransfer::finishImport(const QString &error)
+{
+    const qint64 imported = m_processed;
+    const qint64 skipped = m_skipped;
+    qInfo().noquote() << QStringLiteral("CookieJarTransfer: imported %1 cookies (%2 skipped) in %3 ms")
+                             .arg(imported)
+                             .arg(skipped)
+                             .arg(m_clock.elapsed());
+    reset();
+    emit importFinished(imported, skipped, error);
+}
+
+void CookieJarTransfer::finishExport(const QString &error)
+{
+    const qint64 exported = m_processed;
+    m_stream->flush();
+    const QString writeError = m_file.error() != QFileDevice::NoError ? m_file.errorString() : QString();
+    qInfo().noquote() << QStringLiteral("CookieJarTransfer: exported %1 cookies in %2 ms")
+                             .arg(exported)
+                             .arg(m_clock.elapsed());
+    reset();
+    emit exportFinished(exported, error.isEmpty() ? writeError : error);
+}
+
+void CookieJarTransfer::reset()
+{
+    m_batchTimer->stop();
+    m_drainTimer->stop();
+    if (m_exportConnection) {
+        disconnect(m_exportConnection);
+    }
+    m_exportedKeys.clear();
+    m_exportedKeys.squeeze();
+    m_stream.reset();
+    m_file.close();
+    m_operation = Operation::Idle;
+}
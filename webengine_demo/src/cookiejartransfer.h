@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+class QNetworkCookie;
+class QTextStream;
+class QTimer;
+class QWebEngineCookieStore;
+
+// CookieJarTransfer 在 QWebEngineCookieStore 与 cookie-jar 文件之间批量导入 / 导出（含 HttpOnly），
+// 导入按批逐行读取、导出边收边写，内存占用与文件大小无关。
+class CookieJarTransfer final : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Format
+    {
+        Auto,
+        Netscape,
+        JsonLines,
+    };
+
+    explicit CookieJarTransfer(QWebEngineCookieStore *store, QObject *parent = nullptr);
+    ~CookieJarTransfer() override;
+
+    bool isBusy() const;
+    bool importFile(const QString &path, Format format = Format::Auto);
+    bool exportFile(const QString &path, Format format = Format::Auto);
+    void cancel();
+
+    static Format formatForPath(const QString &path);
+
+signals:
+    void progress(qint64 processed, qint64 skipped);
+    void importFinished(qint64 imported, qint64 skipped, const QString &error);
+    void exportFinished(qint64 exported, const QString &error);
+
+private:
+    enum class Operation
+    {
+        Idle,
+        Importing,
+        Exporting,
+    };
+
+    void importNextBatch();
+    void handleCookieAdded(const QNetworkCookie &cookie);
+    void finishImport(const QString &error);
+    void finishExport(const QString &error);
+    void reset();
+
+    QPointer<QWebEngineCookieStore> m_store;
+    Operation m_operation {Operation::Idle};
+    Format m_format {Format::Netscape};
+    QFile m_file;
+    std::unique_ptr<QTextStream> m_stream;
+    QTimer *m_batchTimer {nullptr};
+    QTimer *m_drainTimer {nullptr};
+    QMetaObject::Connection m_exportConnection;
+    QSet<QByteArray> m_exportedKeys;
+    QElapsedTimer m_clock;
+    qint64 m_processed {0};
+    qint64 m_skipped {0};
+};
@@ -0,0 +1,418 @@
+#include "cookiemirror.h"
+
+#include "connectguard.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+#include <QWebEngineCookieStore>
+#include <QWebEnginePage>
+
+#include <algorithm>
+
+namespace {
+constexpr qint64 kDefaultMaxBytes = 4 * 1024 * 1024;
+// loadAllCookies() 没有完成信号：结果在同一个事件里逐个发出 cookieAdded，该事件处理完即已全部送达；
+// 存储为空时不会收到任何信号，超过这个时间仍没有结果就按空存储结束
+constexpr int kEmptyStoreTimeoutMs = 2000;
+// 每条记录除 name/value/domain/path 外的固定开销估算
+constexpr qint64 kEntryOverheadBytes = 96;
+
+// 常见的二级公共后缀；没有公开的 Public Suffix List API 时用于近似可注册域名
+const QStringList kSecondLevelSuffixes {
+    QStringLiteral("co"), QStringLiteral("com"), QStringLiteral("net"), QStringLiteral("org"),
+    QStringLiteral("gov"), QStringLiteral("edu"), QStringLiteral("ac"), QStringLiteral("ne"),
+    QStringLiteral("or"), QStringLiteral("go"),
+};
+
+qint64 entryBytes(const QNetworkCookie &cookie)
+{
+    return kEntryOverheadBytes + cookie.name().size() + cookie.value().size()
+           + (cookie.domain().size() + cookie.path().size()) * static_cast<qint64>(sizeof(QChar));
+}
+
+QString normalizedPath(const QString &path)
+{
+    return path.isEmpty() ? QStringLiteral("/") : path;
+}
+
+bool sameCookie(const QNetworkCookie &lhs, const QNetworkCookie &rhs)
+{
+    return lhs.name() == rhs.name() && lhs.domain() == rhs.domain() && normalizedPath(lhs.path()) == normalizedPath(rhs.path());
+}
+
+// RFC 6265 5.1.3
+bool domainMatches(const QString &cookieDomain, const QString &host)
+{
+    if (!cookieDomain.startsWith(QLatin1Char('.'))) {
+        return cookieDomain.compare(host, Qt::CaseInsensitive) == 0;
+    }
+    const QString bare = cookieDomain.mid(1);
+    return host.compare(bare, Qt::CaseInsensitive) == 0 || host.endsWith(cookieDomain, Qt::CaseInsensitive);
+}
+
+// RFC 6265 5.1.4
+bool pathMatches(const QString &cookiePath, const QString &requestPath)
+{
+    if (requestPath == cookiePath) {
+        return true;
+    }
+    if (!requestPath.startsWith(cookiePath)) {
+        return false;
+    }
+    return cookiePath.endsWith(QLatin1Char('/')) || requestPath.at(cookiePath.size()) == QLatin1Char('/');
+}
+
+QVariantMap cookieToVariant(const QNetworkCookie &cookie)
+{
+    QVariantMap map {
+        {QStringLiteral("name"), QString::fromUtf8(cookie.name())},
+        {QStringLiteral("value"), QString::fromUtf8(cookie.value())},
+        {QStringLiteral("domain"), cookie.domain()},
+        {QStringLiteral("path"), normalizedPath(cookie.path())},
+        {QStringLiteral("secure"), cookie.isSecure()},
+        {QStringLiteral("httpOnly"), cookie.isHttpOnly()},
+    };
+    if (!cookie.isSessionCookie()) {
+        map.insert(QStringLiteral("expires"), cookie.expirationDate().toSecsSinceEpoch());
+    }
+    return map;
+}
+} // namespace
+
+CookieMirror::CookieMirror(QWebEngineCookieStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_maxBytes(kDefaultMaxBytes)
+{
+}
+
+void CookieMirror::start()
+{
+    if (m_started || !m_store) {
+        return;
+    }
+    m_started = true;
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setSingleShot(true);
+    ENSURE_QT_CONNECT(m_drainTimer, &QTimer::timeout, this, &CookieMirror::finishLoad);
+    ENSURE_QT_CONNECT(m_store, &QWebEngineCookieStore::cookieAdded, this, &CookieMirror::handleCookieAdded);
+    ENSURE_QT_CONNECT(m_store, &QWebEngineCookieStore::cookieRemoved, this, &CookieMirror::handleCookieRemoved);
+    reload();
+}
+
+void CookieMirror::reload()
+{
+    m_loading = true;
+    m_evictedDuringLoad.clear();
+    m_loadClock.start();
+    m_store->loadAllCookies();
+    m_drainTimer->start(kEmptyStoreTimeoutMs);
+}
+
+void CookieMirror::finishLoad()
+{
+    m_loading = false;
+    // 重新加载前被淘汰、加载期间没有再次被淘汰的域名已经补全
+    const int recovered = (m_evictedDomains - m_evictedDuringLoad).size();
+    m_evictedDomains = m_evictedDuringLoad;
+    if (m_loaded) {
+        qInfo().noquote() << QStringLiteral("CookieMirror: reloaded, %1 evicted domains recovered, %2 still evicted")
+                                 .arg(recovered)
+                                 .arg(m_evictedDomains.size());
+        return;
+    }
+    m_loaded = true;
+    qInfo().noquote() << QStringLiteral("CookieMirror: %1 cookies in %2 domains, ~%3 KiB, loaded in %4 ms")
+                             .arg(m_cookies)
+                             .arg(m_buckets.size())
+                             .arg(m_bytes / 1024)
+                             .arg(m_loadClock.elapsed());
+    emit loaded(m_cookies);
+}
+
+void CookieMirror::maybeRecover()
+{
+    // 留出一半余量，避免重新加载后立刻又淘汰同一批域名
+    if (m_loaded && !m_loading && m_store && !m_evictedDomains.isEmpty() && m_bytes <= m_maxBytes / 2) {
+        reload();
+    }
+}
+
+void CookieMirror::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = qMax<qint64>(64 * 1024, bytes);
+    enforceBudget(QString());
+    maybeRecover();
+}
+
+QString CookieMirror::registrableDomain(const QString &host)
+{
+    QString bare = host.toLower();
+    if (bare.startsWith(QLatin1Char('.'))) {
+        bare.remove(0, 1);
+    }
+    if (bare.isEmpty() || !QHostAddress(bare).isNull()) {
+        return bare;
+    }
+    const QStringList labels = bare.split(QLatin1Char('.'), Qt::SkipEmptyParts);
+    if (labels.size() <= 2) {
+        return bare;
+    }
+    // example.co.uk / example.com.cn 这类国家顶级域下的二级后缀保留三段
+    const QString tld = labels.at(labels.size() - 1);
+    const QString second = labels.at(labels.size() - 2);
+    const int keep = tld.size() == 2 && kSecondLevelSuffixes.contains(second) ? 3 : 2;
+    return labels.mid(labels.size() - keep).join(QLatin1Char('.'));
+}
+
+bool CookieMirror::covers(const QUrl &url) const
+{
+    return m_loaded && !m_evictedDomains.contains(registrableDomain(url.host()));
+}
+
+QList<QNetworkCookie> CookieMirror::cookiesForUrl(const QUrl &url, bool *complete)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    if (complete) {
+        *complete = covers(url);
+    }
+    QList<QNetworkCookie> result;
+    const QString host = url.host().toLower();
+    const auto bucket = m_buckets.find(registrableDomain(host));
+    if (host.isEmpty() || bucket == m_buckets.end()) {
+        recordQuery(clock.nsecsElapsed());
+        return result;
+    }
+    bucket->lastUsed = ++m_useCounter;
+
+    const QString path = normalizedPath(url.path());
+    const bool secureChannel = url.scheme() == QLatin1String("https") || url.scheme() == QLatin1String("wss");
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    // std::map 有序，只需遍历不大于请求路径的键
+    for (auto it = bucket->paths.begin(); it != bucket->paths.end() && it->first <= path; ++it) {
+        if (!pathMatches(it->first, path)) {
+            continue;
+        }
+        for (const Entry &entry : it->second) {
+            const QNetworkCookie &cookie = entry.cookie;
+            if ((cookie.isSecure() && !secureChannel) || !domainMatches(cookie.domain(), host)) {
+                continue;
+            }
+            if (!cookie.isSessionCookie() && cookie.expirationDate() <= now) {
+                continue;
+            }
+            result.append(cookie);
+        }
+    }
+    // RFC 6265 5.4：路径更长的 cookie 排在前面
+    std::stable_sort(result.begin(), result.end(), [](const QNetworkCookie &lhs, const QNetworkCookie &rhs) {
+        return normalizedPath(lhs.path()).size() > normalizedPath(rhs.path()).size();
+    });
+    recordQuery(clock.nsecsElapsed());
+    return result;
+}
+
+QString CookieMirror::cookieHeaderForUrl(const QUrl &url, bool *complete)
+{
+    QStringList pairs;
+    for (const QNetworkCookie &cookie : cookiesForUrl(url, complete)) {
+        pairs << QString::fromUtf8(cookie.name() + '=' + cookie.value());
+    }
+    return pairs.join(QStringLiteral("; "));
+}
+
+QList<QNetworkCookie> CookieMirror::cookiesForDomain(const QString &domain) const
+{
+    QList<QNetworkCookie> result;
+    const auto bucket = m_buckets.constFind(registrableDomain(domain));
+    if (bucket == m_buckets.constEnd()) {
+        return result;
+    }
+    for (const auto &path : bucket->paths) {
+        for (const Entry &entry : path.second) {
+            result.append(entry.cookie);
+        }
+    }
+    return result;
+}
+
+CookieMirror::Stats CookieMirror::stats() const
+{
+    Stats stats;
+    stats.cookies = m_cookies;
+    stats.domains = m_buckets.size();
+    stats.bytes = m_bytes;
+    stats.maxBytes = m_maxBytes;
+    stats.evictedCookies = m_evictedCookies;
+    stats.evictedDomains = m_evictedDomains.size();
+    stats.queries = m_queries;
+    stats.avgQueryUs = m_queries > 0 ? m_queryNs / 1000.0 / m_queries : 0.0;
+    stats.loaded = m_loaded;
+    return stats;
+}
+
+QVariantMap CookieMirror::toVariant(const Stats &current)
+{
+    return {
+        {QStringLiteral("cookies"), current.cookies},
+        {QStringLiteral("domains"), current.domains},
+        {QStringLiteral("bytes"), current.bytes},
+        {QStringLiteral("maxBytes"), current.maxBytes},
+        {QStringLiteral("evictedCookies"), current.evictedCookies},
+        {QStringLiteral("evictedDomains"), current.evictedDomains},
+        {QStringLiteral("queries"), current.queries},
+        {QStringLiteral("avgQueryUs"), current.avgQueryUs},
+        {QStringLiteral("loaded"), current.loaded},
+    };
+}
+
+void CookieMirror::handleCookieAdded(const QNetworkCookie &cookie)
+{
+    if (m_loading) {
+        // 0 ms 定时器在当前这批 cookieAdded 全部发出之后才触发
+        m_drainTimer->start(0);
+    }
+    const QString domain = registrableDomain(cookie.domain());
+    // 已过期的 cookie 不会再发给任何请求，只用来覆盖掉同名的旧值
+    if (!cookie.isSessionCookie() && cookie.expirationDate() <= QDateTime::currentDateTimeUtc()) {
+        handleCookieRemoved(cookie);
+        return;
+    }
+    Bucket &bucket = m_buckets[domain];
+    // 同名同域同路径的 cookie 被覆盖时先移除旧值
+    removeEntry(bucket, cookie);
+
+    Entry entry {cookie, entryBytes(cookie)};
+    bucket.paths[normalizedPath(cookie.path())].push_back(entry);
+    bucket.bytes += entry.bytes;
+    bucket.lastUsed = ++m_useCounter;
+    ++bucket.cookies;
+    m_bytes += entry.bytes;
+    ++m_cookies;
+    enforceBudget(domain);
+}
+
+void CookieMirror::handleCookieRemoved(const QNetworkCookie &cookie)
+{
+    const QString domain = registrableDomain(cookie.domain());
+    const auto bucket = m_buckets.find(domain);
+    if (bucket == m_buckets.end()) {
+        return;
+    }
+    removeEntry(*bucket, cookie);
+    if (bucket->cookies == 0) {
+        m_buckets.erase(bucket);
+    }
+    maybeRecover();
+}
+
+bool CookieMirror::removeEntry(Bucket &bucket, const QNetworkCookie &cookie)
+{
+    const auto path = bucket.paths.find(normalizedPath(cookie.path()));
+    if (path == bucket.paths.end()) {
+        return false;
+    }
+    auto &entries = path->second;
+    const auto found = std::find_if(entries.begin(), entries.end(), [&cookie](const Entry &entry) {
+        return sameCookie(entry.cookie, cookie);
+    });
+    if (found == entries.end()) {
+        return false;
+    }
+    bucket.bytes -= found->bytes;
+    --bucket.cookies;
+    m_bytes -= found->bytes;
+    --m_cookies;
+    entries.erase(found);
+    if (entries.empty()) {
+        bucket.paths.erase(path);
+    }
+    return true;
+}
+
+void CookieMirror::enforceBudget(const QString &protectedDomain)
+{
+    while (m_bytes > m_maxBytes && m_buckets.size() > 1) {
+        // 淘汰最久未使用的整个域名，刚写入的域名不参与淘汰
+        auto victim = m_buckets.end();
+        for (auto it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+            if (it.key() != protectedDomain && (victim == m_buckets.end() || it->lastUsed < victim->lastUsed)) {
+                victim = it;
+            }
+        }
+        if (victim == m_buckets.end()) {
+            return;
+        }
+        m_bytes -= victim->bytes;
+        m_cookies -= victim->cookies;
+        m_evictedCookies += victim->cookies;
+        m_evictedDomains.insert(victim.key());
+        m_evictedDuringLoad.insert(victim.key());
+        qInfo().noquote() << QStringLiteral("CookieMirror: evicted %1 cookies of %2 (budget %3 KiB)")
+                                 .arg(victim->cookies)
+                                 .arg(victim.key())
+                                 .arg(m_maxBytes / 1024);
+        m_buckets.erase(victim);
+    }
+}
+
+void CookieMirror::recordQuery(qint64 elapsedNs)
+{
+    ++m_queries;
+    m_queryNs += elapsedNs;
+}
+
+CookieMirrorRpc::CookieMirrorRpc(CookieMirror *mirror, QWebEnginePage *page, QObject *parent)
+    : QObject(parent)
+    , m_mirror(mirror)
+    , m_page(page)
+{
+}
+
+QVariant CookieMirrorRpc::lookup(const QString &url)
+{
+    QVariantList result;
+    if (!allowed()) {
+        return result;
+    }
+    bool complete = false;
+    for (const QNetworkCookie &cookie : m_mirror->cookiesForUrl(QUrl::fromUserInput(url), &complete)) {
+        result.append(cookieToVariant(cookie));
+    }
+    return complete ? QVariant(result) : QVariant();
+}
+
+QVariant CookieMirrorRpc::cookieHeader(const QString &url)
+{
+    if (!allowed()) {
+        return QString();
+    }
+    bool complete = false;
+    const QString header = m_mirror->cookieHeaderForUrl(QUrl::fromUserInput(url), &complete);
+    return complete ? QVariant(header) : QVariant();
+}
+
+QVariantMap CookieMirrorRpc::statistics() const
+{
+    return m_mirror ? CookieMirror::toVariant(m_mirror->stats()) : QVariantMap();
+}
+
+bool CookieMirrorRpc::allowed() const
+{
+    // HttpOnly cookie 只开放给应用自带的本地页面；调用一定来自本 pane 的 channel，只需检查本 pane 的页面
+    if (!m_mirror || !m_page) {
+        qWarning() << "CookieMirrorRpc: RPC query rejected without a page";
+        return false;
+    }
+    if (m_page->url().scheme() != QLatin1String("qrc")) {
+        qWarning() << "CookieMirrorRpc: RPC query rejected for" << m_page->url();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QNetworkCookie>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <map>
+#include <vector>
+
+class QTimer;
+class QUrl;
+class QWebEngineCookieStore;
+class QWebEnginePage;
+
+// CookieMirror 在进程内维护 profile 全部 Cookie（含 HttpOnly）的副本，按可注册域名 + 路径索引，
+// 由 cookieAdded / cookieRemoved 增量更新，同步查询无需经过渲染进程；内存超过上限时淘汰最久未查询的域名，
+// 被淘汰的域名此后在镜像中不再完整，查询时报告未命中，由调用方回到 Cookie 存储或页面读取；
+// 删除 cookie 使内存回落到上限一半以下时重新加载全部 cookie，补回被淘汰的域名。
+class CookieMirror final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int cookies {0};
+        int domains {0};
+        qint64 bytes {0};
+        qint64 maxBytes {0};
+        qint64 evictedCookies {0};
+        int evictedDomains {0};
+        qint64 queries {0};
+        double avgQueryUs {0.0};
+        bool loaded {false};
+    };
+
+    explicit CookieMirror(QWebEngineCookieStore *store, QObject *parent = nullptr);
+
+    void start();
+    void setMaxBytes(qint64 bytes);
+
+    // 初始加载已完成且该 URL 的域名未被淘汰时为 true，此时镜像中的结果是完整的
+    bool covers(const QUrl &url) const;
+    // complete 非空时写入 covers(url) 的结果
+    QList<QNetworkCookie> cookiesForUrl(const QUrl &url, bool *complete = nullptr);
+    QString cookieHeaderForUrl(const QUrl &url, bool *complete = nullptr);
+    QList<QNetworkCookie> cookiesForDomain(const QString &domain) const;
+    Stats stats() const;
+
+    static QString registrableDomain(const QString &host);
+    static QVariantMap toVariant(const Stats &stats);
+
+signals:
+    void loaded(int cookies);
+
+private:
+    struct Entry
+    {
+        QNetworkCookie cookie;
+        qint64 bytes {0};
+    };
+
+    struct Bucket
+    {
+        // path -> 该路径下的 cookie，按路径有序便于前缀匹配
+        std::map<QString, std::vector<Entry>> paths;
+        qint64 bytes {0};
+        int cookies {0};
+        quint64 lastUsed {0};
+    };
+
+    void handleCookieAdded(const QNetworkCookie &cookie);
+    void handleCookieRemoved(const QNetworkCookie &cookie);
+    // 调用 loadAllCookies() 并等待结果送达；初始加载与淘汰后的恢复共用
+    void reload();
+    void finishLoad();
+    void maybeRecover();
+    bool removeEntry(Bucket &bucket, const QNetworkCookie &cookie);
+    void enforceBudget(const QString &protectedDomain);
+    void recordQuery(qint64 elapsedNs);
+
+    QPointer<QWebEngineCookieStore> m_store;
+    QHash<QString, Bucket> m_buckets;
+    // 曾被淘汰的可注册域名；之后写入的 cookie 仍会镜像，但之前的已经丢失
+    QSet<QString> m_evictedDomains;
+    // 本次 reload() 开始后被淘汰的域名，加载完成时取代 m_evictedDomains
+    QSet<QString> m_evictedDuringLoad;
+    QTimer *m_drainTimer {nullptr};
+    QElapsedTimer m_loadClock;
+    quint64 m_useCounter {0};
+    qint64 m_bytes {0};
+    qint64 m_maxBytes {0};
+    int m_cookies {0};
+    qint64 m_evictedCookies {0};
+    qint64 m_queries {0};
+    qint64 m_queryNs {0};
+    bool m_started {false};
+    bool m_loaded {false};
+    bool m_loading {false};
+};
+
+// CookieMirrorRpc 是每个 pane 注册到自己 QWebChannel 的 cookieMirror 对象：多窗口共用同一份镜像，
+// 但只看本 pane 的页面是否位于受信任的本地页面（qrc:），其他窗口打开的网页不影响本窗口的查询。
+class CookieMirrorRpc final : public QObject
+{
+    Q_OBJECT
+
+public:
+    CookieMirrorRpc(CookieMirror *mirror, QWebEnginePage *page, QObject *parent = nullptr);
+
+    // 镜像对该 URL 不完整时返回 null
+    Q_INVOKABLE QVariant lookup(const QString &url);
+    Q_INVOKABLE QVariant cookieHeader(const QString &url);
+    Q_INVOKABLE QVariantMap statistics() const;
+
+private:
+    bool allowed() const;
+
+    QPointer<CookieMirror> m_mirror;
+    QPointer<QWebEnginePage> m_page;
+};
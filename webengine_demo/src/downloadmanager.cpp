@@ -0,0 +1,517 @@
+#include "downloadmanager.h"
+
+#include "connectguard.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestInfo>
+#include <QWebEngineUrlRequestInterceptor>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QWebEngineDownloadRequest>
+#else
+#include <QWebEngineDownloadItem>
+#endif
+
+#include <algorithm>
+
+namespace {
+constexpr int kSampleIntervalMs = 250;
+constexpr int kReportIntervalMs = 1000;
+constexpr int kResumeCheckMs = 2000;
+// 重新发起后在该时间内没有收到对应的下载请求，视为失败并释放名额
+constexpr int kReissueTimeoutMs = 10000;
+constexpr auto kReissuePrefix = "webengine-demo-reissue-";
+constexpr int kMaxRecordedMethods = 256;
+constexpr int kMaxResumeBackoffMs = 30000;
+// 令牌桶最多积攒 0.5 秒的额度，最多欠 1 秒，限制单次暂停的时长
+constexpr double kBurstSeconds = 0.5;
+constexpr double kDebtSeconds = 1.0;
+constexpr double kRateSmoothing = 0.3;
+
+bool isResumable(WebEngineDownload::DownloadInterruptReason reason)
+{
+    switch (reason) {
+    case WebEngineDownload::NetworkFailed:
+    case WebEngineDownload::NetworkTimeout:
+    case WebEngineDownload::NetworkDisconnected:
+    case WebEngineDownload::NetworkServerDown:
+    case WebEngineDownload::ServerFailed:
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+// 下载请求不带请求方法，记录最近以非 GET 方法请求过的 URL；Qt 5 在 IO 线程调用 interceptRequest，因此加锁
+class RequestMethodRecorder final : public QWebEngineUrlRequestInterceptor
+{
+public:
+    using QWebEngineUrlRequestInterceptor::QWebEngineUrlRequestInterceptor;
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info) override
+    {
+        if (info.requestMethod() == "GET") {
+            return;
+        }
+        QMutexLocker locker(&m_mutex);
+        m_nonGet.removeAll(info.requestUrl());
+        m_nonGet.append(info.requestUrl());
+        if (m_nonGet.size() > kMaxRecordedMethods) {
+            m_nonGet.removeFirst();
+        }
+    }
+
+    bool usedNonGet(const QUrl &url) const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_nonGet.contains(url);
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QList<QUrl> m_nonGet;
+};
+
+DownloadManager::DownloadManager(QWebEngineProfile *profile, QObject *parent)
+    : QObject(parent)
+    , m_profile(profile)
+{
+    m_sampleTimer = new QTimer(this);
+    m_sampleTimer->setInterval(kSampleIntervalMs);
+    ENSURE_QT_CONNECT(m_sampleTimer, &QTimer::timeout, this, &DownloadManager::sample);
+
+    if (m_profile) {
+        ENSURE_QT_CONNECT(m_profile.data(), &QWebEngineProfile::downloadRequested, this,
+                          &DownloadManager::handleDownloadRequested);
+        m_methods = new RequestMethodRecorder(this);
+        m_profile->setUrlRequestInterceptor(m_methods);
+    }
+}
+
+DownloadManager::~DownloadManager()
+{
+    if (m_profile) {
+        m_profile->setUrlRequestInterceptor(nullptr);
+    }
+}
+
+void DownloadManager::setLimits(const ConfigManager::DownloadLimits &limits)
+{
+    m_limits = limits;
+    m_limits.maxConcurrent = qMax(1, m_limits.maxConcurrent);
+    m_limits.maxPerHost = qMax(1, m_limits.maxPerHost);
+    schedule();
+}
+
+ConfigManager::DownloadLimits DownloadManager::limits() const
+{
+    return m_limits;
+}
+
+void DownloadManager::setRetryPage(QWebEnginePage *page)
+{
+    m_retryPages.clear();
+    addRetryPage(page);
+}
+
+void DownloadManager::addRetryPage(QWebEnginePage *page)
+{
+    m_retryPages.removeAll(nullptr);
+    if (!page || m_retryPages.contains(page)) {
+        return;
+    }
+    m_retryPages.append(page);
+    // 页面在加载途中销毁时不会再收到 loadFinished，需要自行撤销加载状态
+    ENSURE_QT_CONNECT(page, &QObject::destroyed, this, [this](QObject *object) {
+        m_loadingPages.remove(object);
+    });
+}
+
+void DownloadManager::setPageLoading(const QObject *page, bool loading)
+{
+    if (loading) {
+        m_loadingPages.insert(page);
+    } else {
+        m_loadingPages.remove(page);
+    }
+}
+
+QWebEnginePage *DownloadManager::retryPage() const
+{
+    for (const QPointer<QWebEnginePage> &page : m_retryPages) {
+        if (page) {
+            return page;
+        }
+    }
+    return nullptr;
+}
+
+DownloadManager::Stats DownloadManager::stats() const
+{
+    Stats stats;
+    stats.queued = m_waiting.size() + m_retries.size();
+    for (const Transfer &transfer : m_transfers) {
+        if (transfer.admitted) {
+            ++stats.active;
+        } else {
+            ++stats.queued;
+        }
+        if (transfer.item) {
+            stats.receivedBytes += transfer.item->receivedBytes();
+            stats.totalBytes += qMax<qint64>(0, transfer.item->totalBytes());
+        }
+    }
+    stats.completed = m_completed;
+    stats.failed = m_failed;
+    stats.resumed = m_resumed;
+    stats.throttled = m_throttled;
+    stats.bytesPerSecond = static_cast<qint64>(m_bytesPerSecond);
+    return stats;
+}
+
+void DownloadManager::handleDownloadRequested(WebEngineDownload *download)
+{
+    if (!download || download->state() != WebEngineDownload::DownloadRequested || !m_profile) {
+        return;
+    }
+
+    Transfer transfer;
+    transfer.item = download;
+    transfer.url = download->url();
+    transfer.host = download->url().host().toLower();
+
+    // 重新发起的下载凭建议文件名中的令牌认领，沿用原来的文件名与尝试次数，名额在重新发起时已经占好；
+    // 用户另行发起的同一 URL 的下载没有令牌，按新下载处理
+    const QString suggested = download->downloadFileName();
+    const auto retry = suggested.startsWith(QLatin1String(kReissuePrefix))
+                           ? m_retries.constFind(suggested.mid(qstrlen(kReissuePrefix)).toULongLong())
+                           : m_retries.constEnd();
+    const bool reissued = retry != m_retries.constEnd();
+    if (reissued) {
+        transfer.filePath = retry->filePath;
+        transfer.resumeAttempts = retry->resumeAttempts;
+        m_retries.erase(retry);
+        QFile::remove(transfer.filePath);
+    } else {
+        const QString directory = m_profile->downloadPath();
+        QDir().mkpath(directory);
+        transfer.filePath = uniqueFilePath(directory, download->downloadFileName());
+    }
+
+    const QFileInfo target(transfer.filePath);
+    if (!hasSpaceFor(target.absolutePath(), download->totalBytes())) {
+        qWarning() << "DownloadManager: not enough disk space for" << transfer.url.toString();
+        download->cancel();
+        ++m_failed;
+        emit downloadFinished(transfer.filePath, false, tr("磁盘空间不足"));
+        return;
+    }
+
+    // 超出上限时不接受，等名额空出后再通过页面重新发起；接受之后再暂停的下载仍会占着连接并先收一部分数据。
+    // 无法按 URL 重放的下载或没有可用页面时只能接受后暂停
+    if (!reissued && !hasSlotFor(transfer.host) && canReissue(transfer.url) && retryPage()) {
+        download->cancel();
+        transfer.item.clear();
+        m_waiting.append(transfer);
+        qInfo() << "DownloadManager: queued" << transfer.url.toString() << "until a slot is free";
+        emit statsUpdated(stats());
+        return;
+    }
+    download->setDownloadDirectory(target.absolutePath());
+    download->setDownloadFileName(target.fileName());
+
+    const quint32 id = download->id();
+    ENSURE_QT_CONNECT(download, &WebEngineDownload::stateChanged, this, [this, id]() {
+        handleStateChanged(id);
+    });
+    m_transfers.insert(id, transfer);
+    download->accept();
+    qInfo() << "DownloadManager: accepted" << transfer.url.toString() << "->" << transfer.filePath;
+
+    if (!m_sampleTimer->isActive()) {
+        m_sampleClock.start();
+        m_reportClock.start();
+        m_tokens = 0.0;
+        m_sampleTimer->start();
+    }
+    schedule();
+}
+
+void DownloadManager::handleStateChanged(quint32 id)
+{
+    const auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->item) {
+        return;
+    }
+    switch (it->item->state()) {
+    case WebEngineDownload::DownloadInProgress:
+        it->resuming = false;
+        schedule();
+        break;
+    case WebEngineDownload::DownloadCompleted:
+        finishTransfer(id, true, QString());
+        break;
+    case WebEngineDownload::DownloadCancelled:
+        finishTransfer(id, false, tr("已取消"));
+        break;
+    case WebEngineDownload::DownloadInterrupted:
+        handleInterrupted(id);
+        break;
+    default:
+        break;
+    }
+}
+
+void DownloadManager::handleInterrupted(quint32 id)
+{
+    Transfer &transfer = m_transfers[id];
+    const auto reason = transfer.item->interruptReason();
+    if (!isResumable(reason) || transfer.resumeAttempts >= m_limits.maxResumeAttempts) {
+        finishTransfer(id, false, transfer.item->interruptReasonString());
+        return;
+    }
+    ++transfer.resumeAttempts;
+    const int backoffMs = qMin(kMaxResumeBackoffMs, 1000 << qMin(transfer.resumeAttempts - 1, 5));
+    qInfo() << "DownloadManager: interrupted" << transfer.url.toString() << transfer.item->interruptReasonString()
+            << "- resume attempt" << transfer.resumeAttempts << "in" << backoffMs << "ms";
+    QTimer::singleShot(backoffMs, this, [this, id]() {
+        tryResume(id);
+    });
+}
+
+void DownloadManager::tryResume(quint32 id)
+{
+    const auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->item || it->item->state() != WebEngineDownload::DownloadInterrupted) {
+        return;
+    }
+    it->resuming = true;
+    it->item->resume();
+    ++m_resumed;
+
+    // 部分中断（例如服务器不支持 Range）无法在原下载上继续，resume() 之后仍处于中断状态
+    QTimer::singleShot(kResumeCheckMs, this, [this, id]() {
+        const auto it = m_transfers.constFind(id);
+        if (it != m_transfers.constEnd() && it->resuming && it->item
+            && it->item->state() == WebEngineDownload::DownloadInterrupted) {
+            restartTransfer(id);
+        }
+    });
+}
+
+void DownloadManager::restartTransfer(quint32 id)
+{
+    const auto it = m_transfers.find(id);
+    QWebEnginePage *page = retryPage();
+    if (!page || !canReissue(it->url)) {
+        finishTransfer(id, false, it->item ? it->item->interruptReasonString() : QString());
+        return;
+    }
+    Transfer retry = *it;
+    retry.item.clear();
+    m_transfers.erase(it);
+    qWarning() << "DownloadManager: cannot resume" << retry.url.toString() << "- restarting from zero";
+    reissue(page, retry);
+    schedule();
+}
+
+void DownloadManager::reissue(QWebEnginePage *page, const Transfer &transfer)
+{
+    const quint64 token = ++m_nextReissueToken;
+    m_retries.insert(token, transfer);
+    page->download(transfer.url, QLatin1String(kReissuePrefix) + QString::number(token));
+    QTimer::singleShot(kReissueTimeoutMs, this, [this, token]() {
+        const auto it = m_retries.find(token);
+        if (it == m_retries.end()) {
+            return;
+        }
+        const QString filePath = it->filePath;
+        const QUrl url = it->url;
+        m_retries.erase(it);
+        ++m_failed;
+        qWarning() << "DownloadManager: no download request for" << url.toString();
+        emit downloadFinished(filePath, false, tr("重新发起下载失败"));
+        schedule();
+    });
+}
+
+bool DownloadManager::canReissue(const QUrl &url) const
+{
+    const QString scheme = url.scheme().toLower();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https")) {
+        return false;
+    }
+    return !m_methods || !m_methods->usedNonGet(url);
+}
+
+bool DownloadManager::hasSlotFor(const QString &host) const
+{
+    const int total = m_transfers.size() + m_retries.size();
+    int perHost = 0;
+    for (const Transfer &transfer : m_transfers) {
+        perHost += transfer.host == host ? 1 : 0;
+    }
+    for (const Transfer &transfer : m_retries) {
+        perHost += transfer.host == host ? 1 : 0;
+    }
+    return total < m_limits.maxConcurrent && perHost < m_limits.maxPerHost;
+}
+
+bool DownloadManager::isPathReserved(const QString &filePath) const
+{
+    const auto matches = [&filePath](const Transfer &transfer) {
+        return transfer.filePath == filePath;
+    };
+    return std::any_of(m_transfers.cbegin(), m_transfers.cend(), matches)
+           || std::any_of(m_waiting.cbegin(), m_waiting.cend(), matches)
+           || std::any_of(m_retries.cbegin(), m_retries.cend(), matches);
+}
+
+void DownloadManager::finishTransfer(quint32 id, bool ok, const QString &error)
+{
+    const Transfer transfer = m_transfers.take(id);
+    if (ok) {
+        ++m_completed;
+    } else {
+        ++m_failed;
+    }
+    qInfo() << "DownloadManager:" << (ok ? "finished" : "failed") << transfer.url.toString() << error;
+    emit downloadFinished(transfer.filePath, ok, error);
+    schedule();
+}
+
+void DownloadManager::schedule()
+{
+    QHash<QString, int> perHost;
+    int admitted = 0;
+    for (Transfer &transfer : m_transfers) {
+        const bool allowed = admitted < m_limits.maxConcurrent && perHost.value(transfer.host) < m_limits.maxPerHost;
+        if (allowed) {
+            ++admitted;
+            ++perHost[transfer.host];
+        }
+        transfer.admitted = allowed;
+
+        WebEngineDownload *item = transfer.item;
+        if (!item || item->state() != WebEngineDownload::DownloadInProgress) {
+            continue;
+        }
+        const bool shouldPause = !allowed || m_throttled;
+        if (shouldPause && !item->isPaused()) {
+            item->pause();
+        } else if (!shouldPause && item->isPaused()) {
+            item->resume();
+        }
+    }
+
+    // 名额空出后按请求先后重新发起暂缓的下载
+    for (auto it = m_waiting.begin(); it != m_waiting.end();) {
+        if (!hasSlotFor(it->host)) {
+            ++it;
+            continue;
+        }
+        const Transfer transfer = *it;
+        it = m_waiting.erase(it);
+        if (QWebEnginePage *page = retryPage()) {
+            qInfo() << "DownloadManager: starting queued" << transfer.url.toString();
+            reissue(page, transfer);
+        } else {
+            ++m_failed;
+            emit downloadFinished(transfer.filePath, false, tr("没有可用于重新发起下载的页面"));
+        }
+    }
+}
+
+void DownloadManager::sample()
+{
+    const double seconds = qMax<qint64>(1, m_sampleClock.restart()) / 1000.0;
+    qint64 delta = 0;
+    for (Transfer &transfer : m_transfers) {
+        if (!transfer.item) {
+            continue;
+        }
+        const qint64 received = transfer.item->receivedBytes();
+        const qint64 bytes = qMax<qint64>(0, received - transfer.lastBytes);
+        transfer.lastBytes = received;
+        transfer.bytesPerSecond += kRateSmoothing * (bytes / seconds - transfer.bytesPerSecond);
+        delta += bytes;
+    }
+    m_bytesPerSecond += kRateSmoothing * (delta / seconds - m_bytesPerSecond);
+
+    // 令牌桶：超出额度时暂停全部下载，额度恢复后再继续
+    bool throttled = false;
+    const qint64 limit = effectiveBandwidth();
+    if (limit > 0) {
+        m_tokens = std::clamp(m_tokens + limit * seconds - delta, -limit * kDebtSeconds, limit * kBurstSeconds);
+        throttled = m_tokens < 0.0;
+    } else {
+        m_tokens = 0.0;
+    }
+    if (throttled != m_throttled) {
+        m_throttled = throttled;
+        schedule();
+    }
+
+    if (m_transfers.isEmpty()) {
+        m_sampleTimer->stop();
+        m_throttled = false;
+        m_bytesPerSecond = 0.0;
+        emit statsUpdated(stats());
+        return;
+    }
+    if (m_reportClock.elapsed() >= kReportIntervalMs) {
+        m_reportClock.restart();
+        emit statsUpdated(stats());
+    }
+}
+
+qint64 DownloadManager::effectiveBandwidth() const
+{
+    qint64 limit = m_limits.bandwidthBytesPerSec;
+    if (!m_loadingPages.isEmpty() && m_limits.loadingBandwidthBytesPerSec > 0) {
+        limit = limit > 0 ? qMin(limit, m_limits.loadingBandwidthBytesPerSec) : m_limits.loadingBandwidthBytesPerSec;
+    }
+    return limit;
+}
+
+QString DownloadManager::uniqueFilePath(const QString &directory, const QString &fileName) const
+{
+    const QDir dir(directory);
+    const QString name = fileName.isEmpty() ? QStringLiteral("download") : fileName;
+    QString candidate = dir.filePath(name);
+    const QFileInfo info(name);
+    for (int i = 1; QFileInfo::exists(candidate) || isPathReserved(candidate); ++i) {
+        const QString suffix = info.suffix().isEmpty() ? QString() : QLatin1Char('.') + info.suffix();
+        candidate = dir.filePath(QStringLiteral("%1 (%2)%3").arg(info.completeBaseName()).arg(i).arg(suffix));
+    }
+    return candidate;
+}
+
+bool DownloadManager::hasSpaceFor(const QString &directory, qint64 bytes) const
+{
+    if (bytes <= 0) {
+        return true;
+    }
+    const QStorageInfo storage(directory);
+    if (!storage.isValid()) {
+        return true;
+    }
+    // 进行中的下载尚未写入的部分也要算进去
+    qint64 reserved = 0;
+    for (const Transfer &transfer : m_transfers) {
+        if (transfer.item && transfer.item->totalBytes() > 0) {
+            reserved += qMax<qint64>(0, transfer.item->totalBytes() - transfer.item->receivedBytes());
+        }
+    }
+    return storage.bytesAvailable() >= bytes + reserved;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "configmanager.h"
+#include "webenginesignals.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QUrl>
+
+class QTimer;
+class QWebEnginePage;
+class QWebEngineProfile;
+class RequestMethodRecorder;
+
+// DownloadManager 接管 profile 的全部下载：按全局 / 单主机并发上限排队（超出上限的 http(s) GET 下载先不接受，轮到时通过页面
+// 重新发起；其余下载无法按 URL 重放，接受后暂停），
+// 网络类中断自动续传，按令牌桶暂停 / 恢复实现限速（页面加载期间使用更低的上限），并每秒汇报实时吞吐。
+class DownloadManager final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int active {0};
+        int queued {0};
+        int completed {0};
+        int failed {0};
+        int resumed {0};
+        bool throttled {false};
+        qint64 bytesPerSecond {0};
+        qint64 receivedBytes {0};
+        qint64 totalBytes {0};
+    };
+
+    explicit DownloadManager(QWebEngineProfile *profile, QObject *parent = nullptr);
+    ~DownloadManager() override;
+
+    void setLimits(const ConfigManager::DownloadLimits &limits);
+    ConfigManager::DownloadLimits limits() const;
+    // 排队的下载与无法续传的下载通过该页面重新发起
+    void setRetryPage(QWebEnginePage *page);
+    // 多窗口共用 profile 时登记其余页面，前面的页面销毁后依次顶替
+    void addRetryPage(QWebEnginePage *page);
+    // 任一已登记页面加载期间都使用页面加载时的带宽上限
+    void setPageLoading(const QObject *page, bool loading);
+    Stats stats() const;
+
+signals:
+    void statsUpdated(const DownloadManager::Stats &stats);
+    void downloadFinished(const QString &filePath, bool ok, const QString &error);
+
+private:
+    struct Transfer
+    {
+        QPointer<WebEngineDownload> item;
+        QUrl url;
+        QString host;
+        QString filePath;
+        qint64 lastBytes {0};
+        double bytesPerSecond {0.0};
+        int resumeAttempts {0};
+        bool admitted {false};
+        bool resuming {false};
+    };
+
+    void handleDownloadRequested(WebEngineDownload *download);
+    void handleStateChanged(quint32 id);
+    void handleInterrupted(quint32 id);
+    void tryResume(quint32 id);
+    // resume() 无法继续时的兜底：丢弃已下载的部分，通过页面重新请求同一 URL 并从零开始写到原路径
+    void restartTransfer(quint32 id);
+    // 通过页面重新请求 transfer.url，建议文件名中带一次性令牌；请求回到 handleDownloadRequested 时凭令牌认领，
+    // 沿用 transfer 的路径与尝试次数
+    void reissue(QWebEnginePage *page, const Transfer &transfer);
+    // 只有 http(s) GET 可以只凭 URL 重新发起；POST 请求体、blob: / data: 等在重放时会丢失
+    bool canReissue(const QUrl &url) const;
+    // 已接受的下载与已重新发起、尚未回来的请求都占用并发名额
+    bool hasSlotFor(const QString &host) const;
+    bool isPathReserved(const QString &filePath) const;
+    void finishTransfer(quint32 id, bool ok, const QString &error);
+    void schedule();
+    void sample();
+    qint64 effectiveBandwidth() const;
+    QWebEnginePage *retryPage() const;
+    QString uniqueFilePath(const QString &directory, const QString &fileName) const;
+    bool hasSpaceFor(const QString &directory, qint64 bytes) const;
+
+    QPointer<QWebEngineProfile> m_profile;
+    QList<QPointer<QWebEnginePage>> m_retryPages;
+    QSet<const QObject *> m_loadingPages;
+    ConfigManager::DownloadLimits m_limits;
+    // 以下载 id 排序，即按请求先后排队
+    QMap<quint32, Transfer> m_transfers;
+    // 超出并发上限、尚未接受的下载，按请求先后排列
+    QList<Transfer> m_waiting;
+    // 重新发起的下载：令牌 -> 已尝试次数与目标路径
+    QHash<quint64, Transfer> m_retries;
+    quint64 m_nextReissueToken {0};
+    RequestMethodRecorder *m_methods {nullptr};
+    QTimer *m_sampleTimer {nullptr};
+    QElapsedTimer m_sampleClock;
+    QElapsedTimer m_reportClock;
+    double m_tokens {0.0};
+    bool m_throttled {false};
+    double m_bytesPerSecond {0.0};
+    int m_completed {0};
+    int m_failed {0};
+    int m_resumed {0};
+};
@@ -0,0 +1,534 @@
+#include "framestream.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QIODevice>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// 'QFS1'
+constexpr quint32 kFrameMagic = 0x31534651;
+constexpr int kPushHistory = 256;
+constexpr int kMaxSamples = 1024;
+// 没有新帧时挂起请求的最长时间，超时后回复只有头部的空帧，页面随即重新请求
+constexpr int kLongPollMs = 1000;
+constexpr int kExpiryIntervalMs = 250;
+
+qint64 monotonicNs()
+{
+    return QDeadlineTimer::current().deadlineNSecs();
+}
+
+quint32 encodingId(const QString &encoding)
+{
+    if (encoding == QLatin1String("jpeg")) {
+        return 1;
+    }
+    if (encoding == QLatin1String("png")) {
+        return 2;
+    }
+    return 0;
+}
+
+int clampByte(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// BT.601 有限范围 YUV -> RGBA，整数近似
+QImage i420ToImage(const FrameStream::Frame &frame)
+{
+    const int width = frame.size.width();
+    const int height = frame.size.height();
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    const auto *yPlane = reinterpret_cast<const uchar *>(frame.data.constData());
+    const uchar *uPlane = yPlane + width * height;
+    const uchar *vPlane = uPlane + chromaWidth * chromaHeight;
+
+    QImage image(width, height, QImage::Format_RGBA8888);
+    for (int y = 0; y < height; ++y) {
+        uchar *out = image.scanLine(y);
+        const uchar *yRow = yPlane + y * width;
+        const uchar *uRow = uPlane + (y / 2) * chromaWidth;
+        const uchar *vRow = vPlane + (y / 2) * chromaWidth;
+        for (int x = 0; x < width; ++x) {
+            const int c = 298 * (yRow[x] - 16);
+            const int d = uRow[x / 2] - 128;
+            const int e = vRow[x / 2] - 128;
+            out[0] = static_cast<uchar>(clampByte((c + 409 * e + 128) >> 8));
+            out[1] = static_cast<uchar>(clampByte((c - 100 * d - 208 * e + 128) >> 8));
+            out[2] = static_cast<uchar>(clampByte((c + 516 * d + 128) >> 8));
+            out[3] = 255;
+            out += 4;
+        }
+    }
+    return image;
+}
+
+QByteArray frameHeader(const FrameStream::Frame &frame, const QString &encoding)
+{
+    QByteArray header(FrameStreamHandler::kHeaderBytes, '\0');
+    uchar *out = reinterpret_cast<uchar *>(header.data());
+    qToLittleEndian<quint32>(kFrameMagic, out);
+    qToLittleEndian<quint32>(static_cast<quint32>(frame.seq), out + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(qMax(0, frame.size.width())), out + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(qMax(0, frame.size.height())), out + 12);
+    qToLittleEndian<quint32>(encodingId(encoding), out + 16);
+    const double ageMs = frame.pushedAtNs > 0 ? (monotonicNs() - frame.pushedAtNs) / 1e6 : 0.0;
+    quint64 ageBits = 0;
+    std::memcpy(&ageBits, &ageMs, sizeof(ageBits));
+    qToLittleEndian<quint64>(ageBits, out + 24);
+    return header;
+}
+
+// 头部与帧数据分开保存，原始 RGBA 帧无需为拼接头部再复制一次像素
+class FramePayload final : public QIODevice
+{
+public:
+    FramePayload(const QByteArray &header, const QByteArray &body, QObject *parent)
+        : QIODevice(parent)
+        , m_header(header)
+        , m_body(body)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return m_header.size() + m_body.size(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        qint64 position = pos();
+        qint64 copied = 0;
+        while (copied < maxSize && position < size()) {
+            const bool inHeader = position < m_header.size();
+            const QByteArray &part = inHeader ? m_header : m_body;
+            const qint64 offset = inHeader ? position : position - m_header.size();
+            const qint64 chunk = qMin(maxSize - copied, part.size() - offset);
+            std::memcpy(data + copied, part.constData() + offset, static_cast<size_t>(chunk));
+            copied += chunk;
+            position += chunk;
+        }
+        return copied;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    const QByteArray m_header;
+    const QByteArray m_body;
+};
+
+void replyFrame(QWebEngineUrlRequestJob *job, const QByteArray &header, const QByteArray &body)
+{
+    job->reply(QByteArrayLiteral("application/octet-stream"), new FramePayload(header, body, job));
+}
+} // namespace
+
+const QByteArray FrameStreamHandler::kScheme = QByteArrayLiteral("framestream");
+
+FrameStream::FrameStream(const QString &name, const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_name(name)
+    , m_options(options)
+{
+    // 生产者写入的槽位不能是页面正在读取的最新槽位，至少需要两个
+    m_slots.resize(qMax(2, m_options.slotCount));
+    m_pushTimes.resize(kPushHistory);
+
+    auto &registry = MetricsRegistry::instance();
+    m_pushedCounter = &registry.counter("webengine_demo_frames_total", "Frames pushed to, drawn by or dropped before reaching a page.",
+                                        {{"stream", m_name}, {"result", QStringLiteral("pushed")}});
+    m_deliveredCounter = &registry.counter("webengine_demo_frames_total", "Frames pushed to, drawn by or dropped before reaching a page.",
+                                           {{"stream", m_name}, {"result", QStringLiteral("delivered")}});
+    m_droppedCounter = &registry.counter("webengine_demo_frames_total", "Frames pushed to, drawn by or dropped before reaching a page.",
+                                         {{"stream", m_name}, {"result", QStringLiteral("dropped")}});
+    m_latencyHistogram = &registry.histogram("webengine_demo_frame_latency_seconds", "Time from pushing a frame to the page drawing it.",
+                                             MetricsRegistry::latencyBuckets(), {{"stream", m_name}});
+}
+
+QString FrameStream::name() const
+{
+    return m_name;
+}
+
+FrameStream::Options FrameStream::options() const
+{
+    return m_options;
+}
+
+quint64 FrameStream::push(const QImage &image)
+{
+    if (image.isNull()) {
+        return 0;
+    }
+    const QImage rgba = image.format() == QImage::Format_RGBA8888 ? image : image.convertToFormat(QImage::Format_RGBA8888);
+    const int rowBytes = rgba.width() * 4;
+    return store(rgba.size(), PixelFormat::Rgba8888, rowBytes * rgba.height(), [&rgba, rowBytes](uchar *out) {
+        for (int y = 0; y < rgba.height(); ++y) {
+            std::memcpy(out + y * rowBytes, rgba.constScanLine(y), static_cast<size_t>(rowBytes));
+        }
+    });
+}
+
+quint64 FrameStream::push(const uchar *data, const QSize &size, PixelFormat format, int stride)
+{
+    if (!data || size.isEmpty()) {
+        return 0;
+    }
+    const int width = size.width();
+    const int height = size.height();
+    if (format == PixelFormat::Rgba8888) {
+        const int rowBytes = width * 4;
+        const int sourceStride = stride > 0 ? stride : rowBytes;
+        return store(size, format, rowBytes * height, [data, rowBytes, sourceStride, height](uchar *out) {
+            for (int y = 0; y < height; ++y) {
+                std::memcpy(out + y * rowBytes, data + y * sourceStride, static_cast<size_t>(rowBytes));
+            }
+        });
+    }
+
+    // stride 为 Y 平面的行字节数，U / V 平面取其一半
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    const int yStride = stride > 0 ? stride : width;
+    const int chromaStride = stride > 0 ? (stride + 1) / 2 : chromaWidth;
+    const int bytes = width * height + 2 * chromaWidth * chromaHeight;
+    return store(size, format, bytes, [=](uchar *out) {
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(out + y * width, data + y * yStride, static_cast<size_t>(width));
+        }
+        const uchar *uSource = data + yStride * height;
+        const uchar *vSource = uSource + chromaStride * chromaHeight;
+        uchar *uOut = out + width * height;
+        uchar *vOut = uOut + chromaWidth * chromaHeight;
+        for (int y = 0; y < chromaHeight; ++y) {
+            std::memcpy(uOut + y * chromaWidth, uSource + y * chromaStride, static_cast<size_t>(chromaWidth));
+            std::memcpy(vOut + y * chromaWidth, vSource + y * chromaStride, static_cast<size_t>(chromaWidth));
+        }
+    });
+}
+
+quint64 FrameStream::store(const QSize &size, PixelFormat format, int bytes, const std::function<void(uchar *)> &fill)
+{
+    int index = 0;
+    QByteArray buffer;
+    {
+        QMutexLocker locker(&m_mutex);
+        index = (m_newest + 1) % m_slots.size();
+        // 取出缓冲区在锁外写入；页面只读取最新槽位，不会碰到这里
+        buffer.swap(m_slots[index].frame.data);
+    }
+
+    // 仍被发送中的旧帧共享时 data() 会分离出新缓冲区，否则复用原有内存
+    buffer.resize(bytes);
+    fill(reinterpret_cast<uchar *>(buffer.data()));
+    const qint64 pushedAtNs = monotonicNs();
+
+    quint64 seq = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_newest >= 0 && !m_slots.at(m_newest).served) {
+            ++m_stats.dropped;
+            m_droppedCounter->increment();
+        }
+        seq = m_nextSeq++;
+        Slot &slot = m_slots[index];
+        slot.frame.seq = seq;
+        slot.frame.size = size;
+        slot.frame.format = format;
+        slot.frame.data.swap(buffer);
+        slot.frame.pushedAtNs = pushedAtNs;
+        slot.served = false;
+        m_newest = index;
+        m_pushTimes[static_cast<int>(seq % kPushHistory)] = qMakePair(seq, pushedAtNs);
+        ++m_stats.pushed;
+    }
+    m_pushedCounter->increment();
+    emit frameReady(seq);
+    return seq;
+}
+
+FrameStream::Stats FrameStream::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.latencyP50Ms = MetricsRegistry::percentile(m_latencySamples, 0.50);
+    stats.latencyP95Ms = MetricsRegistry::percentile(m_latencySamples, 0.95);
+    return stats;
+}
+
+QString FrameStream::negotiate(const QStringList &accept)
+{
+    QString chosen;
+    if (accept.isEmpty()) {
+        chosen = m_options.encodings.value(0);
+    } else {
+        const auto it = std::find_if(accept.cbegin(), accept.cend(), [this](const QString &encoding) {
+            return m_options.encodings.contains(encoding);
+        });
+        chosen = it != accept.cend() ? *it : QString();
+    }
+    QMutexLocker locker(&m_mutex);
+    m_stats.encoding = chosen;
+    return chosen;
+}
+
+bool FrameStream::takeNewest(quint64 after, Frame *frame)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_newest < 0) {
+        return false;
+    }
+    Slot &slot = m_slots[m_newest];
+    if (slot.frame.seq <= after) {
+        return false;
+    }
+    slot.served = true;
+    *frame = slot.frame;
+    ++m_stats.served;
+    return true;
+}
+
+void FrameStream::acknowledge(quint64 seq)
+{
+    const qint64 now = monotonicNs();
+    QMutexLocker locker(&m_mutex);
+    const QPair<quint64, qint64> &pushed = m_pushTimes.at(static_cast<int>(seq % kPushHistory));
+    if (pushed.first != seq) {
+        return;
+    }
+    const double latencyMs = (now - pushed.second) / 1e6;
+    if (m_latencySamples.size() >= kMaxSamples) {
+        m_latencySamples.removeFirst();
+    }
+    m_latencySamples.append(latencyMs);
+    ++m_stats.delivered;
+    m_deliveredCounter->increment();
+    m_latencyHistogram->observe(latencyMs / 1000.0);
+}
+
+QByteArray FrameStream::encode(const Frame &frame, const QString &encoding, int jpegQuality)
+{
+    if (encoding == QLatin1String("rgba") && frame.format == PixelFormat::Rgba8888) {
+        return frame.data;
+    }
+    const QImage image = frame.format == PixelFormat::I420
+                             ? i420ToImage(frame)
+                             : QImage(reinterpret_cast<const uchar *>(frame.data.constData()), frame.size.width(),
+                                      frame.size.height(), frame.size.width() * 4, QImage::Format_RGBA8888);
+    if (encoding == QLatin1String("rgba")) {
+        return QByteArray(reinterpret_cast<const char *>(image.constBits()), static_cast<int>(image.sizeInBytes()));
+    }
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    if (encoding == QLatin1String("jpeg")) {
+        image.convertToFormat(QImage::Format_RGB888).save(&buffer, "JPEG", jpegQuality);
+    } else {
+        image.save(&buffer, "PNG");
+    }
+    return encoded;
+}
+
+FrameStreamHandler::FrameStreamHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+    m_expiryTimer = new QTimer(this);
+    m_expiryTimer->setInterval(kExpiryIntervalMs);
+    ENSURE_QT_CONNECT(m_expiryTimer, &QTimer::timeout, this, &FrameStreamHandler::expireWaiting);
+}
+
+void FrameStreamHandler::registerScheme()
+{
+    if (QWebEngineUrlScheme::schemeByName(kScheme).name() == kScheme) {
+        return;
+    }
+    QWebEngineUrlScheme scheme(kScheme);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    // qrc: 与 https 页面都通过 XMLHttpRequest 跨源拉取帧
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::CorsEnabled);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+FrameStreamHandler *FrameStreamHandler::forProfile(QWebEngineProfile *profile)
+{
+    if (auto *existing = qobject_cast<const FrameStreamHandler *>(profile->urlSchemeHandler(kScheme))) {
+        return const_cast<FrameStreamHandler *>(existing);
+    }
+    auto *handler = new FrameStreamHandler(profile);
+    profile->installUrlSchemeHandler(kScheme, handler);
+    return handler;
+}
+
+QString FrameStreamHandler::normalizedName(const QString &name)
+{
+    // 流名称即 URL 主机名，QUrl 会把主机名转为小写，因此这里也按小写登记，并只接受单个 DNS 标签
+    static const QRegularExpression s_label(QStringLiteral("^[a-z0-9]([a-z0-9-]{0,61}[a-z0-9])?$"));
+    const QString lower = name.toLower();
+    return s_label.match(lower).hasMatch() ? lower : QString();
+}
+
+FrameStream *FrameStreamHandler::createStream(const QString &name, const FrameStream::Options &options)
+{
+    const QString key = normalizedName(name);
+    if (key.isEmpty()) {
+        qWarning() << "FrameStreamHandler: invalid stream name" << name;
+        return nullptr;
+    }
+    if (FrameStream *existing = stream(key)) {
+        return existing;
+    }
+    auto *created = new FrameStream(key, options, this);
+    m_streams.insert(key, created);
+    ENSURE_QT_CONNECT(created, &FrameStream::frameReady, this, [this, created]() {
+        serveWaiting(created);
+    });
+    return created;
+}
+
+FrameStream *FrameStreamHandler::stream(const QString &name) const
+{
+    return m_streams.value(normalizedName(name));
+}
+
+void FrameStreamHandler::removeStream(const QString &name)
+{
+    FrameStream *removed = m_streams.take(normalizedName(name));
+    if (!removed) {
+        return;
+    }
+    for (const Waiting &waiting : m_waiting.take(removed)) {
+        if (waiting.job) {
+            waiting.job->fail(QWebEngineUrlRequestJob::RequestAborted);
+        }
+    }
+    removed->deleteLater();
+}
+
+void FrameStreamHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    FrameStream *target = stream(url.host());
+    if (!target || url.path() != QLatin1String("/frame")) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    const QUrlQuery query(url);
+    // 上一帧的绘制确认随下一次拉取一起到达，省去单独的往返
+    const quint64 drawn = query.queryItemValue(QStringLiteral("drawn")).toULongLong();
+    if (drawn > 0) {
+        target->acknowledge(drawn);
+    }
+    const QString encoding =
+        target->negotiate(query.queryItemValue(QStringLiteral("accept")).split(QLatin1Char(','), Qt::SkipEmptyParts));
+    if (encoding.isEmpty()) {
+        qWarning().noquote() << "FrameStreamHandler: no common encoding for" << url.toString();
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    Waiting waiting;
+    waiting.job = job;
+    waiting.after = query.queryItemValue(QStringLiteral("after")).toULongLong();
+    waiting.encoding = encoding;
+    FrameStream::Frame frame;
+    if (target->takeNewest(waiting.after, &frame)) {
+        serve(job, target, frame, encoding);
+        return;
+    }
+    waiting.since.start();
+    m_waiting[target].append(waiting);
+    if (!m_expiryTimer->isActive()) {
+        m_expiryTimer->start();
+    }
+}
+
+void FrameStreamHandler::serveWaiting(FrameStream *target)
+{
+    const auto it = m_waiting.find(target);
+    if (it == m_waiting.end()) {
+        return;
+    }
+    QVector<Waiting> remaining;
+    for (const Waiting &waiting : std::as_const(it.value())) {
+        if (!waiting.job) {
+            continue;
+        }
+        FrameStream::Frame frame;
+        if (target->takeNewest(waiting.after, &frame)) {
+            serve(waiting.job, target, frame, waiting.encoding);
+        } else {
+            remaining.append(waiting);
+        }
+    }
+    it.value() = remaining;
+}
+
+void FrameStreamHandler::serve(QWebEngineUrlRequestJob *job, FrameStream *target, const FrameStream::Frame &frame,
+                               const QString &encoding)
+{
+    if (encoding == QLatin1String("rgba") && frame.format == FrameStream::PixelFormat::Rgba8888) {
+        replyFrame(job, frameHeader(frame, encoding), frame.data);
+        return;
+    }
+
+    // 编码与颜色空间转换放到线程池，结果经 qApp 排队回到 GUI 线程再答复请求
+    const QPointer<QWebEngineUrlRequestJob> guard(job);
+    const int quality = target->options().jpegQuality;
+    QThreadPool::globalInstance()->start([guard, frame, encoding, quality]() {
+        const QByteArray body = FrameStream::encode(frame, encoding, quality);
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, frame, encoding, body]() {
+                if (guard) {
+                    replyFrame(guard, frameHeader(frame, encoding), body);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void FrameStreamHandler::expireWaiting()
+{
+    bool anyWaiting = false;
+    for (auto it = m_waiting.begin(); it != m_waiting.end(); ++it) {
+        QVector<Waiting> remaining;
+        for (const Waiting &waiting : std::as_const(it.value())) {
+            if (!waiting.job) {
+                continue;
+            }
+            if (waiting.since.elapsed() >= kLongPollMs) {
+                // 空帧：宽高为 0，页面直接发起下一次拉取
+                replyFrame(waiting.job, frameHeader(FrameStream::Frame(), waiting.encoding), QByteArray());
+            } else {
+                remaining.append(waiting);
+            }
+        }
+        it.value() = remaining;
+        anyWaiting = anyWaiting || !remaining.isEmpty();
+    }
+    if (!anyWaiting) {
+        m_expiryTimer->stop();
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "metricsregistry.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWebEngineUrlSchemeHandler>
+
+#include <functional>
+
+class QTimer;
+class QWebEngineProfile;
+class QWebEngineUrlRequestJob;
+
+// FrameStream 是 C++ 向页面推送视频帧的环形缓冲：生产者（任意线程）把 QImage 或 RGBA / I420 原始数据写入可复用的槽位，
+// 页面只拉取最新一帧；未被拉取就被新帧取代的帧计为丢弃，页面绘制后的确认用于统计端到端延迟。
+// 同一个流同一时刻只应有一个生产者线程。
+class FrameStream final : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class PixelFormat
+    {
+        Rgba8888,
+        // 三个平面依次排列：Y（width x height）、U、V（各 width/2 x height/2）
+        I420,
+    };
+
+    struct Options
+    {
+        int slotCount {3};
+        // 允许协商的编码，按服务端偏好排列：rgba（原始像素，无编码开销）、jpeg、png
+        QStringList encodings {QStringLiteral("rgba"), QStringLiteral("jpeg"), QStringLiteral("png")};
+        int jpegQuality {80};
+    };
+
+    struct Frame
+    {
+        quint64 seq {0};
+        QSize size;
+        PixelFormat format {PixelFormat::Rgba8888};
+        QByteArray data;
+        // QDeadlineTimer::current() 的单调时钟纳秒数
+        qint64 pushedAtNs {0};
+    };
+
+    struct Stats
+    {
+        quint64 pushed {0};
+        quint64 served {0};
+        quint64 delivered {0};
+        quint64 dropped {0};
+        double latencyP50Ms {0.0};
+        double latencyP95Ms {0.0};
+        QString encoding;
+    };
+
+    explicit FrameStream(const QString &name, const Options &options = Options(), QObject *parent = nullptr);
+
+    QString name() const;
+    Options options() const;
+    // 以下两个 push 可在任意线程调用；返回新帧的序号，参数无效时返回 0
+    quint64 push(const QImage &image);
+    quint64 push(const uchar *data, const QSize &size, PixelFormat format, int stride = 0);
+    Stats stats() const;
+
+    // 页面 accept 列表与 options().encodings 的交集中按页面顺序取第一个；没有交集时返回空字符串
+    QString negotiate(const QStringList &accept);
+    // 取序号大于 after 的最新一帧并标记为已发送；没有更新的帧时返回 false
+    bool takeNewest(quint64 after, Frame *frame);
+    // 页面绘制完 seq 后调用，记录推送到绘制的延迟
+    void acknowledge(quint64 seq);
+
+    // 按 encoding 把帧转换为发送给页面的字节；rgba 为紧密排列的 RGBA8888
+    static QByteArray encode(const Frame &frame, const QString &encoding, int jpegQuality);
+
+signals:
+    void frameReady(quint64 seq);
+
+private:
+    struct Slot
+    {
+        Frame frame;
+        bool served {false};
+    };
+
+    // 在锁外把数据写入下一个槽位的缓冲区，缓冲区未被发送中的帧共享时复用原有内存
+    quint64 store(const QSize &size, PixelFormat format, int bytes, const std::function<void(uchar *)> &fill);
+
+    const QString m_name;
+    const Options m_options;
+    mutable QMutex m_mutex;
+    QVector<Slot> m_slots;
+    int m_newest {-1};
+    quint64 m_nextSeq {1};
+    // 最近推送帧的时间戳，按 seq 取模索引，用于计算确认时的延迟
+    QVector<QPair<quint64, qint64>> m_pushTimes;
+    QVector<double> m_latencySamples;
+    Stats m_stats;
+    MetricsRegistry::Counter *m_pushedCounter {nullptr};
+    MetricsRegistry::Counter *m_deliveredCounter {nullptr};
+    MetricsRegistry::Counter *m_droppedCounter {nullptr};
+    MetricsRegistry::Histogram *m_latencyHistogram {nullptr};
+};
+
+// FrameStreamHandler 在 framestream:// scheme 上服务某个 profile 的全部帧流：
+// GET framestream://<流名称>/frame?after=<序号>&accept=rgba,jpeg&drawn=<序号>，没有新帧时挂起请求直到新帧到达或超时。
+// 每次请求只取当时最新的一帧：页面跟不上时旧帧在 C++ 侧直接丢弃，不会像流式响应那样在管道中积压、拉高延迟。
+class FrameStreamHandler final : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    static const QByteArray kScheme;
+    // 每个响应的固定头部字节数（小端）：magic、seq、宽、高、编码、保留字段、服务时帧龄（double，毫秒）
+    static constexpr int kHeaderBytes = 32;
+
+    // 必须在创建 QApplication 之前调用
+    static void registerScheme();
+    // 返回 profile 上已安装的处理器，没有时创建并安装；处理器随 profile 销毁
+    static FrameStreamHandler *forProfile(QWebEngineProfile *profile);
+
+    // name 用作 URL 主机名，不区分大小写，统一按小写登记；只允许字母、数字与连字符（不以连字符开头或结尾），否则返回 nullptr
+    FrameStream *createStream(const QString &name, const FrameStream::Options &options = FrameStream::Options());
+    FrameStream *stream(const QString &name) const;
+    void removeStream(const QString &name);
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    struct Waiting
+    {
+        QPointer<QWebEngineUrlRequestJob> job;
+        quint64 after {0};
+        QString encoding;
+        QElapsedTimer since;
+    };
+
+    explicit FrameStreamHandler(QObject *parent);
+
+    // 不合法时返回空字符串
+    static QString normalizedName(const QString &name);
+
+    void serveWaiting(FrameStream *stream);
+    void serve(QWebEngineUrlRequestJob *job, FrameStream *stream, const FrameStream::Frame &frame, const QString &encoding);
+    void expireWaiting();
+
+    QHash<QString, QPointer<FrameStream>> m_streams;
+    QHash<FrameStream *, QVector<Waiting>> m_waiting;
+    QTimer *m_expiryTimer {nullptr};
+};
@@ -0,0 +1,217 @@
+#include "jankmonitor.h"
+
+#include "connectguard.h"
+#include "scriptbatchqueue.h"
+#include "userscriptregistry.h"
+#include "webbridge.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QVariant>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+
+#include <algorithm>
+
+namespace {
+constexpr auto kFrameScriptResource = ":/web/scripts/framemonitor.js";
+constexpr auto kFrameScriptName = "qt-frame-monitor";
+constexpr auto kTelemetryChannel = "frames";
+constexpr auto kFlushScript = "window.__qtFrames ? window.__qtFrames.flush() : null";
+constexpr int kProbeIntervalMs = 100;
+constexpr int kReportIntervalMs = 1000;
+// 超过这个时间没有收到页面主动上报，就改为由 C++ 拉取
+constexpr int kPagePushTimeoutMs = 1500;
+constexpr int kPageDataStaleMs = 2500;
+
+void restartClock(QElapsedTimer &clock)
+{
+    if (clock.isValid()) {
+        clock.restart();
+    } else {
+        clock.start();
+    }
+}
+} // namespace
+
+JankMonitor::JankMonitor(QWebEnginePage *page, WebBridge *bridge, UserScriptRegistry *scripts, QObject *parent)
+    : QObject(parent)
+    , m_page(page)
+    , m_bridge(bridge)
+    , m_scripts(scripts)
+{
+    m_probeTimer = new QTimer(this);
+    m_probeTimer->setTimerType(Qt::PreciseTimer);
+    m_probeTimer->setInterval(kProbeIntervalMs);
+    ENSURE_QT_CONNECT(m_probeTimer, &QTimer::timeout, this, &JankMonitor::probeEventLoop);
+
+    m_reportTimer = new QTimer(this);
+    m_reportTimer->setInterval(kReportIntervalMs);
+    ENSURE_QT_CONNECT(m_reportTimer, &QTimer::timeout, this, &JankMonitor::publishSnapshot);
+
+    if (m_bridge) {
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::telemetryReported, this, &JankMonitor::handleTelemetry);
+    }
+
+    m_probeClock.start();
+    m_probeTimer->start();
+    m_reportTimer->start();
+    installScript();
+}
+
+void JankMonitor::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (m_enabled) {
+        m_probeClock.restart();
+        m_probeTimer->start();
+        m_reportTimer->start();
+    } else {
+        m_probeTimer->stop();
+        m_reportTimer->stop();
+        m_lastPagePush.invalidate();
+        m_lastPageData.invalidate();
+    }
+    updateScript();
+}
+
+void JankMonitor::setScriptQueue(ScriptBatchQueue *queue)
+{
+    m_scriptQueue = queue;
+}
+
+bool JankMonitor::isEnabled() const
+{
+    return m_enabled;
+}
+
+JankMonitor::Snapshot JankMonitor::snapshot() const
+{
+    return m_snapshot;
+}
+
+QString JankMonitor::installScript()
+{
+    const QString source = UserScriptRegistry::readResource(QString::fromLatin1(kFrameScriptResource));
+    if (source.isEmpty() || !m_scripts || !m_scripts->install(QString::fromLatin1(kFrameScriptName), source)) {
+        qWarning() << "JankMonitor: cannot install" << kFrameScriptResource;
+        return QString();
+    }
+    return source;
+}
+
+void JankMonitor::updateScript()
+{
+    if (!m_enabled) {
+        if (m_scripts) {
+            m_scripts->remove(QString::fromLatin1(kFrameScriptName));
+        }
+        runPageScript(QStringLiteral("window.__qtFrames && window.__qtFrames.setEnabled(false)"));
+        return;
+    }
+
+    const QString source = installScript();
+    if (source.isEmpty()) {
+        return;
+    }
+    // 之后的文档由注册表注入；当前文档补跑一次，已注入过的页面只需重新启用
+    if (m_page) {
+        m_page->runJavaScript(QStringLiteral("if (window.__qtFrames) { window.__qtFrames.setEnabled(true); } else {\n%1\n}")
+                                  .arg(source),
+                              QWebEngineScript::MainWorld);
+    }
+}
+
+void JankMonitor::probeEventLoop()
+{
+    // 定时器本应每 kProbeIntervalMs 触发一次，迟到的部分就是事件循环被占用的时间
+    const double elapsed = static_cast<double>(m_probeClock.nsecsElapsed()) / 1e6;
+    m_probeClock.restart();
+    const double lag = std::max(0.0, elapsed - kProbeIntervalMs);
+    m_lagSumMs += lag;
+    m_lagMaxMs = std::max(m_lagMaxMs, lag);
+    ++m_lagSamples;
+}
+
+void JankMonitor::publishSnapshot()
+{
+    m_snapshot.eventLoopLagAvgMs = m_lagSamples > 0 ? m_lagSumMs / m_lagSamples : 0.0;
+    m_snapshot.eventLoopLagMaxMs = m_lagMaxMs;
+    m_lagSumMs = 0.0;
+    m_lagMaxMs = 0.0;
+    m_lagSamples = 0;
+
+    const bool pageQuiet = !m_lastPagePush.isValid() || m_lastPagePush.elapsed() > kPagePushTimeoutMs;
+    m_snapshot.pageDataFresh = m_lastPageData.isValid() && m_lastPageData.elapsed() <= kPageDataStaleMs;
+    emit snapshotUpdated(m_snapshot);
+
+    if (pageQuiet) {
+        runPageScript(QString::fromLatin1(kFlushScript), [this](const QVariant &value) {
+            const QString payload = value.toString();
+            if (!payload.isEmpty()) {
+                ingestPageReport(payload);
+            }
+        });
+    }
+}
+
+void JankMonitor::runPageScript(const QString &source, std::function<void(const QVariant &)> callback)
+{
+    if (m_scriptQueue) {
+        m_scriptQueue->enqueue(source, [callback](const QVariant &value, const QString &) {
+            if (callback) {
+                callback(value);
+            }
+        });
+        return;
+    }
+    if (!m_page) {
+        return;
+    }
+    if (callback) {
+        m_page->runJavaScript(source, QWebEngineScript::MainWorld, callback);
+    } else {
+        m_page->runJavaScript(source, QWebEngineScript::MainWorld);
+    }
+}
+
+void JankMonitor::handleTelemetry(const QString &channel, const QString &payload)
+{
+    if (channel == QLatin1String(kTelemetryChannel)) {
+        restartClock(m_lastPagePush);
+        ingestPageReport(payload);
+    }
+}
+
+void JankMonitor::ingestPageReport(const QString &payload)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(payload.toUtf8());
+    if (!doc.isObject()) {
+        return;
+    }
+    const QJsonObject report = doc.object();
+
+    m_snapshot.fps = report.value(QStringLiteral("fps")).toDouble();
+    m_snapshot.frames = report.value(QStringLiteral("frames")).toInt();
+    m_snapshot.droppedFrames = report.value(QStringLiteral("droppedFrames")).toInt();
+    m_snapshot.worstFrameMs = report.value(QStringLiteral("worstFrameMs")).toDouble();
+    m_snapshot.longTasks = report.value(QStringLiteral("longTasks")).toInt();
+    m_snapshot.longTaskMs = report.value(QStringLiteral("longTaskMs")).toDouble();
+    m_snapshot.totalDroppedFrames += m_snapshot.droppedFrames;
+    m_snapshot.totalLongTasks += m_snapshot.longTasks;
+
+    const QJsonArray histogram = report.value(QStringLiteral("longTaskHistogram")).toArray();
+    for (int i = 0; i < kLongTaskBuckets; ++i) {
+        const int count = i < histogram.size() ? histogram.at(i).toInt() : 0;
+        m_snapshot.longTaskHistogram[i] = count;
+        m_snapshot.totalLongTaskHistogram[i] += count;
+    }
+    ++m_snapshot.pageReportSeq;
+    restartClock(m_lastPageData);
+}
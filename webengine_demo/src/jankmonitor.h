@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+
+class QTimer;
+class QWebEnginePage;
+class ScriptBatchQueue;
+class UserScriptRegistry;
+class WebBridge;
+
+// JankMonitor 汇总页面侧的帧率 / 掉帧 / 长任务数据与 C++ GUI 线程的事件循环延迟，
+// 每秒产出一份滚动快照；采样本身只有计数与累加，可以在生产环境常开。性能浮层只负责显示，
+// 不需要帧数据的场景（如加载基准）可 setEnabled(false) 停掉页面脚本与定时器。
+class JankMonitor final : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 长任务直方图：[50,100) [100,250) [250,500) [500,1000) [1000,∞) 毫秒
+    static constexpr int kLongTaskBuckets = 5;
+
+    struct Snapshot
+    {
+        double fps {0.0};
+        int frames {0};
+        int droppedFrames {0};
+        double worstFrameMs {0.0};
+        int longTasks {0};
+        double longTaskMs {0.0};
+        QVector<int> longTaskHistogram = QVector<int>(kLongTaskBuckets, 0);
+        double eventLoopLagAvgMs {0.0};
+        double eventLoopLagMaxMs {0.0};
+        bool pageDataFresh {false};
+        // 每收到一份页面报告加一；同一份报告会随后续快照重复发布，按序号判断是否已计入
+        quint64 pageReportSeq {0};
+
+        qint64 totalDroppedFrames {0};
+        qint64 totalLongTasks {0};
+        QVector<int> totalLongTaskHistogram = QVector<int>(kLongTaskBuckets, 0);
+    };
+
+    JankMonitor(QWebEnginePage *page, WebBridge *bridge, UserScriptRegistry *scripts, QObject *parent = nullptr);
+
+    void setEnabled(bool enabled);
+    void setScriptQueue(ScriptBatchQueue *queue);
+    bool isEnabled() const;
+    Snapshot snapshot() const;
+
+signals:
+    void snapshotUpdated(const JankMonitor::Snapshot &snapshot);
+
+private:
+    QString installScript();
+    void updateScript();
+    void probeEventLoop();
+    void publishSnapshot();
+    void handleTelemetry(const QString &channel, const QString &payload);
+    void ingestPageReport(const QString &payload);
+    void runPageScript(const QString &source, std::function<void(const QVariant &)> callback = {});
+
+    QPointer<QWebEnginePage> m_page;
+    QPointer<WebBridge> m_bridge;
+    QPointer<ScriptBatchQueue> m_scriptQueue;
+    QPointer<UserScriptRegistry> m_scripts;
+    QTimer *m_probeTimer {nullptr};
+    QTimer *m_reportTimer {nullptr};
+    QElapsedTimer m_probeClock;
+    QElapsedTimer m_lastPagePush;
+    QElapsedTimer m_lastPageData;
+    double m_lagSumMs {0.0};
+    double m_lagMaxMs {0.0};
+    int m_lagSamples {0};
+    bool m_enabled {true};
+    Snapshot m_snapshot;
+};
@@ -0,0 +1,98 @@
+#include "jankoverlay.h"
+
+#include <QEvent>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <utility>
+
+namespace {
+constexpr int kMargin = 12;
+constexpr int kPadding = 8;
+constexpr double kJankFpsThreshold = 50.0;
+} // namespace
+
+JankOverlay::JankOverlay(QWidget *host)
+    : QWidget(host)
+    , m_host(host)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents, true);
+    setAttribute(Qt::WA_NoSystemBackground, true);
+    setFocusPolicy(Qt::NoFocus);
+    if (m_host) {
+        m_host->installEventFilter(this);
+    }
+    m_lines << tr("等待帧数据...");
+    reposition();
+}
+
+void JankOverlay::updateSnapshot(const JankMonitor::Snapshot &snapshot)
+{
+    const QVector<int> &histogram = snapshot.totalLongTaskHistogram;
+    m_lines.clear();
+    if (snapshot.pageDataFresh) {
+        m_lines << tr("FPS %1  最差帧 %2 ms")
+                       .arg(snapshot.fps, 0, 'f', 1)
+                       .arg(snapshot.worstFrameMs, 0, 'f', 1);
+    } else {
+        m_lines << tr("FPS -（页面无帧数据）");
+    }
+    m_lines << tr("掉帧 %1（累计 %2）").arg(snapshot.droppedFrames).arg(snapshot.totalDroppedFrames);
+    m_lines << tr("长任务 %1（累计 %2）").arg(snapshot.longTasks).arg(snapshot.totalLongTasks);
+    m_lines << tr("  <100:%1 <250:%2 <500:%3 <1s:%4 ≥1s:%5")
+                   .arg(histogram.value(0))
+                   .arg(histogram.value(1))
+                   .arg(histogram.value(2))
+                   .arg(histogram.value(3))
+                   .arg(histogram.value(4));
+    m_lines << tr("事件循环延迟 均值 %1 / 最大 %2 ms")
+                   .arg(snapshot.eventLoopLagAvgMs, 0, 'f', 1)
+                   .arg(snapshot.eventLoopLagMaxMs, 0, 'f', 1);
+
+    m_janky = snapshot.pageDataFresh && snapshot.fps < kJankFpsThreshold;
+    reposition();
+    update();
+}
+
+bool JankOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_host && (event->type() == QEvent::Resize || event->type() == QEvent::Show)) {
+        reposition();
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void JankOverlay::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    QPainterPath background;
+    background.addRoundedRect(rect(), 6, 6);
+    painter.fillPath(background, m_janky ? QColor(120, 20, 20, 200) : QColor(0, 0, 0, 170));
+
+    painter.setPen(Qt::white);
+    const QFontMetrics metrics(font());
+    int y = kPadding + metrics.ascent();
+    for (const QString &line : std::as_const(m_lines)) {
+        painter.drawText(kPadding, y, line);
+        y += metrics.lineSpacing();
+    }
+}
+
+void JankOverlay::reposition()
+{
+    const QFontMetrics metrics(font());
+    int width = 0;
+    for (const QString &line : std::as_const(m_lines)) {
+        width = qMax(width, metrics.horizontalAdvance(line));
+    }
+    const QSize size(width + kPadding * 2, metrics.lineSpacing() * m_lines.size() + kPadding * 2);
+    resize(size);
+    if (m_host) {
+        move(m_host->width() - size.width() - kMargin, kMargin);
+    }
+    raise();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "jankmonitor.h"
+
+#include <QStringList>
+#include <QWidget>
+
+// JankOverlay 以半透明浮层的形式叠加在网页区域右上角，显示 JankMonitor 的滚动统计。
+class JankOverlay final : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit JankOverlay(QWidget *host);
+
+public slots:
+    void updateSnapshot(const JankMonitor::Snapshot &snapshot);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void reposition();
+
+    QWidget *m_host {nullptr};
+    QStringList m_lines;
+    bool m_janky {false};
+};
@@ -1,36 +1,271 @@
-#include "browserwindow.h"
+#include "appcontroller.h"
+#include "batchrenderer.h"
 #include "configmanager.h"
+#include "configwatcher.h"
+#include "connectguard.h"
+#include "framestream.h"
+#include "metricsserver.h"
+#include "renderingbenchmark.h"
+#include "renderservice.h"
+#include "shardbroker.h"
+#include "shardworker.h"
+#include "startuptrace.h"
+#include "tracerecorder.h"
 
 #include <QApplication>
 #include <QCoreApplication>
+#include <QDebug>
 #include <QFileInfo>
+#include <QPainter>
+#include <QPixmap>
+#include <QSplashScreen>
+#include <QStringList>
 #include <QTextCodec>
+#include <QTimer>
+#include <QUrl>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+QStringList argumentsFrom(int argc, char *argv[])
+{
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+    return arguments;
+}
+
+QString optionValue(const QStringList &arguments, const QString &name)
+{
+    const QString flag = QStringLiteral("--") + name;
+    for (int i = 0; i < arguments.size(); ++i) {
+        if (arguments.at(i) == flag && i + 1 < arguments.size()) {
+            return arguments.at(i + 1);
+        }
+        if (arguments.at(i).startsWith(flag + QLatin1Char('='))) {
+            return arguments.at(i).mid(flag.size() + 1);
+        }
+    }
+    return {};
+}
+
+void prepareHeadlessEnvironment()
+{
+    // 批量渲染与常驻渲染服务不创建任何可见窗口，使用 offscreen 平台；软件渲染由 software-only 预设负责
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+}
+
+QPixmap splashPixmap()
+{
+    QPixmap pixmap(480, 200);
+    pixmap.fill(QColor(45, 62, 80));
+    QPainter painter(&pixmap);
+    painter.setPen(Qt::white);
+    QFont font = painter.font();
+    font.setPointSize(16);
+    painter.setFont(font);
+    painter.drawText(pixmap.rect(), Qt::AlignCenter, QStringLiteral("Qt WebEngine Demo"));
+    return pixmap;
+}
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::begin();
     QTextCodec::setCodecForLocale(QTextCodec::codecForLocale());
     qputenv("QTWEBENGINE_DISABLE_SANDBOX", "1");
+
+    const QStringList arguments = argumentsFrom(argc, argv);
+    // --trace 从启动起记录追踪事件，--trace=<文件> 同时指定输出路径；退出时写出
+    const auto traceArgument = std::find_if(arguments.cbegin(), arguments.cend(), [](const QString &argument) {
+        return argument == QLatin1String("--trace") || argument.startsWith(QLatin1String("--trace="));
+    });
+    if (traceArgument != arguments.cend()) {
+        TraceRecorder::setOutputPath(traceArgument->section(QLatin1Char('='), 1));
+        TraceRecorder::start();
+    }
+    BatchRenderOptions batchOptions;
+    QString batchError;
+    const bool batchMode = BatchRenderOptions::fromArguments(arguments, &batchOptions, &batchError);
+    if (batchMode && !batchError.isEmpty()) {
+        qCritical().noquote() << "Invalid batch render arguments:" << batchError;
+        return 2;
+    }
+    RenderServiceOptions serviceOptions;
+    QString serviceError;
+    const bool serviceMode = RenderServiceOptions::fromArguments(arguments, &serviceOptions, &serviceError);
+    if (serviceMode && !serviceError.isEmpty()) {
+        qCritical().noquote() << "Invalid render service arguments:" << serviceError;
+        return 2;
+    }
+    RenderingBenchmarkOptions renderingOptions;
+    QString renderingError;
+    const bool renderingBench = RenderingBenchmarkOptions::fromArguments(arguments, &renderingOptions, &renderingError);
+    if (renderingBench && !renderingError.isEmpty()) {
+        qCritical().noquote() << "Invalid rendering benchmark arguments:" << renderingError;
+        return 2;
+    }
+
     auto &config = ConfigManager::instance();
     const QString executableDir = QFileInfo(QString::fromLocal8Bit(argv[0])).absolutePath();
     config.initialize(executableDir);
     config.applyWebEngineRemoteDebugging();
+    StartupTrace::setExportPath(config.startupTracePath());
+    StartupTrace::mark(QStringLiteral("config-loaded"));
 #if !defined(NDEBUG)
     if (config.remoteDebugPort() <= 0) {
         qputenv("QTWEBENGINE_REMOTE_DEBUGGING", "9223");
     }
 #endif
-    QCoreApplication::setAttribute(Qt::AA_UseOpenGLES);
+
+    if (renderingBench && renderingOptions.role == RenderingBenchmarkOptions::Role::Controller) {
+        // 调度进程本身不加载网页，逐个预设拉起子进程测量
+        QCoreApplication controller(argc, argv);
+        return RenderingBenchmark(renderingOptions).run();
+    }
+
+    QString shardServer;
+    int shardIndex = 0;
+    const bool shardWorker = ShardWorker::fromArguments(arguments, &shardServer, &shardIndex);
+    const int shards = optionValue(arguments, QStringLiteral("shards")).toInt();
+    if (shards > 0 && !shardWorker) {
+        // 分片模式的 broker 只转发命令与消息，不创建网页；每个 worker 是以 --shard-worker 启动的本程序
+        QCoreApplication broker(argc, argv);
+        ShardBroker::Options shardOptions;
+        shardOptions.shards = shards;
+        const QString profileName = optionValue(arguments, QStringLiteral("rendering-profile"));
+        if (!profileName.isEmpty()) {
+            shardOptions.extraArguments << QStringLiteral("--rendering-profile") << profileName;
+        }
+        ShardBroker shardBroker(shardOptions);
+        if (!shardBroker.start()) {
+            return 1;
+        }
+        const int panes = qMax(shards, AppController::Options::fromConfig(arguments).windows);
+        for (int i = 0; i < panes; ++i) {
+            shardBroker.openPane(QUrl(QStringLiteral("qrc:/web/index.html")));
+        }
+        // 用户关闭了全部窗口，或全部 worker 正常退出时结束
+        ENSURE_QT_CONNECT(&shardBroker, &ShardBroker::paneClosed, &broker, [&shardBroker]() {
+            if (shardBroker.paneIds().isEmpty()) {
+                QCoreApplication::quit();
+            }
+        });
+        ENSURE_QT_CONNECT(&shardBroker, &ShardBroker::finished, &broker, &QCoreApplication::quit);
+        ENSURE_QT_CONNECT(&broker, &QCoreApplication::aboutToQuit, &shardBroker, &ShardBroker::stop);
+        return broker.exec();
+    }
+
+    QString renderingProfile = optionValue(arguments, QStringLiteral("rendering-profile"));
+    if (batchMode || serviceMode) {
+        prepareHeadlessEnvironment();
+        // 无头模式默认走软件渲染；命令行或 config.json 显式指定的预设优先
+        if (renderingProfile.isEmpty() && config.snapshot()->renderingProfile.isEmpty()) {
+            renderingProfile = QStringLiteral("software-only");
+        }
+    }
+    config.applyRenderingProfile(renderingProfile);
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     QGuiApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
+    StartupTrace::mark(QStringLiteral("attributes-set"));
 
+    // 自定义 scheme 必须在创建 QApplication 之前注册
+    FrameStreamHandler::registerScheme();
     QApplication app(argc, argv);
     QApplication::setApplicationName(QStringLiteral("Qt WebEngine Demo"));
     QApplication::setOrganizationName(QStringLiteral("DemoOrg"));
     QApplication::setApplicationVersion(QStringLiteral("0.1.0"));
+    StartupTrace::mark(QStringLiteral("qapplication-created"));
+    ENSURE_QT_CONNECT(&app, &QCoreApplication::aboutToQuit, []() {
+        TraceRecorder::stop();
+    });
+#ifdef WEBENGINE_DEMO_PROFILE_CONNECTIONS
+    ENSURE_QT_CONNECT(&app, &QCoreApplication::aboutToQuit, []() {
+        ConnectProfiler::dumpReport();
+    });
+#endif
+
+    if (batchMode) {
+        BatchRenderer renderer(batchOptions);
+        ENSURE_QT_CONNECT(&renderer, &BatchRenderer::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        QTimer::singleShot(0, &renderer, &BatchRenderer::start);
+        return QApplication::instance()->exec();
+    }
+
+    if (serviceMode) {
+        // 常驻服务没有可见窗口，一直运行到进程被终止
+        QApplication::setQuitOnLastWindowClosed(false);
+        RenderService service(serviceOptions);
+        if (!service.start()) {
+            return 1;
+        }
+        return QApplication::instance()->exec();
+    }
+
+    if (shardWorker) {
+        // worker 的窗口由 broker 的命令打开和关闭，关闭最后一个窗口不结束进程
+        QApplication::setQuitOnLastWindowClosed(false);
+        ShardWorker worker(shardServer, shardIndex);
+        if (!worker.start()) {
+            return 1;
+        }
+        ENSURE_QT_CONNECT(&worker, &ShardWorker::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        return QApplication::instance()->exec();
+    }
 
-    BrowserWindow window;
-    window.show();
+    if (renderingBench) {
+        RenderingBenchmarkProbe probe(renderingOptions);
+        ENSURE_QT_CONNECT(&probe, &RenderingBenchmarkProbe::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        QTimer::singleShot(0, &probe, &RenderingBenchmarkProbe::start);
+        return QApplication::instance()->exec();
+    }
+
+    // 交互模式下监视 config.json，可运行时调整的设置无需重启即生效
+    ConfigWatcher configWatcher;
+
+    MetricsServer metricsServer;
+    if (config.metricsPort() > 0) {
+        metricsServer.start(static_cast<quint16>(config.metricsPort()));
+        ENSURE_QT_CONNECT(&app, &QCoreApplication::aboutToQuit, &metricsServer, &MetricsServer::stop);
+    }
+
+    const bool fastStart = config.fastStart() || arguments.contains(QStringLiteral("--fast-start"));
+    const bool showSplash = config.startupSplash() || arguments.contains(QStringLiteral("--splash"));
+
+    std::unique_ptr<QSplashScreen> splash;
+    if (showSplash) {
+        splash = std::make_unique<QSplashScreen>(splashPixmap());
+        splash->show();
+        splash->showMessage(QObject::tr("正在启动..."), Qt::AlignBottom | Qt::AlignHCenter, Qt::white);
+        app.processEvents();
+        StartupTrace::mark(QStringLiteral("splash-shown"));
+    }
+
+    // 多窗口模式下所有窗口共用 profile 与渲染进程池，单窗口时同样经由 AppController 创建
+    AppController::Options windowOptions = AppController::Options::fromConfig(arguments);
+    windowOptions.startupMode = fastStart ? BrowserWindow::StartupMode::FastStart : BrowserWindow::StartupMode::Standard;
+    AppController controller(windowOptions);
+    BrowserWindow *window = controller.start();
+    StartupTrace::mark(QStringLiteral("window-constructed"));
+    if (splash) {
+        ENSURE_QT_CONNECT(window, &BrowserWindow::firstLoadFinished, splash.get(), [&splash, window]() {
+            splash->finish(window);
+        });
+    }
+    for (const int windowId : controller.windowIds()) {
+        controller.window(windowId)->show();
+    }
+    StartupTrace::mark(QStringLiteral("window-shown"));
     return QApplication::instance()->exec();
 }
-
@@ -1,7 +1,9 @@
 #include "messageconsole.h"
 
 #include "connectguard.h"
+#include "tracerecorder.h"
 #include "webbridge.h"
+#include "webenginepane.h"
 
 #include <QDateTime>
 #include <QHBoxLayout>
@@ -41,8 +43,10 @@ MessageConsole::MessageConsole(QWidget *parent)
     ENSURE_QT_CONNECT(m_input, &QLineEdit::returnPressed, this, &MessageConsole::handleSendClicked);
 }
 
-void MessageConsole::attachBridge(WebBridge *bridge)
+void MessageConsole::attachPane(WebEnginePane *pane)
 {
+    WebBridge *bridge = pane ? pane->bridge() : nullptr;
+    m_pane = pane;
     if (m_bridge == bridge) {
         return;
     }
@@ -55,6 +59,11 @@ void MessageConsole::attachBridge(WebBridge *bridge)
         ENSURE_QT_CONNECT(m_bridge, &WebBridge::messageFromCpp, this, [this](const QString &payload) {
             appendEntry(tr("C++ -> Web"), payload);
         });
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::messageBatchFromCpp, this, [this](const QStringList &payloads) {
+            for (const QString &payload : payloads) {
+                appendEntry(tr("C++ -> Web (批量)"), payload);
+            }
+        });
         appendSystemMessage(tr("消息通道已连接 "));
     } else {
         appendSystemMessage(tr("消息通道未连接 "));
@@ -79,12 +88,12 @@ void MessageConsole::handleSendClicked()
         return;
     }
 
-    if (!m_bridge) {
+    if (!m_pane || !m_bridge) {
         appendSystemMessage(tr("无法发送：Web 引擎尚未准备"));
         return;
     }
 
-    m_bridge->dispatchToWeb(payload);
+    m_pane->broadcastToPage(payload);
     emit messageSent(payload);
     m_input->clear();
 }
@@ -97,6 +106,7 @@ void MessageConsole::handleIncomingMessage(const QString &payload)
 
 void MessageConsole::appendEntry(const QString &direction, const QString &payload)
 {
+    TRACE_SCOPE("console", "MessageConsole::appendEntry");
     if (!m_log) {
         return;
     }
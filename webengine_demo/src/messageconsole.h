@@ -1,11 +1,13 @@
 #pragma once
 
+#include <QPointer>
 #include <QWidget>
 #include <QString>
 
 class QPlainTextEdit;
 class QLineEdit;
 class WebBridge;
+class WebEnginePane;
 
 class MessageConsole final : public QWidget
 {
@@ -14,7 +16,8 @@ class MessageConsole final : public QWidget
 public:
     explicit MessageConsole(QWidget *parent = nullptr);
 
-    void attachBridge(WebBridge *bridge);
+    // 发送经 pane 的 broadcastToPage 排队，页面未就绪或冻结时与其他消息一样延后投递
+    void attachPane(WebEnginePane *pane);
     void focusInput();
 
 signals:
@@ -29,6 +32,7 @@ private:
     void appendEntry(const QString &direction, const QString &payload);
     void appendSystemMessage(const QString &payload);
 
+    QPointer<WebEnginePane> m_pane;
     WebBridge *m_bridge {nullptr};
     QPlainTextEdit *m_log {nullptr};
     QLineEdit *m_input {nullptr};
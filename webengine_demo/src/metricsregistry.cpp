@@ -0,0 +1,222 @@
+#include "metricsregistry.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+void atomicAdd(std::atomic<double> &target, double delta)
+{
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+QString escapeLabelValue(QString value)
+{
+    value.replace(QLatin1Char('\\'), QStringLiteral("\\\\"));
+    value.replace(QLatin1Char('"'), QStringLiteral("\\\""));
+    value.replace(QLatin1Char('\n'), QStringLiteral("\\n"));
+    return value;
+}
+
+QByteArray formatValue(double value)
+{
+    if (std::isnan(value)) {
+        return QByteArrayLiteral("NaN");
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? QByteArrayLiteral("+Inf") : QByteArrayLiteral("-Inf");
+    }
+    return QByteArray::number(value, 'g', 17);
+}
+
+// 把额外的标签（例如直方图的 le）拼到已有标签集合上
+QByteArray withLabel(const QString &labels, const QString &extra)
+{
+    if (labels.isEmpty()) {
+        return (QLatin1Char('{') + extra + QLatin1Char('}')).toUtf8();
+    }
+    QString merged = labels;
+    merged.insert(merged.size() - 1, QLatin1Char(',') + extra);
+    return merged.toUtf8();
+}
+} // namespace
+
+void MetricsRegistry::Gauge::add(double delta)
+{
+    atomicAdd(m_value, delta);
+}
+
+MetricsRegistry::Histogram::Histogram(QVector<double> bounds)
+    : m_bounds(std::move(bounds))
+{
+    std::sort(m_bounds.begin(), m_bounds.end());
+    m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()), m_bounds.end());
+    m_buckets = std::make_unique<std::atomic<quint64>[]>(m_bounds.size() + 1);
+    for (int i = 0; i <= m_bounds.size(); ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricsRegistry::Histogram::observe(double value)
+{
+    const auto bucket = std::lower_bound(m_bounds.cbegin(), m_bounds.cend(), value) - m_bounds.cbegin();
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    atomicAdd(m_sum, value);
+}
+
+QVector<quint64> MetricsRegistry::Histogram::bucketCounts() const
+{
+    QVector<quint64> counts(m_bounds.size() + 1);
+    for (int i = 0; i < counts.size(); ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry s_instance;
+    return s_instance;
+}
+
+QVector<double> MetricsRegistry::latencyBuckets()
+{
+    return {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0};
+}
+
+double MetricsRegistry::percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const int rank = qBound(0, static_cast<int>(p * values.size() + 0.5) - 1, values.size() - 1);
+    return values.at(rank);
+}
+
+MetricsRegistry::Counter &MetricsRegistry::counter(const char *name, const char *help, Labels labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series &series = findOrCreate(name, help, Type::Counter, labels);
+    if (!series.counter) {
+        series.counter = std::make_unique<Counter>();
+    }
+    return *series.counter;
+}
+
+MetricsRegistry::Gauge &MetricsRegistry::gauge(const char *name, const char *help, Labels labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series &series = findOrCreate(name, help, Type::Gauge, labels);
+    if (!series.gauge) {
+        series.gauge = std::make_unique<Gauge>();
+    }
+    return *series.gauge;
+}
+
+MetricsRegistry::Histogram &MetricsRegistry::histogram(const char *name,
+                                                       const char *help,
+                                                       const QVector<double> &bounds,
+                                                       Labels labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series &series = findOrCreate(name, help, Type::Histogram, labels);
+    if (!series.histogram) {
+        series.histogram = std::make_unique<Histogram>(bounds);
+    }
+    return *series.histogram;
+}
+
+QByteArray MetricsRegistry::render() const
+{
+    static const char *const kTypeNames[] = {"counter", "gauge", "histogram"};
+
+    QByteArray out;
+    QMutexLocker locker(&m_mutex);
+    for (const Family &family : m_families) {
+        const QByteArray name = family.name.toUtf8();
+        out += "# HELP " + name + ' ' + family.help.toUtf8() + '\n';
+        out += "# TYPE " + name + ' ' + kTypeNames[static_cast<int>(family.type)] + '\n';
+        for (const Series &series : family.series) {
+            const QByteArray labels = series.labels.toUtf8();
+            switch (family.type) {
+            case Type::Counter:
+                if (!series.counter) {
+                    break;
+                }
+                out += name + labels + ' ' + QByteArray::number(series.counter->value()) + '\n';
+                break;
+            case Type::Gauge:
+                if (!series.gauge) {
+                    break;
+                }
+                out += name + labels + ' ' + formatValue(series.gauge->value()) + '\n';
+                break;
+            case Type::Histogram: {
+                if (!series.histogram) {
+                    break;
+                }
+                const Histogram &histogram = *series.histogram;
+                const QVector<quint64> counts = histogram.bucketCounts();
+                quint64 cumulative = 0;
+                for (int i = 0; i < counts.size(); ++i) {
+                    cumulative += counts.at(i);
+                    const double bound = i < histogram.bounds().size() ? histogram.bounds().at(i)
+                                                                       : std::numeric_limits<double>::infinity();
+                    const QString le = QStringLiteral("le=\"%1\"").arg(QString::fromLatin1(formatValue(bound)));
+                    out += name + "_bucket" + withLabel(series.labels, le) + ' ' + QByteArray::number(cumulative) + '\n';
+                }
+                // 并发 observe 时 count 可能略大于各桶之和，以桶的累计值为准保持一致
+                out += name + "_sum" + labels + ' ' + formatValue(histogram.sum()) + '\n';
+                out += name + "_count" + labels + ' ' + QByteArray::number(cumulative) + '\n';
+                break;
+            }
+            }
+        }
+    }
+    return out;
+}
+
+MetricsRegistry::Series &MetricsRegistry::findOrCreate(const char *name, const char *help, Type type, Labels labels)
+{
+    const QString familyName = QString::fromLatin1(name);
+    auto family = std::find_if(m_families.begin(), m_families.end(), [&familyName](const Family &entry) {
+        return entry.name == familyName;
+    });
+    if (family == m_families.end()) {
+        m_families.push_back({familyName, QString::fromUtf8(help), type, {}});
+        family = std::prev(m_families.end());
+    } else if (family->type != type) {
+        // 类型冲突的序列不会被导出
+        qWarning() << "MetricsRegistry: metric" << familyName << "registered with conflicting types";
+    }
+
+    const QString labelText = formatLabels(labels);
+    auto series = std::find_if(family->series.begin(), family->series.end(), [&labelText](const Series &entry) {
+        return entry.labels == labelText;
+    });
+    if (series != family->series.end()) {
+        return *series;
+    }
+    family->series.push_back({labelText, nullptr, nullptr, nullptr});
+    return family->series.back();
+}
+
+QString MetricsRegistry::formatLabels(Labels labels)
+{
+    if (labels.size() == 0) {
+        return QString();
+    }
+    QStringList parts;
+    for (const auto &label : labels) {
+        parts << QStringLiteral("%1=\"%2\"").arg(QString::fromLatin1(label.first), escapeLabelValue(label.second));
+    }
+    return QLatin1Char('{') + parts.join(QLatin1Char(',')) + QLatin1Char('}');
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+// MetricsRegistry 保存进程内的计数器、仪表与直方图，由 MetricsServer 在工作线程中导出为 Prometheus 文本格式。
+// 取得指标的引用需要加锁，应在初始化时缓存；更新只是原子操作，任意线程可调用。
+class MetricsRegistry final
+{
+public:
+    using Labels = std::initializer_list<std::pair<const char *, QString>>;
+
+    class Counter
+    {
+    public:
+        void increment(quint64 delta = 1) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+        quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<quint64> m_value {0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        void add(double delta);
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> m_value {0.0};
+    };
+
+    class Histogram
+    {
+    public:
+        explicit Histogram(QVector<double> bounds);
+
+        void observe(double value);
+        const QVector<double> &bounds() const { return m_bounds; }
+        // 各桶的非累计计数，最后一个为 +Inf
+        QVector<quint64> bucketCounts() const;
+        quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+        double sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+    private:
+        QVector<double> m_bounds;
+        std::unique_ptr<std::atomic<quint64>[]> m_buckets;
+        std::atomic<quint64> m_count {0};
+        std::atomic<double> m_sum {0.0};
+    };
+
+    static MetricsRegistry &instance();
+    // 常用的秒级延迟分桶：1ms ~ 30s
+    static QVector<double> latencyBuckets();
+    // 最近秩法求分位数，p 取 0 ~ 1；没有样本时返回 0
+    static double percentile(QVector<double> values, double p);
+
+    // 同名同标签返回同一个实例；同一名称的所有序列必须是同一种类型
+    Counter &counter(const char *name, const char *help, Labels labels = {});
+    Gauge &gauge(const char *name, const char *help, Labels labels = {});
+    Histogram &histogram(const char *name, const char *help, const QVector<double> &bounds, Labels labels = {});
+
+    // Prometheus text exposition format 0.0.4
+    QByteArray render() const;
+
+private:
+    enum class Type
+    {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Series
+    {
+        QString labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family
+    {
+        QString name;
+        QString help;
+        Type type;
+        std::deque<Series> series;
+    };
+
+    MetricsRegistry() = default;
+
+    Series &findOrCreate(const char *name, const char *help, Type type, Labels labels);
+    static QString formatLabels(Labels labels);
+
+    mutable QMutex m_mutex;
+    std::deque<Family> m_families;
+};
@@ -0,0 +1,141 @@
+#include "metricsserver.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QHostAddress>
+#include <QList>
+#include <QMetaObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <memory>
+
+namespace {
+constexpr int kMaxRequestBytes = 8 * 1024;
+// 客户端迟迟不发完请求头时主动断开，避免占住连接
+constexpr int kRequestTimeoutMs = 5000;
+
+void respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body,
+             bool includeBody)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    if (includeBody) {
+        response += body;
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+// 只读到请求头结束；请求体与 keep-alive 都不支持，每次响应后关闭连接
+void handleReadyRead(QTcpSocket *socket, QByteArray *buffer)
+{
+    buffer->append(socket->readAll());
+    if (buffer->size() > kMaxRequestBytes) {
+        socket->abort();
+        return;
+    }
+    const int headerEnd = buffer->indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return;
+    }
+    QObject::disconnect(socket, &QTcpSocket::readyRead, nullptr, nullptr);
+
+    const QList<QByteArray> requestLine = buffer->left(buffer->indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray path = requestLine.value(1).split('?').value(0);
+    const bool head = method == "HEAD";
+    if (method != "GET" && !head) {
+        respond(socket, "405 Method Not Allowed", "text/plain; charset=utf-8", "method not allowed\n", true);
+        return;
+    }
+    if (path != "/metrics") {
+        respond(socket, "404 Not Found", "text/plain; charset=utf-8", "not found\n", !head);
+        return;
+    }
+
+    static MetricsRegistry::Counter &scrapes =
+        MetricsRegistry::instance().counter("webengine_demo_metrics_scrapes_total", "Number of /metrics requests served.");
+    scrapes.increment();
+    respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", MetricsRegistry::instance().render(), !head);
+}
+
+void acceptConnections(QTcpServer *server)
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        auto buffer = std::make_shared<QByteArray>();
+        ENSURE_QT_CONNECT(socket, &QTcpSocket::readyRead, socket, [socket, buffer]() {
+            handleReadyRead(socket, buffer.get());
+        });
+        ENSURE_QT_CONNECT(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(kRequestTimeoutMs, socket, &QTcpSocket::abort);
+    }
+}
+} // namespace
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+{
+    m_thread.setObjectName(QStringLiteral("MetricsServer"));
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(quint16 port)
+{
+    stop();
+
+    m_thread.start();
+    // QTcpServer 及其接受的连接都归工作线程所有，GUI 线程只负责启停
+    auto *server = new QTcpServer;
+    server->moveToThread(&m_thread);
+    ENSURE_QT_CONNECT(&m_thread, &QThread::finished, server, &QObject::deleteLater);
+
+    bool listening = false;
+    QString error;
+    QMetaObject::invokeMethod(
+        server,
+        [server, port, &listening, &error]() {
+            listening = server->listen(QHostAddress::LocalHost, port);
+            if (!listening) {
+                error = server->errorString();
+                return;
+            }
+            ENSURE_QT_CONNECT(server, &QTcpServer::newConnection, server, [server]() {
+                acceptConnections(server);
+            });
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        qWarning() << "MetricsServer: cannot listen on 127.0.0.1:" << port << error;
+        m_thread.quit();
+        m_thread.wait();
+        return false;
+    }
+    m_server = server;
+    m_port = port;
+    qInfo() << "MetricsServer: serving http://127.0.0.1:" << port << "/metrics";
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (!m_thread.isRunning()) {
+        return;
+    }
+    // 线程结束时 finished 触发 deleteLater，连同未关闭的连接一起在工作线程中释放
+    m_thread.quit();
+    m_thread.wait();
+    m_server = nullptr;
+    m_port = 0;
+}
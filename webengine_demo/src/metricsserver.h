@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QtGlobal>
+
+class QTcpServer;
+
+// MetricsServer 在独立线程中监听 127.0.0.1，对 GET /metrics 返回 MetricsRegistry 的 Prometheus 文本；
+// 抓取只读取原子计数，不触碰任何 GUI 对象，也不会阻塞 GUI 线程。
+class MetricsServer final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+    ~MetricsServer() override;
+
+    // 阻塞到工作线程完成 listen；端口被占用等失败时返回 false
+    bool start(quint16 port);
+    void stop();
+    bool isRunning() const { return m_server != nullptr; }
+    quint16 port() const { return m_port; }
+
+private:
+    QThread m_thread;
+    QTcpServer *m_server {nullptr};
+    quint16 m_port {0};
+};
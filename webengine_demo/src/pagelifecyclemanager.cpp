@@ -0,0 +1,286 @@
+#include "pagelifecyclemanager.h"
+
+#include "connectguard.h"
+#include "processstats.h"
+#include "webenginepane.h"
+
+#include <QDebug>
+#include <QEvent>
+#include <QTimer>
+#include <QWebEngineView>
+#include <QWidget>
+#include <QWindow>
+
+#include <algorithm>
+
+namespace {
+constexpr int kDefaultGracePeriodMs = 5000;
+} // namespace
+
+PageLifecycleManager::PageLifecycleManager(WebEnginePane *pane)
+    : QObject(pane)
+    , m_pane(pane)
+{
+    Q_ASSERT(m_pane);
+
+    m_graceTimer = new QTimer(this);
+    m_graceTimer->setSingleShot(true);
+    m_graceTimer->setInterval(kDefaultGracePeriodMs);
+    ENSURE_QT_CONNECT(m_graceTimer, &QTimer::timeout, this, &PageLifecycleManager::freeze);
+
+    m_activeSince.start();
+    m_pane->installEventFilter(this);
+    attachWindow();
+    // 创建时窗口可能已经隐藏或最小化，之后不会再收到对应事件
+    evaluateVisibility();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    // 构造时渲染进程通常还没启动，renderProcessPid() 为 0，基准要等进程起来后再取
+    if (auto *enginePage = page()) {
+        ENSURE_QT_CONNECT(enginePage, &QWebEnginePage::renderProcessPidChanged, this,
+                          &PageLifecycleManager::handleRendererChanged);
+    }
+#endif
+}
+
+void PageLifecycleManager::setGracePeriod(int ms)
+{
+    m_graceTimer->setInterval(std::max(0, ms));
+}
+
+int PageLifecycleManager::gracePeriod() const
+{
+    return m_graceTimer->interval();
+}
+
+bool PageLifecycleManager::isFrozen() const
+{
+    return m_frozen;
+}
+
+bool PageLifecycleManager::isDiscarded() const
+{
+    return m_discarded;
+}
+
+bool PageLifecycleManager::isInBackground() const
+{
+    return windowHidden();
+}
+
+PageLifecycleManager::Stats PageLifecycleManager::stats() const
+{
+    return m_stats;
+}
+
+bool PageLifecycleManager::freezeNow()
+{
+    if (m_frozen || !windowHidden()) {
+        return false;
+    }
+    m_graceTimer->stop();
+    freeze();
+    return m_frozen;
+}
+
+bool PageLifecycleManager::discard()
+{
+    auto *enginePage = page();
+    if (!enginePage || m_discarded || !windowHidden()) {
+        return false;
+    }
+    // Discarded 只能从 Frozen 进入
+    if (!m_frozen) {
+        m_graceTimer->stop();
+        freeze();
+    }
+    if (!m_frozen) {
+        return false;
+    }
+    enginePage->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+    m_discarded = true;
+    ++m_stats.discards;
+    qInfo() << "PageLifecycleManager: page discarded";
+    return true;
+}
+
+bool PageLifecycleManager::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_pane.data()) {
+        switch (event->type()) {
+        case QEvent::ParentChange:
+        case QEvent::Show:
+            attachWindow();
+            break;
+        default:
+            break;
+        }
+        // pane 自己就是顶层窗口时不会给 m_window 装过滤器，显示状态变化只能在这里处理
+        if (m_window.data() == m_pane.data()) {
+            switch (event->type()) {
+            case QEvent::ParentChange:
+            case QEvent::Show:
+            case QEvent::Hide:
+            case QEvent::WindowStateChange:
+                evaluateVisibility();
+                break;
+            default:
+                break;
+            }
+        }
+    } else if (watched == m_window.data()) {
+        switch (event->type()) {
+        case QEvent::Show:
+            attachWindow();
+            evaluateVisibility();
+            break;
+        case QEvent::Hide:
+        case QEvent::WindowStateChange:
+            evaluateVisibility();
+            break;
+        default:
+            break;
+        }
+    } else if (watched == m_windowHandle.data() && event->type() == QEvent::Expose) {
+        // 平台支持遮挡检测时（如 macOS），被完全遮挡的窗口会收到 isExposed() == false
+        m_exposed = m_windowHandle->isExposed();
+        evaluateVisibility();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void PageLifecycleManager::attachWindow()
+{
+    QWidget *window = m_pane ? m_pane->window() : nullptr;
+    if (window != m_window) {
+        if (m_window) {
+            m_window->removeEventFilter(this);
+        }
+        m_window = window;
+        if (m_window && m_window.data() != m_pane.data()) {
+            m_window->installEventFilter(this);
+        }
+    }
+
+    QWindow *handle = m_window ? m_window->windowHandle() : nullptr;
+    if (handle != m_windowHandle) {
+        if (m_windowHandle) {
+            m_windowHandle->removeEventFilter(this);
+        }
+        m_windowHandle = handle;
+        m_exposed = true;
+        if (m_windowHandle) {
+            m_windowHandle->installEventFilter(this);
+        }
+    }
+}
+
+void PageLifecycleManager::evaluateVisibility()
+{
+    if (windowHidden()) {
+        if (!m_frozen && !m_graceTimer->isActive()) {
+            m_graceTimer->start();
+        }
+        return;
+    }
+
+    m_graceTimer->stop();
+    if (m_frozen) {
+        resume();
+    } else if (m_activeCpuStartMs < 0) {
+        m_activeCpuStartMs = rendererCpuTimeMs();
+        m_activeSince.restart();
+    }
+}
+
+void PageLifecycleManager::freeze()
+{
+    auto *enginePage = page();
+    if (!enginePage || m_frozen || !windowHidden()) {
+        return;
+    }
+
+    const qint64 cpu = rendererCpuTimeMs();
+    const qint64 activeMs = m_activeSince.elapsed();
+    if (cpu >= 0 && m_activeCpuStartMs >= 0 && activeMs > 0) {
+        m_activeCpuRate = static_cast<double>(cpu - m_activeCpuStartMs) / static_cast<double>(activeMs);
+    }
+
+    // Frozen 要求页面不可见；最小化的窗口在 Qt 看来仍然 visible，需要显式隐藏页面
+    enginePage->setVisible(false);
+    enginePage->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+
+    m_frozen = true;
+    m_frozenSince.start();
+    m_frozenCpuStartMs = cpu;
+    ++m_stats.freezes;
+    qInfo() << "PageLifecycleManager: page frozen after" << gracePeriod() << "ms hidden";
+    emit frozen();
+}
+
+void PageLifecycleManager::resume()
+{
+    auto *enginePage = page();
+    if (!m_frozen) {
+        return;
+    }
+    m_frozen = false;
+    m_discarded = false;
+
+    // 从 Discarded 切回 Active 时 WebEngine 会重新加载页面
+    if (enginePage) {
+        enginePage->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+        enginePage->setVisible(true);
+    }
+
+    const qint64 frozenMs = m_frozenSince.elapsed();
+    const qint64 cpu = rendererCpuTimeMs();
+    const qint64 frozenCpuMs = (cpu >= 0 && m_frozenCpuStartMs >= 0) ? cpu - m_frozenCpuStartMs : 0;
+    const qint64 savedMs = std::max<qint64>(0, static_cast<qint64>(m_activeCpuRate * frozenMs) - frozenCpuMs);
+
+    m_stats.frozenMs += frozenMs;
+    m_stats.cpuSavedMs += savedMs;
+    m_activeSince.restart();
+    m_activeCpuStartMs = cpu;
+
+    qInfo() << "PageLifecycleManager: page resumed after" << frozenMs << "ms frozen,"
+            << "renderer CPU saved ~" << savedMs << "ms (total" << m_stats.cpuSavedMs << "ms)";
+    emit resumed(frozenMs, savedMs);
+}
+
+void PageLifecycleManager::handleRendererChanged()
+{
+    const qint64 cpu = rendererCpuTimeMs();
+    if (m_frozen) {
+        // 冻结期间换上的新进程，其 CPU 时间全部发生在冻结期间
+        m_frozenCpuStartMs = cpu >= 0 ? 0 : -1;
+        return;
+    }
+    m_activeCpuStartMs = cpu;
+    m_activeSince.restart();
+}
+
+bool PageLifecycleManager::windowHidden() const
+{
+    if (!m_window) {
+        return false;
+    }
+    return !m_window->isVisible() || m_window->isMinimized() || !m_exposed;
+}
+
+qint64 PageLifecycleManager::rendererCpuTimeMs() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    if (auto *enginePage = page()) {
+        return ProcessStats::sample(enginePage->renderProcessPid()).cpuTimeMs;
+    }
+#endif
+    return -1;
+}
+
+QWebEnginePage *PageLifecycleManager::page() const
+{
+    if (!m_pane || !m_pane->view()) {
+        return nullptr;
+    }
+    return m_pane->view()->page();
+}
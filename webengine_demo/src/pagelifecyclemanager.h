@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QWebEnginePage>
+
+class QTimer;
+class QWidget;
+class QWindow;
+class WebEnginePane;
+
+// PageLifecycleManager 监听窗口的可见性、最小化与遮挡状态，
+// 窗口隐藏超过宽限期后把页面切到 Frozen，恢复显示时切回 Active，并统计节省的渲染进程 CPU。
+class PageLifecycleManager final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int freezes {0};
+        int discards {0};
+        qint64 frozenMs {0};
+        qint64 cpuSavedMs {0};
+    };
+
+    explicit PageLifecycleManager(WebEnginePane *pane);
+
+    void setGracePeriod(int ms);
+    int gracePeriod() const;
+    bool isFrozen() const;
+    bool isDiscarded() const;
+    // 窗口隐藏、最小化或被完全遮挡
+    bool isInBackground() const;
+    Stats stats() const;
+
+    // 内存压力下跳过宽限期立即冻结；窗口可见时不做任何事
+    bool freezeNow();
+    // 丢弃后台页面，渲染进程中的页面状态被释放，窗口重新显示时自动重新加载
+    bool discard();
+
+signals:
+    void frozen();
+    void resumed(qint64 frozenMs, qint64 cpuSavedMs);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void attachWindow();
+    void evaluateVisibility();
+    void freeze();
+    void resume();
+    // 渲染进程启动或更换后重新取 CPU 基准，旧进程的读数不能与新进程相减
+    void handleRendererChanged();
+    bool windowHidden() const;
+    qint64 rendererCpuTimeMs() const;
+    QWebEnginePage *page() const;
+
+    QPointer<WebEnginePane> m_pane;
+    QPointer<QWidget> m_window;
+    QPointer<QWindow> m_windowHandle;
+    QTimer *m_graceTimer {nullptr};
+    QElapsedTimer m_activeSince;
+    QElapsedTimer m_frozenSince;
+    qint64 m_activeCpuStartMs {-1};
+    qint64 m_frozenCpuStartMs {-1};
+    double m_activeCpuRate {0.0};
+    bool m_frozen {false};
+    bool m_discarded {false};
+    bool m_exposed {true};
+    Stats m_stats;
+};
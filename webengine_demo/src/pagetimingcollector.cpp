@@ -0,0 +1,335 @@
+#include "pagetimingcollector.h"
+
+#include "connectguard.h"
+#include "scriptbatchqueue.h"
+#include "userscriptregistry.h"
+#include "webbridge.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVariant>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+
+#include <cmath>
+#include <utility>
+
+namespace {
+constexpr auto kTimingScriptResource = ":/web/scripts/pagetiming.js";
+constexpr auto kTimingScriptName = "qt-page-timing";
+constexpr auto kTelemetryChannel = "timing";
+constexpr auto kBridgeChannel = "bridge";
+constexpr auto kFlushScript = "window.__qtTiming ? window.__qtTiming.flush() : null";
+// 给 LCP 与迟到的资源留出时间，再读取一次汇总
+constexpr int kSettleDelayMs = 2500;
+constexpr int kMaxReportedResources = 5;
+
+QJsonValue roundedMs(const QJsonObject &source, const char *key)
+{
+    const QJsonValue value = source.value(QLatin1String(key));
+    if (!value.isDouble() || value.toDouble() <= 0.0) {
+        return QJsonValue::Null;
+    }
+    return std::round(value.toDouble() * 10.0) / 10.0;
+}
+
+// 导出文件超过上限时改名为 <文件>.1（覆盖上一份）后重新开始
+constexpr qint64 kMaxExportFileBytes = 16 * 1024 * 1024;
+// 磁盘跟不上时最多积压的报告数，超出丢弃最旧的
+constexpr int kMaxPendingExports = 1024;
+
+// 所有 collector 共用的导出队列：GUI 线程只入队，线程池里同一时刻最多一个任务按入队顺序追加写盘
+class TimingExportWriter
+{
+public:
+    static TimingExportWriter &instance()
+    {
+        // 不析构：进程退出时线程池里的写盘任务可能晚于静态对象析构结束
+        static auto *s_writer = new TimingExportWriter;
+        return *s_writer;
+    }
+
+    void append(const QString &path, const QByteArray &line)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pending.size() >= kMaxPendingExports) {
+            m_pending.removeFirst();
+            ++m_dropped;
+        }
+        m_pending.append(qMakePair(path, line));
+        if (m_draining) {
+            return;
+        }
+        m_draining = true;
+        locker.unlock();
+        QThreadPool::globalInstance()->start([this]() { drain(); });
+    }
+
+private:
+    void drain()
+    {
+        for (;;) {
+            QList<QPair<QString, QByteArray>> batch;
+            int dropped = 0;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_pending.isEmpty()) {
+                    m_draining = false;
+                    return;
+                }
+                std::swap(batch, m_pending);
+                std::swap(dropped, m_dropped);
+            }
+            if (dropped > 0) {
+                qWarning() << "PageTimingCollector: dropped" << dropped << "timing reports while the export file lagged";
+            }
+            for (const auto &entry : std::as_const(batch)) {
+                write(entry.first, entry.second);
+            }
+        }
+    }
+
+    static void write(const QString &path, const QByteArray &line)
+    {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        const QFileInfo info(path);
+        if (info.exists() && info.size() + line.size() > kMaxExportFileBytes) {
+            const QString rotated = path + QStringLiteral(".1");
+            QFile::remove(rotated);
+            if (!QFile::rename(path, rotated)) {
+                qWarning() << "PageTimingCollector: cannot rotate" << path;
+            }
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "PageTimingCollector: cannot append to" << path << file.errorString();
+            return;
+        }
+        file.write(line);
+    }
+
+    QMutex m_mutex;
+    QList<QPair<QString, QByteArray>> m_pending;
+    int m_dropped {0};
+    bool m_draining {false};
+};
+} // namespace
+
+PageTimingCollector::PageTimingCollector(QWebEnginePage *page, WebBridge *bridge, UserScriptRegistry *scripts, QObject *parent)
+    : QObject(parent)
+    , m_page(page)
+    , m_bridge(bridge)
+    , m_scripts(scripts)
+{
+    m_settleTimer = new QTimer(this);
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(kSettleDelayMs);
+    ENSURE_QT_CONNECT(m_settleTimer, &QTimer::timeout, this, &PageTimingCollector::requestReport);
+
+    if (m_bridge) {
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::telemetryReported, this, &PageTimingCollector::handleTelemetry);
+    }
+    installScript(scripts);
+}
+
+void PageTimingCollector::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (m_enabled) {
+        installScript(m_scripts);
+        return;
+    }
+    if (m_scripts) {
+        m_scripts->remove(QString::fromLatin1(kTimingScriptName));
+    }
+    m_settleTimer->stop();
+    m_awaitingReport = false;
+}
+
+bool PageTimingCollector::isEnabled() const
+{
+    return m_enabled;
+}
+
+void PageTimingCollector::setExportPath(const QString &path)
+{
+    m_exportPath = path;
+}
+
+void PageTimingCollector::setScriptQueue(ScriptBatchQueue *queue)
+{
+    m_scriptQueue = queue;
+}
+
+QString PageTimingCollector::exportPath() const
+{
+    return m_exportPath;
+}
+
+QJsonObject PageTimingCollector::lastReport() const
+{
+    return m_lastReport;
+}
+
+void PageTimingCollector::handleLoadStarted()
+{
+    m_settleTimer->stop();
+    if (!m_enabled) {
+        return;
+    }
+    m_loadClock.start();
+    m_loadStartedAt = QDateTime::currentDateTimeUtc();
+    m_wallLoadMs = -1;
+    m_wallBridgeReadyMs = -1;
+    m_bridgeReadyMs = -1.0;
+    m_awaitingReport = true;
+}
+
+void PageTimingCollector::handlePageReady()
+{
+    if (!m_awaitingReport || !m_loadClock.isValid() || m_wallBridgeReadyMs >= 0) {
+        return;
+    }
+    m_wallBridgeReadyMs = m_loadClock.elapsed();
+    qInfo().noquote() << QStringLiteral("PageTimingCollector: bridge ready %1 ms after load start%2")
+                             .arg(m_wallBridgeReadyMs)
+                             .arg(m_wallLoadMs < 0 ? QStringLiteral(" (before loadFinished)") : QString());
+}
+
+void PageTimingCollector::handleLoadFinished(bool ok)
+{
+    if (!m_awaitingReport) {
+        return;
+    }
+    m_lastLoadOk = ok;
+    m_wallLoadMs = m_loadClock.isValid() ? m_loadClock.elapsed() : -1;
+    if (!ok) {
+        publish({});
+        return;
+    }
+    m_settleTimer->start();
+}
+
+void PageTimingCollector::installScript(UserScriptRegistry *scripts)
+{
+    if (!scripts || !scripts->installResource(QString::fromLatin1(kTimingScriptName), QString::fromLatin1(kTimingScriptResource))) {
+        qWarning() << "PageTimingCollector: cannot install" << kTimingScriptResource;
+    }
+}
+
+void PageTimingCollector::requestReport()
+{
+    if (!m_page || !m_awaitingReport) {
+        return;
+    }
+    // 有 bridge 的页面会通过 reportTelemetry 回传（返回 null），否则直接用返回值
+    const auto handleResult = [this](const QVariant &value) {
+        const QString payload = value.toString();
+        if (!payload.isEmpty()) {
+            ingest(payload);
+        }
+    };
+    if (m_scriptQueue) {
+        m_scriptQueue->enqueue(QString::fromLatin1(kFlushScript), [handleResult](const QVariant &value, const QString &) {
+            handleResult(value);
+        });
+        return;
+    }
+    m_page->runJavaScript(QString::fromLatin1(kFlushScript), QWebEngineScript::MainWorld, handleResult);
+}
+
+void PageTimingCollector::handleTelemetry(const QString &channel, const QString &payload)
+{
+    if (channel == QLatin1String(kTelemetryChannel)) {
+        ingest(payload);
+    } else if (channel == QLatin1String(kBridgeChannel) && m_awaitingReport) {
+        m_bridgeReadyMs = QJsonDocument::fromJson(payload.toUtf8()).object().value(QStringLiteral("readyMs")).toDouble(-1.0);
+    }
+}
+
+void PageTimingCollector::ingest(const QString &payload)
+{
+    if (!m_awaitingReport) {
+        return;
+    }
+
+    QJsonParseError error {};
+    const QJsonDocument doc = QJsonDocument::fromJson(payload.toUtf8(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "PageTimingCollector: invalid timing payload" << error.errorString();
+        return;
+    }
+
+    const QJsonObject timing = doc.object();
+    QJsonObject report;
+    report.insert(QStringLiteral("url"), timing.value(QStringLiteral("url")));
+    report.insert(QStringLiteral("ttfbMs"), roundedMs(timing, "ttfb"));
+    report.insert(QStringLiteral("domContentLoadedMs"), roundedMs(timing, "domContentLoaded"));
+    report.insert(QStringLiteral("loadMs"), roundedMs(timing, "load"));
+    report.insert(QStringLiteral("firstPaintMs"), roundedMs(timing, "firstPaint"));
+    report.insert(QStringLiteral("firstContentfulPaintMs"), roundedMs(timing, "firstContentfulPaint"));
+    report.insert(QStringLiteral("largestContentfulPaintMs"), roundedMs(timing, "largestContentfulPaint"));
+    report.insert(QStringLiteral("transferBytes"), timing.value(QStringLiteral("transferSize")).toDouble());
+    report.insert(QStringLiteral("resourceCount"), timing.value(QStringLiteral("resourceCount")).toInt());
+    report.insert(QStringLiteral("resourceBytes"), timing.value(QStringLiteral("resourceBytes")).toDouble());
+
+    QJsonArray largest;
+    const QJsonArray resources = timing.value(QStringLiteral("resources")).toArray();
+    for (const QJsonValue &value : resources) {
+        if (largest.size() >= kMaxReportedResources) {
+            break;
+        }
+        const QJsonObject resource = value.toObject();
+        largest.append(QJsonObject {
+            {QStringLiteral("url"), resource.value(QStringLiteral("name"))},
+            {QStringLiteral("type"), resource.value(QStringLiteral("type"))},
+            {QStringLiteral("durationMs"), roundedMs(resource, "duration")},
+            {QStringLiteral("bytes"), resource.value(QStringLiteral("bytes")).toDouble()},
+        });
+    }
+    report.insert(QStringLiteral("largestResources"), largest);
+    publish(report);
+}
+
+void PageTimingCollector::publish(QJsonObject report)
+{
+    m_awaitingReport = false;
+    m_settleTimer->stop();
+
+    if (!report.contains(QStringLiteral("url")) && m_page) {
+        report.insert(QStringLiteral("url"), m_page->url().toString());
+    }
+    report.insert(QStringLiteral("ok"), m_lastLoadOk);
+    report.insert(QStringLiteral("startedAt"), m_loadStartedAt.toString(Qt::ISODateWithMs));
+    report.insert(QStringLiteral("wallLoadMs"), m_wallLoadMs);
+    // bridgeReadyMs 与其它页面侧指标同样相对导航开始，wallBridgeReadyMs 与 wallLoadMs 同为 C++ 侧计时
+    report.insert(QStringLiteral("bridgeReadyMs"),
+                  m_bridgeReadyMs > 0.0 ? QJsonValue(std::round(m_bridgeReadyMs * 10.0) / 10.0) : QJsonValue());
+    report.insert(QStringLiteral("wallBridgeReadyMs"), m_wallBridgeReadyMs);
+
+    m_lastReport = report;
+    exportReport(report);
+    emit reportReady(report);
+}
+
+void PageTimingCollector::exportReport(const QJsonObject &report)
+{
+    if (m_exportPath.isEmpty()) {
+        return;
+    }
+
+    TimingExportWriter::instance().append(m_exportPath, QJsonDocument(report).toJson(QJsonDocument::Compact) + '\n');
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+
+class QTimer;
+class QWebEnginePage;
+class ScriptBatchQueue;
+class UserScriptRegistry;
+class WebBridge;
+
+// PageTimingCollector 向页面注入计时脚本，每次加载结束后汇总
+// TTFB / DOMContentLoaded / load / FCP / LCP 与最大的若干资源，生成一份加载报告，
+// 并可按 JSON Lines 追加写入文件（在线程池中写盘，超过 16 MiB 时轮转），方便在多台机器间聚合。
+class PageTimingCollector final : public QObject
+{
+    Q_OBJECT
+
+public:
+    PageTimingCollector(QWebEnginePage *page, WebBridge *bridge, UserScriptRegistry *scripts, QObject *parent = nullptr);
+
+    // 默认开启；关闭后移除计时脚本（下一个文档起生效）并忽略之后的加载，基准测量时用来排除其开销
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    // 为空（默认）时不导出
+    void setExportPath(const QString &path);
+    void setScriptQueue(ScriptBatchQueue *queue);
+    QString exportPath() const;
+    QJsonObject lastReport() const;
+
+    void handleLoadStarted();
+    void handleLoadFinished(bool ok);
+    void handlePageReady();
+
+signals:
+    void reportReady(const QJsonObject &report);
+
+private:
+    void installScript(UserScriptRegistry *scripts);
+    void requestReport();
+    void handleTelemetry(const QString &channel, const QString &payload);
+    void ingest(const QString &payload);
+    void publish(QJsonObject report);
+    void exportReport(const QJsonObject &report);
+
+    QPointer<QWebEnginePage> m_page;
+    QPointer<WebBridge> m_bridge;
+    QPointer<UserScriptRegistry> m_scripts;
+    QPointer<ScriptBatchQueue> m_scriptQueue;
+    QTimer *m_settleTimer {nullptr};
+    QElapsedTimer m_loadClock;
+    QDateTime m_loadStartedAt;
+    qint64 m_wallLoadMs {-1};
+    qint64 m_wallBridgeReadyMs {-1};
+    double m_bridgeReadyMs {-1.0};
+    bool m_enabled {true};
+    bool m_lastLoadOk {false};
+    bool m_awaitingReport {false};
+    QString m_exportPath;
+    QJsonObject m_lastReport;
+};
@@ -0,0 +1,123 @@
+#include "processstats.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(Q_OS_LINUX)
+QByteArray readProcFile(qint64 pid, const char *name)
+{
+    QFile file(QStringLiteral("/proc/%1/%2").arg(pid).arg(QLatin1String(name)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
+
+qint64 readRssBytes(qint64 pid)
+{
+    // statm: size resident shared text lib data dt（单位为页）
+    const QList<QByteArray> fields = readProcFile(pid, "statm").simplified().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    bool ok = false;
+    const qint64 pages = fields.at(1).toLongLong(&ok);
+    if (!ok) {
+        return -1;
+    }
+    return pages * static_cast<qint64>(sysconf(_SC_PAGESIZE));
+}
+
+qint64 readCpuTimeMs(qint64 pid)
+{
+    // stat 的第二列是带括号的进程名，可能含空格，从最后一个 ')' 之后开始解析
+    const QByteArray stat = readProcFile(pid, "stat");
+    const int close = stat.lastIndexOf(')');
+    if (close < 0) {
+        return -1;
+    }
+    const QList<QByteArray> fields = stat.mid(close + 2).simplified().split(' ');
+    // 去掉 pid 与 comm 后，utime/stime 位于第 12/13 个字段
+    if (fields.size() < 13) {
+        return -1;
+    }
+    bool utimeOk = false;
+    bool stimeOk = false;
+    const qint64 ticks = fields.at(11).toLongLong(&utimeOk) + fields.at(12).toLongLong(&stimeOk);
+    if (!utimeOk || !stimeOk) {
+        return -1;
+    }
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? ticks * 1000 / ticksPerSecond : -1;
+}
+
+qint64 readParentPid(qint64 pid)
+{
+    const QByteArray stat = readProcFile(pid, "stat");
+    const int close = stat.lastIndexOf(')');
+    if (close < 0) {
+        return -1;
+    }
+    // ')' 之后依次是 state 与 ppid
+    return stat.mid(close + 2).simplified().split(' ').value(1).toLongLong();
+}
+#endif
+} // namespace
+
+ProcessStats::Sample ProcessStats::sample(qint64 pid)
+{
+    Sample result;
+    result.pid = pid;
+    if (pid <= 0) {
+        return result;
+    }
+#if defined(Q_OS_LINUX)
+    result.rssBytes = readRssBytes(pid);
+    result.cpuTimeMs = readCpuTimeMs(pid);
+#endif
+    return result;
+}
+
+ProcessStats::Sample ProcessStats::sampleSelf()
+{
+    return sample(currentPid());
+}
+
+qint64 ProcessStats::currentPid()
+{
+    return QCoreApplication::applicationPid();
+}
+
+QList<qint64> ProcessStats::descendantPids(qint64 pid)
+{
+    QList<qint64> result;
+#if defined(Q_OS_LINUX)
+    QMultiHash<qint64, qint64> children;
+    const QStringList entries = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const qint64 child = entry.toLongLong(&ok);
+        if (ok) {
+            children.insert(readParentPid(child), child);
+        }
+    }
+    QList<qint64> pending {pid};
+    while (!pending.isEmpty()) {
+        const QList<qint64> direct = children.values(pending.takeFirst());
+        result += direct;
+        pending += direct;
+    }
+#else
+    Q_UNUSED(pid);
+#endif
+    return result;
+}
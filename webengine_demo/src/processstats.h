@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QList>
+#include <QtGlobal>
+
+// ProcessStats 读取进程的常驻内存与累计 CPU 时间，
+// 目前基于 /proc/<pid>/statm 与 /proc/<pid>/stat，非 Linux 平台返回 -1。
+class ProcessStats final
+{
+public:
+    struct Sample
+    {
+        qint64 pid {0};
+        qint64 rssBytes {-1};
+        qint64 cpuTimeMs {-1};
+
+        bool isValid() const { return rssBytes >= 0 || cpuTimeMs >= 0; }
+    };
+
+    ProcessStats() = delete;
+
+    static Sample sample(qint64 pid);
+    static Sample sampleSelf();
+    static qint64 currentPid();
+    // 所有后代进程（WebEngine 的渲染、GPU 与工具进程），非 Linux 平台返回空列表
+    static QList<qint64> descendantPids(qint64 pid);
+};
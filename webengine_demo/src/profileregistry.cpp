@@ -0,0 +1,170 @@
+#include "profileregistry.h"
+
+#include "configmanager.h"
+#include "connectguard.h"
+#include "cookiejartransfer.h"
+#include "cookiemirror.h"
+#include "downloadmanager.h"
+#include "metricsregistry.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+
+#include <utility>
+
+const QString ProfileRegistry::kDefaultProfileName = QStringLiteral("DemoProfile");
+
+SharedProfile::SharedProfile(const QString &name, QObject *parent)
+    : QObject(parent)
+    , m_name(name)
+{
+    m_profile = new QWebEngineProfile(name, this);
+    ProfileRegistry::configureProfile(m_profile);
+    m_defaultUserAgent = m_profile->httpUserAgent();
+
+    auto &config = ConfigManager::instance();
+    m_cookieJar = new CookieJarTransfer(m_profile->cookieStore(), this);
+    m_cookieMirror = new CookieMirror(m_profile->cookieStore(), this);
+    m_cookieMirror->setMaxBytes(config.cookieMirrorBudgetBytes());
+    m_cookieMirror->start();
+    m_downloads = new DownloadManager(m_profile, this);
+    m_downloads->setLimits(config.downloadLimits());
+}
+
+QString SharedProfile::name() const
+{
+    return m_name;
+}
+
+QWebEngineProfile *SharedProfile::profile() const
+{
+    return m_profile;
+}
+
+CookieMirror *SharedProfile::cookieMirror() const
+{
+    return m_cookieMirror;
+}
+
+CookieJarTransfer *SharedProfile::cookieJar() const
+{
+    return m_cookieJar;
+}
+
+DownloadManager *SharedProfile::downloads() const
+{
+    return m_downloads;
+}
+
+QString SharedProfile::defaultUserAgent() const
+{
+    return m_defaultUserAgent;
+}
+
+int SharedProfile::pageCount() const
+{
+    return m_pages;
+}
+
+void SharedProfile::attachPage(QWebEnginePage *page)
+{
+    if (!page) {
+        return;
+    }
+    ++m_pages;
+    m_downloads->addRetryPage(page);
+    ENSURE_QT_CONNECT(page, &QObject::destroyed, this, [this]() {
+        if (--m_pages == 0) {
+            emit unused();
+        }
+    });
+}
+
+ProfileRegistry::ProfileRegistry(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ProfileRegistry::~ProfileRegistry()
+{
+    // profile 必须晚于使用它的页面销毁，这里只提示，不强行延长生命周期
+    for (const QPointer<SharedProfile> &shared : std::as_const(m_profiles)) {
+        if (shared && shared->pageCount() > 0) {
+            qWarning() << "ProfileRegistry: profile" << shared->name() << "destroyed with" << shared->pageCount()
+                       << "pages still attached";
+        }
+    }
+}
+
+SharedProfile *ProfileRegistry::acquire(const QString &name)
+{
+    const QString key = name.isEmpty() ? kDefaultProfileName : name;
+    if (SharedProfile *existing = m_profiles.value(key)) {
+        return existing;
+    }
+
+    auto *shared = new SharedProfile(key, this);
+    m_profiles.insert(key, shared);
+    // 同名 profile 不能同时存在两份，回收推迟到事件循环且期间被重新使用时取消
+    ENSURE_QT_CONNECT(shared, &SharedProfile::unused, this, [this, shared]() {
+        QTimer::singleShot(0, this, [this, shared = QPointer<SharedProfile>(shared)]() {
+            if (!shared || shared->pageCount() > 0) {
+                return;
+            }
+            const QString released = shared->name();
+            m_profiles.remove(released);
+            delete shared.data();
+            emit profileReleased(released);
+        });
+    });
+    qInfo() << "ProfileRegistry: created profile" << key;
+    emit profileCreated(key);
+    return shared;
+}
+
+SharedProfile *ProfileRegistry::find(const QString &name) const
+{
+    return m_profiles.value(name.isEmpty() ? kDefaultProfileName : name);
+}
+
+int ProfileRegistry::profileCount() const
+{
+    return m_profiles.size();
+}
+
+void ProfileRegistry::configureProfile(QWebEngineProfile *profile)
+{
+    profile->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    profile->setPersistentCookiesPolicy(QWebEngineProfile::AllowPersistentCookies);
+    profile->setSpellCheckEnabled(false);
+
+    // 缓存设置作为信息类指标导出：类型标签上的值为 1，最大容量 0 表示由 Chromium 自动决定
+    auto &metrics = MetricsRegistry::instance();
+    const std::pair<QWebEngineProfile::HttpCacheType, QString> cacheTypes[] = {
+        {QWebEngineProfile::DiskHttpCache, QStringLiteral("disk")},
+        {QWebEngineProfile::MemoryHttpCache, QStringLiteral("memory")},
+        {QWebEngineProfile::NoCache, QStringLiteral("none")},
+    };
+    for (const auto &cacheType : cacheTypes) {
+        metrics.gauge("webengine_demo_http_cache_type", "HTTP cache type of the pane profile.", {{"type", cacheType.second}})
+            .set(profile->httpCacheType() == cacheType.first ? 1 : 0);
+    }
+    metrics.gauge("webengine_demo_http_cache_max_bytes", "Configured maximum HTTP cache size, 0 means automatic.")
+        .set(profile->httpCacheMaximumSize());
+
+    QString storageRoot = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    if (storageRoot.isEmpty()) {
+        return;
+    }
+    // 默认 profile 沿用原有目录，其余命名 profile 各占一个子目录
+    if (profile->storageName() != kDefaultProfileName) {
+        storageRoot = QDir(storageRoot).filePath(QStringLiteral("profiles/") + profile->storageName());
+    }
+    profile->setCachePath(storageRoot + "/cache");
+    profile->setPersistentStoragePath(storageRoot + "/storage");
+    profile->setDownloadPath(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation));
+}
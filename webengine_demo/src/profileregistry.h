@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class CookieJarTransfer;
+class CookieMirror;
+class DownloadManager;
+class QWebEnginePage;
+class QWebEngineProfile;
+
+// SharedProfile 是一个命名 profile 及其 Cookie 镜像、Cookie 导入导出与下载管理的唯一实例，
+// 由使用它的所有页面共享；最后一个页面销毁后通知 ProfileRegistry 回收。
+class SharedProfile final : public QObject
+{
+    Q_OBJECT
+
+public:
+    QString name() const;
+    QWebEngineProfile *profile() const;
+    CookieMirror *cookieMirror() const;
+    CookieJarTransfer *cookieJar() const;
+    DownloadManager *downloads() const;
+    // 创建 profile 时的 UA；任一窗口修改 UA 后仍可据此恢复
+    QString defaultUserAgent() const;
+    int pageCount() const;
+
+    // 登记使用该 profile 的页面，作为下载重新发起的候选页面
+    void attachPage(QWebEnginePage *page);
+
+signals:
+    void unused();
+
+private:
+    friend class ProfileRegistry;
+    SharedProfile(const QString &name, QObject *parent);
+
+    QString m_name;
+    QWebEngineProfile *m_profile {nullptr};
+    CookieMirror *m_cookieMirror {nullptr};
+    CookieJarTransfer *m_cookieJar {nullptr};
+    DownloadManager *m_downloads {nullptr};
+    QString m_defaultUserAgent;
+    int m_pages {0};
+};
+
+// ProfileRegistry 按名称管理 SharedProfile：多窗口模式下同名的窗口共用一份 HTTP 缓存、Cookie 与下载队列，
+// 不同名称则各自独立（磁盘目录按名称区分）。
+class ProfileRegistry final : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const QString kDefaultProfileName;
+
+    explicit ProfileRegistry(QObject *parent = nullptr);
+    ~ProfileRegistry() override;
+
+    // 不存在时创建；返回的对象在最后一个登记页面销毁后回收
+    SharedProfile *acquire(const QString &name = kDefaultProfileName);
+    SharedProfile *find(const QString &name) const;
+    int profileCount() const;
+
+    // 缓存类型、Cookie 策略与存储目录；单 pane 模式自行创建的 profile 也使用同一套设置
+    static void configureProfile(QWebEngineProfile *profile);
+
+signals:
+    void profileCreated(const QString &name);
+    void profileReleased(const QString &name);
+
+private:
+    QHash<QString, QPointer<SharedProfile>> m_profiles;
+};
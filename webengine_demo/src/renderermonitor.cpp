@@ -0,0 +1,321 @@
+#include "renderermonitor.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+#include "pagelifecyclemanager.h"
+#include "profileregistry.h"
+#include "webenginepane.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMetaObject>
+#include <QThread>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineView>
+
+#include <algorithm>
+
+namespace {
+// 动作执行后等待渲染进程真正释放内存再测量回收量
+constexpr int kReclaimSettleMs = 2000;
+constexpr int kMinSampleIntervalMs = 250;
+
+// 所有 pane 共用一个采样线程，按需启动；最后一个监视器销毁或应用退出时停止，应用退出后不再接受采样请求
+struct SamplerThread
+{
+    QThread *thread {nullptr};
+    QObject *context {nullptr};
+    int monitors {0};
+    bool shutdown {false};
+
+    ~SamplerThread() { stop(); }
+
+    void stop()
+    {
+        if (!thread) {
+            return;
+        }
+        thread->quit();
+        thread->wait();
+        // 线程已结束，context 不会再被使用，可直接在当前线程删除
+        delete context;
+        delete thread;
+        context = nullptr;
+        thread = nullptr;
+    }
+};
+
+SamplerThread &sampler()
+{
+    static SamplerThread s_sampler;
+    return s_sampler;
+}
+
+QObject *samplerContext()
+{
+    SamplerThread &shared = sampler();
+    if (shared.shutdown) {
+        return nullptr;
+    }
+    if (!shared.thread) {
+        shared.thread = new QThread;
+        shared.thread->setObjectName(QStringLiteral("RendererSampler"));
+        shared.context = new QObject;
+        shared.context->moveToThread(shared.thread);
+        shared.thread->start(QThread::LowPriority);
+    }
+    return shared.context;
+}
+
+
+double toMiB(qint64 bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+} // namespace
+
+RendererMonitor::RendererMonitor(WebEnginePane *pane)
+    : QObject(pane)
+    , m_pane(pane)
+{
+    Q_ASSERT(m_pane);
+
+    ++sampler().monitors;
+    static bool s_quitHooked = false;
+    if (!s_quitHooked) {
+        s_quitHooked = true;
+        ENSURE_QT_CONNECT(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, []() {
+            sampler().shutdown = true;
+            sampler().stop();
+        });
+    }
+
+    m_clock.start();
+    m_timer = new QTimer(this);
+    ENSURE_QT_CONNECT(m_timer, &QTimer::timeout, this, &RendererMonitor::sampleNow);
+    setPolicy(ConfigManager::MemoryPressure());
+}
+
+RendererMonitor::~RendererMonitor()
+{
+    if (--sampler().monitors == 0) {
+        sampler().stop();
+    }
+}
+
+void RendererMonitor::setPolicy(const ConfigManager::MemoryPressure &policy)
+{
+    m_policy = policy;
+    if (m_policy.sampleIntervalMs <= 0) {
+        m_timer->stop();
+        return;
+    }
+    m_timer->start(std::max(kMinSampleIntervalMs, m_policy.sampleIntervalMs));
+}
+
+ConfigManager::MemoryPressure RendererMonitor::policy() const
+{
+    return m_policy;
+}
+
+RendererMonitor::Usage RendererMonitor::usage() const
+{
+    return m_usage;
+}
+
+QString RendererMonitor::actionName(Action action)
+{
+    switch (action) {
+    case Action::ClearHttpCache:
+        return QStringLiteral("clear-http-cache");
+    case Action::DropBridgeQueue:
+        return QStringLiteral("drop-bridge-queue");
+    case Action::FreezeBackground:
+        return QStringLiteral("freeze-background");
+    case Action::DiscardBackground:
+        return QStringLiteral("discard-background");
+    }
+    return QString();
+}
+
+void RendererMonitor::sampleNow()
+{
+    if (m_sampleInFlight) {
+        return;
+    }
+    const qint64 pid = rendererPid();
+    if (pid <= 0) {
+        // 渲染进程已退出（例如页面被丢弃），结算待测量的回收量
+        if (m_reclaimPending) {
+            handleSample(ProcessStats::Sample());
+        }
+        return;
+    }
+    QObject *context = samplerContext();
+    if (!context) {
+        return;
+    }
+
+    // renderProcessPid() 只能在 GUI 线程读取，/proc 的读取放到采样线程；结果经 qApp 排队回到 GUI 线程
+    m_sampleInFlight = true;
+    QPointer<RendererMonitor> self(this);
+    QMetaObject::invokeMethod(
+        context,
+        [self, pid]() {
+            const ProcessStats::Sample sample = ProcessStats::sample(pid);
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [self, sample]() {
+                    if (self) {
+                        self->handleSample(sample);
+                    }
+                },
+                Qt::QueuedConnection);
+        },
+        Qt::QueuedConnection);
+}
+
+void RendererMonitor::handleSample(const ProcessStats::Sample &sample)
+{
+    m_sampleInFlight = false;
+
+    const qint64 elapsedMs = m_lastSample.isValid() ? m_lastSample.restart() : -1;
+    if (!m_lastSample.isValid()) {
+        m_lastSample.start();
+    }
+    if (sample.pid != m_usage.pid) {
+        m_lastCpuTimeMs = -1;
+    }
+
+    Usage usage;
+    usage.pid = sample.pid;
+    usage.rssBytes = sample.rssBytes;
+    usage.sampledAtMs = m_clock.elapsed();
+    if (sample.cpuTimeMs >= 0 && m_lastCpuTimeMs >= 0 && elapsedMs > 0) {
+        usage.cpuPercent = 100.0 * static_cast<double>(sample.cpuTimeMs - m_lastCpuTimeMs) / static_cast<double>(elapsedMs);
+    }
+    m_lastCpuTimeMs = sample.cpuTimeMs;
+    m_usage = usage;
+    emit usageSampled(m_usage);
+
+    if (m_reclaimPending) {
+        m_reclaimPending = false;
+        const QString name = actionName(m_pendingReclaim.action);
+        if (sample.pid != m_pendingReclaim.pid || sample.rssBytes < 0) {
+            // 进程退出或更换后，新读数（或缺失的读数）与动作前的 RSS 不可比
+            qInfo().noquote() << "RendererMonitor:" << name << "on renderer" << m_pendingReclaim.pid
+                              << "reclaimed an unknown amount (renderer exited or was replaced)";
+            emit memoryReclaimed(m_pendingReclaim.action, -1);
+            return;
+        }
+        const qint64 rssAfter = sample.rssBytes;
+        const qint64 reclaimed = m_pendingReclaim.rssBefore - rssAfter;
+        qInfo().noquote() << "RendererMonitor:" << name << "on renderer" << m_pendingReclaim.pid << "reclaimed"
+                          << QString::number(toMiB(reclaimed), 'f', 1) << "MiB (RSS"
+                          << QString::number(toMiB(m_pendingReclaim.rssBefore), 'f', 1) << "->"
+                          << QString::number(toMiB(rssAfter), 'f', 1) << "MiB)";
+        if (reclaimed > 0) {
+            MetricsRegistry::instance()
+                .counter("webengine_demo_memory_reclaimed_bytes_total", "Renderer memory reclaimed by memory-pressure actions.",
+                         {{"action", name}})
+                .increment(static_cast<quint64>(reclaimed));
+        }
+        emit memoryReclaimed(m_pendingReclaim.action, reclaimed);
+        return;
+    }
+    evaluatePressure();
+}
+
+void RendererMonitor::evaluatePressure()
+{
+    if (!m_usage.isValid()) {
+        return;
+    }
+    const Action actions[] = {
+        Action::ClearHttpCache,
+        Action::DropBridgeQueue,
+        Action::FreezeBackground,
+        Action::DiscardBackground,
+    };
+    const qint64 now = m_clock.elapsed();
+    for (const Action action : actions) {
+        const qint64 limit = threshold(action);
+        if (limit <= 0 || m_usage.rssBytes < limit) {
+            continue;
+        }
+        const auto last = m_lastActionAtMs.constFind(static_cast<int>(action));
+        if (last != m_lastActionAtMs.constEnd() && now - last.value() < m_policy.cooldownMs) {
+            continue;
+        }
+        if (!perform(action)) {
+            continue;
+        }
+
+        m_lastActionAtMs.insert(static_cast<int>(action), now);
+        m_pendingReclaim = PendingReclaim {action, m_usage.pid, m_usage.rssBytes};
+        m_reclaimPending = true;
+        const QString name = actionName(action);
+        qInfo().noquote() << "RendererMonitor:" << name << "fired for renderer" << m_usage.pid << "at"
+                          << QString::number(toMiB(m_usage.rssBytes), 'f', 1) << "MiB (threshold"
+                          << QString::number(toMiB(limit), 'f', 1) << "MiB)";
+        MetricsRegistry::instance()
+            .counter("webengine_demo_memory_pressure_actions_total", "Memory-pressure actions fired.", {{"action", name}})
+            .increment();
+        emit actionTriggered(action, m_usage.rssBytes);
+        QTimer::singleShot(kReclaimSettleMs, this, &RendererMonitor::sampleNow);
+        // 每次采样最多执行一个动作，压力仍在时下一次采样再升级
+        return;
+    }
+}
+
+bool RendererMonitor::perform(Action action)
+{
+    if (!m_pane) {
+        return false;
+    }
+    PageLifecycleManager *lifecycle = m_pane->lifecycle();
+    switch (action) {
+    case Action::ClearHttpCache: {
+        const SharedProfile *shared = m_pane->sharedProfile();
+        if (shared && shared->pageCount() > 1) {
+            emit sharedCacheClearRequested();
+        } else {
+            m_pane->clearHttpCache();
+        }
+        return true;
+    }
+    case Action::DropBridgeQueue:
+        return m_pane->dropPendingMessages() > 0;
+    case Action::FreezeBackground:
+        return lifecycle && lifecycle->freezeNow();
+    case Action::DiscardBackground:
+        return lifecycle && lifecycle->discard();
+    }
+    return false;
+}
+
+qint64 RendererMonitor::threshold(Action action) const
+{
+    switch (action) {
+    case Action::ClearHttpCache:
+        return m_policy.clearCacheBytes;
+    case Action::DropBridgeQueue:
+        return m_policy.dropQueuesBytes;
+    case Action::FreezeBackground:
+        return m_policy.freezeBackgroundBytes;
+    case Action::DiscardBackground:
+        return m_policy.discardBackgroundBytes;
+    }
+    return 0;
+}
+
+qint64 RendererMonitor::rendererPid() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    if (m_pane && m_pane->view() && m_pane->view()->page()) {
+        return m_pane->view()->page()->renderProcessPid();
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "configmanager.h"
+#include "processstats.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class QTimer;
+class WebEnginePane;
+
+// RendererMonitor 定时采样 pane 所在渲染进程的 RSS 与 CPU 占用，/proc 读取在共享的后台线程完成；
+// RSS 超过 MemoryPressure 中的阈值时依次清空 HTTP 缓存、丢弃 bridge 队列、冻结或丢弃后台页面，并记录回收的内存。
+// 由窗口所有者创建并设置策略；无头、服务与 worker pane 不挂监视器。
+class RendererMonitor final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Usage
+    {
+        qint64 pid {0};
+        qint64 rssBytes {-1};
+        // 两次采样之间的平均占用，100 表示占满一个核心；首次采样为 -1
+        double cpuPercent {-1.0};
+        qint64 sampledAtMs {0};
+
+        bool isValid() const { return pid > 0 && rssBytes >= 0; }
+    };
+
+    // 按代价从低到高排列，压力持续时逐级升级
+    enum class Action
+    {
+        ClearHttpCache,
+        DropBridgeQueue,
+        FreezeBackground,
+        DiscardBackground,
+    };
+    Q_ENUM(Action)
+
+    explicit RendererMonitor(WebEnginePane *pane);
+    ~RendererMonitor() override;
+
+    void setPolicy(const ConfigManager::MemoryPressure &policy);
+    ConfigManager::MemoryPressure policy() const;
+    Usage usage() const;
+    static QString actionName(Action action);
+
+public slots:
+    void sampleNow();
+
+signals:
+    void usageSampled(const RendererMonitor::Usage &usage);
+    void actionTriggered(RendererMonitor::Action action, qint64 rssBytes);
+    // 渲染进程在测量前退出或已更换时无法得知回收量，bytes 为 -1
+    void memoryReclaimed(RendererMonitor::Action action, qint64 bytes);
+    // profile 被多个页面共用时不直接清空缓存，交给持有 profile 的控制器统一处理并限频
+    void sharedCacheClearRequested();
+
+private:
+    struct PendingReclaim
+    {
+        Action action {Action::ClearHttpCache};
+        qint64 pid {0};
+        qint64 rssBefore {0};
+    };
+
+    void handleSample(const ProcessStats::Sample &sample);
+    void evaluatePressure();
+    bool perform(Action action);
+    qint64 threshold(Action action) const;
+    qint64 rendererPid() const;
+
+    QPointer<WebEnginePane> m_pane;
+    QTimer *m_timer {nullptr};
+    ConfigManager::MemoryPressure m_policy;
+    Usage m_usage;
+    qint64 m_lastCpuTimeMs {-1};
+    QElapsedTimer m_clock;
+    QElapsedTimer m_lastSample;
+    QHash<int, qint64> m_lastActionAtMs;
+    PendingReclaim m_pendingReclaim;
+    bool m_reclaimPending {false};
+    bool m_sampleInFlight {false};
+};
+
+Q_DECLARE_METATYPE(RendererMonitor::Usage)
@@ -0,0 +1,316 @@
+#include "renderingbenchmark.h"
+
+#include "configmanager.h"
+#include "connectguard.h"
+#include "jankmonitor.h"
+#include "processstats.h"
+#include "webenginepane.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTextStream>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineView>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr auto kControllerOption = "rendering-bench";
+constexpr auto kProbeOption = "rendering-bench-child";
+constexpr int kMemorySampleIntervalMs = 500;
+constexpr int kChildStartupBudgetMs = 60000;
+const QString kResultPrefix = QStringLiteral("RENDERING_BENCH_RESULT ");
+
+double toMiB(qint64 bytes)
+{
+    return bytes >= 0 ? bytes / (1024.0 * 1024.0) : -1.0;
+}
+
+QString formatNumber(const QJsonValue &value, int precision = 1)
+{
+    const double number = value.toDouble(-1.0);
+    return number < 0.0 ? QStringLiteral("-") : QString::number(number, 'f', precision);
+}
+} // namespace
+
+bool RenderingBenchmarkOptions::fromArguments(const QStringList &arguments, RenderingBenchmarkOptions *options, QString *error)
+{
+    const auto hasFlag = [&arguments](const char *name) {
+        const QString flag = QStringLiteral("--") + QLatin1String(name);
+        return std::any_of(arguments.cbegin(), arguments.cend(), [&flag](const QString &argument) {
+            return argument == flag || argument.startsWith(flag + QLatin1Char('='));
+        });
+    };
+    const bool probe = hasFlag(kProbeOption);
+    if (!probe && !hasFlag(kControllerOption)) {
+        return false;
+    }
+    options->role = probe ? Role::Probe : Role::Controller;
+
+    QStringList profileNames;
+    for (const auto &profile : ConfigManager::renderingProfiles()) {
+        profileNames << profile.name;
+    }
+
+    QCommandLineParser parser;
+    const QCommandLineOption controllerOption(QLatin1String(kControllerOption),
+                                              QStringLiteral("Cycle rendering profiles in child processes."));
+    const QCommandLineOption probeOption(QLatin1String(kProbeOption),
+                                         QStringLiteral("Internal: measure a single profile."));
+    const QCommandLineOption profilesOption(QStringLiteral("profiles"),
+                                            QStringLiteral("Comma separated rendering profiles."),
+                                            QStringLiteral("list"),
+                                            profileNames.join(QLatin1Char(',')));
+    const QCommandLineOption profileOption(QStringLiteral("rendering-profile"),
+                                           QStringLiteral("Rendering profile for this process."),
+                                           QStringLiteral("name"));
+    const QCommandLineOption urlOption(QStringLiteral("bench-url"),
+                                       QStringLiteral("Test page."),
+                                       QStringLiteral("url"),
+                                       options->url.toString());
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+                                          QStringLiteral("Warm-up after load, ms."),
+                                          QStringLiteral("ms"),
+                                          QString::number(options->warmupMs));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+                                            QStringLiteral("Measurement window, ms."),
+                                            QStringLiteral("ms"),
+                                            QString::number(options->durationMs));
+    const QCommandLineOption offscreenOption(QStringLiteral("offscreen"),
+                                             QStringLiteral("Run child processes on the offscreen platform."));
+    parser.addOptions({controllerOption,
+                       probeOption,
+                       profilesOption,
+                       profileOption,
+                       urlOption,
+                       warmupOption,
+                       durationOption,
+                       offscreenOption});
+
+    // 其余参数交给 QApplication 与 Chromium，这里只关心本基准的选项
+    if (!parser.parse(arguments) && parser.unknownOptionNames().isEmpty()) {
+        *error = parser.errorText();
+        return true;
+    }
+
+    options->profiles = probe ? QStringList {parser.value(profileOption)}
+                              : parser.value(profilesOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &profile : std::as_const(options->profiles)) {
+        if (!ConfigManager::findRenderingProfile(profile, nullptr)) {
+            *error = QStringLiteral("unknown rendering profile: %1").arg(profile);
+            return true;
+        }
+    }
+    if (options->profiles.isEmpty()) {
+        *error = QStringLiteral("no rendering profile selected");
+        return true;
+    }
+    options->url = QUrl::fromUserInput(parser.value(urlOption));
+    options->warmupMs = qMax(0, parser.value(warmupOption).toInt());
+    options->durationMs = qMax(1000, parser.value(durationOption).toInt());
+    options->offscreen = parser.isSet(offscreenOption);
+    if (!options->url.isValid()) {
+        *error = QStringLiteral("invalid test page: %1").arg(parser.value(urlOption));
+    }
+    return true;
+}
+
+RenderingBenchmark::RenderingBenchmark(const RenderingBenchmarkOptions &options)
+    : m_options(options)
+{
+}
+
+int RenderingBenchmark::run()
+{
+    QVector<QJsonObject> results;
+    int failures = 0;
+    for (const QString &profile : std::as_const(m_options.profiles)) {
+        qInfo().noquote() << "RenderingBenchmark: measuring profile" << profile;
+        QString error;
+        QJsonObject result = runProfile(profile, &error);
+        if (!error.isEmpty()) {
+            qWarning().noquote() << "RenderingBenchmark:" << profile << error;
+            result = QJsonObject {{QStringLiteral("profile"), profile}, {QStringLiteral("error"), error}};
+            ++failures;
+        }
+        results.append(result);
+    }
+    printSummary(results);
+    return failures == 0 ? 0 : 1;
+}
+
+QJsonObject RenderingBenchmark::runProfile(const QString &profile, QString *error) const
+{
+    QProcess child;
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    if (m_options.offscreen) {
+        environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+    }
+    child.setProcessEnvironment(environment);
+    child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    child.start(QCoreApplication::applicationFilePath(),
+                {QStringLiteral("--") + QLatin1String(kProbeOption),
+                 QStringLiteral("--rendering-profile"), profile,
+                 QStringLiteral("--bench-url"), m_options.url.toString(),
+                 QStringLiteral("--warmup"), QString::number(m_options.warmupMs),
+                 QStringLiteral("--duration"), QString::number(m_options.durationMs)});
+
+    const int budgetMs = m_options.warmupMs + m_options.durationMs + kChildStartupBudgetMs;
+    if (!child.waitForFinished(budgetMs)) {
+        child.kill();
+        child.waitForFinished();
+        *error = QStringLiteral("child process timed out");
+        return {};
+    }
+
+    // 子进程可能混有 Chromium 日志，只取带前缀的结果行
+    const QStringList lines = QString::fromLocal8Bit(child.readAllStandardOutput()).split(QLatin1Char('\n'));
+    for (auto it = lines.crbegin(); it != lines.crend(); ++it) {
+        const QString line = it->trimmed();
+        if (!line.startsWith(kResultPrefix)) {
+            continue;
+        }
+        const QJsonDocument document = QJsonDocument::fromJson(line.mid(kResultPrefix.size()).toUtf8());
+        if (document.isObject()) {
+            return document.object();
+        }
+    }
+    *error = QStringLiteral("no result (exit code %1)").arg(child.exitCode());
+    return {};
+}
+
+void RenderingBenchmark::printSummary(const QVector<QJsonObject> &results) const
+{
+    QTextStream out(stdout);
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(QStringLiteral("profile"), -14)
+               .arg(QStringLiteral("avg fps"), 8)
+               .arg(QStringLiteral("frame ms"), 9)
+               .arg(QStringLiteral("worst ms"), 9)
+               .arg(QStringLiteral("dropped"), 8)
+               .arg(QStringLiteral("renderer MiB"), 13)
+               .arg(QStringLiteral("browser MiB"), 12);
+    for (const QJsonObject &result : results) {
+        if (result.contains(QStringLiteral("error"))) {
+            out << QStringLiteral("%1 %2\n")
+                       .arg(result.value(QStringLiteral("profile")).toString(), -14)
+                       .arg(result.value(QStringLiteral("error")).toString());
+            continue;
+        }
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(result.value(QStringLiteral("profile")).toString(), -14)
+                   .arg(formatNumber(result.value(QStringLiteral("avgFps"))), 8)
+                   .arg(formatNumber(result.value(QStringLiteral("meanFrameMs")), 2), 9)
+                   .arg(formatNumber(result.value(QStringLiteral("worstFrameMs"))), 9)
+                   .arg(result.value(QStringLiteral("droppedFrames")).toInt(), 8)
+                   .arg(formatNumber(result.value(QStringLiteral("peakRendererRssMiB"))), 13)
+                   .arg(formatNumber(result.value(QStringLiteral("peakBrowserRssMiB"))), 12);
+    }
+}
+
+RenderingBenchmarkProbe::RenderingBenchmarkProbe(const RenderingBenchmarkOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(kMemorySampleIntervalMs);
+    ENSURE_QT_CONNECT(m_memoryTimer, &QTimer::timeout, this, &RenderingBenchmarkProbe::sampleMemory);
+}
+
+RenderingBenchmarkProbe::~RenderingBenchmarkProbe() = default;
+
+void RenderingBenchmarkProbe::start()
+{
+    m_pane = std::make_unique<WebEnginePane>();
+    m_pane->resize(1280, 800);
+    m_pane->show();
+    ENSURE_QT_CONNECT(m_pane.get(), &WebEnginePane::loadFinished, this, &RenderingBenchmarkProbe::handleLoadFinished);
+    if (auto *monitor = m_pane->jankMonitor()) {
+        ENSURE_QT_CONNECT(monitor, &JankMonitor::snapshotUpdated, this, [this](const JankMonitor::Snapshot &snapshot) {
+            if (!m_measuring || !snapshot.pageDataFresh || snapshot.pageReportSeq == m_lastPageReportSeq) {
+                return;
+            }
+            m_lastPageReportSeq = snapshot.pageReportSeq;
+            ++m_snapshots;
+            m_frames += snapshot.frames;
+            m_droppedFrames += snapshot.droppedFrames;
+            m_longTasks += snapshot.longTasks;
+            m_worstFrameMs = qMax(m_worstFrameMs, snapshot.worstFrameMs);
+            m_minFps = m_minFps < 0.0 ? snapshot.fps : qMin(m_minFps, snapshot.fps);
+        });
+    }
+    m_pane->load(m_options.url);
+    QTimer::singleShot(m_options.warmupMs + m_options.durationMs + kChildStartupBudgetMs, this, [this]() {
+        if (!m_loaded) {
+            qWarning() << "RenderingBenchmarkProbe: test page did not load";
+            emit finished(1);
+        }
+    });
+}
+
+void RenderingBenchmarkProbe::handleLoadFinished(bool ok)
+{
+    if (m_loaded) {
+        return;
+    }
+    if (!ok) {
+        qWarning() << "RenderingBenchmarkProbe: failed to load" << m_options.url;
+        emit finished(1);
+        return;
+    }
+    m_loaded = true;
+    QTimer::singleShot(m_options.warmupMs, this, &RenderingBenchmarkProbe::beginMeasurement);
+}
+
+void RenderingBenchmarkProbe::beginMeasurement()
+{
+    m_measuring = true;
+    // 预热期间收到的报告不计入
+    if (auto *monitor = m_pane->jankMonitor()) {
+        m_lastPageReportSeq = monitor->snapshot().pageReportSeq;
+    }
+    m_measureClock.start();
+    sampleMemory();
+    m_memoryTimer->start();
+    QTimer::singleShot(m_options.durationMs, this, &RenderingBenchmarkProbe::finish);
+}
+
+void RenderingBenchmarkProbe::sampleMemory()
+{
+    const qint64 rendererPid = m_pane ? m_pane->view()->page()->renderProcessPid() : 0;
+    m_peakRendererRss = qMax(m_peakRendererRss, ProcessStats::sample(rendererPid).rssBytes);
+    m_peakBrowserRss = qMax(m_peakBrowserRss, ProcessStats::sampleSelf().rssBytes);
+}
+
+void RenderingBenchmarkProbe::finish()
+{
+    sampleMemory();
+    m_memoryTimer->stop();
+    m_measuring = false;
+
+    const double elapsedMs = m_measureClock.nsecsElapsed() / 1e6;
+    const QJsonObject result {
+        {QStringLiteral("profile"), m_options.profiles.value(0)},
+        {QStringLiteral("chromiumFlags"), QString::fromLocal8Bit(qgetenv("QTWEBENGINE_CHROMIUM_FLAGS"))},
+        {QStringLiteral("durationMs"), elapsedMs},
+        {QStringLiteral("snapshots"), m_snapshots},
+        {QStringLiteral("frames"), m_frames},
+        {QStringLiteral("avgFps"), m_frames > 0 ? m_frames * 1000.0 / elapsedMs : -1.0},
+        {QStringLiteral("minFps"), m_minFps},
+        {QStringLiteral("meanFrameMs"), m_frames > 0 ? elapsedMs / m_frames : -1.0},
+        {QStringLiteral("worstFrameMs"), m_worstFrameMs},
+        {QStringLiteral("droppedFrames"), m_droppedFrames},
+        {QStringLiteral("longTasks"), m_longTasks},
+        {QStringLiteral("peakRendererRssMiB"), toMiB(m_peakRendererRss)},
+        {QStringLiteral("peakBrowserRssMiB"), toMiB(m_peakBrowserRss)},
+    };
+    QTextStream(stdout) << kResultPrefix << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+    emit finished(m_snapshots > 0 ? 0 : 1);
+}
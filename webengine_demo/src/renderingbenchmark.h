@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include <memory>
+
+class QTimer;
+class WebEnginePane;
+
+// RenderingBenchmarkOptions 描述 --rendering-bench（调度进程）与 --rendering-bench-child（被测进程）的参数。
+struct RenderingBenchmarkOptions
+{
+    enum class Role
+    {
+        Controller,
+        Probe,
+    };
+
+    Role role {Role::Controller};
+    QStringList profiles;
+    QUrl url {QStringLiteral("qrc:/web/rendering-test.html")};
+    int warmupMs {2000};
+    int durationMs {10000};
+    bool offscreen {false};
+
+    // 未指定 --rendering-bench / --rendering-bench-child 时返回 false。
+    static bool fromArguments(const QStringList &arguments, RenderingBenchmarkOptions *options, QString *error);
+};
+
+// RenderingBenchmark 依次以每个渲染预设启动子进程（Chromium 参数只能在进程启动时生效），
+// 收集子进程输出的帧时间与内存数据并汇总成表格。
+class RenderingBenchmark final
+{
+public:
+    explicit RenderingBenchmark(const RenderingBenchmarkOptions &options);
+
+    int run();
+
+private:
+    QJsonObject runProfile(const QString &profile, QString *error) const;
+    void printSummary(const QVector<QJsonObject> &results) const;
+
+    RenderingBenchmarkOptions m_options;
+};
+
+// RenderingBenchmarkProbe 在子进程中加载测试页，预热后统计 JankMonitor 快照与渲染 / 浏览器进程内存，
+// 结束时向标准输出写一行 JSON。
+class RenderingBenchmarkProbe final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderingBenchmarkProbe(const RenderingBenchmarkOptions &options, QObject *parent = nullptr);
+    ~RenderingBenchmarkProbe() override;
+
+public slots:
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    void handleLoadFinished(bool ok);
+    void beginMeasurement();
+    void sampleMemory();
+    void finish();
+
+    RenderingBenchmarkOptions m_options;
+    std::unique_ptr<WebEnginePane> m_pane;
+    QTimer *m_memoryTimer {nullptr};
+    QElapsedTimer m_measureClock;
+    bool m_measuring {false};
+    bool m_loaded {false};
+    int m_snapshots {0};
+    quint64 m_lastPageReportSeq {0};
+    qint64 m_frames {0};
+    qint64 m_droppedFrames {0};
+    double m_worstFrameMs {0.0};
+    double m_minFps {-1.0};
+    qint64 m_longTasks {0};
+    qint64 m_peakRendererRss {-1};
+    qint64 m_peakBrowserRss {-1};
+};
@@ -0,0 +1,209 @@
+#include "renderprocessrecovery.h"
+
+#include "connectguard.h"
+#include "webbridge.h"
+#include "webenginepane.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QWebEngineView>
+
+#include <algorithm>
+
+namespace {
+constexpr int kBaseReloadDelayMs = 500;
+constexpr int kMaxReloadDelayMs = 30000;
+constexpr int kCrashLoopWindowMs = 60000;
+constexpr int kMaxCrashesPerWindow = 3;
+// 恢复期间的重载连续失败这么多次后放弃，避免在 30 秒上限上无限重试
+constexpr int kMaxReloadAttempts = 8;
+constexpr int kJournalCapacity = 256;
+} // namespace
+
+RenderProcessRecovery::RenderProcessRecovery(WebEnginePane *pane, WebBridge *bridge)
+    : QObject(pane)
+    , m_pane(pane)
+    , m_bridge(bridge)
+{
+    m_clock.start();
+
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    ENSURE_QT_CONNECT(m_reloadTimer, &QTimer::timeout, this, &RenderProcessRecovery::performReload);
+
+    if (m_bridge) {
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::messageFromCpp, this, &RenderProcessRecovery::journalMessage);
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::messageBatchFromCpp, this, [this](const QStringList &payloads) {
+            for (const QString &payload : payloads) {
+                journalMessage(payload);
+            }
+        });
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::stateSnapshotSaved, this, &RenderProcessRecovery::recordSnapshot);
+        ENSURE_QT_CONNECT(m_bridge, &WebBridge::messagesAcknowledged, this, &RenderProcessRecovery::acknowledge);
+    }
+}
+
+void RenderProcessRecovery::handleRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status,
+                                                          int exitCode)
+{
+    if (status == QWebEnginePage::NormalTerminationStatus) {
+        return;
+    }
+
+    ++m_stats.crashes;
+    if (m_crashedAt < 0) {
+        m_crashedAt = m_clock.elapsed();
+    }
+
+    if (crashLoopDetected()) {
+        qWarning() << "RenderProcessRecovery: last exit code" << exitCode;
+        abandon("crash loop detected");
+        return;
+    }
+
+    m_recovering = true;
+    scheduleReload();
+}
+
+void RenderProcessRecovery::handleUrlChanged(const QUrl &url)
+{
+    if (url.isEmpty() || url == m_lastUrl) {
+        return;
+    }
+    if (!m_recovering) {
+        m_journal.clear();
+        m_snapshot.clear();
+        m_snapshotUrl.clear();
+    }
+    m_lastUrl = url;
+}
+
+void RenderProcessRecovery::handleLoadFinished(bool ok)
+{
+    if (!m_recovering || ok || m_reloadTimer->isActive()) {
+        return;
+    }
+    if (m_attempt >= kMaxReloadAttempts) {
+        abandon("reload keeps failing");
+        return;
+    }
+    scheduleReload();
+}
+
+void RenderProcessRecovery::handlePageReady()
+{
+    // 新文档的确认计数从 0 开始，旧文档未确认的消息只在恢复时重放
+    m_sentInDocument = 0;
+    if (!m_recovering) {
+        m_journal.clear();
+        return;
+    }
+
+    const qint64 elapsed = m_clock.elapsed() - m_crashedAt;
+    m_recovering = false;
+    m_crashedAt = -1;
+    m_attempt = 0;
+
+    if (m_bridge) {
+        if (!m_snapshot.isEmpty() && m_snapshotUrl.matches(m_lastUrl, QUrl::StripTrailingSlash)) {
+            m_bridge->requestStateRestore(m_snapshot);
+        }
+        // 重放的消息会以新文档中的序号再次进入日志，等页面确认后移除
+        const QVector<JournalEntry> replay = m_journal;
+        m_journal.clear();
+        for (const JournalEntry &entry : replay) {
+            m_bridge->dispatchToWeb(entry.payload);
+        }
+        if (!replay.isEmpty()) {
+            qInfo() << "RenderProcessRecovery: replayed" << replay.size() << "journaled messages";
+        }
+    }
+
+    ++m_stats.recoveries;
+    m_stats.lastRecoveryMs = elapsed;
+    m_stats.totalRecoveryMs += elapsed;
+    qInfo() << "RenderProcessRecovery: page recovered in" << elapsed << "ms"
+            << "(recoveries:" << m_stats.recoveries << "crashes:" << m_stats.crashes << ')';
+    emit recovered(elapsed);
+}
+
+bool RenderProcessRecovery::isRecovering() const
+{
+    return m_recovering;
+}
+
+RenderProcessRecovery::Stats RenderProcessRecovery::stats() const
+{
+    return m_stats;
+}
+
+void RenderProcessRecovery::recordSnapshot(const QString &snapshot)
+{
+    m_snapshot = snapshot;
+    m_snapshotUrl = (m_pane && m_pane->view()) ? m_pane->view()->url() : QUrl();
+}
+
+void RenderProcessRecovery::journalMessage(const QString &payload)
+{
+    // 空消息同样计入序号，与页面侧的计数保持一致
+    ++m_sentInDocument;
+    if (payload.isEmpty()) {
+        return;
+    }
+    if (m_journal.size() >= kJournalCapacity) {
+        m_journal.removeFirst();
+    }
+    m_journal.append({m_sentInDocument, payload});
+}
+
+void RenderProcessRecovery::acknowledge(int count)
+{
+    // 确认数是当前文档累计收到的消息数，序号不超过它的消息已送达
+    const auto delivered = std::find_if(m_journal.begin(), m_journal.end(), [count](const JournalEntry &entry) {
+        return entry.seq > count;
+    });
+    m_journal.erase(m_journal.begin(), delivered);
+}
+
+void RenderProcessRecovery::abandon(const char *reason)
+{
+    m_reloadTimer->stop();
+    m_recovering = false;
+    m_crashedAt = -1;
+    m_attempt = 0;
+    ++m_stats.abandoned;
+    qWarning() << "RenderProcessRecovery:" << reason << "- giving up after" << m_crashTimes.size()
+               << "crashes in the window";
+    emit recoveryAbandoned(m_crashTimes.size());
+}
+
+void RenderProcessRecovery::scheduleReload()
+{
+    ++m_attempt;
+    const int shift = std::min(m_attempt - 1, 16);
+    const int delay = std::min(kBaseReloadDelayMs << shift, kMaxReloadDelayMs);
+    qWarning() << "RenderProcessRecovery: reloading" << m_lastUrl << "in" << delay << "ms, attempt" << m_attempt;
+    m_reloadTimer->start(delay);
+    emit recoveryScheduled(m_attempt, delay);
+}
+
+void RenderProcessRecovery::performReload()
+{
+    if (!m_pane || !m_lastUrl.isValid()) {
+        m_recovering = false;
+        m_crashedAt = -1;
+        return;
+    }
+    m_pane->load(m_lastUrl);
+}
+
+bool RenderProcessRecovery::crashLoopDetected()
+{
+    const qint64 now = m_clock.elapsed();
+    m_crashTimes.append(now);
+    m_crashTimes.erase(std::remove_if(m_crashTimes.begin(),
+                                      m_crashTimes.end(),
+                                      [now](qint64 at) { return now - at > kCrashLoopWindowMs; }),
+                       m_crashTimes.end());
+    return m_crashTimes.size() >= kMaxCrashesPerWindow;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+#include <QWebEnginePage>
+
+class QTimer;
+class WebBridge;
+class WebEnginePane;
+
+// RenderProcessRecovery 负责渲染进程崩溃后的自动恢复：
+// 按指数退避重新加载最后的 URL，页面就绪后通过 bridge 恢复滚动/表单快照，
+// 并重放崩溃前页面尚未确认收到的 C++ -> JS 消息；短时间内反复崩溃或重载一直失败则熔断放弃。
+class RenderProcessRecovery final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int crashes {0};
+        int recoveries {0};
+        int abandoned {0};
+        qint64 lastRecoveryMs {-1};
+        qint64 totalRecoveryMs {0};
+    };
+
+    explicit RenderProcessRecovery(WebEnginePane *pane, WebBridge *bridge);
+
+    void handleRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status, int exitCode);
+    void handleUrlChanged(const QUrl &url);
+    void handleLoadFinished(bool ok);
+    void handlePageReady();
+
+    bool isRecovering() const;
+    Stats stats() const;
+
+signals:
+    void recoveryScheduled(int attempt, int delayMs);
+    void recovered(qint64 elapsedMs);
+    void recoveryAbandoned(int crashesInWindow);
+
+private:
+    struct JournalEntry
+    {
+        // 当前文档中发出的第几条消息，从 1 开始
+        qint64 seq {0};
+        QString payload;
+    };
+
+    void recordSnapshot(const QString &snapshot);
+    void journalMessage(const QString &payload);
+    void acknowledge(int count);
+    void abandon(const char *reason);
+    void scheduleReload();
+    void performReload();
+    bool crashLoopDetected();
+
+    QPointer<WebEnginePane> m_pane;
+    QPointer<WebBridge> m_bridge;
+    QTimer *m_reloadTimer {nullptr};
+    QUrl m_lastUrl;
+    QUrl m_snapshotUrl;
+    QString m_snapshot;
+    QVector<JournalEntry> m_journal;
+    qint64 m_sentInDocument {0};
+    QVector<qint64> m_crashTimes;
+    QElapsedTimer m_clock;
+    qint64 m_crashedAt {-1};
+    int m_attempt {0};
+    bool m_recovering {false};
+    Stats m_stats;
+};
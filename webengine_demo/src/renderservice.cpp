@@ -0,0 +1,728 @@
+#include "renderservice.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+#include "profileregistry.h"
+#include "shardchannel.h"
+#include "webbridge.h"
+#include "webenginepane.h"
+
+#include <QBuffer>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPixmap>
+#include <QTimer>
+#include <QVariantMap>
+#include <QWebEnginePage>
+#include <QWebEngineView>
+
+#include <algorithm>
+
+namespace {
+constexpr auto kRenderServiceOption = "render-service";
+constexpr auto kProfileName = "RenderService";
+// 结果按块流式返回，单帧远小于 ShardChannel::kMaxFrameBytes
+constexpr int kChunkBytes = 256 * 1024;
+constexpr int kChunkChars = 128 * 1024;
+constexpr int kExpiryIntervalMs = 250;
+constexpr int kMaxSamples = 1024;
+
+QSize parseViewport(const QString &text)
+{
+    const QStringList parts = text.toLower().split(QLatin1Char('x'));
+    if (parts.size() != 2) {
+        return {};
+    }
+    bool widthOk = false;
+    bool heightOk = false;
+    const QSize size(parts.at(0).toInt(&widthOk), parts.at(1).toInt(&heightOk));
+    return widthOk && heightOk && size.width() > 0 && size.height() > 0 ? size : QSize();
+}
+
+// 以 JSON 字符串字面量的形式嵌入脚本
+QString jsStringLiteral(const QString &text)
+{
+    const QByteArray json = QJsonDocument(QJsonArray {text}).toJson(QJsonDocument::Compact);
+    return QString::fromUtf8(json.mid(1, json.size() - 2));
+}
+
+void recordSample(QVector<double> *samples, double value)
+{
+    if (samples->size() >= kMaxSamples) {
+        samples->removeFirst();
+    }
+    samples->append(value);
+}
+
+// high / normal / low，也接受 0..2 的整数；0 最先调度
+int parsePriority(const QJsonValue &value)
+{
+    if (value.isDouble()) {
+        return qBound(0, value.toInt(), RenderService::kPriorityLevels - 1);
+    }
+    const QString name = value.toString().toLower();
+    if (name == QLatin1String("high")) {
+        return 0;
+    }
+    if (name == QLatin1String("low")) {
+        return 2;
+    }
+    return 1;
+}
+
+QString typeName(RenderService::JobType type)
+{
+    switch (type) {
+    case RenderService::JobType::Render:
+        return QStringLiteral("render");
+    case RenderService::JobType::Eval:
+        return QStringLiteral("eval");
+    case RenderService::JobType::Text:
+        return QStringLiteral("text");
+    }
+    return QString();
+}
+
+void countJob(RenderService::JobType type, const char *result)
+{
+    MetricsRegistry::instance()
+        .counter("webengine_demo_render_service_jobs_total", "Render service jobs by type and result.",
+                 {{"type", typeName(type)}, {"result", QString::fromLatin1(result)}})
+        .increment();
+}
+} // namespace
+
+bool RenderServiceOptions::fromArguments(const QStringList &arguments, RenderServiceOptions *options, QString *error)
+{
+    const QString flag = QStringLiteral("--") + QLatin1String(kRenderServiceOption);
+    const bool requested = std::any_of(arguments.cbegin(), arguments.cend(), [&flag](const QString &argument) {
+        return argument == flag || argument.startsWith(flag + QLatin1Char('='));
+    });
+    if (!requested) {
+        return false;
+    }
+
+    QCommandLineParser parser;
+    const QCommandLineOption socketOption(QLatin1String(kRenderServiceOption),
+                                          QStringLiteral("Local socket name or path to listen on."),
+                                          QStringLiteral("name"));
+    const QCommandLineOption poolOption(QStringLiteral("pool"),
+                                        QStringLiteral("Warm offscreen panes."),
+                                        QStringLiteral("n"),
+                                        QString::number(options->poolSize));
+    const QCommandLineOption viewportOption(QStringLiteral("viewport"),
+                                            QStringLiteral("Viewport size, e.g. 1280x800."),
+                                            QStringLiteral("WxH"),
+                                            QStringLiteral("1280x800"));
+    const QCommandLineOption timeoutOption(QStringLiteral("job-timeout"),
+                                           QStringLiteral("Upper bound for one job, ms."),
+                                           QStringLiteral("ms"),
+                                           QString::number(options->jobTimeoutMs));
+    const QCommandLineOption settleOption(QStringLiteral("settle"),
+                                          QStringLiteral("Delay after load before running the job, ms."),
+                                          QStringLiteral("ms"),
+                                          QString::number(options->settleMs));
+    const QCommandLineOption queueOption(QStringLiteral("max-queued-per-client"),
+                                         QStringLiteral("Queued jobs allowed per client."),
+                                         QStringLiteral("n"),
+                                         QString::number(options->maxQueuedPerClient));
+    parser.addOptions({socketOption, poolOption, viewportOption, timeoutOption, settleOption, queueOption});
+
+    // main() 传入的是完整 argv，其中还有 Qt 自身（-platform 等）和 --rendering-profile 等参数，只把本模式选项的错误当作错误
+    if (!parser.parse(arguments) && parser.unknownOptionNames().isEmpty()) {
+        *error = parser.errorText();
+        return true;
+    }
+
+    options->socketName = parser.value(socketOption);
+    if (options->socketName.isEmpty()) {
+        *error = QStringLiteral("--render-service needs a socket name");
+        return true;
+    }
+    options->poolSize = qMax(1, parser.value(poolOption).toInt());
+    options->jobTimeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+    options->settleMs = qMax(0, parser.value(settleOption).toInt());
+    options->maxQueuedPerClient = qMax(1, parser.value(queueOption).toInt());
+    options->viewport = parseViewport(parser.value(viewportOption));
+    if (!options->viewport.isValid()) {
+        *error = QStringLiteral("invalid viewport: %1").arg(parser.value(viewportOption));
+    }
+    return true;
+}
+
+RenderService::RenderService(const RenderServiceOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    m_profiles = new ProfileRegistry(this);
+    m_expiryTimer = new QTimer(this);
+    m_expiryTimer->setInterval(kExpiryIntervalMs);
+    ENSURE_QT_CONNECT(m_expiryTimer, &QTimer::timeout, this, &RenderService::expireQueued);
+}
+
+RenderService::~RenderService()
+{
+    // pane 必须先于 ProfileRegistry 中的 profile 销毁
+    for (const auto &slot : m_slots) {
+        delete slot->pane.data();
+    }
+}
+
+bool RenderService::start()
+{
+    QLocalServer::removeServer(m_options.socketName);
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(m_options.socketName)) {
+        qCritical().noquote() << "RenderService: cannot listen on" << m_options.socketName << "-" << m_server->errorString();
+        return false;
+    }
+    ENSURE_QT_CONNECT(m_server, &QLocalServer::newConnection, this, &RenderService::handleConnection);
+
+    // 连接在 pane 预热期间即可接入，任务排队到有 pane 完成预热为止
+    for (int i = 0; i < m_options.poolSize; ++i) {
+        m_slots.push_back(std::unique_ptr<Slot>(createSlot()));
+    }
+    m_uptime.start();
+    m_expiryTimer->start();
+    updateGauges();
+    qInfo().noquote() << QStringLiteral("RenderService: listening on %1 with %2 warm panes")
+                             .arg(m_server->fullServerName())
+                             .arg(m_options.poolSize);
+    return true;
+}
+
+RenderService::Stats RenderService::stats() const
+{
+    Stats stats = m_counts;
+    stats.poolSize = static_cast<int>(m_slots.size());
+    qint64 busyMs = m_busyMs;
+    for (const auto &slot : m_slots) {
+        if (slot->busy) {
+            ++stats.busySlots;
+            busyMs += slot->runClock.elapsed();
+        }
+    }
+    const qint64 capacityMs = m_uptime.isValid() ? m_uptime.elapsed() * qMax<qint64>(1, stats.poolSize) : 0;
+    stats.utilization = capacityMs > 0 ? qMin(1.0, static_cast<double>(busyMs) / static_cast<double>(capacityMs)) : 0.0;
+    for (const Client &client : m_clients) {
+        stats.queued += client.queued;
+    }
+    stats.waitP50Ms = MetricsRegistry::percentile(m_waitSamples, 0.50);
+    stats.waitP95Ms = MetricsRegistry::percentile(m_waitSamples, 0.95);
+    stats.runP50Ms = MetricsRegistry::percentile(m_runSamples, 0.50);
+    stats.runP95Ms = MetricsRegistry::percentile(m_runSamples, 0.95);
+    return stats;
+}
+
+void RenderService::handleConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        const quint64 clientId = m_nextClientId++;
+        Client client;
+        client.channel = new ShardChannel(socket, this);
+        m_clients.insert(clientId, client);
+        ENSURE_QT_CONNECT(client.channel, &ShardChannel::received, this, [this, clientId](const QJsonObject &command) {
+            handleCommand(clientId, command);
+        });
+        ENSURE_QT_CONNECT(client.channel, &ShardChannel::disconnected, this, [this, clientId]() {
+            dropClient(clientId);
+        });
+    }
+}
+
+void RenderService::handleCommand(quint64 clientId, const QJsonObject &command)
+{
+    const QString name = command.value(QStringLiteral("cmd")).toString();
+    if (name == QLatin1String("submit")) {
+        submit(clientId, command);
+    } else if (name == QLatin1String("cancel")) {
+        cancel(clientId, command.value(QStringLiteral("id")).toString());
+    } else if (name == QLatin1String("stats")) {
+        reply(clientId, QString(), QStringLiteral("stats"), statsObject());
+    } else {
+        reply(clientId, command.value(QStringLiteral("id")).toString(), QStringLiteral("error"),
+              {{QStringLiteral("error"), QStringLiteral("unknown command: %1").arg(name)}});
+    }
+}
+
+void RenderService::submit(quint64 clientId, const QJsonObject &command)
+{
+    Job job;
+    job.clientId = clientId;
+    job.id = command.value(QStringLiteral("id")).toString();
+    job.url = QUrl::fromUserInput(command.value(QStringLiteral("url")).toString());
+    job.script = command.value(QStringLiteral("script")).toString();
+    job.format = command.value(QStringLiteral("format")).toString(QStringLiteral("png")).toLower();
+    job.priority = parsePriority(command.value(QStringLiteral("priority")));
+    job.deadlineMs = command.value(QStringLiteral("deadlineMs")).toVariant().toLongLong();
+
+    const QString type = command.value(QStringLiteral("type")).toString();
+    QString error;
+    if (type == QLatin1String("render")) {
+        job.type = JobType::Render;
+        if (job.format != QLatin1String("png") && job.format != QLatin1String("pdf")) {
+            error = QStringLiteral("unsupported format: %1").arg(job.format);
+        }
+    } else if (type == QLatin1String("eval")) {
+        job.type = JobType::Eval;
+        if (job.script.isEmpty()) {
+            error = QStringLiteral("eval needs a script");
+        }
+    } else if (type == QLatin1String("text")) {
+        job.type = JobType::Text;
+    } else {
+        error = QStringLiteral("unknown job type: %1").arg(type);
+    }
+    if (error.isEmpty() && job.id.isEmpty()) {
+        error = QStringLiteral("missing job id");
+    }
+    if (error.isEmpty() && !job.url.isValid()) {
+        error = QStringLiteral("invalid url");
+    }
+
+    Client &client = m_clients[clientId];
+    if (error.isEmpty() && client.queued >= m_options.maxQueuedPerClient) {
+        error = QStringLiteral("queue full");
+    }
+    ++m_counts.submitted;
+    if (!error.isEmpty()) {
+        ++m_counts.rejected;
+        countJob(job.type, "rejected");
+        reply(clientId, job.id, QStringLiteral("done"), {{QStringLiteral("ok"), false}, {QStringLiteral("error"), error}});
+        return;
+    }
+
+    job.queuedAt.start();
+    std::deque<Job> &queue = client.queues[job.priority];
+    if (queue.empty()) {
+        m_rotation[job.priority].push_back(clientId);
+    }
+    queue.push_back(job);
+    ++client.queued;
+    reply(clientId, job.id, QStringLiteral("accepted"), {{QStringLiteral("queued"), client.queued}});
+    updateGauges();
+    schedule();
+}
+
+void RenderService::cancel(quint64 clientId, const QString &jobId)
+{
+    const auto it = m_clients.find(clientId);
+    if (it == m_clients.end()) {
+        return;
+    }
+    for (int priority = 0; priority < kPriorityLevels; ++priority) {
+        std::deque<Job> &queue = it->queues[priority];
+        const auto found = std::find_if(queue.begin(), queue.end(), [&jobId](const Job &job) {
+            return job.id == jobId;
+        });
+        if (found == queue.end()) {
+            continue;
+        }
+        const JobType type = found->type;
+        queue.erase(found);
+        --it->queued;
+        if (queue.empty()) {
+            std::deque<quint64> &rotation = m_rotation[priority];
+            rotation.erase(std::remove(rotation.begin(), rotation.end(), clientId), rotation.end());
+        }
+        ++m_counts.cancelled;
+        countJob(type, "cancelled");
+        reply(clientId, jobId, QStringLiteral("done"), {{QStringLiteral("ok"), false}, {QStringLiteral("error"), QStringLiteral("cancelled")}});
+        updateGauges();
+        return;
+    }
+    for (const auto &slot : m_slots) {
+        if (slot->busy && slot->job.clientId == clientId && slot->job.id == jobId) {
+            if (slot->pane) {
+                slot->pane->view()->page()->triggerAction(QWebEnginePage::Stop);
+            }
+            complete(slot.get(), false, QStringLiteral("cancelled"));
+            return;
+        }
+    }
+}
+
+void RenderService::dropClient(quint64 clientId)
+{
+    const auto it = m_clients.find(clientId);
+    if (it == m_clients.end()) {
+        return;
+    }
+    m_counts.cancelled += it->queued;
+    it->channel->deleteLater();
+    m_clients.erase(it);
+    for (std::deque<quint64> &rotation : m_rotation) {
+        rotation.erase(std::remove(rotation.begin(), rotation.end(), clientId), rotation.end());
+    }
+    // 客户端已断开，正在执行的任务直接放弃，释放 pane 给其他客户端
+    for (const auto &slot : m_slots) {
+        if (slot->busy && slot->job.clientId == clientId) {
+            complete(slot.get(), false, QStringLiteral("client disconnected"));
+        }
+    }
+    updateGauges();
+}
+
+RenderService::Slot *RenderService::createSlot()
+{
+    auto *slot = new Slot;
+    SharedProfile *profile = m_profiles->acquire(QLatin1String(kProfileName));
+    auto *pane = new WebEnginePane(new BasicBridge, nullptr, profile);
+    pane->setAttribute(Qt::WA_DontShowOnScreen, true);
+    pane->resize(m_options.viewport);
+    pane->show();
+    slot->pane = pane;
+
+    slot->timeout = new QTimer(pane);
+    slot->timeout->setSingleShot(true);
+    ENSURE_QT_CONNECT(slot->timeout, &QTimer::timeout, this, [this, slot]() {
+        const bool deadline = slot->job.deadlineMs > 0 && remainingMs(slot->job) <= 0;
+        if (slot->pane && slot->pane->view()->page()) {
+            slot->pane->view()->page()->triggerAction(QWebEnginePage::Stop);
+        }
+        complete(slot, false, deadline ? QStringLiteral("deadline exceeded") : QStringLiteral("timeout"));
+    });
+    ENSURE_QT_CONNECT(pane->view()->page(), &QWebEnginePage::loadStarted, this, [slot]() {
+        slot->startedGeneration = slot->loadGeneration;
+    });
+    ENSURE_QT_CONNECT(pane, &WebEnginePane::loadFinished, this, [this, slot](bool ok) {
+        if (slot->startedGeneration == 0 || slot->startedGeneration != slot->loadGeneration) {
+            return;
+        }
+        handleLoadFinished(slot, slot->startedGeneration, ok);
+    });
+
+    // 预热：先加载空白页拉起渲染进程，完成后才参与调度
+    ++slot->generation;
+    slot->loadGeneration = slot->generation;
+    slot->startedGeneration = 0;
+    pane->load(QUrl(QStringLiteral("about:blank")));
+    return slot;
+}
+
+void RenderService::schedule()
+{
+    // 合并同一轮事件循环内的多次调度；也避免在 WebEngine 信号回调里直接发起新的加载
+    if (m_scheduleQueued) {
+        return;
+    }
+    m_scheduleQueued = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_scheduleQueued = false;
+        for (const auto &slot : m_slots) {
+            if (slot->busy || !slot->warm || !slot->pane) {
+                continue;
+            }
+            Job job;
+            if (!takeNext(&job)) {
+                break;
+            }
+            dispatch(slot.get(), job);
+        }
+        updateGauges();
+    });
+}
+
+bool RenderService::takeNext(Job *job)
+{
+    // 高优先级先调度；同一优先级内按客户端轮转，每次取一个任务，避免单个客户端占满 pane 池
+    for (int priority = 0; priority < kPriorityLevels; ++priority) {
+        std::deque<quint64> &rotation = m_rotation[priority];
+        while (!rotation.empty()) {
+            const quint64 clientId = rotation.front();
+            rotation.pop_front();
+            const auto it = m_clients.find(clientId);
+            if (it == m_clients.end() || it->queues[priority].empty()) {
+                continue;
+            }
+            std::deque<Job> &queue = it->queues[priority];
+            Job candidate = queue.front();
+            queue.pop_front();
+            --it->queued;
+            if (!queue.empty()) {
+                rotation.push_back(clientId);
+            }
+            if (candidate.deadlineMs > 0 && remainingMs(candidate) <= 0) {
+                ++m_counts.expired;
+                countJob(candidate.type, "expired");
+                reply(clientId, candidate.id, QStringLiteral("done"),
+                      {{QStringLiteral("ok"), false}, {QStringLiteral("error"), QStringLiteral("deadline exceeded")}});
+                continue;
+            }
+            *job = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RenderService::expireQueued()
+{
+    // 排队中已过截止时间的任务及时回报，不等到轮到它时才发现
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        if (it->queued == 0) {
+            continue;
+        }
+        for (int priority = 0; priority < kPriorityLevels; ++priority) {
+            std::deque<Job> &queue = it->queues[priority];
+            const bool hadJobs = !queue.empty();
+            for (auto job = queue.begin(); job != queue.end();) {
+                if (job->deadlineMs <= 0 || remainingMs(*job) > 0) {
+                    ++job;
+                    continue;
+                }
+                ++m_counts.expired;
+                countJob(job->type, "expired");
+                reply(it.key(), job->id, QStringLiteral("done"),
+                      {{QStringLiteral("ok"), false}, {QStringLiteral("error"), QStringLiteral("deadline exceeded")}});
+                job = queue.erase(job);
+                --it->queued;
+            }
+            if (hadJobs && queue.empty()) {
+                std::deque<quint64> &rotation = m_rotation[priority];
+                rotation.erase(std::remove(rotation.begin(), rotation.end(), it.key()), rotation.end());
+            }
+        }
+    }
+    updateGauges();
+}
+
+void RenderService::dispatch(Slot *slot, const Job &job)
+{
+    slot->job = job;
+    ++slot->generation;
+    slot->busy = true;
+    slot->runClock.start();
+
+    const qint64 waitMs = job.queuedAt.elapsed();
+    recordSample(&m_waitSamples, static_cast<double>(waitMs));
+    static MetricsRegistry::Histogram &s_wait = MetricsRegistry::instance().histogram(
+        "webengine_demo_render_service_queue_wait_seconds", "Time render service jobs spent queued.",
+        MetricsRegistry::latencyBuckets());
+    s_wait.observe(waitMs / 1000.0);
+
+    qint64 timeoutMs = m_options.jobTimeoutMs;
+    if (job.deadlineMs > 0) {
+        timeoutMs = qMin(timeoutMs, remainingMs(job));
+    }
+    slot->timeout->start(static_cast<int>(qMax<qint64>(1, timeoutMs)));
+    reply(job.clientId, job.id, QStringLiteral("started"), {{QStringLiteral("waitMs"), waitMs}});
+    slot->loadGeneration = slot->generation;
+    slot->startedGeneration = 0;
+    slot->pane->load(job.url);
+}
+
+void RenderService::handleLoadFinished(Slot *slot, quint64 generation, bool ok)
+{
+    // 每次 load() 只处理一个 loadFinished，页面自身的后续导航不属于任务
+    slot->loadGeneration = 0;
+    slot->startedGeneration = 0;
+    if (!slot->warm) {
+        slot->warm = true;
+        schedule();
+        return;
+    }
+    if (!slot->busy || generation != slot->generation) {
+        return;
+    }
+    if (!ok) {
+        complete(slot, false, QStringLiteral("load failed"));
+        return;
+    }
+    QTimer::singleShot(m_options.settleMs, this, [this, slot, generation]() {
+        execute(slot, generation);
+    });
+}
+
+void RenderService::execute(Slot *slot, quint64 generation)
+{
+    if (!slot->busy || generation != slot->generation || !slot->pane) {
+        return;
+    }
+    QWebEnginePage *page = slot->pane->view()->page();
+    QPointer<RenderService> self(this);
+    // 回调可能在任务超时或取消之后才到达，按 generation 丢弃
+    const auto current = [self, slot, generation]() {
+        return self && slot->busy && generation == slot->generation;
+    };
+
+    switch (slot->job.type) {
+    case JobType::Render:
+        if (slot->job.format == QLatin1String("pdf")) {
+            const QPageLayout layout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF());
+            page->printToPdf(
+                [this, slot, current](const QByteArray &pdf) {
+                    if (!current()) {
+                        return;
+                    }
+                    streamBytes(slot, pdf);
+                    complete(slot, !pdf.isEmpty(), pdf.isEmpty() ? QStringLiteral("printToPdf failed") : QString(),
+                             {{QStringLiteral("bytes"), pdf.size()}});
+                },
+                layout);
+        } else {
+            QByteArray png;
+            QBuffer buffer(&png);
+            buffer.open(QIODevice::WriteOnly);
+            const QPixmap pixmap = slot->pane->view()->grab();
+            const bool saved = !pixmap.isNull() && pixmap.save(&buffer, "PNG");
+            if (saved) {
+                streamBytes(slot, png);
+            }
+            complete(slot, saved, saved ? QString() : QStringLiteral("grab failed"), {{QStringLiteral("bytes"), png.size()}});
+        }
+        return;
+    case JobType::Eval: {
+        // runJavaScript 在脚本抛异常或有语法错误时只回调 null，用 eval 包一层把异常带回来
+        const QString script =
+            QStringLiteral("(function(){try{var v=(0,eval)(%1);return {v:v===undefined?null:v};}"
+                           "catch(e){return {e:String(e&&e.stack||e)};}})()")
+                .arg(jsStringLiteral(slot->job.script));
+        page->runJavaScript(script, [this, slot, current](const QVariant &value) {
+            if (!current()) {
+                return;
+            }
+            const QVariantMap envelope = value.toMap();
+            const auto error = envelope.constFind(QStringLiteral("e"));
+            if (error != envelope.constEnd()) {
+                complete(slot, false, error->toString());
+            } else if (envelope.isEmpty()) {
+                complete(slot, false, QStringLiteral("script did not run"));
+            } else {
+                complete(slot, true, QString(),
+                         {{QStringLiteral("result"), QJsonValue::fromVariant(envelope.value(QStringLiteral("v")))}});
+            }
+        });
+        return;
+    }
+    case JobType::Text:
+        page->toPlainText([this, slot, current](const QString &text) {
+            if (!current()) {
+                return;
+            }
+            int seq = 0;
+            for (int offset = 0; offset < text.size(); offset += kChunkChars) {
+                reply(slot->job.clientId, slot->job.id, QStringLiteral("chunk"),
+                      {{QStringLiteral("seq"), seq++}, {QStringLiteral("text"), text.mid(offset, kChunkChars)}});
+            }
+            complete(slot, true, QString(), {{QStringLiteral("chars"), text.size()}});
+        });
+        return;
+    }
+}
+
+void RenderService::streamBytes(Slot *slot, const QByteArray &bytes)
+{
+    int seq = 0;
+    for (int offset = 0; offset < bytes.size(); offset += kChunkBytes) {
+        reply(slot->job.clientId, slot->job.id, QStringLiteral("chunk"),
+              {{QStringLiteral("seq"), seq++},
+               {QStringLiteral("data"), QString::fromLatin1(bytes.mid(offset, kChunkBytes).toBase64())}});
+    }
+}
+
+void RenderService::complete(Slot *slot, bool ok, const QString &error, const QJsonObject &extra)
+{
+    if (!slot->busy) {
+        return;
+    }
+    slot->timeout->stop();
+    ++slot->generation;
+    slot->busy = false;
+    // 超时或取消时放弃的加载会在 Stop 或下一次 load() 之后以失败结束，这个迟到的信号不属于任何任务
+    slot->loadGeneration = 0;
+    slot->startedGeneration = 0;
+
+    const qint64 runMs = slot->runClock.elapsed();
+    m_busyMs += runMs;
+    recordSample(&m_runSamples, static_cast<double>(runMs));
+    const bool cancelled = error == QLatin1String("cancelled") || error == QLatin1String("client disconnected");
+    const bool expired = error == QLatin1String("deadline exceeded");
+    if (ok) {
+        ++m_counts.completed;
+    } else if (cancelled) {
+        ++m_counts.cancelled;
+    } else if (expired) {
+        ++m_counts.expired;
+    } else {
+        ++m_counts.failed;
+    }
+    countJob(slot->job.type, ok ? "ok" : cancelled ? "cancelled" : expired ? "expired" : "failed");
+
+    QJsonObject fields = extra;
+    fields.insert(QStringLiteral("ok"), ok);
+    fields.insert(QStringLiteral("runMs"), runMs);
+    fields.insert(QStringLiteral("waitMs"), slot->job.queuedAt.elapsed() - runMs);
+    if (!error.isEmpty()) {
+        fields.insert(QStringLiteral("error"), error);
+    }
+    reply(slot->job.clientId, slot->job.id, QStringLiteral("done"), fields);
+    schedule();
+}
+
+void RenderService::reply(quint64 clientId, const QString &jobId, const QString &event, QJsonObject fields)
+{
+    const auto it = m_clients.constFind(clientId);
+    if (it == m_clients.constEnd()) {
+        return;
+    }
+    fields.insert(QStringLiteral("evt"), event);
+    if (!jobId.isEmpty()) {
+        fields.insert(QStringLiteral("id"), jobId);
+    }
+    it->channel->send(fields);
+}
+
+qint64 RenderService::remainingMs(const Job &job) const
+{
+    return job.deadlineMs - job.queuedAt.elapsed();
+}
+
+QJsonObject RenderService::statsObject() const
+{
+    const Stats current = stats();
+    return QJsonObject {{QStringLiteral("poolSize"), current.poolSize},
+                        {QStringLiteral("busySlots"), current.busySlots},
+                        {QStringLiteral("utilization"), current.utilization},
+                        {QStringLiteral("queued"), current.queued},
+                        {QStringLiteral("submitted"), current.submitted},
+                        {QStringLiteral("completed"), current.completed},
+                        {QStringLiteral("failed"), current.failed},
+                        {QStringLiteral("expired"), current.expired},
+                        {QStringLiteral("cancelled"), current.cancelled},
+                        {QStringLiteral("rejected"), current.rejected},
+                        {QStringLiteral("waitP50Ms"), current.waitP50Ms},
+                        {QStringLiteral("waitP95Ms"), current.waitP95Ms},
+                        {QStringLiteral("runP50Ms"), current.runP50Ms},
+                        {QStringLiteral("runP95Ms"), current.runP95Ms}};
+}
+
+void RenderService::updateGauges()
+{
+    static MetricsRegistry::Gauge &s_poolSize =
+        MetricsRegistry::instance().gauge("webengine_demo_render_service_pool_size", "Warm panes in the render service pool.");
+    static MetricsRegistry::Gauge &s_busy =
+        MetricsRegistry::instance().gauge("webengine_demo_render_service_pool_busy", "Render service panes running a job.");
+    static MetricsRegistry::Gauge &s_queued =
+        MetricsRegistry::instance().gauge("webengine_demo_render_service_queued_jobs", "Render service jobs waiting for a pane.");
+    int busy = 0;
+    for (const auto &slot : m_slots) {
+        busy += slot->busy ? 1 : 0;
+    }
+    int queued = 0;
+    for (const Client &client : m_clients) {
+        queued += client.queued;
+    }
+    s_poolSize.set(static_cast<double>(m_slots.size()));
+    s_busy.set(busy);
+    s_queued.set(queued);
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class ProfileRegistry;
+class QLocalServer;
+class QTimer;
+class ShardChannel;
+class WebEnginePane;
+
+// RenderServiceOptions 描述常驻渲染服务模式的命令行参数。
+struct RenderServiceOptions
+{
+    // 本地套接字名称；Linux / macOS 上为 Unix 域套接字，可以是绝对路径
+    QString socketName;
+    int poolSize {4};
+    QSize viewport {1280, 800};
+    int jobTimeoutMs {30000};
+    int settleMs {100};
+    // 每个客户端最多排队的任务数，超出时直接拒绝
+    int maxQueuedPerClient {256};
+
+    // 解析 --render-service 相关参数；未指定 --render-service 时返回 false。
+    static bool fromArguments(const QStringList &arguments, RenderServiceOptions *options, QString *error);
+};
+
+// RenderService 是常驻的无界面渲染服务：客户端经本地套接字提交 render / eval / text 任务，
+// 调度器按优先级、截止时间与客户端轮转把任务分给预热好的离屏 WebEnginePane 池，结果分块流式返回。
+class RenderService final : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class JobType
+    {
+        Render,
+        Eval,
+        Text,
+    };
+
+    struct Stats
+    {
+        int poolSize {0};
+        int busySlots {0};
+        // 自启动以来 pane 处于忙碌状态的时间占比
+        double utilization {0.0};
+        int queued {0};
+        qint64 submitted {0};
+        qint64 completed {0};
+        qint64 failed {0};
+        qint64 expired {0};
+        qint64 cancelled {0};
+        qint64 rejected {0};
+        double waitP50Ms {0.0};
+        double waitP95Ms {0.0};
+        double runP50Ms {0.0};
+        double runP95Ms {0.0};
+    };
+
+    static constexpr int kPriorityLevels = 3;
+
+    explicit RenderService(const RenderServiceOptions &options, QObject *parent = nullptr);
+    ~RenderService() override;
+
+    bool start();
+    Stats stats() const;
+
+private:
+    struct Job
+    {
+        quint64 clientId {0};
+        QString id;
+        JobType type {JobType::Render};
+        QUrl url;
+        QString script;
+        QString format;
+        int priority {1};
+        QElapsedTimer queuedAt;
+        // 相对提交时刻的截止时间，<= 0 表示只受 jobTimeoutMs 限制
+        qint64 deadlineMs {0};
+    };
+
+    struct Client
+    {
+        ShardChannel *channel {nullptr};
+        std::array<std::deque<Job>, kPriorityLevels> queues;
+        int queued {0};
+    };
+
+    struct Slot
+    {
+        QPointer<WebEnginePane> pane;
+        QTimer *timeout {nullptr};
+        Job job;
+        quint64 generation {0};
+        // dispatch() 调用 load() 时的 generation；对应的 loadFinished 处理后或任务放弃时归零
+        quint64 loadGeneration {0};
+        // 收到 loadStarted 时的 loadGeneration：被放弃的上一次导航的 loadFinished 会早于本次 loadStarted 到达
+        quint64 startedGeneration {0};
+        // 预热加载完成后才参与调度
+        bool warm {false};
+        bool busy {false};
+        QElapsedTimer runClock;
+    };
+
+    void handleConnection();
+    void handleCommand(quint64 clientId, const QJsonObject &command);
+    void submit(quint64 clientId, const QJsonObject &command);
+    void cancel(quint64 clientId, const QString &jobId);
+    void dropClient(quint64 clientId);
+    Slot *createSlot();
+    void schedule();
+    bool takeNext(Job *job);
+    void expireQueued();
+    void dispatch(Slot *slot, const Job &job);
+    void handleLoadFinished(Slot *slot, quint64 generation, bool ok);
+    void execute(Slot *slot, quint64 generation);
+    void streamBytes(Slot *slot, const QByteArray &bytes);
+    void complete(Slot *slot, bool ok, const QString &error, const QJsonObject &extra = QJsonObject());
+    void reply(quint64 clientId, const QString &jobId, const QString &event, QJsonObject fields = QJsonObject());
+    qint64 remainingMs(const Job &job) const;
+    QJsonObject statsObject() const;
+    void updateGauges();
+
+    RenderServiceOptions m_options;
+    QLocalServer *m_server {nullptr};
+    ProfileRegistry *m_profiles {nullptr};
+    QTimer *m_expiryTimer {nullptr};
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    QHash<quint64, Client> m_clients;
+    // 每个优先级一个客户端轮转队列，只包含在该优先级有排队任务的客户端
+    std::array<std::deque<quint64>, kPriorityLevels> m_rotation;
+    quint64 m_nextClientId {1};
+    bool m_scheduleQueued {false};
+
+    QElapsedTimer m_uptime;
+    qint64 m_busyMs {0};
+    QVector<double> m_waitSamples;
+    QVector<double> m_runSamples;
+    Stats m_counts;
+};
@@ -0,0 +1,213 @@
+#include "scriptbatchqueue.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QWebEnginePage>
+
+#include <utility>
+
+namespace {
+constexpr int kLatencyWindow = 256;
+} // namespace
+
+ScriptBatchQueue::ScriptBatchQueue(QWebEnginePage *page, QObject *parent)
+    : QObject(parent)
+    , m_page(page)
+{
+    m_latencySamples.reserve(kLatencyWindow);
+    m_throughputClock.start();
+    if (m_page) {
+        const auto nextDocument = [this]() {
+            ++m_document;
+        };
+        ENSURE_QT_CONNECT(m_page, &QWebEnginePage::loadStarted, this, nextDocument);
+        ENSURE_QT_CONNECT(m_page, &QWebEnginePage::renderProcessTerminated, this, nextDocument);
+    }
+}
+
+void ScriptBatchQueue::enqueue(const QString &expression, Callback callback, quint32 worldId)
+{
+    Call call {expression, std::move(callback), QElapsedTimer()};
+    call.queuedAt.start();
+    m_pending[worldId].append(std::move(call));
+    ++m_calls;
+    scheduleFlush();
+}
+
+void ScriptBatchQueue::setMaxBatchSize(int calls)
+{
+    m_maxBatchSize = qMax(1, calls);
+}
+
+ScriptBatchQueue::Metrics ScriptBatchQueue::metrics() const
+{
+    Metrics metrics;
+    metrics.calls = m_calls;
+    metrics.batches = m_batches;
+    metrics.failedCalls = m_failedCalls;
+    metrics.fallbackBatches = m_fallbackBatches;
+    metrics.avgBatchSize = m_batches > 0 ? static_cast<double>(m_completedCalls) / m_batches : 0.0;
+    metrics.latencyP50Ms = MetricsRegistry::percentile(m_latencySamples, 0.50);
+    metrics.latencyP95Ms = MetricsRegistry::percentile(m_latencySamples, 0.95);
+    metrics.latencyMaxMs = m_latencyMaxMs;
+    const double seconds = m_throughputClock.elapsed() / 1000.0;
+    metrics.callsPerSecond = seconds > 0.0 ? m_completedCalls / seconds : 0.0;
+    return metrics;
+}
+
+void ScriptBatchQueue::resetMetrics()
+{
+    m_latencySamples.clear();
+    m_latencyCursor = 0;
+    m_calls = 0;
+    m_completedCalls = 0;
+    m_batches = 0;
+    m_failedCalls = 0;
+    m_fallbackBatches = 0;
+    m_latencyMaxMs = 0.0;
+    m_throughputClock.restart();
+}
+
+void ScriptBatchQueue::flush()
+{
+    m_flushScheduled = false;
+    const auto pending = std::exchange(m_pending, {});
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        const QVector<Call> &calls = it.value();
+        for (int offset = 0; offset < calls.size(); offset += m_maxBatchSize) {
+            runBatch(it.key(), calls.mid(offset, m_maxBatchSize));
+        }
+    }
+}
+
+void ScriptBatchQueue::scheduleFlush()
+{
+    if (m_flushScheduled) {
+        return;
+    }
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, &ScriptBatchQueue::flush);
+}
+
+void ScriptBatchQueue::runBatch(quint32 worldId, QVector<Call> calls)
+{
+    if (!m_page) {
+        for (Call &call : calls) {
+            complete(call, QVariant(), QStringLiteral("page destroyed"));
+        }
+        return;
+    }
+    ++m_batches;
+    if (calls.size() == 1) {
+        runIndividually(worldId, std::move(calls));
+        return;
+    }
+
+    const int expected = calls.size();
+    const quint64 document = m_document;
+    QPointer<ScriptBatchQueue> self(this);
+    m_page->runJavaScript(buildScript(calls), worldId, [self, worldId, calls, expected, document](const QVariant &value) mutable {
+        if (!self) {
+            return;
+        }
+        if (value.userType() != QMetaType::QVariantList) {
+            if (document != self->m_document) {
+                // 页面已导航或渲染进程退出，无法确定这批调用是否执行过，不能重跑
+                for (Call &call : calls) {
+                    self->complete(call, QVariant(), QStringLiteral("page navigated"));
+                }
+                return;
+            }
+            // 语法错误无法被 try/catch 捕获，整批脚本一句都没有执行；退回到逐个执行，只让出错的那个调用失败
+            ++self->m_fallbackBatches;
+            qWarning() << "ScriptBatchQueue: batch of" << expected << "calls did not parse, retrying individually";
+            self->runIndividually(worldId, std::move(calls));
+            return;
+        }
+        const QVariantList results = value.toList();
+        if (results.size() != expected) {
+            // 脚本已经执行，只是结果无法对应，不重跑
+            for (Call &call : calls) {
+                self->complete(call, QVariant(), QStringLiteral("malformed batch result"));
+            }
+            return;
+        }
+        for (int i = 0; i < expected; ++i) {
+            const QVariantMap entry = results.at(i).toMap();
+            const auto error = entry.constFind(QStringLiteral("e"));
+            if (error != entry.constEnd()) {
+                self->complete(calls[i], QVariant(), error->toString());
+            } else {
+                self->complete(calls[i], entry.value(QStringLiteral("v")), QString());
+            }
+        }
+    });
+}
+
+void ScriptBatchQueue::runIndividually(quint32 worldId, QVector<Call> calls)
+{
+    if (!m_page) {
+        for (Call &call : calls) {
+            complete(call, QVariant(), QStringLiteral("page destroyed"));
+        }
+        return;
+    }
+    QPointer<ScriptBatchQueue> self(this);
+    for (Call &call : calls) {
+        const QString script =
+            QStringLiteral("(function(){try{var __qtValue=(%1);return {v:__qtValue===undefined?null:__qtValue};}"
+                           "catch(e){return {e:String(e&&e.stack||e)};}})()")
+                .arg(call.expression);
+        m_page->runJavaScript(script, worldId, [self, call](const QVariant &value) mutable {
+            if (!self) {
+                return;
+            }
+            const QVariantMap entry = value.toMap();
+            const auto error = entry.constFind(QStringLiteral("e"));
+            if (error != entry.constEnd()) {
+                self->complete(call, QVariant(), error->toString());
+            } else if (entry.isEmpty()) {
+                self->complete(call, QVariant(), QStringLiteral("script did not run (syntax error or page navigated)"));
+            } else {
+                self->complete(call, entry.value(QStringLiteral("v")), QString());
+            }
+        });
+    }
+}
+
+void ScriptBatchQueue::complete(Call &call, const QVariant &result, const QString &error)
+{
+    const double latencyMs = call.queuedAt.nsecsElapsed() / 1e6;
+    if (m_latencySamples.size() < kLatencyWindow) {
+        m_latencySamples.append(latencyMs);
+    } else {
+        m_latencySamples[m_latencyCursor] = latencyMs;
+        m_latencyCursor = (m_latencyCursor + 1) % kLatencyWindow;
+    }
+    m_latencyMaxMs = qMax(m_latencyMaxMs, latencyMs);
+    ++m_completedCalls;
+    if (!error.isEmpty()) {
+        ++m_failedCalls;
+    }
+    if (call.callback) {
+        call.callback(result, error);
+    }
+}
+
+QString ScriptBatchQueue::buildScript(const QVector<Call> &calls)
+{
+    // 每个表达式单独 try/catch，undefined 统一转成 null，保证结果数组与调用一一对应
+    QString script = QStringLiteral("(function(){var __qtResults=[];\n");
+    for (const Call &call : calls) {
+        script += QStringLiteral("try{var __qtValue=(%1);__qtResults.push({v:__qtValue===undefined?null:__qtValue});}"
+                                 "catch(e){__qtResults.push({e:String(e&&e.stack||e)});}\n")
+                      .arg(call.expression);
+    }
+    script += QStringLiteral("return __qtResults;})()");
+    return script;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <QWebEngineScript>
+
+#include <functional>
+
+class QWebEnginePage;
+
+// ScriptBatchQueue 把同一轮事件循环内的多次 runJavaScript 合并成一段脚本执行：
+// 每个调用包在独立的 try/catch 中，结果数组按序分发回各自的回调，并统计延迟与吞吐。
+class ScriptBatchQueue final : public QObject
+{
+    Q_OBJECT
+
+public:
+    // error 非空表示该表达式抛出了异常或整批执行失败
+    using Callback = std::function<void(const QVariant &result, const QString &error)>;
+
+    struct Metrics
+    {
+        qint64 calls {0};
+        qint64 batches {0};
+        qint64 failedCalls {0};
+        qint64 fallbackBatches {0};
+        double avgBatchSize {0.0};
+        double latencyP50Ms {0.0};
+        double latencyP95Ms {0.0};
+        double latencyMaxMs {0.0};
+        double callsPerSecond {0.0};
+    };
+
+    explicit ScriptBatchQueue(QWebEnginePage *page, QObject *parent = nullptr);
+
+    // expression 必须是单个 JavaScript 表达式，返回值需可被 runJavaScript 转换
+    void enqueue(const QString &expression, Callback callback = Callback(),
+                 quint32 worldId = QWebEngineScript::MainWorld);
+    void setMaxBatchSize(int calls);
+    Metrics metrics() const;
+    void resetMetrics();
+
+public slots:
+    void flush();
+
+private:
+    struct Call
+    {
+        QString expression;
+        Callback callback;
+        QElapsedTimer queuedAt;
+    };
+
+    void scheduleFlush();
+    void runBatch(quint32 worldId, QVector<Call> calls);
+    void runIndividually(quint32 worldId, QVector<Call> calls);
+    void complete(Call &call, const QVariant &result, const QString &error);
+    static QString buildScript(const QVector<Call> &calls);
+
+    QPointer<QWebEnginePage> m_page;
+    // 每次导航或渲染进程退出时递增，用来判断一批脚本的结果丢失是否因为文档已经换掉
+    quint64 m_document {0};
+    QHash<quint32, QVector<Call>> m_pending;
+    bool m_flushScheduled {false};
+    int m_maxBatchSize {64};
+
+    QElapsedTimer m_throughputClock;
+    QVector<double> m_latencySamples;
+    int m_latencyCursor {0};
+    qint64 m_calls {0};
+    qint64 m_completedCalls {0};
+    qint64 m_batches {0};
+    qint64 m_failedCalls {0};
+    qint64 m_fallbackBatches {0};
+    double m_latencyMaxMs {0.0};
+};
@@ -0,0 +1,361 @@
+#include "shardbroker.h"
+
+#include "connectguard.h"
+#include "metricsregistry.h"
+#include "shardchannel.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr int kInitialBackoffMs = 500;
+constexpr int kMaxBackoffMs = 10000;
+// worker 稳定运行超过该时长后，下一次崩溃重新从最短退避开始
+constexpr int kStableUptimeMs = 60000;
+constexpr int kStopTimeoutMs = 5000;
+
+MetricsRegistry::Counter &restartsCounter()
+{
+    static MetricsRegistry::Counter &s_counter =
+        MetricsRegistry::instance().counter("webengine_demo_shard_restarts_total", "Shard worker processes restarted after a crash.");
+    return s_counter;
+}
+} // namespace
+
+ShardBroker::ShardBroker(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    m_options.shards = qMax(1, m_options.shards);
+    if (m_options.program.isEmpty()) {
+        m_options.program = QCoreApplication::applicationFilePath();
+    }
+    m_serverName = QStringLiteral("webengine-demo-shards-%1").arg(QCoreApplication::applicationPid());
+}
+
+ShardBroker::~ShardBroker()
+{
+    stop();
+}
+
+bool ShardBroker::start()
+{
+    if (m_server) {
+        return true;
+    }
+    QLocalServer::removeServer(m_serverName);
+    m_server = new QLocalServer(this);
+    // 只允许同一用户的进程连接
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(m_serverName)) {
+        qWarning() << "ShardBroker: cannot listen on" << m_serverName << m_server->errorString();
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    ENSURE_QT_CONNECT(m_server, &QLocalServer::newConnection, this, &ShardBroker::handleConnection);
+
+    m_shards.resize(m_options.shards);
+    for (int i = 0; i < m_shards.size(); ++i) {
+        m_shards[i].index = i;
+        m_shards[i].backoffMs = kInitialBackoffMs;
+        launch(i);
+    }
+    m_stats.shards = m_shards.size();
+    qInfo() << "ShardBroker: started" << m_shards.size() << "workers on" << m_server->fullServerName();
+    return true;
+}
+
+void ShardBroker::stop()
+{
+    if (m_stopping || !m_server) {
+        return;
+    }
+    m_stopping = true;
+    for (Shard &shard : m_shards) {
+        if (shard.channel) {
+            shard.channel->send(QJsonObject {{QStringLiteral("cmd"), QStringLiteral("quit")}});
+            shard.channel->socket()->flush();
+        }
+    }
+    for (Shard &shard : m_shards) {
+        if (!shard.process) {
+            continue;
+        }
+        if (!shard.process->waitForFinished(kStopTimeoutMs)) {
+            qWarning() << "ShardBroker: worker" << shard.index << "did not exit, killing it";
+            shard.process->kill();
+            shard.process->waitForFinished();
+        }
+        delete shard.process;
+        shard.process = nullptr;
+    }
+    m_server->close();
+}
+
+int ShardBroker::openPane(const QUrl &url, const QJsonObject &scripts)
+{
+    const int shard = leastLoadedShard();
+    if (shard < 0) {
+        qWarning() << "ShardBroker: no running worker for" << url;
+        return 0;
+    }
+    Pane pane;
+    pane.id = m_nextPaneId++;
+    pane.shard = shard;
+    pane.url = url;
+    pane.scripts = scripts;
+    m_panes.insert(pane.id, pane);
+    ++m_stats.panes;
+    // 未就绪的 worker 会在 hello 之后统一打开分配给它的 pane
+    if (m_shards.at(pane.shard).ready) {
+        sendToShard(pane.shard, openCommand(pane));
+    }
+    return pane.id;
+}
+
+bool ShardBroker::sendToPane(int paneId, const QString &payload)
+{
+    const auto it = m_panes.constFind(paneId);
+    if (it == m_panes.constEnd()) {
+        return false;
+    }
+    ++m_stats.messagesToPages;
+    return sendToShard(it->shard, QJsonObject {{QStringLiteral("cmd"), QStringLiteral("send")},
+                                               {QStringLiteral("pane"), paneId},
+                                               {QStringLiteral("payload"), payload}});
+}
+
+int ShardBroker::broadcast(const QString &payload)
+{
+    int sent = 0;
+    for (const int paneId : m_panes.keys()) {
+        if (sendToPane(paneId, payload)) {
+            ++sent;
+        }
+    }
+    return sent;
+}
+
+void ShardBroker::closePane(int paneId)
+{
+    const auto it = m_panes.find(paneId);
+    if (it == m_panes.end()) {
+        return;
+    }
+    const int shard = it->shard;
+    m_panes.erase(it);
+    --m_stats.panes;
+    sendToShard(shard, QJsonObject {{QStringLiteral("cmd"), QStringLiteral("close")}, {QStringLiteral("pane"), paneId}});
+}
+
+int ShardBroker::shardOf(int paneId) const
+{
+    return m_panes.value(paneId).shard;
+}
+
+QList<int> ShardBroker::paneIds() const
+{
+    return m_panes.keys();
+}
+
+ShardBroker::Stats ShardBroker::stats() const
+{
+    Stats stats = m_stats;
+    stats.readyShards = static_cast<int>(std::count_if(m_shards.cbegin(), m_shards.cend(), [](const Shard &shard) {
+        return shard.ready;
+    }));
+    return stats;
+}
+
+void ShardBroker::launch(int index)
+{
+    Shard &shard = m_shards[index];
+    // 退避期间缓存的命令保留到新 worker 就绪后再发送
+    shard.ready = false;
+    delete shard.process;
+    shard.process = new QProcess(this);
+    shard.process->setProcessEnvironment(m_options.environment);
+    shard.process->setProcessChannelMode(QProcess::ForwardedChannels);
+    ENSURE_QT_CONNECT(shard.process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), this,
+                      [this, index](int exitCode, QProcess::ExitStatus status) {
+                          handleExit(index, exitCode, status == QProcess::CrashExit);
+                      });
+
+    QStringList arguments {QStringLiteral("--shard-worker"), m_serverName, QStringLiteral("--shard-index"), QString::number(index)};
+    arguments += m_options.extraArguments;
+    shard.uptime.start();
+    shard.process->start(m_options.program, arguments);
+}
+
+void ShardBroker::handleConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        auto *channel = new ShardChannel(socket, this);
+        // 第一帧必须是 hello，之后才知道它属于哪个分片
+        ENSURE_QT_CONNECT(channel, &ShardChannel::received, this, [this, channel](const QJsonObject &message) {
+            handleHello(channel, message);
+        });
+        ENSURE_QT_CONNECT(channel, &ShardChannel::disconnected, channel, &QObject::deleteLater);
+    }
+}
+
+void ShardBroker::handleHello(ShardChannel *channel, const QJsonObject &message)
+{
+    const int index = message.value(QStringLiteral("shard")).toInt(-1);
+    if (message.value(QStringLiteral("evt")).toString() != QLatin1String("hello") || index < 0 || index >= m_shards.size()) {
+        qWarning() << "ShardBroker: unexpected first frame from worker, closing connection";
+        channel->socket()->abort();
+        return;
+    }
+    disconnect(channel, &ShardChannel::received, this, nullptr);
+    ENSURE_QT_CONNECT(channel, &ShardChannel::received, this, [this, index](const QJsonObject &event) {
+        handleEvent(index, event);
+    });
+
+    Shard &shard = m_shards[index];
+    if (shard.channel && shard.channel != channel) {
+        shard.channel->deleteLater();
+    }
+    shard.channel = channel;
+    shard.ready = true;
+    qInfo() << "ShardBroker: worker" << index << "ready, pid" << message.value(QStringLiteral("pid")).toVariant().toLongLong();
+
+    // 先恢复（或首次打开）分配给该分片的 pane，再发送就绪前缓存的命令
+    for (const Pane &pane : std::as_const(m_panes)) {
+        if (pane.shard == index) {
+            channel->send(openCommand(pane));
+        }
+    }
+    const QList<QJsonObject> pending = std::exchange(shard.pending, {});
+    for (const QJsonObject &command : pending) {
+        channel->send(command);
+    }
+
+    emit shardReady(index);
+    if (!m_allReadyReported && stats().readyShards == m_shards.size()) {
+        m_allReadyReported = true;
+        emit allShardsReady();
+    }
+}
+
+void ShardBroker::handleEvent(int shard, const QJsonObject &message)
+{
+    const QString event = message.value(QStringLiteral("evt")).toString();
+    const int paneId = message.value(QStringLiteral("pane")).toInt();
+    if (event == QLatin1String("message")) {
+        ++m_stats.messagesFromPages;
+        emit paneMessage(paneId, message.value(QStringLiteral("payload")).toString());
+    } else if (event == QLatin1String("loaded")) {
+        emit paneLoaded(paneId, message.value(QStringLiteral("ok")).toBool());
+    } else if (event == QLatin1String("closed")) {
+        // 用户在 worker 中关闭了窗口，之后不再随重启恢复
+        if (m_panes.remove(paneId) > 0) {
+            --m_stats.panes;
+            emit paneClosed(paneId);
+        }
+    } else {
+        qWarning() << "ShardBroker: unknown event" << event << "from worker" << shard;
+    }
+}
+
+void ShardBroker::handleExit(int index, int exitCode, bool crashed)
+{
+    Shard &shard = m_shards[index];
+    shard.ready = false;
+    if (m_stopping) {
+        return;
+    }
+    if (!crashed && exitCode == 0) {
+        qInfo() << "ShardBroker: worker" << index << "exited";
+        shard.done = true;
+        for (auto it = m_panes.begin(); it != m_panes.end();) {
+            if (it->shard == index) {
+                const int paneId = it.key();
+                it = m_panes.erase(it);
+                --m_stats.panes;
+                emit paneClosed(paneId);
+            } else {
+                ++it;
+            }
+        }
+        const bool allDone = std::all_of(m_shards.cbegin(), m_shards.cend(), [](const Shard &candidate) {
+            return candidate.done;
+        });
+        if (allDone) {
+            emit finished();
+        }
+        return;
+    }
+
+    qWarning() << "ShardBroker: worker" << index << (crashed ? "crashed" : "failed") << "with exit code" << exitCode;
+    emit shardCrashed(index, exitCode);
+    if (!m_options.restartOnCrash) {
+        shard.done = true;
+        return;
+    }
+    if (shard.uptime.elapsed() >= kStableUptimeMs) {
+        shard.backoffMs = kInitialBackoffMs;
+    }
+    const int delayMs = shard.backoffMs;
+    shard.backoffMs = qMin(kMaxBackoffMs, shard.backoffMs * 2);
+    QTimer::singleShot(delayMs, this, [this, index]() {
+        if (m_stopping) {
+            return;
+        }
+        ++m_stats.restarts;
+        restartsCounter().increment();
+        launch(index);
+        emit shardRestarted(index);
+    });
+}
+
+bool ShardBroker::sendToShard(int index, const QJsonObject &command)
+{
+    Shard &shard = m_shards[index];
+    if (shard.ready && shard.channel && shard.channel->send(command)) {
+        return true;
+    }
+    if (shard.done) {
+        return false;
+    }
+    if (shard.pending.size() >= m_options.maxPendingCommands) {
+        shard.pending.removeFirst();
+        ++m_stats.droppedCommands;
+    }
+    shard.pending.append(command);
+    return true;
+}
+
+QJsonObject ShardBroker::openCommand(const Pane &pane) const
+{
+    return QJsonObject {{QStringLiteral("cmd"), QStringLiteral("open")},
+                        {QStringLiteral("pane"), pane.id},
+                        {QStringLiteral("url"), pane.url.toString()},
+                        {QStringLiteral("scripts"), pane.scripts}};
+}
+
+int ShardBroker::leastLoadedShard() const
+{
+    QVector<int> load(m_shards.size(), 0);
+    for (const Pane &pane : m_panes) {
+        ++load[pane.shard];
+    }
+    int best = -1;
+    for (int i = 0; i < m_shards.size(); ++i) {
+        if (m_shards.at(i).done) {
+            continue;
+        }
+        if (best < 0 || load.at(i) < load.at(best)) {
+            best = i;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+class QLocalServer;
+class QProcess;
+class ShardChannel;
+
+// ShardBroker 是分片模式下的轻量调度进程：拉起 K 个 worker（同一可执行文件的 --shard-worker 模式），
+// 把 pane 分配到负载最低的 worker，经本地 socket 转发命令与 bridge 消息；worker 异常退出时按退避重启并重新打开它的 pane。
+class ShardBroker final : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int shards {2};
+        // 为空时使用当前可执行文件
+        QString program;
+        QStringList extraArguments;
+        QProcessEnvironment environment {QProcessEnvironment::systemEnvironment()};
+        bool restartOnCrash {true};
+        // worker 未就绪期间每个分片最多缓存的命令数，超出时丢弃最早的
+        int maxPendingCommands {10000};
+    };
+
+    struct Stats
+    {
+        int shards {0};
+        int readyShards {0};
+        int panes {0};
+        qint64 messagesToPages {0};
+        qint64 messagesFromPages {0};
+        qint64 droppedCommands {0};
+        int restarts {0};
+    };
+
+    explicit ShardBroker(const Options &options, QObject *parent = nullptr);
+    ~ShardBroker() override;
+
+    bool start();
+    // 通知全部 worker 退出，超时后强制结束
+    void stop();
+
+    // 返回全局唯一的 pane id，全部 worker 都已退出时返回 0 且不打开；
+    // scripts 为 名称 -> 源码，在 worker 中安装为用户脚本，重启后同样恢复
+    int openPane(const QUrl &url, const QJsonObject &scripts = QJsonObject());
+    bool sendToPane(int paneId, const QString &payload);
+    int broadcast(const QString &payload);
+    void closePane(int paneId);
+    int shardOf(int paneId) const;
+    QList<int> paneIds() const;
+    Stats stats() const;
+
+signals:
+    void shardReady(int shard);
+    void allShardsReady();
+    void shardCrashed(int shard, int exitCode);
+    void shardRestarted(int shard);
+    void paneLoaded(int paneId, bool ok);
+    void paneMessage(int paneId, const QString &payload);
+    void paneClosed(int paneId);
+    // 全部 worker 都已正常退出
+    void finished();
+
+private:
+    struct Pane
+    {
+        int id {0};
+        int shard {0};
+        QUrl url;
+        QJsonObject scripts;
+    };
+
+    struct Shard
+    {
+        int index {0};
+        QProcess *process {nullptr};
+        QPointer<ShardChannel> channel;
+        QList<QJsonObject> pending;
+        QElapsedTimer uptime;
+        int backoffMs {0};
+        bool ready {false};
+        bool done {false};
+    };
+
+    void launch(int shard);
+    void handleConnection();
+    void handleHello(ShardChannel *channel, const QJsonObject &message);
+    void handleEvent(int shard, const QJsonObject &message);
+    void handleExit(int shard, int exitCode, bool crashed);
+    bool sendToShard(int shard, const QJsonObject &command);
+    QJsonObject openCommand(const Pane &pane) const;
+    // 不计已退出的 worker；全部退出时返回 -1
+    int leastLoadedShard() const;
+
+    Options m_options;
+    QString m_serverName;
+    QLocalServer *m_server {nullptr};
+    QVector<Shard> m_shards;
+    QMap<int, Pane> m_panes;
+    int m_nextPaneId {1};
+    bool m_stopping {false};
+    bool m_allReadyReported {false};
+    Stats m_stats;
+};
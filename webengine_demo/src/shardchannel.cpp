@@ -0,0 +1,84 @@
+#include "shardchannel.h"
+
+#include "connectguard.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QtEndian>
+
+namespace {
+constexpr int kHeaderBytes = 4;
+} // namespace
+
+ShardChannel::ShardChannel(QLocalSocket *socket, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+{
+    Q_ASSERT(m_socket);
+    m_socket->setParent(this);
+    ENSURE_QT_CONNECT(m_socket, &QLocalSocket::readyRead, this, &ShardChannel::readFrames);
+    ENSURE_QT_CONNECT(m_socket, &QLocalSocket::disconnected, this, &ShardChannel::disconnected);
+}
+
+QLocalSocket *ShardChannel::socket() const
+{
+    return m_socket;
+}
+
+bool ShardChannel::isConnected() const
+{
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+bool ShardChannel::send(const QJsonObject &message)
+{
+    if (!isConnected()) {
+        return false;
+    }
+    const QByteArray body = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    if (body.size() > kMaxFrameBytes) {
+        qWarning() << "ShardChannel: dropping oversized frame of" << body.size() << "bytes";
+        return false;
+    }
+    QByteArray frame(kHeaderBytes, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(body.size()), frame.data());
+    frame += body;
+    m_socket->write(frame);
+    ++m_framesSent;
+    return true;
+}
+
+void ShardChannel::readFrames()
+{
+    m_buffer += m_socket->readAll();
+    // 一次 readyRead 可能带来多帧，也可能只有半帧；接收方可能在处理帧时销毁本对象
+    const QPointer<ShardChannel> self(this);
+    int offset = 0;
+    while (m_buffer.size() - offset >= kHeaderBytes) {
+        const quint32 length = qFromBigEndian<quint32>(m_buffer.constData() + offset);
+        if (length > static_cast<quint32>(kMaxFrameBytes)) {
+            qWarning() << "ShardChannel: frame of" << length << "bytes exceeds the limit, closing connection";
+            m_buffer.clear();
+            m_socket->abort();
+            return;
+        }
+        if (m_buffer.size() - offset - kHeaderBytes < static_cast<int>(length)) {
+            break;
+        }
+        const QJsonDocument document =
+            QJsonDocument::fromJson(QByteArray::fromRawData(m_buffer.constData() + offset + kHeaderBytes, static_cast<int>(length)));
+        offset += kHeaderBytes + static_cast<int>(length);
+        ++m_framesReceived;
+        if (document.isObject()) {
+            emit received(document.object());
+            if (!self) {
+                return;
+            }
+        } else {
+            qWarning() << "ShardChannel: ignoring malformed frame";
+        }
+    }
+    m_buffer.remove(0, offset);
+}
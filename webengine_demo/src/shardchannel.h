@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QObject>
+
+class QLocalSocket;
+
+// ShardChannel 在 QLocalSocket 上收发分片协议帧：4 字节大端长度 + 紧凑 JSON 对象。
+// 分片 broker 与 worker 两端、渲染服务与其客户端共用；超长帧视为协议错误并断开连接。
+class ShardChannel final : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxFrameBytes = 16 * 1024 * 1024;
+
+    // 接管 socket 的所有权
+    explicit ShardChannel(QLocalSocket *socket, QObject *parent = nullptr);
+
+    QLocalSocket *socket() const;
+    bool isConnected() const;
+    bool send(const QJsonObject &message);
+    qint64 framesSent() const { return m_framesSent; }
+    qint64 framesReceived() const { return m_framesReceived; }
+
+signals:
+    void received(const QJsonObject &message);
+    void disconnected();
+
+private:
+    void readFrames();
+
+    QLocalSocket *m_socket {nullptr};
+    QByteArray m_buffer;
+    qint64 m_framesSent {0};
+    qint64 m_framesReceived {0};
+};
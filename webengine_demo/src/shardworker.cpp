@@ -0,0 +1,156 @@
+#include "shardworker.h"
+
+#include "connectguard.h"
+#include "profileregistry.h"
+#include "shardchannel.h"
+#include "userscriptregistry.h"
+#include "webbridge.h"
+#include "webenginepane.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QLocalSocket>
+#include <QUrl>
+
+#include <utility>
+
+namespace {
+constexpr int kConnectTimeoutMs = 5000;
+} // namespace
+
+ShardWorker::ShardWorker(const QString &serverName, int shardIndex, QObject *parent)
+    : QObject(parent)
+    , m_serverName(serverName)
+    , m_shardIndex(shardIndex)
+{
+    m_profiles = new ProfileRegistry(this);
+}
+
+ShardWorker::~ShardWorker()
+{
+    // pane 必须先于 ProfileRegistry 中的 profile 销毁
+    m_shuttingDown = true;
+    const auto panes = m_panes;
+    for (const QPointer<WebEnginePane> &pane : panes) {
+        delete pane.data();
+    }
+}
+
+bool ShardWorker::fromArguments(const QStringList &arguments, QString *serverName, int *shardIndex)
+{
+    const int serverAt = arguments.indexOf(QStringLiteral("--shard-worker"));
+    if (serverAt < 0 || serverAt + 1 >= arguments.size()) {
+        return false;
+    }
+    *serverName = arguments.at(serverAt + 1);
+    const int indexAt = arguments.indexOf(QStringLiteral("--shard-index"));
+    *shardIndex = indexAt >= 0 ? arguments.value(indexAt + 1).toInt() : 0;
+    return true;
+}
+
+bool ShardWorker::start()
+{
+    auto *socket = new QLocalSocket;
+    socket->connectToServer(m_serverName);
+    if (!socket->waitForConnected(kConnectTimeoutMs)) {
+        qWarning() << "ShardWorker: cannot connect to broker" << m_serverName << socket->errorString();
+        delete socket;
+        return false;
+    }
+    m_channel = new ShardChannel(socket, this);
+    ENSURE_QT_CONNECT(m_channel, &ShardChannel::received, this, &ShardWorker::handleCommand);
+    // broker 退出后 worker 没有存在的意义
+    ENSURE_QT_CONNECT(m_channel, &ShardChannel::disconnected, this, [this]() {
+        if (!m_shuttingDown) {
+            qWarning() << "ShardWorker: broker disconnected, shard" << m_shardIndex << "exiting";
+            shutdown(0);
+        }
+    });
+    m_channel->send(QJsonObject {{QStringLiteral("evt"), QStringLiteral("hello")},
+                                 {QStringLiteral("shard"), m_shardIndex},
+                                 {QStringLiteral("pid"), QCoreApplication::applicationPid()}});
+    qInfo() << "ShardWorker: shard" << m_shardIndex << "connected to" << m_serverName;
+    return true;
+}
+
+void ShardWorker::handleCommand(const QJsonObject &command)
+{
+    const QString name = command.value(QStringLiteral("cmd")).toString();
+    const int paneId = command.value(QStringLiteral("pane")).toInt();
+    if (name == QLatin1String("send")) {
+        if (WebEnginePane *pane = m_panes.value(paneId)) {
+            pane->broadcastToPage(command.value(QStringLiteral("payload")).toString());
+        }
+    } else if (name == QLatin1String("open")) {
+        openPane(paneId, QUrl(command.value(QStringLiteral("url")).toString()), command.value(QStringLiteral("scripts")).toObject());
+    } else if (name == QLatin1String("load")) {
+        if (WebEnginePane *pane = m_panes.value(paneId)) {
+            pane->load(QUrl(command.value(QStringLiteral("url")).toString()));
+        }
+    } else if (name == QLatin1String("close")) {
+        closePane(paneId);
+    } else if (name == QLatin1String("quit")) {
+        shutdown(0);
+    } else {
+        qWarning() << "ShardWorker: unknown command" << name;
+    }
+}
+
+void ShardWorker::openPane(int paneId, const QUrl &url, const QJsonObject &scripts)
+{
+    // broker 在重连后会重发 open，已存在的 pane 保持不变
+    if (paneId <= 0 || m_panes.value(paneId)) {
+        return;
+    }
+    // 各 worker 进程不能共用同一个 profile 目录
+    SharedProfile *profile = m_profiles->acquire(QStringLiteral("%1-shard%2").arg(ProfileRegistry::kDefaultProfileName).arg(m_shardIndex));
+    auto *pane = new WebEnginePane(new BasicBridge, nullptr, profile);
+    pane->setAttribute(Qt::WA_DeleteOnClose);
+    pane->setWindowTitle(tr("分片 %1 - 页面 %2").arg(m_shardIndex).arg(paneId));
+    pane->resize(1024, 768);
+    for (auto it = scripts.constBegin(); it != scripts.constEnd(); ++it) {
+        pane->userScripts()->install(it.key(), it.value().toString());
+    }
+    m_panes.insert(paneId, pane);
+
+    ENSURE_QT_CONNECT(pane, &WebEnginePane::messageFromJs, this, [this, paneId](const QString &payload) {
+        m_channel->send(QJsonObject {{QStringLiteral("evt"), QStringLiteral("message")},
+                                     {QStringLiteral("pane"), paneId},
+                                     {QStringLiteral("payload"), payload}});
+    });
+    ENSURE_QT_CONNECT(pane, &WebEnginePane::loadFinished, this, [this, paneId](bool ok) {
+        m_channel->send(QJsonObject {{QStringLiteral("evt"), QStringLiteral("loaded")},
+                                     {QStringLiteral("pane"), paneId},
+                                     {QStringLiteral("ok"), ok}});
+    });
+    ENSURE_QT_CONNECT(pane, &QObject::destroyed, this, [this, paneId]() {
+        m_panes.remove(paneId);
+        if (!m_shuttingDown) {
+            m_channel->send(QJsonObject {{QStringLiteral("evt"), QStringLiteral("closed")}, {QStringLiteral("pane"), paneId}});
+        }
+    });
+
+    pane->load(url);
+    pane->show();
+}
+
+void ShardWorker::closePane(int paneId)
+{
+    if (WebEnginePane *pane = m_panes.take(paneId)) {
+        pane->deleteLater();
+    }
+}
+
+void ShardWorker::shutdown(int exitCode)
+{
+    if (m_shuttingDown) {
+        return;
+    }
+    m_shuttingDown = true;
+    for (const QPointer<WebEnginePane> &pane : std::as_const(m_panes)) {
+        if (pane) {
+            pane->deleteLater();
+        }
+    }
+    emit finished(exitCode);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+
+class ProfileRegistry;
+class ShardChannel;
+class WebEnginePane;
+
+// ShardWorker 运行在分片模式的 worker 进程中：连接 broker 的本地 socket，按命令创建 / 关闭 WebEnginePane，
+// 把 send 命令转给 pane 的 bridge，并把页面消息与加载结果回报给 broker；worker 内的 pane 共用一个按分片命名的 profile。
+class ShardWorker final : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShardWorker(const QString &serverName, int shardIndex, QObject *parent = nullptr);
+    ~ShardWorker() override;
+
+    // 解析 --shard-worker <服务名> --shard-index <n>；不是 worker 模式时返回 false
+    static bool fromArguments(const QStringList &arguments, QString *serverName, int *shardIndex);
+
+    bool start();
+    int shardIndex() const { return m_shardIndex; }
+
+signals:
+    void finished(int exitCode);
+
+private:
+    void handleCommand(const QJsonObject &command);
+    void openPane(int paneId, const QUrl &url, const QJsonObject &scripts);
+    void closePane(int paneId);
+    void shutdown(int exitCode);
+
+    QString m_serverName;
+    int m_shardIndex {0};
+    ShardChannel *m_channel {nullptr};
+    ProfileRegistry *m_profiles {nullptr};
+    QHash<int, QPointer<WebEnginePane>> m_panes;
+    bool m_shuttingDown {false};
+};
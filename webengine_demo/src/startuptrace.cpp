@@ -0,0 +1,133 @@
+#include "startuptrace.h"
+
+#include "tracerecorder.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace {
+struct TraceState
+{
+    QElapsedTimer clock;
+    QVector<StartupTrace::Phase> phases;
+    QString exportPath;
+    // 进程入口在 TraceRecorder 时钟上的位置，用于把各阶段写成 trace 中的 span
+    qint64 traceOriginNs {0};
+    bool finished {false};
+};
+
+TraceState &state()
+{
+    static TraceState s_state;
+    return s_state;
+}
+
+double toMs(qint64 ns)
+{
+    return ns / 1e6;
+}
+} // namespace
+
+void StartupTrace::begin()
+{
+    auto &trace = state();
+    if (trace.clock.isValid()) {
+        return;
+    }
+    trace.clock.start();
+    trace.traceOriginNs = TraceRecorder::nowNs();
+    trace.phases.append({QStringLiteral("process-entry"), 0});
+}
+
+void StartupTrace::mark(const QString &phase)
+{
+    markAt(phase, elapsedNs());
+}
+
+void StartupTrace::markAt(const QString &phase, qint64 atNs)
+{
+    auto &trace = state();
+    if (trace.finished || !trace.clock.isValid()) {
+        return;
+    }
+    trace.phases.append({phase, atNs});
+}
+
+qint64 StartupTrace::elapsedNs()
+{
+    const auto &trace = state();
+    return trace.clock.isValid() ? trace.clock.nsecsElapsed() : 0;
+}
+
+qint64 StartupTrace::phaseNs(const QString &phase)
+{
+    const auto &phases = state().phases;
+    const auto found = std::find_if(phases.cbegin(), phases.cend(), [&phase](const Phase &entry) {
+        return entry.name == phase;
+    });
+    return found != phases.cend() ? found->atNs : -1;
+}
+
+QVector<StartupTrace::Phase> StartupTrace::phases()
+{
+    return state().phases;
+}
+
+void StartupTrace::setExportPath(const QString &path)
+{
+    state().exportPath = path;
+}
+
+void StartupTrace::finish()
+{
+    auto &trace = state();
+    if (trace.finished || !trace.clock.isValid()) {
+        return;
+    }
+    trace.finished = true;
+
+    // markAt 允许回填（例如由页面 FCP 推算的时间点），输出前按时间排序
+    std::stable_sort(trace.phases.begin(), trace.phases.end(), [](const Phase &lhs, const Phase &rhs) {
+        return lhs.atNs < rhs.atNs;
+    });
+
+    QJsonArray entries;
+    qint64 previousNs = 0;
+    for (const Phase &phase : qAsConst(trace.phases)) {
+        qInfo().noquote() << QStringLiteral("StartupTrace: %1 +%2 ms (delta %3 ms)")
+                                 .arg(phase.name, -28)
+                                 .arg(toMs(phase.atNs), 0, 'f', 1)
+                                 .arg(toMs(phase.atNs - previousNs), 0, 'f', 1);
+        TraceRecorder::complete("startup", "", trace.traceOriginNs + previousNs, phase.atNs - previousNs, nullptr,
+                                QString(), phase.name);
+        entries.append(QJsonObject {
+            {QStringLiteral("phase"), phase.name},
+            {QStringLiteral("ms"), toMs(phase.atNs)},
+        });
+        previousNs = phase.atNs;
+    }
+
+    if (trace.exportPath.isEmpty()) {
+        return;
+    }
+    QDir().mkpath(QFileInfo(trace.exportPath).absolutePath());
+    QFile file(trace.exportPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "StartupTrace: cannot write" << trace.exportPath << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(QJsonObject {{QStringLiteral("phases"), entries}}).toJson(QJsonDocument::Indented));
+}
+
+bool StartupTrace::isFinished()
+{
+    return state().finished;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// StartupTrace 以单调时钟记录启动各阶段相对进程入口的时间戳，
+// 首次内容绘制后输出一次汇总，并可按配置写入 JSON 文件。仅在 GUI 线程使用。
+class StartupTrace final
+{
+public:
+    struct Phase
+    {
+        QString name;
+        qint64 atNs {0};
+    };
+
+    StartupTrace() = delete;
+
+    static void begin();
+    static void mark(const QString &phase);
+    static void markAt(const QString &phase, qint64 atNs);
+    static qint64 elapsedNs();
+    static qint64 phaseNs(const QString &phase);
+    static QVector<Phase> phases();
+
+    static void setExportPath(const QString &path);
+    static void finish();
+    static bool isFinished();
+};
@@ -0,0 +1,292 @@
+#include "tracerecorder.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::s_enabled {false};
+
+namespace {
+constexpr int kChunkEvents = 4096;
+// 每个线程每轮最多约 100 万个事件，超出后丢弃并计数
+constexpr int kMaxChunksPerThread = 256;
+
+qint64 steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+const qint64 kOriginNs = steadyNs();
+
+struct Event
+{
+    const char *category {nullptr};
+    const char *name {nullptr};
+    char phase {'X'};
+    qint64 tsNs {0};
+    qint64 durationNs {0};
+    const char *argName {nullptr};
+    QString argValue;
+    QString dynamicName;
+};
+
+// 单写者分块缓冲：只有所属线程追加事件，count 以 release 发布，导出时 acquire 读取已发布的部分
+struct Chunk
+{
+    Event events[kChunkEvents];
+    std::atomic<int> count {0};
+    std::atomic<Chunk *> next {nullptr};
+};
+
+struct ThreadBuffer
+{
+    ~ThreadBuffer()
+    {
+        for (Chunk *chunk = head; chunk;) {
+            Chunk *next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    int tid {0};
+    QString threadName;
+    Chunk *head {nullptr};
+    Chunk *tail {nullptr};
+    int chunks {0};
+    std::atomic<qint64> dropped {0};
+};
+
+struct Registry
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    // 上一轮的缓冲区延后一轮释放，避免与仍在写入的线程竞争
+    std::vector<std::unique_ptr<ThreadBuffer>> retired;
+    std::atomic<quint64> epoch {1};
+    int nextTid {1};
+};
+
+Registry &registry()
+{
+    static Registry s_registry;
+    return s_registry;
+}
+
+QString s_outputPath;
+QThread *s_guiThread = nullptr;
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+thread_local quint64 t_epoch = 0;
+
+ThreadBuffer *createBuffer()
+{
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->head = buffer->tail = new Chunk;
+    buffer->chunks = 1;
+    QThread *thread = QThread::currentThread();
+    buffer->threadName = thread ? thread->objectName() : QString();
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = thread == s_guiThread ? QStringLiteral("GUI") : QStringLiteral("thread");
+    }
+
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    buffer->tid = reg.nextTid++;
+    reg.buffers.push_back(std::move(buffer));
+    return reg.buffers.back().get();
+}
+
+void append(Event &&event)
+{
+    const quint64 epoch = registry().epoch.load(std::memory_order_acquire);
+    if (t_epoch != epoch || !t_buffer) {
+        t_buffer = createBuffer();
+        t_epoch = epoch;
+    }
+    ThreadBuffer *buffer = t_buffer;
+    Chunk *chunk = buffer->tail;
+    int index = chunk->count.load(std::memory_order_relaxed);
+    if (index == kChunkEvents) {
+        if (buffer->chunks >= kMaxChunksPerThread) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto *next = new Chunk;
+        chunk->next.store(next, std::memory_order_release);
+        buffer->tail = chunk = next;
+        ++buffer->chunks;
+        index = 0;
+    }
+    chunk->events[index] = std::move(event);
+    chunk->count.store(index + 1, std::memory_order_release);
+}
+
+double toUs(qint64 ns)
+{
+    return ns / 1000.0;
+}
+
+QJsonObject toJson(const Event &event, qint64 pid, int tid)
+{
+    QJsonObject object {
+        {QStringLiteral("name"), event.dynamicName.isEmpty() ? QString::fromLatin1(event.name) : event.dynamicName},
+        {QStringLiteral("cat"), QString::fromLatin1(event.category)},
+        {QStringLiteral("ph"), QString(QLatin1Char(event.phase))},
+        {QStringLiteral("ts"), toUs(event.tsNs)},
+        {QStringLiteral("pid"), pid},
+        {QStringLiteral("tid"), tid},
+    };
+    if (event.phase == 'X') {
+        object.insert(QStringLiteral("dur"), toUs(event.durationNs));
+    } else if (event.phase == 'i') {
+        object.insert(QStringLiteral("s"), QStringLiteral("t"));
+    }
+    if (event.argName) {
+        object.insert(QStringLiteral("args"), QJsonObject {{QString::fromLatin1(event.argName), event.argValue}});
+    }
+    return object;
+}
+
+QJsonObject metadata(const char *name, qint64 pid, int tid, const QString &value)
+{
+    return QJsonObject {
+        {QStringLiteral("name"), QString::fromLatin1(name)},
+        {QStringLiteral("ph"), QStringLiteral("M")},
+        {QStringLiteral("pid"), pid},
+        {QStringLiteral("tid"), tid},
+        {QStringLiteral("args"), QJsonObject {{QStringLiteral("name"), value}}},
+    };
+}
+} // namespace
+
+void TraceRecorder::start()
+{
+    Registry &reg = registry();
+    {
+        QMutexLocker locker(&reg.mutex);
+        reg.retired = std::move(reg.buffers);
+        reg.buffers.clear();
+        reg.epoch.fetch_add(1, std::memory_order_acq_rel);
+    }
+    s_guiThread = QThread::currentThread();
+    s_enabled.store(true, std::memory_order_relaxed);
+    qInfo() << "TraceRecorder: started";
+}
+
+QString TraceRecorder::stop()
+{
+    if (!isEnabled()) {
+        return QString();
+    }
+    s_enabled.store(false, std::memory_order_relaxed);
+    const QString path = outputPath();
+    return writeTo(path) ? path : QString();
+}
+
+bool TraceRecorder::writeTo(const QString &path)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "TraceRecorder: cannot write" << path << file.errorString();
+        return false;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    qint64 written = 0;
+    qint64 dropped = 0;
+    bool first = true;
+    const auto writeObject = [&file, &first](const QJsonObject &object) {
+        file.write(first ? "\n" : ",\n");
+        file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+        first = false;
+    };
+
+    // 逐个事件写出，不在内存中拼出整份 JSON
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const QString processName = QCoreApplication::applicationName();
+    writeObject(metadata("process_name", pid, 0, processName.isEmpty() ? QStringLiteral("WebEngineDemo") : processName));
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        writeObject(metadata("thread_name", pid, buffer->tid, buffer->threadName));
+        for (const Chunk *chunk = buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const int count = chunk->count.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i) {
+                writeObject(toJson(chunk->events[i], pid, buffer->tid));
+            }
+            written += count;
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    file.write("\n]}\n");
+    if (!file.flush()) {
+        qWarning() << "TraceRecorder: write failed" << path << file.errorString();
+        return false;
+    }
+    qInfo() << "TraceRecorder: wrote" << written << "events to" << path;
+    if (dropped > 0) {
+        qWarning() << "TraceRecorder: dropped" << dropped << "events after per-thread buffers filled up";
+    }
+    return true;
+}
+
+void TraceRecorder::setOutputPath(const QString &path)
+{
+    s_outputPath = path;
+}
+
+QString TraceRecorder::outputPath()
+{
+    if (!s_outputPath.isEmpty()) {
+        return s_outputPath;
+    }
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    const QString name = QStringLiteral("trace-%1.json").arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")));
+    return QDir(base.isEmpty() ? QDir::tempPath() : base).filePath(QStringLiteral("traces/") + name);
+}
+
+qint64 TraceRecorder::nowNs()
+{
+    return steadyNs() - kOriginNs;
+}
+
+void TraceRecorder::complete(const char *category, const char *name, qint64 startNs, qint64 durationNs,
+                             const char *argName, const QString &argValue, const QString &dynamicName)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    append(Event {category, name, 'X', startNs, durationNs, argName, argValue, dynamicName});
+}
+
+void TraceRecorder::instant(const char *category, const char *name, const char *argName, const QString &argValue)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    append(Event {category, name, 'i', nowNs(), 0, argName, argValue, QString()});
+}
+
+void TraceRecorder::instantAt(const char *category, const QString &dynamicName, qint64 atNs)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    append(Event {category, "", 'i', atNs, 0, nullptr, QString(), dynamicName});
+}
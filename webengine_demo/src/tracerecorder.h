@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+// TraceRecorder 记录应用自身代码路径的 span 与 instant 事件，导出为 Chrome Trace Event JSON（chrome://tracing / Perfetto 可直接打开）。
+// 每个线程写入自己的无锁分块缓冲区；关闭时只剩一次原子读，事件参数也不会被求值。
+class TraceRecorder final
+{
+public:
+    TraceRecorder() = delete;
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    // 开始新一轮记录（丢弃上一轮的事件），需在 GUI 线程调用；stop() 停止记录并把本轮事件写入 outputPath()，
+    // 返回写入的文件路径，失败或未在记录时返回空字符串
+    static void start();
+    static QString stop();
+    static bool writeTo(const QString &path);
+    // 未设置时每次停止都写入 AppData/traces 下带时间戳的新文件
+    static void setOutputPath(const QString &path);
+    static QString outputPath();
+
+    // 与 StartupTrace 等模块共用的单调时钟（纳秒）
+    static qint64 nowNs();
+
+    // name / category / argName 必须是静态字符串；dynamicName 非空时代替 name 显示
+    static void complete(const char *category, const char *name, qint64 startNs, qint64 durationNs,
+                         const char *argName = nullptr, const QString &argValue = QString(),
+                         const QString &dynamicName = QString());
+    static void instant(const char *category, const char *name, const char *argName = nullptr,
+                        const QString &argValue = QString());
+    static void instantAt(const char *category, const QString &dynamicName, qint64 atNs);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// 作用域 span：构造时若未开启追踪则什么都不做，析构时写入一个完整事件（ph = X）
+class TraceScope final
+{
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category)
+        , m_name(name)
+        , m_startNs(TraceRecorder::isEnabled() ? TraceRecorder::nowNs() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_startNs >= 0) {
+            TraceRecorder::complete(m_category, m_name, m_startNs, TraceRecorder::nowNs() - m_startNs, m_argName,
+                                    m_argValue);
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    bool isActive() const { return m_startNs >= 0; }
+
+    void setArg(const char *name, const QString &value)
+    {
+        m_argName = name;
+        m_argValue = value;
+    }
+
+private:
+    const char *m_category;
+    const char *m_name;
+    qint64 m_startNs;
+    const char *m_argName {nullptr};
+    QString m_argValue;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+
+// value 只在追踪开启时求值
+#define TRACE_SCOPE_ARG(category, name, argName, value)                         \
+    TraceScope TRACE_CONCAT(traceScope_, __LINE__)(category, name);             \
+    if (TRACE_CONCAT(traceScope_, __LINE__).isActive())                         \
+    TRACE_CONCAT(traceScope_, __LINE__).setArg(argName, value)
+
+#define TRACE_INSTANT(category, name)            \
+    do {                                         \
+        if (TraceRecorder::isEnabled()) {        \
+            TraceRecorder::instant(category, name); \
+        }                                        \
+    } while (false)
+
+#define TRACE_INSTANT_ARG(category, name, argName, value)            \
+    do {                                                             \
+        if (TraceRecorder::isEnabled()) {                            \
+            TraceRecorder::instant(category, name, argName, value);  \
+        }                                                            \
+    } while (false)
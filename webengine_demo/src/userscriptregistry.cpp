@@ -0,0 +1,95 @@
+#include "userscriptregistry.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QWebEnginePage>
+#include <QWebEngineScriptCollection>
+
+namespace {
+constexpr auto kWebChannelResource = ":/web/qtwebchannel/qwebchannel.js";
+constexpr auto kBootstrapResource = ":/web/scripts/bridgebootstrap.js";
+} // namespace
+
+const QString UserScriptRegistry::kChannelBootstrapName = QStringLiteral("qt-channel-bootstrap");
+
+UserScriptRegistry::UserScriptRegistry(QWebEnginePage *page, QObject *parent)
+    : QObject(parent)
+    , m_page(page)
+{
+}
+
+bool UserScriptRegistry::install(const QString &name, const QString &source,
+                                 QWebEngineScript::InjectionPoint injectionPoint, quint32 worldId,
+                                 bool runsOnSubFrames)
+{
+    if (!m_page || name.isEmpty() || source.isEmpty()) {
+        return false;
+    }
+    remove(name);
+
+    QWebEngineScript script;
+    script.setName(name);
+    script.setSourceCode(source);
+    script.setInjectionPoint(injectionPoint);
+    script.setWorldId(worldId);
+    script.setRunsOnSubFrames(runsOnSubFrames);
+    m_page->scripts().insert(script);
+    m_scripts.insert(name, script);
+    return true;
+}
+
+bool UserScriptRegistry::installResource(const QString &name, const QString &resourcePath,
+                                         QWebEngineScript::InjectionPoint injectionPoint, quint32 worldId,
+                                         bool runsOnSubFrames)
+{
+    const QString source = readResource(resourcePath);
+    return !source.isEmpty() && install(name, source, injectionPoint, worldId, runsOnSubFrames);
+}
+
+bool UserScriptRegistry::installChannelBootstrap(quint32 worldId, const QUrl &socketUrl)
+{
+    // qwebchannel.js 与引导代码合并成一个脚本，保证 QWebChannel 在引导代码执行时已定义
+    const QString channel = readResource(QString::fromLatin1(kWebChannelResource));
+    const QString bootstrap = readResource(QString::fromLatin1(kBootstrapResource));
+    if (channel.isEmpty() || bootstrap.isEmpty()) {
+        return false;
+    }
+    // 连接地址只作为外层函数的参数交给引导代码，不挂到 window 上，页面脚本读不到；
+    // 地址由 WebSocketChannelServer 生成，完全编码后不含引号
+    const QString socket = socketUrl.isValid() ? socketUrl.toString(QUrl::FullyEncoded) : QString();
+    const QString source = channel + QStringLiteral("\n(function (channelSocketUrl) {\n%1\n})('%2');\n").arg(bootstrap, socket);
+    return install(kChannelBootstrapName, source, QWebEngineScript::DocumentCreation, worldId);
+}
+
+bool UserScriptRegistry::remove(const QString &name)
+{
+    const auto it = m_scripts.find(name);
+    if (it == m_scripts.end()) {
+        return false;
+    }
+    if (m_page) {
+        m_page->scripts().remove(it.value());
+    }
+    m_scripts.erase(it);
+    return true;
+}
+
+bool UserScriptRegistry::contains(const QString &name) const
+{
+    return m_scripts.contains(name);
+}
+
+QStringList UserScriptRegistry::names() const
+{
+    return m_scripts.keys();
+}
+
+QString UserScriptRegistry::readResource(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "UserScriptRegistry: cannot open" << path;
+        return QString();
+    }
+    return QString::fromUtf8(file.readAll());
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QWebEngineScript>
+
+class QWebEnginePage;
+
+// UserScriptRegistry 统一管理安装到页面 QWebEngineScriptCollection 中的脚本，
+// 按名称去重，可指定注入时机与 world；默认安装 QWebChannel 引导脚本，使 bridge 在页面脚本运行前就开始建立。
+class UserScriptRegistry final : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const QString kChannelBootstrapName;
+
+    explicit UserScriptRegistry(QWebEnginePage *page, QObject *parent = nullptr);
+
+    // 同名脚本会被替换
+    bool install(const QString &name, const QString &source,
+                 QWebEngineScript::InjectionPoint injectionPoint = QWebEngineScript::DocumentCreation,
+                 quint32 worldId = QWebEngineScript::MainWorld, bool runsOnSubFrames = false);
+    bool installResource(const QString &name, const QString &resourcePath,
+                         QWebEngineScript::InjectionPoint injectionPoint = QWebEngineScript::DocumentCreation,
+                         quint32 worldId = QWebEngineScript::MainWorld, bool runsOnSubFrames = false);
+    // worldId 必须与 QWebEnginePage::setWebChannel 使用的 world 一致；
+    // socketUrl 有效时引导代码在 qrc: 页面中改为经该 WebSocket 地址连接 QWebChannel，而不是页面内置的 qt.webChannelTransport
+    bool installChannelBootstrap(quint32 worldId = QWebEngineScript::MainWorld, const QUrl &socketUrl = QUrl());
+    bool remove(const QString &name);
+    bool contains(const QString &name) const;
+    QStringList names() const;
+
+    // 读取 qrc 中的脚本，失败时返回空字符串
+    static QString readResource(const QString &path);
+
+private:
+    QPointer<QWebEnginePage> m_page;
+    QHash<QString, QWebEngineScript> m_scripts;
+};
@@ -1,7 +1,42 @@
 #include "webbridge.h"
 
+#include "metricsregistry.h"
+#include "tracerecorder.h"
+
 #include <QCoreApplication>
 
+namespace {
+// 指标引用在首次使用时取得并缓存，之后每条消息只做原子加
+struct BridgeMetrics
+{
+    MetricsRegistry::Counter &messagesFromWeb;
+    MetricsRegistry::Counter &messagesToWeb;
+    MetricsRegistry::Counter &bytesFromWeb;
+    MetricsRegistry::Counter &bytesToWeb;
+    MetricsRegistry::Counter &batchesToWeb;
+};
+
+BridgeMetrics &bridgeMetrics()
+{
+    static const char *const kMessagesHelp = "Messages passed through WebBridge.";
+    static const char *const kBytesHelp = "UTF-16 payload bytes passed through WebBridge.";
+    auto &registry = MetricsRegistry::instance();
+    static BridgeMetrics s_metrics {
+        registry.counter("webengine_demo_bridge_messages_total", kMessagesHelp, {{"direction", QStringLiteral("from_web")}}),
+        registry.counter("webengine_demo_bridge_messages_total", kMessagesHelp, {{"direction", QStringLiteral("to_web")}}),
+        registry.counter("webengine_demo_bridge_bytes_total", kBytesHelp, {{"direction", QStringLiteral("from_web")}}),
+        registry.counter("webengine_demo_bridge_bytes_total", kBytesHelp, {{"direction", QStringLiteral("to_web")}}),
+        registry.counter("webengine_demo_bridge_batches_total", "Message batches dispatched to the page."),
+    };
+    return s_metrics;
+}
+
+quint64 payloadBytes(const QString &payload)
+{
+    return static_cast<quint64>(payload.size()) * sizeof(QChar);
+}
+} // namespace
+
 WebBridge::WebBridge(QObject *parent)
     : QObject(parent)
 {
@@ -9,6 +44,10 @@ WebBridge::WebBridge(QObject *parent)
 
 void WebBridge::sendToCpp(const QString &payload)
 {
+    TRACE_SCOPE_ARG("bridge", "WebBridge::sendToCpp", "bytes", QString::number(payload.size()));
+    BridgeMetrics &metrics = bridgeMetrics();
+    metrics.messagesFromWeb.increment();
+    metrics.bytesFromWeb.increment(payloadBytes(payload));
     emit messageFromJs(payload);
     onMessageFromWeb(payload);
 }
@@ -24,15 +63,55 @@ QString WebBridge::applicationVersion() const
 
 void WebBridge::dispatchToWeb(const QString &payload)
 {
+    TRACE_SCOPE_ARG("bridge", "WebBridge::dispatchToWeb", "bytes", QString::number(payload.size()));
+    BridgeMetrics &metrics = bridgeMetrics();
+    metrics.messagesToWeb.increment();
+    metrics.bytesToWeb.increment(payloadBytes(payload));
     emit messageFromCpp(payload);
     onMessageFromCpp(payload);
 }
 
+void WebBridge::dispatchBatchToWeb(const QStringList &payloads)
+{
+    if (payloads.isEmpty()) {
+        return;
+    }
+    TRACE_SCOPE_ARG("bridge", "WebBridge::dispatchBatchToWeb", "messages", QString::number(payloads.size()));
+    BridgeMetrics &metrics = bridgeMetrics();
+    metrics.batchesToWeb.increment();
+    metrics.messagesToWeb.increment(static_cast<quint64>(payloads.size()));
+    emit messageBatchFromCpp(payloads);
+    for (const QString &payload : payloads) {
+        metrics.bytesToWeb.increment(payloadBytes(payload));
+        onMessageFromCpp(payload);
+    }
+}
+
 void WebBridge::notifyPageReady()
 {
     emit pageReady();
 }
 
+void WebBridge::saveStateSnapshot(const QString &snapshot)
+{
+    emit stateSnapshotSaved(snapshot);
+}
+
+void WebBridge::reportTelemetry(const QString &channel, const QString &payload)
+{
+    emit telemetryReported(channel, payload);
+}
+
+void WebBridge::acknowledgeMessages(int count)
+{
+    emit messagesAcknowledged(count);
+}
+
+void WebBridge::requestStateRestore(const QString &snapshot)
+{
+    emit restoreStateRequested(snapshot);
+}
+
 BasicBridge::BasicBridge(QObject *parent)
     : WebBridge(parent)
 {
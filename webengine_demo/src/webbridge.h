@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QObject>
+#include <QStringList>
 
 class WebBridge : public QObject
 {
@@ -13,14 +14,25 @@ public:
     Q_INVOKABLE void sendToCpp(const QString &payload);
     Q_INVOKABLE QString applicationVersion() const;
     Q_INVOKABLE void notifyPageReady();
+    Q_INVOKABLE void saveStateSnapshot(const QString &snapshot);
+    Q_INVOKABLE void reportTelemetry(const QString &channel, const QString &payload);
+    // 页面确认当前文档已收到的 C++ -> JS 消息总数（单条与批量中的每条都计入）
+    Q_INVOKABLE void acknowledgeMessages(int count);
 
 public slots:
     void dispatchToWeb(const QString &payload);
+    void dispatchBatchToWeb(const QStringList &payloads);
+    void requestStateRestore(const QString &snapshot);
 
 signals:
     void messageFromJs(const QString &payload);
     void messageFromCpp(const QString &payload);
+    void messageBatchFromCpp(const QStringList &payloads);
     void pageReady();
+    void stateSnapshotSaved(const QString &snapshot);
+    void restoreStateRequested(const QString &snapshot);
+    void telemetryReported(const QString &channel, const QString &payload);
+    void messagesAcknowledged(int count);
 
 protected:
     virtual void onMessageFromWeb(const QString &payload) = 0;
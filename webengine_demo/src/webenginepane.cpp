@@ -1,18 +1,33 @@
 #include "webenginepane.h"
 
+#include "configmanager.h"
+#include "configwatcher.h"
 #include "connectguard.h"
+#include "cookiejartransfer.h"
+#include "cookiemirror.h"
+#include "downloadmanager.h"
+#include "jankmonitor.h"
+#include "metricsregistry.h"
+#include "pagelifecyclemanager.h"
+#include "pagetimingcollector.h"
+#include "profileregistry.h"
+#include "renderprocessrecovery.h"
+#include "scriptbatchqueue.h"
+#include "tracerecorder.h"
+#include "userscriptregistry.h"
 #include "webbridge.h"
 #include "webenginepanesignalhandler.h"
 #include "webenginesignals.h"
+#include "websocketchannel.h"
 
 #include <QAction>
 #include <QClipboard>
 #include <QDateTime>
+#include <QDebug>
 #include <QDesktopServices>
 #include <QGuiApplication>
 #include <QMenu>
 #include <QNetworkCookie>
-#include <QStandardPaths>
 #include <QTimer>
 #include <QUrl>
 #include <QVariant>
@@ -29,6 +44,8 @@
 
 constexpr auto kZhihuHost = "www.zhihu.com";
 constexpr auto kZhihuHostNoWWW = "zhihu.com";
+// 页面未就绪或冻结时最多积压的消息数，超出后丢弃最旧的
+constexpr int kMaxPendingMessages = 500;
 
 bool shouldRedirectZhihu(const QUrl &url)
 {
@@ -43,6 +60,13 @@ bool shouldRedirectZhihu(const QUrl &url)
     return false;
 }
 
+MetricsRegistry::Gauge &pendingMessagesGauge()
+{
+    static MetricsRegistry::Gauge &s_gauge = MetricsRegistry::instance().gauge(
+        "webengine_demo_pending_messages", "Messages queued for pages whose bridge is not ready or that are frozen.");
+    return s_gauge;
+}
+
 InterceptingPage::InterceptingPage(QWebEngineProfile* profile, QObject* parent)
 	: QWebEnginePage(profile, parent)
 {
@@ -55,21 +79,28 @@ void InterceptingPage::setRedirectTarget(const QUrl &target)
 
 bool InterceptingPage::acceptNavigationRequest(const QUrl &url, NavigationType type, bool isMainFrame)
 {
+	TRACE_SCOPE_ARG("navigation", "InterceptingPage::acceptNavigationRequest", "url", url.toString());
 	if (isMainFrame && shouldRedirectZhihu(url) && m_redirectTarget.isValid()) {
+		TRACE_INSTANT_ARG("navigation", "redirect", "target", m_redirectTarget.toString());
 		const QUrl target(m_redirectTarget);
 		QTimer::singleShot(0, this, [this, target]() {
 			this->load(target);
 		});
 		return false;
 	}
-	return QWebEnginePage::acceptNavigationRequest(url, type, isMainFrame);
+	const bool accepted = QWebEnginePage::acceptNavigationRequest(url, type, isMainFrame);
+	if (accepted && isMainFrame) {
+		emit mainFrameNavigationAccepted(url);
+	}
+	return accepted;
 }
 
 
 //} // namespace
 
-WebEnginePane::WebEnginePane(WebBridge *bridge, QWidget *parent)
+WebEnginePane::WebEnginePane(WebBridge *bridge, QWidget *parent, SharedProfile *sharedProfile)
     : QWidget(parent)
+    , m_sharedProfile(sharedProfile)
     , m_bridge(bridge)
 {
     auto *layout = new QVBoxLayout(this);
@@ -85,15 +116,71 @@ WebEnginePane::WebEnginePane(WebBridge *bridge, QWidget *parent)
     ensureBridge();
     setupChannel();
     resetLoadState();
+    m_recovery = new RenderProcessRecovery(this, m_bridge);
+    m_scriptQueue = new ScriptBatchQueue(m_view->page(), this);
+    m_scripts = new UserScriptRegistry(m_view->page(), this);
+    applyChannelTransport();
+    m_timing = new PageTimingCollector(m_view->page(), m_bridge, m_scripts, this);
+    m_timing->setExportPath(ConfigManager::instance().pageTimingExportPath());
+    m_timing->setScriptQueue(m_scriptQueue);
+    m_jankMonitor = new JankMonitor(m_view->page(), m_bridge, m_scripts, this);
+    m_jankMonitor->setScriptQueue(m_scriptQueue);
+    if (m_sharedProfile) {
+        m_cookieJar = m_sharedProfile->cookieJar();
+        m_cookieMirror = m_sharedProfile->cookieMirror();
+        m_downloads = m_sharedProfile->downloads();
+        m_sharedProfile->attachPage(m_view->page());
+    } else {
+        m_cookieJar = new CookieJarTransfer(m_profile->cookieStore(), this);
+        m_cookieMirror = new CookieMirror(m_profile->cookieStore(), this);
+        m_cookieMirror->setMaxBytes(ConfigManager::instance().cookieMirrorBudgetBytes());
+        m_cookieMirror->start();
+        m_downloads = new DownloadManager(m_profile, this);
+        m_downloads->setLimits(ConfigManager::instance().downloadLimits());
+        m_downloads->setRetryPage(m_view->page());
+    }
+    m_channel->registerObject(QStringLiteral("cookieMirror"), new CookieMirrorRpc(m_cookieMirror, m_view->page(), this));
     m_signalHub = new WebEnginePaneSignalHandler(this);
     m_signalHub->bind(m_view);
 
+    watchRuntimeConfig();
+
     ENSURE_QT_CONNECT(m_bridge, &WebBridge::messageFromJs, this, &WebEnginePane::messageFromJs);
     ENSURE_QT_CONNECT(m_view, &QWidget::customContextMenuRequested, this, &WebEnginePane::showCustomContextMenu);
     ENSURE_QT_CONNECT(m_bridge, &WebBridge::pageReady, this, &WebEnginePane::handlePageReady);
+    if (auto *page = qobject_cast<InterceptingPage *>(m_view->page())) {
+        ENSURE_QT_CONNECT(page, &InterceptingPage::mainFrameNavigationAccepted, this, &WebEnginePane::prepareChannelSocket);
+    }
+    ENSURE_QT_CONNECT(m_timing, &PageTimingCollector::reportReady, this, &WebEnginePane::timingReportReady);
 }
 
-WebEnginePane::~WebEnginePane() = default;
+WebEnginePane::~WebEnginePane()
+{
+    pendingMessagesGauge().add(-m_pendingPayloads.size());
+}
+
+void WebEnginePane::watchRuntimeConfig()
+{
+    auto *watcher = ConfigWatcher::instance();
+    if (!watcher) {
+        return;
+    }
+    // 这些设置随 config.json 热重载即时生效，每次都读取最新快照
+    watcher->onChanged(QStringLiteral("pageFreezeDelayMs"), this, [this]() {
+        if (m_lifecycle) {
+            m_lifecycle->setGracePeriod(ConfigManager::instance().pageFreezeDelayMs());
+        }
+    });
+    watcher->onChanged(QStringLiteral("pageTimingExportPath"), this, [this]() {
+        m_timing->setExportPath(ConfigManager::instance().pageTimingExportPath());
+    });
+    watcher->onChanged(QStringLiteral("cookieMirrorBudgetKiB"), this, [this]() {
+        m_cookieMirror->setMaxBytes(ConfigManager::instance().cookieMirrorBudgetBytes());
+    });
+    watcher->onChanged(QStringLiteral("downloads"), this, [this]() {
+        m_downloads->setLimits(ConfigManager::instance().downloadLimits());
+    });
+}
 
 QWebEngineView *WebEnginePane::view() const
 {
@@ -105,6 +192,11 @@ QWebEngineProfile *WebEnginePane::profile() const
     return m_profile;
 }
 
+SharedProfile *WebEnginePane::sharedProfile() const
+{
+    return m_sharedProfile;
+}
+
 WebBridge *WebEnginePane::bridge() const
 {
     return m_bridge;
@@ -115,6 +207,72 @@ WebEngineSignals *WebEnginePane::signalHub() const
     return m_signalHub;
 }
 
+RenderProcessRecovery *WebEnginePane::recovery() const
+{
+    return m_recovery;
+}
+
+PageLifecycleManager *WebEnginePane::lifecycle() const
+{
+    return m_lifecycle;
+}
+
+PageLifecycleManager *WebEnginePane::enableLifecycle()
+{
+    if (m_lifecycle) {
+        return m_lifecycle;
+    }
+    m_lifecycle = new PageLifecycleManager(this);
+    m_lifecycle->setGracePeriod(ConfigManager::instance().pageFreezeDelayMs());
+    ENSURE_QT_CONNECT(m_lifecycle, &PageLifecycleManager::resumed, this, [this]() {
+        // 冻结期间积压的消息在恢复时一次性批量送达
+        if (m_lastLoadSucceeded && m_jsReady) {
+            flushPendingMessages(true);
+        }
+    });
+    return m_lifecycle;
+}
+
+QJsonObject WebEnginePane::lastTimingReport() const
+{
+    return m_timing ? m_timing->lastReport() : QJsonObject();
+}
+
+JankMonitor *WebEnginePane::jankMonitor() const
+{
+    return m_jankMonitor;
+}
+
+PageTimingCollector *WebEnginePane::timingCollector() const
+{
+    return m_timing;
+}
+
+CookieJarTransfer *WebEnginePane::cookieJar() const
+{
+    return m_cookieJar;
+}
+
+CookieMirror *WebEnginePane::cookieMirror() const
+{
+    return m_cookieMirror;
+}
+
+DownloadManager *WebEnginePane::downloads() const
+{
+    return m_downloads;
+}
+
+ScriptBatchQueue *WebEnginePane::scriptQueue() const
+{
+    return m_scriptQueue;
+}
+
+UserScriptRegistry *WebEnginePane::userScripts() const
+{
+    return m_scripts;
+}
+
 void WebEnginePane::setUserAgent(const QString &ua)
 {
     if (!m_profile) {
@@ -187,9 +345,14 @@ void WebEnginePane::dumpDocumentCookies()
         return;
     }
 
-    auto *page = m_view->page();
-    page->runJavaScript(QStringLiteral("document.cookie"), [this](const QVariant &value) {
-        if (!value.isValid()) {
+    // 镜像就绪且该域名未被淘汰时直接同步返回（包含 HttpOnly），否则退回到页面里读取 document.cookie
+    if (m_cookieMirror && m_cookieMirror->covers(m_view->url())) {
+        emit cookiesDumped(m_cookieMirror->cookieHeaderForUrl(m_view->url()));
+        return;
+    }
+
+    m_scriptQueue->enqueue(QStringLiteral("document.cookie"), [this](const QVariant &value, const QString &error) {
+        if (!error.isEmpty() || !value.isValid()) {
             emit cookiesDumped(tr("未能获取 document.cookie"));
             return;
         }
@@ -200,6 +363,7 @@ void WebEnginePane::dumpDocumentCookies()
 
 void WebEnginePane::load(const QUrl &url)
 {
+    TRACE_SCOPE_ARG("pane", "WebEnginePane::load", "url", url.toString());
     if (!m_view || !url.isValid()) {
         return;
     }
@@ -215,11 +379,46 @@ void WebEnginePane::clearProfileData()
 
     m_profile->clearAllVisitedLinks();
     m_profile->clearHttpCache();
+    static MetricsRegistry::Counter &s_cacheClears =
+        MetricsRegistry::instance().counter("webengine_demo_http_cache_clears_total", "HTTP cache clears requested by the user.");
+    s_cacheClears.increment();
     if (auto *store = m_profile->cookieStore()) {
         store->deleteAllCookies();
     }
 }
 
+void WebEnginePane::clearHttpCache()
+{
+    if (m_profile) {
+        m_profile->clearHttpCache();
+    }
+}
+
+int WebEnginePane::dropPendingMessages()
+{
+    const int dropped = m_pendingPayloads.size();
+    if (dropped > 0) {
+        qWarning() << "WebEnginePane: dropping" << dropped << "pending bridge messages";
+        m_pendingPayloads.clear();
+        pendingMessagesGauge().add(-dropped);
+    }
+    return dropped;
+}
+
+WebEnginePane::ChannelTransport WebEnginePane::channelTransport() const
+{
+    return m_channelTransport;
+}
+
+void WebEnginePane::setChannelTransport(ChannelTransport transport)
+{
+    if (transport == m_channelTransport) {
+        return;
+    }
+    m_channelTransport = transport;
+    applyChannelTransport();
+}
+
 void WebEnginePane::broadcastToPage(const QString &payload)
 {
     if (!m_bridge) {
@@ -231,12 +430,24 @@ void WebEnginePane::broadcastToPage(const QString &payload)
         return;
     }
 
-    if (m_lastLoadSucceeded && m_jsReady) {
+    if (m_lastLoadSucceeded && m_jsReady && !isPageFrozen()) {
         m_bridge->dispatchToWeb(trimmed);
         return;
     }
 
+    if (isPageFrozen()) {
+        // 冻结期间合并重复消息，只保留最新的一份
+        pendingMessagesGauge().add(-m_pendingPayloads.removeAll(trimmed));
+    }
+    if (m_pendingPayloads.size() >= kMaxPendingMessages) {
+        static MetricsRegistry::Counter &s_dropped = MetricsRegistry::instance().counter(
+            "webengine_demo_pending_messages_dropped_total", "Queued page messages dropped because the queue was full.");
+        s_dropped.increment();
+        m_pendingPayloads.removeFirst();
+        pendingMessagesGauge().add(-1);
+    }
     m_pendingPayloads.append(trimmed);
+    pendingMessagesGauge().add(1);
 }
 
 void WebEnginePane::setRedirectTarget(const QUrl &url)
@@ -258,18 +469,14 @@ QUrl WebEnginePane::redirectTarget() const
 
 void WebEnginePane::configureProfile()
 {
-    m_profile = new QWebEngineProfile("DemoProfile", this);
-    m_profile->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
-    m_profile->setPersistentCookiesPolicy(QWebEngineProfile::AllowPersistentCookies);
-    m_profile->setSpellCheckEnabled(false);
-    m_defaultUserAgent = m_profile->httpUserAgent();
-
-    const QString storageRoot = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
-    if (!storageRoot.isEmpty()) {
-        m_profile->setCachePath(storageRoot + "/cache");
-        m_profile->setPersistentStoragePath(storageRoot + "/storage");
-        m_profile->setDownloadPath(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation));
+    if (m_sharedProfile) {
+        m_profile = m_sharedProfile->profile();
+        m_defaultUserAgent = m_sharedProfile->defaultUserAgent();
+        return;
     }
+    m_profile = new QWebEngineProfile(ProfileRegistry::kDefaultProfileName, this);
+    ProfileRegistry::configureProfile(m_profile);
+    m_defaultUserAgent = m_profile->httpUserAgent();
 }
 
 void WebEnginePane::configureView()
@@ -365,9 +572,48 @@ void WebEnginePane::setupChannel()
     }
 
     m_channel->registerObject(QStringLiteral("bridge"), m_bridge);
-    if (m_view && m_view->page()) {
-        m_view->page()->setWebChannel(m_channel);
+    if (ConfigManager::instance().webChannel().transport == QLatin1String("websocket")) {
+        m_channelTransport = ChannelTransport::WebSocket;
+    }
+}
+
+void WebEnginePane::applyChannelTransport()
+{
+    if (!m_channel || !m_scripts) {
+        return;
     }
+
+    QWebEnginePage *page = m_view->page();
+    if (m_channelTransport == ChannelTransport::WebSocket) {
+        if (WebSocketChannelServer::instance()->isListening()) {
+            // 不再挂内置传输，否则 QWebChannel 会把属性变化同时广播到两条传输上
+            page->setWebChannel(nullptr);
+            prepareChannelSocket(page->url());
+            return;
+        }
+        qWarning() << "WebEnginePane: websocket channel transport unavailable, falling back to page transport";
+        m_channelTransport = ChannelTransport::Page;
+    }
+
+    if (auto *server = WebSocketChannelServer::existingInstance()) {
+        server->detach(m_channel);
+    }
+    page->setWebChannel(m_channel);
+    m_scripts->installChannelBootstrap();
+}
+
+void WebEnginePane::prepareChannelSocket(const QUrl &target)
+{
+    if (m_channelTransport != ChannelTransport::WebSocket || !m_scripts) {
+        return;
+    }
+    auto *server = WebSocketChannelServer::instance();
+    // 远程页面同样会注入引导脚本，令牌一旦落到远程页面就可能被转交出去，因此只为 qrc: 页面签发
+    const QUrl socketUrl = target.scheme() == QLatin1String("qrc") ? server->issue(m_channel, target) : QUrl();
+    if (!socketUrl.isValid()) {
+        server->revoke(m_channel);
+    }
+    m_scripts->installChannelBootstrap(QWebEngineScript::MainWorld, socketUrl);
 }
 
 void WebEnginePane::ensureBridge()
@@ -383,11 +629,24 @@ void WebEnginePane::handleLoadStarted()
 {
     m_lastLoadSucceeded = false;
     m_jsReady = false;
+    if (m_timing) {
+        m_timing->handleLoadStarted();
+    }
+    if (m_downloads) {
+        m_downloads->setPageLoading(m_view->page(), true);
+    }
 }
 
 void WebEnginePane::handlePageReady()
 {
     m_jsReady = true;
+    if (m_recovery) {
+        m_recovery->handlePageReady();
+    }
+    if (m_timing) {
+        m_timing->handlePageReady();
+    }
+    // 页面就绪可能早于 loadFinished，排队的消息等加载成功后再投递，由 loadFinished 负责补发
     if (m_lastLoadSucceeded) {
         flushPendingMessages();
     }
@@ -399,14 +658,20 @@ void WebEnginePane::resetLoadState()
     m_jsReady = false;
 }
 
-void WebEnginePane::flushPendingMessages()
+void WebEnginePane::flushPendingMessages(bool asBatch)
 {
-    if (!m_bridge || m_pendingPayloads.isEmpty()) {
+    TRACE_SCOPE_ARG("bridge", "WebEnginePane::flushPendingMessages", "pending", QString::number(m_pendingPayloads.size()));
+    if (!m_bridge || m_pendingPayloads.isEmpty() || isPageFrozen()) {
         return;
     }
 
     const auto pending = m_pendingPayloads;
     m_pendingPayloads.clear();
+    pendingMessagesGauge().add(-pending.size());
+    if (asBatch) {
+        m_bridge->dispatchBatchToWeb(pending);
+        return;
+    }
     for (const QString &message : pending) {
         if (!message.isEmpty()) {
             m_bridge->dispatchToWeb(message);
@@ -414,3 +679,7 @@ void WebEnginePane::flushPendingMessages()
     }
 }
 
+bool WebEnginePane::isPageFrozen() const
+{
+    return m_lifecycle && m_lifecycle->isFrozen();
+}
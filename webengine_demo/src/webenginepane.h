@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QJsonObject>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
@@ -12,6 +13,16 @@ class QWebEngineProfile;
 class QWebEngineView;
 class QPoint;
 
+class CookieJarTransfer;
+class CookieMirror;
+class DownloadManager;
+class JankMonitor;
+class PageLifecycleManager;
+class PageTimingCollector;
+class RenderProcessRecovery;
+class ScriptBatchQueue;
+class SharedProfile;
+class UserScriptRegistry;
 class WebBridge;
 class WebEngineSignals;
 class WebEnginePaneSignalHandler;
@@ -27,6 +38,10 @@ public:
     explicit InterceptingPage(QWebEngineProfile* profile, QObject* parent = nullptr);
     void setRedirectTarget(const QUrl& target);
 
+signals:
+    // 主框架导航已放行，文档尚未创建
+    void mainFrameNavigationAccepted(const QUrl &url);
+
 protected:
     virtual bool acceptNavigationRequest(const QUrl& url, NavigationType type, bool isMainFrame);
 
@@ -41,19 +56,49 @@ class WebEnginePane final : public QWidget
     friend class WebEnginePaneSignalHandler;
 
 public:
-    explicit WebEnginePane(WebBridge *bridge = nullptr, QWidget *parent = nullptr);
+    // QWebChannel 的传输：Page 为 QWebEnginePage::setWebChannel 的内置传输；
+    // WebSocket 经本机回环 WebSocket 连接，支持二进制帧与更大的消息，大消息在线程池中序列化
+    enum class ChannelTransport
+    {
+        Page,
+        WebSocket,
+    };
+
+    // sharedProfile 非空时使用多窗口共享的 profile 及其 Cookie / 下载组件，否则自行创建
+    explicit WebEnginePane(WebBridge *bridge = nullptr, QWidget *parent = nullptr, SharedProfile *sharedProfile = nullptr);
     ~WebEnginePane() override;
 
     QWebEngineView *view() const;
     QWebEngineProfile *profile() const;
+    SharedProfile *sharedProfile() const;
     WebBridge *bridge() const;
     void setUserAgent(const QString &ua);
     QString currentUserAgent() const;
     WebEngineSignals *signalHub() const;
+    RenderProcessRecovery *recovery() const;
+    // 未调用 enableLifecycle() 时为空
+    PageLifecycleManager *lifecycle() const;
+    // 由窗口所有者按需启用后台冻结 / 丢弃；无头、服务与 worker pane 不启用，避免任务中途被冻结
+    PageLifecycleManager *enableLifecycle();
+    QJsonObject lastTimingReport() const;
+    PageTimingCollector *timingCollector() const;
+    JankMonitor *jankMonitor() const;
+    CookieJarTransfer *cookieJar() const;
+    CookieMirror *cookieMirror() const;
+    DownloadManager *downloads() const;
+    ScriptBatchQueue *scriptQueue() const;
+    UserScriptRegistry *userScripts() const;
     bool setCookieForCurrentPage(const QString& cookieLine);
     void dumpDocumentCookies();
     void setRedirectTarget(const QUrl &url);
     QUrl redirectTarget() const;
+    // 只清空 HTTP 缓存，不动 Cookie 与访问记录
+    void clearHttpCache();
+    // 丢弃尚未送达页面的 C++ -> JS 消息，返回丢弃的条数
+    int dropPendingMessages();
+    ChannelTransport channelTransport() const;
+    // 下一次加载页面时生效；WebSocket 服务不可用时退回 Page。WebSocket 传输只向 qrc: 页面开放
+    void setChannelTransport(ChannelTransport transport);
 
 public slots:
     void load(const QUrl &url);
@@ -65,6 +110,7 @@ signals:
     void loadFinished(bool ok);
     void messageFromJs(const QString &payload);
     void cookiesDumped(const QString &cookies);
+    void timingReportReady(const QJsonObject &report);
 
 private slots:
     void showCustomContextMenu(const QPoint &pos);
@@ -76,19 +122,35 @@ private:
     void configureProfile();
     void configureView();
     void setupChannel();
+    void applyChannelTransport();
+    // WebSocket 传输下每次主框架导航换发一次性令牌，只有 qrc: 页面拿得到连接地址
+    void prepareChannelSocket(const QUrl &target);
     void ensureBridge();
-    void flushPendingMessages();
+    void flushPendingMessages(bool asBatch = false);
+    void watchRuntimeConfig();
+    bool isPageFrozen() const;
 
 private:
     QWebEngineView *m_view {nullptr};
     QWebEngineProfile *m_profile {nullptr};
+    SharedProfile *m_sharedProfile {nullptr};
     QWebChannel *m_channel {nullptr};
+    ChannelTransport m_channelTransport {ChannelTransport::Page};
     WebBridge *m_bridge {nullptr};
     QString m_defaultUserAgent;
     bool m_lastLoadSucceeded {false};
     bool m_jsReady {false};
     QStringList m_pendingPayloads;
     WebEngineSignals *m_signalHub {nullptr};
+    RenderProcessRecovery *m_recovery {nullptr};
+    PageLifecycleManager *m_lifecycle {nullptr};
+    PageTimingCollector *m_timing {nullptr};
+    JankMonitor *m_jankMonitor {nullptr};
+    CookieJarTransfer *m_cookieJar {nullptr};
+    CookieMirror *m_cookieMirror {nullptr};
+    DownloadManager *m_downloads {nullptr};
+    ScriptBatchQueue *m_scriptQueue {nullptr};
+    UserScriptRegistry *m_scripts {nullptr};
     QUrl m_redirectTarget = QStringLiteral("https://baidu.com");
 };
 
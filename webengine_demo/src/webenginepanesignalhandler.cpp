@@ -1,6 +1,11 @@
 #include "webenginepanesignalhandler.h"
 
 #include "connectguard.h"
+#include "downloadmanager.h"
+#include "metricsregistry.h"
+#include "pagetimingcollector.h"
+#include "renderprocessrecovery.h"
+#include "tracerecorder.h"
 #include "webenginepane.h"
 #include <QWebEngineView>
 
@@ -8,6 +13,33 @@
 #include <QDebug>
 #include <QIcon>
 
+namespace {
+MetricsRegistry::Counter &loadOutcomeCounter(bool ok)
+{
+    static const char *const kHelp = "Main frame loads by outcome.";
+    static MetricsRegistry::Counter &s_ok =
+        MetricsRegistry::instance().counter("webengine_demo_page_loads_total", kHelp, {{"result", QStringLiteral("ok")}});
+    static MetricsRegistry::Counter &s_failed =
+        MetricsRegistry::instance().counter("webengine_demo_page_loads_total", kHelp, {{"result", QStringLiteral("failed")}});
+    return ok ? s_ok : s_failed;
+}
+
+QString terminationStatusLabel(QWebEnginePage::RenderProcessTerminationStatus status)
+{
+    switch (status) {
+    case QWebEnginePage::NormalTerminationStatus:
+        return QStringLiteral("normal");
+    case QWebEnginePage::AbnormalTerminationStatus:
+        return QStringLiteral("abnormal");
+    case QWebEnginePage::CrashedTerminationStatus:
+        return QStringLiteral("crashed");
+    case QWebEnginePage::KilledTerminationStatus:
+        return QStringLiteral("killed");
+    }
+    return QStringLiteral("unknown");
+}
+} // namespace
+
 WebEnginePaneSignalHandler::WebEnginePaneSignalHandler(WebEnginePane *pane)
     : WebEngineSignals(pane)
     , m_pane(pane)
@@ -16,72 +48,64 @@ WebEnginePaneSignalHandler::WebEnginePaneSignalHandler(WebEnginePane *pane)
 
     ENSURE_QT_CONNECT(this, &WebEngineSignals::viewAttached, this, &WebEnginePaneSignalHandler::handleViewAttached);
     ENSURE_QT_CONNECT(this, &WebEngineSignals::viewDetached, this, &WebEnginePaneSignalHandler::handleViewDetached);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewUrlChanged, this, &WebEnginePaneSignalHandler::handleViewUrlChanged);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewTitleChanged, this, &WebEnginePaneSignalHandler::handleViewTitleChanged);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewIconChanged, this, &WebEnginePaneSignalHandler::handleViewIconChanged);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewLoadStarted, this, &WebEnginePaneSignalHandler::handleViewLoadStarted);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewLoadProgress, this, &WebEnginePaneSignalHandler::handleViewLoadProgress);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewLoadFinished, this, &WebEnginePaneSignalHandler::handleViewLoadFinished);
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::viewSelectionChanged, this, &WebEnginePaneSignalHandler::handleViewSelectionChanged);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::viewRenderProcessTerminated,
+}
+
+void WebEnginePaneSignalHandler::attachView(QWebEngineView *view)
+{
+    ENSURE_QT_CONNECT(view, &QWebEngineView::urlChanged, this, &WebEnginePaneSignalHandler::handleViewUrlChanged);
+    ENSURE_QT_CONNECT(view, &QWebEngineView::titleChanged, this, &WebEnginePaneSignalHandler::handleViewTitleChanged);
+    ENSURE_QT_CONNECT(view, &QWebEngineView::iconChanged, this, &WebEnginePaneSignalHandler::handleViewIconChanged);
+    ENSURE_QT_CONNECT(view, &QWebEngineView::loadStarted, this, &WebEnginePaneSignalHandler::handleViewLoadStarted);
+    ENSURE_QT_CONNECT(view, &QWebEngineView::loadFinished, this, &WebEnginePaneSignalHandler::handleViewLoadFinished);
+    // page 的 renderProcessTerminated 与 view 的是同一次事件，只连 view 的，避免重复触发恢复
+    ENSURE_QT_CONNECT(view,
+                      &QWebEngineView::renderProcessTerminated,
                       this,
                       &WebEnginePaneSignalHandler::handleViewRenderProcessTerminated);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::viewFindTextFinished,
-                      this,
-                      &WebEnginePaneSignalHandler::handleViewFindTextFinished);
-#endif
+}
 
-    ENSURE_QT_CONNECT(this, &WebEngineSignals::pageLinkHovered, this, &WebEnginePaneSignalHandler::handlePageLinkHovered);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageFullScreenRequested,
+void WebEnginePaneSignalHandler::attachPage(QWebEnginePage *page)
+{
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::fullScreenRequested,
                       this,
                       &WebEnginePaneSignalHandler::handlePageFullScreenRequested);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageFeaturePermissionRequested,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::featurePermissionRequested,
                       this,
                       &WebEnginePaneSignalHandler::handlePageFeaturePermissionRequested);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageFeaturePermissionRequestCanceled,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::featurePermissionRequestCanceled,
                       this,
                       &WebEnginePaneSignalHandler::handlePageFeaturePermissionRequestCanceled);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageQuotaRequested,
-                      this,
-                      &WebEnginePaneSignalHandler::handlePageQuotaRequested);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageSelectClientCertificate,
+    ENSURE_QT_CONNECT(page, &QWebEnginePage::quotaRequested, this, &WebEnginePaneSignalHandler::handlePageQuotaRequested);
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::selectClientCertificate,
                       this,
                       &WebEnginePaneSignalHandler::handlePageSelectClientCertificate);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageAuthenticationRequired,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::authenticationRequired,
                       this,
                       &WebEnginePaneSignalHandler::handlePageAuthenticationRequired);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageProxyAuthenticationRequired,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::proxyAuthenticationRequired,
                       this,
                       &WebEnginePaneSignalHandler::handlePageProxyAuthenticationRequired);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageRenderProcessTerminated,
-                      this,
-                      &WebEnginePaneSignalHandler::handlePageRenderProcessTerminated);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageWindowCloseRequested,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::windowCloseRequested,
                       this,
                       &WebEnginePaneSignalHandler::handlePageWindowCloseRequested);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageRegisterProtocolHandlerRequested,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::registerProtocolHandlerRequested,
                       this,
                       &WebEnginePaneSignalHandler::handlePageRegisterProtocolHandlerRequested);
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageNotificationShown,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::notificationShown,
                       this,
                       &WebEnginePaneSignalHandler::handlePageNotificationShown);
-    ENSURE_QT_CONNECT(this,
-                      &WebEngineSignals::pageNotificationClosed,
+    ENSURE_QT_CONNECT(page,
+                      &QWebEnginePage::notificationClosed,
                       this,
                       &WebEnginePaneSignalHandler::handlePageNotificationClosed);
 #endif
@@ -120,6 +144,9 @@ void WebEnginePaneSignalHandler::handleViewUrlChanged(const QUrl &url)
     if (!m_pane) {
         return;
     }
+    if (m_pane->m_recovery) {
+        m_pane->m_recovery->handleUrlChanged(url);
+    }
     Q_EMIT m_pane->urlChanged(url);
 }
 
@@ -141,54 +168,60 @@ void WebEnginePaneSignalHandler::handleViewIconChanged(const QIcon &icon)
 
 void WebEnginePaneSignalHandler::handleViewLoadStarted()
 {
+    TRACE_INSTANT("pane", "loadStarted");
+    m_loadTimer.start();
     if (m_pane) {
         m_pane->handleLoadStarted();
     }
 }
 
-void WebEnginePaneSignalHandler::handleViewLoadProgress(int progress)
-{
-    Q_UNUSED(progress);
-}
-
 void WebEnginePaneSignalHandler::handleViewLoadFinished(bool ok)
 {
+    TRACE_INSTANT_ARG("pane", "loadFinished", "ok", ok ? QStringLiteral("true") : QStringLiteral("false"));
+    loadOutcomeCounter(ok).increment();
+    if (m_loadTimer.isValid()) {
+        static MetricsRegistry::Histogram &s_duration = MetricsRegistry::instance().histogram(
+            "webengine_demo_page_load_duration_seconds", "Time from loadStarted to loadFinished.",
+            MetricsRegistry::latencyBuckets());
+        s_duration.observe(m_loadTimer.nsecsElapsed() / 1e9);
+        m_loadTimer.invalidate();
+    }
     if (!m_pane) {
         return;
     }
     m_pane->m_lastLoadSucceeded = ok;
-    if (m_pane->m_lastLoadSucceeded && m_pane->m_jsReady) {
+    if (m_pane->m_recovery) {
+        m_pane->m_recovery->handleLoadFinished(ok);
+    }
+    if (m_pane->m_timing) {
+        m_pane->m_timing->handleLoadFinished(ok);
+    }
+    if (m_pane->m_downloads) {
+        m_pane->m_downloads->setPageLoading(m_pane->m_view->page(), false);
+    }
+    if (m_pane->m_jsReady) {
         m_pane->flushPendingMessages();
     }
     Q_EMIT m_pane->loadFinished(ok);
 }
 
-void WebEnginePaneSignalHandler::handleViewSelectionChanged()
-{
-    // no-op hook for future use
-}
-
 void WebEnginePaneSignalHandler::handleViewRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status,
                                                                    int exitCode)
 {
     qWarning() << "QWebEngineView render process terminated" << status << exitCode;
+    m_loadTimer.invalidate();
+    MetricsRegistry::instance()
+        .counter("webengine_demo_render_process_terminations_total", "Render process terminations by status.",
+                 {{"status", terminationStatusLabel(status)}})
+        .increment();
     if (m_pane) {
         m_pane->resetLoadState();
+        if (m_pane->m_recovery) {
+            m_pane->m_recovery->handleRenderProcessTerminated(status, exitCode);
+        }
     }
 }
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
-void WebEnginePaneSignalHandler::handleViewFindTextFinished(const QWebEngineFindTextResult &result)
-{
-    Q_UNUSED(result);
-}
-#endif
-
-void WebEnginePaneSignalHandler::handlePageLinkHovered(const QString &url)
-{
-    Q_UNUSED(url);
-}
-
 void WebEnginePaneSignalHandler::handlePageFullScreenRequested(QWebEngineFullScreenRequest request)
 {
     request.accept();
@@ -243,12 +276,6 @@ void WebEnginePaneSignalHandler::handlePageProxyAuthenticationRequired(const QUr
     }
 }
 
-void WebEnginePaneSignalHandler::handlePageRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status,
-                                                                   int exitCode)
-{
-    handleViewRenderProcessTerminated(status, exitCode);
-}
-
 void WebEnginePaneSignalHandler::handlePageWindowCloseRequested()
 {
     if (auto *view = m_pane ? m_pane->view() : nullptr) {
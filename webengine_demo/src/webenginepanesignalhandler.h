@@ -2,8 +2,12 @@
 
 #include "webenginesignals.h"
 
+#include <QElapsedTimer>
+
 class WebEnginePane;
 
+// WebEnginePaneSignalHandler 在 attachView/attachPage 中把用到的上游信号直接连到处理函数，
+// 不经过 hub 信号转发；未使用的信号（loadProgress、linkHovered 等）不会建立任何连接。
 class WebEnginePaneSignalHandler final : public WebEngineSignals
 {
 public:
@@ -11,6 +15,10 @@ public:
 
     void updateFullScreen(bool enabled);
 
+protected:
+    void attachView(QWebEngineView *view) override;
+    void attachPage(QWebEnginePage *page) override;
+
 private:
     void handleViewAttached(QWebEngineView *view);
     void handleViewDetached();
@@ -18,14 +26,8 @@ private:
     void handleViewTitleChanged(const QString &title);
     void handleViewIconChanged(const QIcon &icon);
     void handleViewLoadStarted();
-    void handleViewLoadProgress(int progress);
     void handleViewLoadFinished(bool ok);
-    void handleViewSelectionChanged();
     void handleViewRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status, int exitCode);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
-    void handleViewFindTextFinished(const QWebEngineFindTextResult &result);
-#endif
-    void handlePageLinkHovered(const QString &url);
     void handlePageFullScreenRequested(QWebEngineFullScreenRequest request);
     void handlePageFeaturePermissionRequested(const QUrl &securityOrigin, QWebEnginePage::Feature feature);
     void handlePageFeaturePermissionRequestCanceled(const QUrl &securityOrigin, QWebEnginePage::Feature feature);
@@ -35,7 +37,6 @@ private:
     void handlePageProxyAuthenticationRequired(const QUrl &requestUrl,
                                                QAuthenticator *authenticator,
                                                const QString &proxyHost);
-    void handlePageRenderProcessTerminated(QWebEnginePage::RenderProcessTerminationStatus status, int exitCode);
     void handlePageWindowCloseRequested();
     void handlePageRegisterProtocolHandlerRequested(const QWebEngineRegisterProtocolHandlerRequest &request);
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
@@ -45,6 +46,8 @@ private:
 
 private:
     WebEnginePane *m_pane {nullptr};
+    // 从 loadStarted 起计时，loadFinished 时写入加载耗时直方图
+    QElapsedTimer m_loadTimer;
 };
 
 
@@ -3,12 +3,120 @@
 #include "connectguard.h"
 
 #include <QAuthenticator>
+#include <QMetaMethod>
+#include <QVector>
 #include <QtGlobal>
-//#include <QWebEngineDownloadRequest>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QWebEngineDownloadRequest>
+#else
+#include <QWebEngineDownloadItem>
+#endif
 //#include <QWebEngineNewWindowRequest>
 #include <QWebEngineProfile>
 #include <QWebEngineView>
 
+#include <functional>
+
+namespace {
+enum class Source
+{
+    View,
+    Page,
+};
+
+// hub 信号与上游信号的对应关系；只有当 hub 信号有接收者时才建立上游连接
+struct Forwarder
+{
+    QMetaMethod signal;
+    Source source;
+    std::function<QMetaObject::Connection(WebEngineSignals *hub, QObject *upstream)> connect;
+};
+
+template <typename Upstream, typename UpstreamSignal, typename HubSignal>
+Forwarder forward(Source source, UpstreamSignal upstreamSignal, HubSignal hubSignal)
+{
+    return {QMetaMethod::fromSignal(hubSignal), source, [upstreamSignal, hubSignal](WebEngineSignals *hub, QObject *upstream) {
+                return QObject::connect(static_cast<Upstream *>(upstream), upstreamSignal, hub, hubSignal);
+            }};
+}
+
+const QVector<Forwarder> &forwarders()
+{
+    static const QVector<Forwarder> table {
+        forward<QWebEngineView>(Source::View, &QWebEngineView::urlChanged, &WebEngineSignals::viewUrlChanged),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::titleChanged, &WebEngineSignals::viewTitleChanged),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::iconChanged, &WebEngineSignals::viewIconChanged),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::loadStarted, &WebEngineSignals::viewLoadStarted),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::loadProgress, &WebEngineSignals::viewLoadProgress),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::loadFinished, &WebEngineSignals::viewLoadFinished),
+        forward<QWebEngineView>(Source::View, &QWebEngineView::selectionChanged, &WebEngineSignals::viewSelectionChanged),
+        forward<QWebEngineView>(Source::View,
+                                &QWebEngineView::renderProcessTerminated,
+                                &WebEngineSignals::viewRenderProcessTerminated),
+#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
+        forward<QWebEngineView>(Source::View, &QWebEngineView::findTextFinished, &WebEngineSignals::viewFindTextFinished),
+#endif
+        forward<QWebEnginePage>(Source::Page, &QWebEnginePage::linkHovered, &WebEngineSignals::pageLinkHovered),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::fullScreenRequested,
+                                &WebEngineSignals::pageFullScreenRequested),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::featurePermissionRequested,
+                                &WebEngineSignals::pageFeaturePermissionRequested),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::featurePermissionRequestCanceled,
+                                &WebEngineSignals::pageFeaturePermissionRequestCanceled),
+        forward<QWebEnginePage>(Source::Page, &QWebEnginePage::quotaRequested, &WebEngineSignals::pageQuotaRequested),
+        //forward<QWebEnginePage>(Source::Page, &QWebEnginePage::certificateError, &WebEngineSignals::pageCertificateError),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::selectClientCertificate,
+                                &WebEngineSignals::pageSelectClientCertificate),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::authenticationRequired,
+                                &WebEngineSignals::pageAuthenticationRequired),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::proxyAuthenticationRequired,
+                                &WebEngineSignals::pageProxyAuthenticationRequired),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::renderProcessTerminated,
+                                &WebEngineSignals::pageRenderProcessTerminated),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::windowCloseRequested,
+                                &WebEngineSignals::pageWindowCloseRequested),
+        forward<QWebEnginePage>(Source::Page,
+                                &QWebEnginePage::registerProtocolHandlerRequested,
+                                &WebEngineSignals::pageRegisterProtocolHandlerRequested),
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+        forward<QWebEnginePage>(Source::Page, &QWebEnginePage::notificationShown, &WebEngineSignals::pageNotificationShown),
+        forward<QWebEnginePage>(Source::Page, &QWebEnginePage::notificationClosed, &WebEngineSignals::pageNotificationClosed),
+#endif
+        // 下载请求由 profile 发出，只转发属于当前页面的那部分；接受与调度由 DownloadManager 负责
+        {QMetaMethod::fromSignal(&WebEngineSignals::pageDownloadRequested),
+         Source::Page,
+         [](WebEngineSignals *hub, QObject *upstream) {
+             auto *page = static_cast<QWebEnginePage *>(upstream);
+             return QObject::connect(page->profile(), &QWebEngineProfile::downloadRequested, hub,
+                                     [hub, page](WebEngineDownload *download) {
+                                         if (download && download->page() == page) {
+                                             emit hub->pageDownloadRequested(download);
+                                         }
+                                     });
+         }},
+    };
+    return table;
+}
+
+const Forwarder *findForwarder(const QMetaMethod &signal)
+{
+    for (const Forwarder &forwarder : forwarders()) {
+        if (forwarder.signal == signal) {
+            return &forwarder;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
 WebEngineSignals::WebEngineSignals(QObject *parent)
     : QObject(parent)
 {
@@ -60,6 +168,43 @@ QWebEnginePage *WebEngineSignals::page() const
     return m_page.data();
 }
 
+int WebEngineSignals::upstreamConnectionCount() const
+{
+    return m_upstream.size();
+}
+
+void WebEngineSignals::connectNotify(const QMetaMethod &signal)
+{
+    // Qt 在释放内部锁之后才调用 connectNotify，这里可以安全地建立上游连接；仅限 GUI 线程使用
+    const Forwarder *forwarder = findForwarder(signal);
+    if (!forwarder || m_upstream.contains(signal.methodIndex())) {
+        return;
+    }
+    connectUpstream(signal.methodIndex());
+}
+
+void WebEngineSignals::disconnectNotify(const QMetaMethod &signal)
+{
+    // disconnectNotify 可能在持有内部锁或接收者析构期间被调用，上游连接延后到事件循环中再清理
+    if (signal.isValid() && !findForwarder(signal)) {
+        return;
+    }
+    if (!m_pruneScheduled) {
+        m_pruneScheduled = true;
+        QMetaObject::invokeMethod(this, &WebEngineSignals::pruneUpstream, Qt::QueuedConnection);
+    }
+}
+
+void WebEngineSignals::attachView(QWebEngineView *view)
+{
+    Q_UNUSED(view);
+}
+
+void WebEngineSignals::attachPage(QWebEnginePage *page)
+{
+    Q_UNUSED(page);
+}
+
 void WebEngineSignals::handleViewDestroyed()
 {
     disconnectViewSignals();
@@ -83,92 +228,82 @@ void WebEngineSignals::handlePageChanged(QWebEnginePage *page)
 
 void WebEngineSignals::connectViewSignals(QWebEngineView *view)
 {
-    ENSURE_QT_CONNECT(view, &QWebEngineView::urlChanged, this, &WebEngineSignals::viewUrlChanged);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::titleChanged, this, &WebEngineSignals::viewTitleChanged);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::iconChanged, this, &WebEngineSignals::viewIconChanged);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::loadStarted, this, &WebEngineSignals::viewLoadStarted);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::loadProgress, this, &WebEngineSignals::viewLoadProgress);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::loadFinished, this, &WebEngineSignals::viewLoadFinished);
-    //ENSURE_QT_CONNECT(view, &QWebEngineView::loadingChanged, this, &WebEngineSignals::viewLoadingChanged);
-    ENSURE_QT_CONNECT(view, &QWebEngineView::selectionChanged, this, &WebEngineSignals::viewSelectionChanged);
-    ENSURE_QT_CONNECT(view,
-                      &QWebEngineView::renderProcessTerminated,
-                      this,
-                      &WebEngineSignals::viewRenderProcessTerminated);
-    //ENSURE_QT_CONNECT(view, &QWebEngineView::zoomFactorChanged, this, &WebEngineSignals::viewZoomFactorChanged);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
-    ENSURE_QT_CONNECT(view, &QWebEngineView::findTextFinished, this, &WebEngineSignals::viewFindTextFinished);
-#endif
+    connectListenedSignals(true);
+    attachView(view);
 }
 
 void WebEngineSignals::connectPageSignals(QWebEnginePage *page)
 {
-    ENSURE_QT_CONNECT(page, &QWebEnginePage::linkHovered, this, &WebEngineSignals::pageLinkHovered);
-    ENSURE_QT_CONNECT(page, &QWebEnginePage::fullScreenRequested, this, &WebEngineSignals::pageFullScreenRequested);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::featurePermissionRequested,
-                      this,
-                      &WebEngineSignals::pageFeaturePermissionRequested);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::featurePermissionRequestCanceled,
-                      this,
-                      &WebEngineSignals::pageFeaturePermissionRequestCanceled);
-    ENSURE_QT_CONNECT(page, &QWebEnginePage::quotaRequested, this, &WebEngineSignals::pageQuotaRequested);
-    //ENSURE_QT_CONNECT(page, &QWebEnginePage::certificateError, this, &WebEngineSignals::pageCertificateError);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::selectClientCertificate,
-                      this,
-                      &WebEngineSignals::pageSelectClientCertificate);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::authenticationRequired,
-                      this,
-                      &WebEngineSignals::pageAuthenticationRequired);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::proxyAuthenticationRequired,
-                      this,
-                      &WebEngineSignals::pageProxyAuthenticationRequired);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::renderProcessTerminated,
-                      this,
-                      &WebEngineSignals::pageRenderProcessTerminated);
-    ENSURE_QT_CONNECT(page, &QWebEnginePage::windowCloseRequested, this, &WebEngineSignals::pageWindowCloseRequested);
-    //ENSURE_QT_CONNECT(page, &QWebEnginePage::profileChanged, this, &WebEngineSignals::pageProfileChanged);
-    //ENSURE_QT_CONNECT(page,
-    //                  &QWebEnginePage::newWindowRequested,
-    //                  this,
-    //                  &WebEngineSignals::pageNewWindowRequested);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::registerProtocolHandlerRequested,
-                      this,
-                      &WebEngineSignals::pageRegisterProtocolHandlerRequested);
-    //ENSURE_QT_CONNECT(page,
-    //                  &QWebEnginePage::downloadRequested,
-    //                  this,
-    //                  &WebEngineSignals::pageDownloadRequested);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::notificationShown,
-                      this,
-                      &WebEngineSignals::pageNotificationShown);
-    ENSURE_QT_CONNECT(page,
-                      &QWebEnginePage::notificationClosed,
-                      this,
-                      &WebEngineSignals::pageNotificationClosed);
-#endif
+    connectListenedSignals(false);
+    attachPage(page);
+}
+
+void WebEngineSignals::connectListenedSignals(bool viewSignals)
+{
+    const Source wanted = viewSignals ? Source::View : Source::Page;
+    for (const Forwarder &forwarder : forwarders()) {
+        if (forwarder.source == wanted && isSignalConnected(forwarder.signal)) {
+            connectUpstream(forwarder.signal.methodIndex());
+        }
+    }
+}
+
+void WebEngineSignals::connectUpstream(int signalIndex)
+{
+    const Forwarder *forwarder = findForwarder(metaObject()->method(signalIndex));
+    QObject *upstream = nullptr;
+    if (forwarder) {
+        upstream = forwarder->source == Source::View ? static_cast<QObject *>(m_view.data())
+                                                     : static_cast<QObject *>(m_page.data());
+    }
+    if (!upstream) {
+        return;
+    }
+    const QMetaObject::Connection connection = forwarder->connect(this, upstream);
+    ConnectGuard::verify(connection, forwarder->signal.methodSignature().constData(), __FILE__, __LINE__);
+    m_upstream.insert(signalIndex, connection);
+}
+
+void WebEngineSignals::pruneUpstream()
+{
+    m_pruneScheduled = false;
+    for (auto it = m_upstream.begin(); it != m_upstream.end();) {
+        if (!isSignalConnected(metaObject()->method(it.key()))) {
+            disconnect(it.value());
+            it = m_upstream.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void WebEngineSignals::disconnectViewSignals()
 {
+    disconnectUpstream(true);
     if (!m_view.isNull()) {
+        // 同时断开子类在 attachView 中直接连接的处理函数
         disconnect(m_view.data(), nullptr, this, nullptr);
     }
 }
 
 void WebEngineSignals::disconnectPageSignals()
 {
+    disconnectUpstream(false);
     if (!m_page.isNull()) {
         disconnect(m_page.data(), nullptr, this, nullptr);
     }
 }
 
-
+void WebEngineSignals::disconnectUpstream(bool viewSignals)
+{
+    const Source wanted = viewSignals ? Source::View : Source::Page;
+    for (auto it = m_upstream.begin(); it != m_upstream.end();) {
+        const Forwarder *forwarder = findForwarder(metaObject()->method(it.key()));
+        if (forwarder && forwarder->source == wanted) {
+            disconnect(it.value());
+            it = m_upstream.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <QHash>
+#include <QMetaObject>
 #include <QObject>
 #include <QPointer>
 #include <QIcon>
@@ -21,13 +23,21 @@
 
 class QAuthenticator;
 class QPoint;
-class QWebEngineDownloadRequest;
 class QWebEngineNewWindowRequest;
 class QWebEngineProfile;
 class QWebEngineView;
 
-// WebEngineSignals 负责集中连接 QWebEngineView/QWebEnginePage 的常用信号，
-// 方便子类继承后一次性获得所有 WebEngine 相关事件。
+// Qt 5 的下载对象是 QWebEngineDownloadItem，Qt 6 改名为 QWebEngineDownloadRequest，接口基本一致
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+class QWebEngineDownloadRequest;
+using WebEngineDownload = QWebEngineDownloadRequest;
+#else
+class QWebEngineDownloadItem;
+using WebEngineDownload = QWebEngineDownloadItem;
+#endif
+
+// WebEngineSignals 负责集中转发 QWebEngineView/QWebEnginePage 的常用信号，方便子类继承后获得所有 WebEngine 相关事件。
+// 上游信号按需连接：只有 hub 信号有接收者时才建立转发；子类可在 attachView/attachPage 中直接连接上游，省去一次转发。
 class WebEngineSignals : public QObject
 {
     Q_OBJECT
@@ -40,6 +50,8 @@ public:
 
     QWebEngineView *view() const;
     QWebEnginePage *page() const;
+    // 当前已建立的上游转发连接数，用于观察按需连接的效果
+    int upstreamConnectionCount() const;
 
 signals:
     void viewAttached(QWebEngineView *view);
@@ -71,10 +83,18 @@ signals:
     //void pageProfileChanged(QWebEngineProfile *profile);
     //void pageNewWindowRequested(const QWebEngineNewWindowRequest &request);
     void pageRegisterProtocolHandlerRequested(const QWebEngineRegisterProtocolHandlerRequest &request);
-    void pageDownloadRequested(QWebEngineDownloadRequest *download);
+    void pageDownloadRequested(WebEngineDownload *download);
     void pageNotificationShown(QWebEngineNotification *notification);
     void pageNotificationClosed(QWebEngineNotification *notification);
 
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
+    // 绑定 view / 切换 page 后调用；子类在这里把上游信号直接连到自己的处理函数，解绑时自动断开
+    virtual void attachView(QWebEngineView *view);
+    virtual void attachPage(QWebEnginePage *page);
+
 private slots:
     void handleViewDestroyed();
     void handlePageChanged(QWebEnginePage *page);
@@ -82,11 +102,18 @@ private slots:
 private:
     void connectViewSignals(QWebEngineView *view);
     void connectPageSignals(QWebEnginePage *page);
+    void connectListenedSignals(bool viewSignals);
+    void connectUpstream(int signalIndex);
+    void pruneUpstream();
     void disconnectViewSignals();
     void disconnectPageSignals();
+    void disconnectUpstream(bool viewSignals);
 
     QPointer<QWebEngineView> m_view;
     QPointer<QWebEnginePage> m_page;
+    // hub 信号的方法索引 -> 对应的上游连接
+    QHash<int, QMetaObject::Connection> m_upstream;
+    bool m_pruneScheduled {false};
 };
 
 
@@ -0,0 +1,379 @@
+#include "websocketchannel.h"
+
+#include "configmanager.h"
+#include "connectguard.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QJsonValue>
+#include <QMetaObject>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QUrlQuery>
+#include <QVector>
+#include <QWebChannel>
+#include <QWebSocket>
+#include <QWebSocketServer>
+
+namespace {
+constexpr int kTokenWords = 4;
+
+QPointer<WebSocketChannelServer> s_instance;
+
+struct TransportMetrics
+{
+    MetricsRegistry::Counter *messagesSent {nullptr};
+    MetricsRegistry::Counter *messagesReceived {nullptr};
+    MetricsRegistry::Counter *bytesSent {nullptr};
+    MetricsRegistry::Counter *bytesReceived {nullptr};
+    MetricsRegistry::Counter *offloaded {nullptr};
+    MetricsRegistry::Gauge *connections {nullptr};
+};
+
+const TransportMetrics &transportMetrics()
+{
+    static const TransportMetrics s_metrics = []() {
+        auto &registry = MetricsRegistry::instance();
+        TransportMetrics metrics;
+        metrics.messagesSent = &registry.counter("webengine_demo_channel_socket_messages_total",
+                                                 "QWebChannel messages carried by the WebSocket transport.",
+                                                 {{"direction", QStringLiteral("sent")}});
+        metrics.messagesReceived = &registry.counter("webengine_demo_channel_socket_messages_total",
+                                                     "QWebChannel messages carried by the WebSocket transport.",
+                                                     {{"direction", QStringLiteral("received")}});
+        metrics.bytesSent = &registry.counter("webengine_demo_channel_socket_bytes_total",
+                                              "Serialized QWebChannel message bytes carried by the WebSocket transport.",
+                                              {{"direction", QStringLiteral("sent")}});
+        metrics.bytesReceived = &registry.counter("webengine_demo_channel_socket_bytes_total",
+                                                  "Serialized QWebChannel message bytes carried by the WebSocket transport.",
+                                                  {{"direction", QStringLiteral("received")}});
+        metrics.offloaded = &registry.counter("webengine_demo_channel_socket_offloaded_total",
+                                              "WebSocket transport messages serialized or parsed on the thread pool.");
+        metrics.connections = &registry.gauge("webengine_demo_channel_socket_connections",
+                                              "Open WebSocket connections attached to a QWebChannel.");
+        return metrics;
+    }();
+    return s_metrics;
+}
+
+// 粗略估算紧凑序列化后的字节数，达到 limit 即停止遍历
+qint64 estimateBytes(const QJsonValue &value, qint64 limit)
+{
+    switch (value.type()) {
+    case QJsonValue::String:
+        return value.toString().size() + 2;
+    case QJsonValue::Array: {
+        qint64 total = 2;
+        const QJsonArray array = value.toArray();
+        for (const QJsonValue &item : array) {
+            total += estimateBytes(item, limit - total) + 1;
+            if (total >= limit) {
+                break;
+            }
+        }
+        return total;
+    }
+    case QJsonValue::Object: {
+        qint64 total = 2;
+        const QJsonObject object = value.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd() && total < limit; ++it) {
+            total += it.key().size() + 4 + estimateBytes(it.value(), limit - total);
+        }
+        return total;
+    }
+    default:
+        return 8;
+    }
+}
+
+QJsonObject parseMessage(const QByteArray &frame)
+{
+    QJsonParseError error {};
+    const QJsonDocument doc = QJsonDocument::fromJson(frame, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "WebSocketChannelTransport: dropping malformed message:" << error.errorString();
+        return QJsonObject();
+    }
+    return doc.object();
+}
+
+QString newToken()
+{
+    quint32 words[kTokenWords];
+    QRandomGenerator::system()->fillRange(words);
+    return QString::fromLatin1(QByteArray(reinterpret_cast<const char *>(words), sizeof(words)).toHex());
+}
+} // namespace
+
+WebSocketChannelTransport::WebSocketChannelTransport(QWebSocket *socket, const Options &options, QObject *parent)
+    : QWebChannelAbstractTransport(parent)
+    , m_socket(socket)
+    , m_options(options)
+{
+    m_socket->setParent(this);
+    ENSURE_QT_CONNECT(m_socket, &QWebSocket::textMessageReceived, this, [this](const QString &message) {
+        receiveFrame(message.toUtf8());
+    });
+    ENSURE_QT_CONNECT(m_socket, &QWebSocket::binaryMessageReceived, this, &WebSocketChannelTransport::receiveFrame);
+    ENSURE_QT_CONNECT(m_socket, &QWebSocket::disconnected, this, &QObject::deleteLater);
+    transportMetrics().connections->add(1);
+}
+
+WebSocketChannelTransport::~WebSocketChannelTransport()
+{
+    transportMetrics().connections->add(-1);
+}
+
+void WebSocketChannelTransport::sendMessage(const QJsonObject &message)
+{
+    const quint64 seq = m_nextOutgoing++;
+    const int threshold = m_options.workerThresholdBytes;
+    if (threshold > 0 && estimateBytes(message, threshold) < threshold) {
+        deliverOutgoing(seq, QJsonDocument(message).toJson(QJsonDocument::Compact));
+        return;
+    }
+
+    // 大消息在线程池中序列化，结果经 qApp 排队回到 GUI 线程按序发送
+    transportMetrics().offloaded->increment();
+    const QPointer<WebSocketChannelTransport> guard(this);
+    QThreadPool::globalInstance()->start([guard, seq, message]() {
+        const QByteArray bytes = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, seq, bytes]() {
+                if (guard) {
+                    guard->deliverOutgoing(seq, bytes);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void WebSocketChannelTransport::receiveFrame(const QByteArray &frame)
+{
+    const quint64 seq = m_nextIncoming++;
+    transportMetrics().bytesReceived->increment(static_cast<quint64>(frame.size()));
+    const int threshold = m_options.workerThresholdBytes;
+    if (threshold > 0 && frame.size() < threshold) {
+        deliverIncoming(seq, parseMessage(frame));
+        return;
+    }
+
+    transportMetrics().offloaded->increment();
+    const QPointer<WebSocketChannelTransport> guard(this);
+    QThreadPool::globalInstance()->start([guard, seq, frame]() {
+        const QJsonObject message = parseMessage(frame);
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, seq, message]() {
+                if (guard) {
+                    guard->deliverIncoming(seq, message);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void WebSocketChannelTransport::deliverOutgoing(quint64 seq, const QByteArray &bytes)
+{
+    if (seq != m_flushedOutgoing) {
+        m_readyOutgoing.insert(seq, bytes);
+        return;
+    }
+    sendFrame(bytes);
+    ++m_flushedOutgoing;
+    for (auto it = m_readyOutgoing.find(m_flushedOutgoing); it != m_readyOutgoing.end();
+         it = m_readyOutgoing.find(m_flushedOutgoing)) {
+        sendFrame(it.value());
+        m_readyOutgoing.erase(it);
+        ++m_flushedOutgoing;
+    }
+}
+
+void WebSocketChannelTransport::deliverIncoming(quint64 seq, const QJsonObject &message)
+{
+    if (seq != m_flushedIncoming) {
+        m_readyIncoming.insert(seq, message);
+        return;
+    }
+    // 分发过程中 QWebChannel 可能同步回复并再次进入本对象，先取出再发信号
+    QVector<QJsonObject> ready {message};
+    ++m_flushedIncoming;
+    for (auto it = m_readyIncoming.find(m_flushedIncoming); it != m_readyIncoming.end();
+         it = m_readyIncoming.find(m_flushedIncoming)) {
+        ready.append(it.value());
+        m_readyIncoming.erase(it);
+        ++m_flushedIncoming;
+    }
+    const QPointer<WebSocketChannelTransport> guard(this);
+    for (const QJsonObject &next : std::as_const(ready)) {
+        if (!guard) {
+            return;
+        }
+        // 解析失败的消息只占序号，不分发
+        if (!next.isEmpty()) {
+            transportMetrics().messagesReceived->increment();
+            emit messageReceived(next, this);
+        }
+    }
+}
+
+void WebSocketChannelTransport::sendFrame(const QByteArray &bytes)
+{
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    transportMetrics().messagesSent->increment();
+    transportMetrics().bytesSent->increment(static_cast<quint64>(bytes.size()));
+    if (m_options.binaryFrames) {
+        m_socket->sendBinaryMessage(bytes);
+    } else {
+        m_socket->sendTextMessage(QString::fromUtf8(bytes));
+    }
+}
+
+WebSocketChannelServer *WebSocketChannelServer::instance()
+{
+    if (!s_instance) {
+        s_instance = new WebSocketChannelServer(QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+WebSocketChannelServer *WebSocketChannelServer::existingInstance()
+{
+    return s_instance;
+}
+
+WebSocketChannelServer::WebSocketChannelServer(QObject *parent)
+    : QObject(parent)
+{
+    const ConfigManager::WebChannel config = ConfigManager::instance().webChannel();
+    m_maxMessageBytes = config.maxMessageBytes;
+    m_workerThresholdBytes = config.workerThresholdBytes;
+    m_rejectedCounter = &MetricsRegistry::instance().counter(
+        "webengine_demo_channel_socket_rejected_total", "WebSocket channel connections rejected for an unknown or reused token or a mismatched origin.");
+
+    m_server = new QWebSocketServer(QStringLiteral("WebEngineDemo"), QWebSocketServer::NonSecureMode, this);
+    ENSURE_QT_CONNECT(m_server, &QWebSocketServer::newConnection, this, &WebSocketChannelServer::acceptPending);
+    // 只监听回环地址，端口由系统分配
+    if (!m_server->listen(QHostAddress::LocalHost, 0)) {
+        qWarning() << "WebSocketChannelServer: listen failed:" << m_server->errorString();
+        return;
+    }
+    qInfo() << "WebSocketChannelServer: listening on port" << m_server->serverPort();
+}
+
+bool WebSocketChannelServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+QUrl WebSocketChannelServer::issue(QWebChannel *channel, const QUrl &page)
+{
+    if (!channel || !m_server->isListening()) {
+        return QUrl();
+    }
+    revoke(channel);
+    const QString token = newToken();
+    m_tokens.insert(channel, token);
+    m_grants.insert(token, Grant {channel, page});
+    // 同一个 channel 只连接一次，重复 connect 会让槽函数执行多次
+    disconnect(channel, &QObject::destroyed, this, nullptr);
+    ENSURE_QT_CONNECT(channel, &QObject::destroyed, this, [this, channel]() {
+        m_grants.remove(m_tokens.take(channel));
+    });
+
+    QUrl url;
+    url.setScheme(QStringLiteral("ws"));
+    url.setHost(m_server->serverAddress().toString());
+    url.setPort(m_server->serverPort());
+    url.setPath(QStringLiteral("/"));
+    url.setQuery(QUrlQuery {{QStringLiteral("token"), token}});
+    return url;
+}
+
+void WebSocketChannelServer::revoke(QWebChannel *channel)
+{
+    const QString token = m_tokens.take(channel);
+    if (!token.isEmpty()) {
+        m_grants.remove(token);
+    }
+}
+
+void WebSocketChannelServer::detach(QWebChannel *channel)
+{
+    if (!channel) {
+        return;
+    }
+    revoke(channel);
+    disconnect(channel, &QObject::destroyed, this, nullptr);
+    const auto transports = channel->findChildren<WebSocketChannelTransport *>(QString(), Qt::FindDirectChildrenOnly);
+    for (WebSocketChannelTransport *transport : transports) {
+        transport->deleteLater();
+    }
+}
+
+void WebSocketChannelServer::acceptPending()
+{
+    while (QWebSocket *socket = m_server->nextPendingConnection()) {
+        const QUrlQuery query(socket->requestUrl());
+        const QString token = query.queryItemValue(QStringLiteral("token"));
+        // 令牌只能使用一次：不论连接是否通过后续校验，取出后即作废
+        const auto it = m_grants.find(token);
+        if (token.isEmpty() || it == m_grants.end()) {
+            reject(socket, "unknown token");
+            continue;
+        }
+        const Grant grant = it.value();
+        m_grants.erase(it);
+        m_tokens.remove(grant.channel.data());
+        if (!grant.channel) {
+            reject(socket, "channel destroyed");
+            continue;
+        }
+        if (!originMatches(socket->origin(), grant.page)) {
+            reject(socket, "origin mismatch");
+            continue;
+        }
+
+        // 上一个文档的连接在新文档接入时关闭，channel 同一时刻只服务当前页面
+        const auto previous = grant.channel->findChildren<WebSocketChannelTransport *>(QString(), Qt::FindDirectChildrenOnly);
+        for (WebSocketChannelTransport *transport : previous) {
+            transport->deleteLater();
+        }
+        socket->setMaxAllowedIncomingMessageSize(static_cast<quint64>(m_maxMessageBytes));
+        socket->setMaxAllowedIncomingFrameSize(static_cast<quint64>(m_maxMessageBytes));
+        WebSocketChannelTransport::Options options;
+        options.binaryFrames = query.queryItemValue(QStringLiteral("binary")) == QLatin1String("1");
+        options.workerThresholdBytes = m_workerThresholdBytes;
+        // transport 是 channel 的子对象，随 channel 销毁；transport 销毁时 QWebChannel 自动断开它
+        grant.channel->connectTo(new WebSocketChannelTransport(socket, options, grant.channel));
+    }
+}
+
+void WebSocketChannelServer::reject(QWebSocket *socket, const char *reason)
+{
+    m_rejectedCounter->increment();
+    qWarning() << "WebSocketChannelServer: rejecting connection from" << socket->peerAddress().toString()
+               << "origin" << socket->origin() << "-" << reason;
+    socket->close(QWebSocketProtocol::CloseCodePolicyViolated);
+    socket->deleteLater();
+}
+
+bool WebSocketChannelServer::originMatches(const QString &origin, const QUrl &page)
+{
+    // 没有主机部分的 scheme（qrc:/index.html）在 Chromium 中是不透明来源，Origin 头为 "null"
+    if (page.host().isEmpty()) {
+        return origin == QLatin1String("null") || origin == page.scheme() + QLatin1String("://");
+    }
+    QUrl expected;
+    expected.setScheme(page.scheme());
+    expected.setHost(page.host());
+    expected.setPort(page.port());
+    return origin == expected.toString(QUrl::FullyEncoded);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "metricsregistry.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+#include <QWebChannelAbstractTransport>
+
+class QWebChannel;
+class QWebSocket;
+class QWebSocketServer;
+
+// WebSocketChannelTransport 把一个本机回环 WebSocket 连接作为 QWebChannel 的传输：
+// 小消息在 GUI 线程直接序列化 / 解析，超过阈值的放到线程池，按序号重排后依次发送或分发，保证两个方向的消息顺序不变。
+class WebSocketChannelTransport final : public QWebChannelAbstractTransport
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        // 客户端在连接 URL 中带 binary=1 时以二进制帧发送 UTF-8 JSON，省去页面侧的字符串帧校验
+        bool binaryFrames {false};
+        // 估算大小达到该值的消息交给线程池处理，0 表示全部在线程池处理
+        int workerThresholdBytes {16 * 1024};
+    };
+
+    // 接管 socket 的所有权；socket 断开后对象自行销毁
+    WebSocketChannelTransport(QWebSocket *socket, const Options &options, QObject *parent = nullptr);
+    ~WebSocketChannelTransport() override;
+
+    void sendMessage(const QJsonObject &message) override;
+
+private:
+    void receiveFrame(const QByteArray &frame);
+    // 以下两个函数按序号排队，前面的消息还在线程池中时先缓存
+    void deliverOutgoing(quint64 seq, const QByteArray &bytes);
+    void deliverIncoming(quint64 seq, const QJsonObject &message);
+    void sendFrame(const QByteArray &bytes);
+
+    QWebSocket *m_socket {nullptr};
+    const Options m_options;
+    quint64 m_nextOutgoing {0};
+    quint64 m_flushedOutgoing {0};
+    QHash<quint64, QByteArray> m_readyOutgoing;
+    quint64 m_nextIncoming {0};
+    quint64 m_flushedIncoming {0};
+    QHash<quint64, QJsonObject> m_readyIncoming;
+};
+
+// WebSocketChannelServer 是进程内共用的回环 WebSocket 服务：每次导航为 QWebChannel 签发一个一次性令牌，
+// 令牌绑定目标页面的来源，第一条带该令牌且 Origin 匹配的连接接到 channel 上，令牌随即作废；其余连接一律拒绝。
+class WebSocketChannelServer final : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 首次调用时在 127.0.0.1 的随机端口上开始监听
+    static WebSocketChannelServer *instance();
+    // 尚未创建时返回 nullptr
+    static WebSocketChannelServer *existingInstance();
+
+    bool isListening() const;
+    // 作废 channel 尚未使用的令牌并签发新令牌，返回 ws://127.0.0.1:<端口>/?token=<令牌>；监听失败时返回无效 URL
+    QUrl issue(QWebChannel *channel, const QUrl &page);
+    // 作废 channel 尚未使用的令牌，已建立的连接不受影响
+    void revoke(QWebChannel *channel);
+    // 作废令牌并关闭该 channel 已建立的连接
+    void detach(QWebChannel *channel);
+
+private:
+    struct Grant
+    {
+        QPointer<QWebChannel> channel;
+        QUrl page;
+    };
+
+    explicit WebSocketChannelServer(QObject *parent);
+
+    void acceptPending();
+    void reject(QWebSocket *socket, const char *reason);
+    static bool originMatches(const QString &origin, const QUrl &page);
+
+    QWebSocketServer *m_server {nullptr};
+    qint64 m_maxMessageBytes {0};
+    int m_workerThresholdBytes {0};
+    QHash<QString, Grant> m_grants;
+    QHash<QWebChannel *, QString> m_tokens;
+    MetricsRegistry::Counter *m_rejectedCounter {nullptr};
+};
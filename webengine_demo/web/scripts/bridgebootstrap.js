@@ -0,0 +1,107 @@
+// 由 UserScriptRegistry 与 qwebchannel.js 一起在 DocumentCreation 阶段注入：页面脚本运行前就开始建立 QWebChannel，
+// 页面通过 window.qtBridgeReady.then((bridge) => ...) 取得 bridge。qrc: 页面在已注册的回调执行完后自动调用 notifyPageReady()，
+// 其他页面挂好监听后需自行调用 bridge.notifyPageReady()，否则 C++ 的消息一直留在队列中。
+// channelSocketUrl 由 UserScriptRegistry 作为外层函数参数传入：非空且当前是 qrc: 页面时经本机 WebSocket 连接，否则使用页面内置的 qt.webChannelTransport。
+(function () {
+    'use strict';
+    if (window.qtBridgeReady || window.top !== window || typeof QWebChannel !== 'function') {
+        return;
+    }
+
+    // transport 通常在脚本上下文创建时已就绪，个别情况下稍晚，短暂重试
+    const kMaxAttempts = 50;
+    // 收到的 C++ 消息数合并后再确认，C++ 只在渲染进程崩溃后重放尚未确认的消息
+    const kAckDelayMs = 250;
+    let attempts = 0;
+    let resolveReady = null;
+    window.qtBridgeReady = new Promise((resolve) => {
+        resolveReady = resolve;
+    });
+
+    const start = (transport) => {
+        new QWebChannel(transport, (channel) => {
+            const bridge = channel.objects.bridge;
+            if (!bridge) {
+                return;
+            }
+            const readyMs = performance.now();
+            window.qtBridge = bridge;
+            window.__qtBridge = bridge;
+            if (typeof bridge.acknowledgeMessages === 'function') {
+                let received = 0;
+                let ackTimer = 0;
+                const count = (n) => {
+                    received += n;
+                    if (!ackTimer) {
+                        ackTimer = setTimeout(() => {
+                            ackTimer = 0;
+                            bridge.acknowledgeMessages(received);
+                        }, kAckDelayMs);
+                    }
+                };
+                bridge.messageFromCpp.connect(() => count(1));
+                bridge.messageBatchFromCpp.connect((payloads) => count(payloads.length));
+            }
+            resolveReady(bridge);
+            // then 回调按注册顺序执行，这里排在页面已注册的回调之后
+            window.qtBridgeReady.then(() => {
+                if (typeof bridge.reportTelemetry === 'function') {
+                    bridge.reportTelemetry('bridge', JSON.stringify({ readyMs }));
+                }
+                if (location.protocol === 'qrc:' && typeof bridge.notifyPageReady === 'function') {
+                    bridge.notifyPageReady();
+                }
+            });
+        });
+    };
+
+    // C++ 以二进制帧发送 UTF-8 JSON，解码成字符串后交给 qwebchannel.js；页面发出的消息同样编码为二进制帧
+    const openSocket = (url) => {
+        const socket = new WebSocket(url + '&binary=1');
+        socket.binaryType = 'arraybuffer';
+        const encoder = new TextEncoder();
+        const decoder = new TextDecoder();
+        const transport = {
+            onmessage: null,
+            send(message) {
+                socket.send(encoder.encode(message));
+            },
+        };
+        let opened = false;
+        socket.onopen = () => {
+            opened = true;
+            start(transport);
+        };
+        socket.onmessage = (event) => {
+            if (transport.onmessage) {
+                const data = typeof event.data === 'string' ? event.data : decoder.decode(event.data);
+                transport.onmessage({ data });
+            }
+        };
+        // 令牌只能用一次，被拒绝后重试没有意义
+        socket.onclose = () => {
+            if (!opened) {
+                console.warn('qt bridge: channel socket rejected');
+            }
+        };
+    };
+
+    const connect = () => {
+        if (channelSocketUrl) {
+            // 令牌只签发给 qrc: 页面，服务端还会校验 Origin
+            if (location.protocol === 'qrc:') {
+                openSocket(channelSocketUrl);
+            }
+            return;
+        }
+        if (!(window.qt && window.qt.webChannelTransport)) {
+            attempts += 1;
+            if (attempts < kMaxAttempts) {
+                setTimeout(connect, 0);
+            }
+            return;
+        }
+        start(window.qt.webChannelTransport);
+    };
+    connect();
+})();
@@ -0,0 +1,125 @@
+// JankMonitor 启用期间（默认启用）于 DocumentCreation 阶段注入：统计 requestAnimationFrame 帧间隔与 longtask，
+// 每秒聚合一次；bridge 可用时主动通过 reportTelemetry 上报，否则等待 C++ 调用 flush() 拉取。
+// setEnabled(false) 停掉 rAF 循环、上报定时器与 longtask 观察者，页面上不再有任何周期性开销。
+(function () {
+    'use strict';
+    if (window.__qtFrames || window.top !== window) {
+        return;
+    }
+
+    const kFrameBudgetMs = 1000 / 60;
+    const kReportIntervalMs = 1000;
+    // 长任务直方图上界（毫秒），最后一个桶收集 >= 1000ms 的任务
+    const kLongTaskBuckets = [100, 250, 500, 1000];
+
+    const freshWindow = () => ({
+        startedAt: performance.now(),
+        frames: 0,
+        frameTimeSum: 0,
+        worstFrame: 0,
+        dropped: 0,
+        longTasks: 0,
+        longTaskMs: 0,
+        histogram: new Array(kLongTaskBuckets.length + 1).fill(0),
+    });
+
+    let current = freshWindow();
+    let lastFrame = 0;
+    let enabled = false;
+    let reportTimer = 0;
+    let longTaskObserver = null;
+
+    const onFrame = (now) => {
+        if (!enabled) {
+            lastFrame = 0;
+            return;
+        }
+        if (lastFrame) {
+            const delta = now - lastFrame;
+            current.frames += 1;
+            current.frameTimeSum += delta;
+            current.worstFrame = Math.max(current.worstFrame, delta);
+            const missed = Math.round(delta / kFrameBudgetMs) - 1;
+            if (missed > 0) {
+                current.dropped += missed;
+            }
+        }
+        lastFrame = now;
+        requestAnimationFrame(onFrame);
+    };
+
+    // 页面隐藏时 rAF 自动暂停，恢复后的第一帧间隔不计入统计
+    document.addEventListener('visibilitychange', () => {
+        lastFrame = 0;
+    });
+
+    const observeLongTasks = () => {
+        try {
+            longTaskObserver = new PerformanceObserver((list) => {
+                list.getEntries().forEach((entry) => {
+                    const index = kLongTaskBuckets.findIndex((bound) => entry.duration < bound);
+                    current.longTasks += 1;
+                    current.longTaskMs += entry.duration;
+                    current.histogram[index < 0 ? kLongTaskBuckets.length : index] += 1;
+                });
+            });
+            longTaskObserver.observe({ type: 'longtask', buffered: false });
+        } catch (e) {
+            // 不支持 longtask 时只统计帧率
+            longTaskObserver = null;
+        }
+    };
+
+    const take = () => {
+        const elapsed = performance.now() - current.startedAt;
+        const report = {
+            elapsedMs: elapsed,
+            frames: current.frames,
+            fps: elapsed > 0 ? (current.frames * 1000) / elapsed : 0,
+            droppedFrames: current.dropped,
+            worstFrameMs: current.worstFrame,
+            avgFrameMs: current.frames ? current.frameTimeSum / current.frames : 0,
+            longTasks: current.longTasks,
+            longTaskMs: current.longTaskMs,
+            longTaskHistogram: current.histogram,
+        };
+        current = freshWindow();
+        return report;
+    };
+
+    const flush = () => {
+        const report = JSON.stringify(take());
+        const bridge = window.__qtBridge;
+        if (bridge && typeof bridge.reportTelemetry === 'function') {
+            bridge.reportTelemetry('frames', report);
+            return null;
+        }
+        return report;
+    };
+
+    const setEnabled = (value) => {
+        const wasEnabled = enabled;
+        enabled = !!value;
+        current = freshWindow();
+        if (enabled && !wasEnabled) {
+            requestAnimationFrame(onFrame);
+            observeLongTasks();
+            reportTimer = setInterval(() => {
+                if (window.__qtBridge && !document.hidden) {
+                    flush();
+                }
+            }, kReportIntervalMs);
+        } else if (!enabled && wasEnabled) {
+            // 已排队的下一帧回调看到 enabled 为 false 后不再续订
+            clearInterval(reportTimer);
+            reportTimer = 0;
+            if (longTaskObserver) {
+                longTaskObserver.disconnect();
+                longTaskObserver = null;
+            }
+        }
+    };
+
+    window.__qtFrames = { flush, setEnabled };
+    setEnabled(true);
+})();
@@ -0,0 +1,118 @@
+// 从 framestream://<名称>/frame 拉取 C++ 推送的最新帧并绘制到 canvas：
+// 每次请求携带上一帧的序号（after）与已绘制的序号（drawn），服务端没有新帧时挂起请求，因此循环不会空转。
+// 用法：const client = new FrameStreamClient(canvas, 'camera', { accept: ['rgba', 'jpeg'] }); client.start();
+(function () {
+    'use strict';
+    if (window.FrameStreamClient) {
+        return;
+    }
+
+    const kHeaderBytes = 32;
+    const kMagic = 0x31534651;
+    const kEncodings = ['rgba', 'jpeg', 'png'];
+    const kMimeTypes = { jpeg: 'image/jpeg', png: 'image/png' };
+    const kRetryDelayMs = 500;
+
+    class FrameStreamClient {
+        constructor(canvas, name, options = {}) {
+            this.canvas = canvas;
+            this.context = canvas.getContext('2d');
+            this.name = name;
+            this.accept = options.accept || ['rgba', 'jpeg'];
+            this.onFrame = options.onFrame || null;
+            this.running = false;
+            this.lastSeq = 0;
+            this.drawnSeq = 0;
+            this.stats = { frames: 0, emptyPolls: 0, errors: 0, bytes: 0, encoding: '' };
+        }
+
+        start() {
+            if (this.running) {
+                return;
+            }
+            this.running = true;
+            this.pull();
+        }
+
+        stop() {
+            this.running = false;
+            if (this.request) {
+                this.request.abort();
+                this.request = null;
+            }
+        }
+
+        pull() {
+            if (!this.running) {
+                return;
+            }
+            const url = `framestream://${this.name}/frame?after=${this.lastSeq}&drawn=${this.drawnSeq}` +
+                `&accept=${encodeURIComponent(this.accept.join(','))}`;
+            // 确认只需送达一次
+            this.drawnSeq = 0;
+            const request = new XMLHttpRequest();
+            this.request = request;
+            request.open('GET', url);
+            request.responseType = 'arraybuffer';
+            request.onload = () => this.handleResponse(request.response);
+            request.onerror = () => {
+                this.stats.errors += 1;
+                setTimeout(() => this.pull(), kRetryDelayMs);
+            };
+            request.send();
+        }
+
+        handleResponse(buffer) {
+            const view = new DataView(buffer);
+            if (buffer.byteLength < kHeaderBytes || view.getUint32(0, true) !== kMagic) {
+                this.stats.errors += 1;
+                setTimeout(() => this.pull(), kRetryDelayMs);
+                return;
+            }
+            const seq = view.getUint32(4, true);
+            const width = view.getUint32(8, true);
+            const height = view.getUint32(12, true);
+            const encoding = kEncodings[view.getUint32(16, true)] || 'rgba';
+            const ageMs = view.getFloat64(24, true);
+            if (width === 0 || height === 0) {
+                this.stats.emptyPolls += 1;
+                this.pull();
+                return;
+            }
+            this.lastSeq = seq;
+            this.stats.encoding = encoding;
+            this.stats.bytes += buffer.byteLength;
+            this.draw(buffer, width, height, encoding).then(() => {
+                this.stats.frames += 1;
+                this.drawnSeq = seq;
+                if (this.onFrame) {
+                    this.onFrame({ seq, width, height, encoding, ageMs });
+                }
+                this.pull();
+            }, () => {
+                this.stats.errors += 1;
+                this.pull();
+            });
+        }
+
+        draw(buffer, width, height, encoding) {
+            if (this.canvas.width !== width || this.canvas.height !== height) {
+                this.canvas.width = width;
+                this.canvas.height = height;
+            }
+            if (encoding === 'rgba') {
+                const pixels = new Uint8ClampedArray(buffer, kHeaderBytes, width * height * 4);
+                this.context.putImageData(new ImageData(pixels, width, height), 0, 0);
+                return Promise.resolve();
+            }
+            // 压缩帧交给浏览器在后台线程解码
+            const blob = new Blob([new Uint8Array(buffer, kHeaderBytes)], { type: kMimeTypes[encoding] });
+            return createImageBitmap(blob).then((bitmap) => {
+                this.context.drawImage(bitmap, 0, 0);
+                bitmap.close();
+            });
+        }
+    }
+
+    window.FrameStreamClient = FrameStreamClient;
+})();
@@ -0,0 +1,72 @@
+// 由 PageTimingCollector 在 DocumentCreation 阶段注入，收集 Navigation / Resource / Paint 计时，
+// 页面加载稳定后由 C++ 调用 flush()：bridge 可用时通过 reportTelemetry 批量回传，否则直接返回 JSON。
+(function () {
+    'use strict';
+    if (window.__qtTiming || window.top !== window) {
+        return;
+    }
+
+    const kMaxResources = 20;
+    const state = { paint: {}, lcp: 0, resources: [], resourceCount: 0, resourceBytes: 0 };
+
+    const observe = (type, handler) => {
+        try {
+            new PerformanceObserver((list) => list.getEntries().forEach(handler))
+                .observe({ type, buffered: true });
+        } catch (e) {
+            // 旧版 Chromium 不支持的条目类型直接忽略
+        }
+    };
+
+    observe('paint', (entry) => {
+        state.paint[entry.name] = entry.startTime;
+    });
+    observe('largest-contentful-paint', (entry) => {
+        state.lcp = entry.renderTime || entry.loadTime || entry.startTime;
+    });
+    observe('resource', (entry) => {
+        const bytes = entry.transferSize || entry.encodedBodySize || 0;
+        state.resourceCount += 1;
+        state.resourceBytes += bytes;
+        state.resources.push({
+            name: entry.name,
+            type: entry.initiatorType,
+            duration: entry.duration,
+            bytes,
+        });
+        if (state.resources.length > kMaxResources * 2) {
+            state.resources.sort((a, b) => b.bytes - a.bytes || b.duration - a.duration);
+            state.resources.length = kMaxResources;
+        }
+    });
+
+    const collect = () => {
+        const nav = performance.getEntriesByType('navigation')[0] || {};
+        state.resources.sort((a, b) => b.bytes - a.bytes || b.duration - a.duration);
+        return {
+            url: location.href,
+            ttfb: nav.responseStart,
+            domContentLoaded: nav.domContentLoadedEventEnd,
+            load: nav.loadEventEnd,
+            transferSize: nav.transferSize,
+            firstPaint: state.paint['first-paint'],
+            firstContentfulPaint: state.paint['first-contentful-paint'],
+            largestContentfulPaint: state.lcp,
+            resourceCount: state.resourceCount,
+            resourceBytes: state.resourceBytes,
+            resources: state.resources.slice(0, kMaxResources),
+        };
+    };
+
+    const flush = () => {
+        const report = JSON.stringify(collect());
+        const bridge = window.__qtBridge;
+        if (bridge && typeof bridge.reportTelemetry === 'function') {
+            bridge.reportTelemetry('timing', report);
+            return null;
+        }
+        return report;
+    };
+
+    window.__qtTiming = { collect, flush };
+})();